@@ -1,18 +1,29 @@
 /* Register mapping:
  * 00000 = Read start address
- * 00100 = Read length (in 64-byte packets)
+ * 00100 = Rows remaining; writing this starts the blit
  * 01000 = Write start address
- * 01100 = Write row length (in 64-byte packets)
- * 10000 = Write row stride
- * 10100 = Write words written
- 
-        parameter DEFAULT_RDADDR = 31'h00000000;
-	parameter DEFAULT_RDLEN  = 31'h00000000;
-	parameter DEFAULT_WRADDR = 31'h00000000;
-	parameter DEFAULT_WRROWL = 31'h00000000;
-	parameter DEFAULT_WRROWS = 31'h00000000;
-	parameter DEFAULT_WRDONE = 31'h00000000;
-
+ * 01100 = Row width (in pixels)
+ * 10000 = Write row stride (in bytes)
+ * 10100 = Read row stride (in bytes)
+ * 11000 = Mode:
+ *         bits 1:0 pick which source pixels get written:
+ *           0 = those whose alpha (bits 7:0) is at least bits 15:8 of
+ *               this register (the default is 1, so anything that isn't
+ *               entirely transparent)
+ *           1 = all of them
+ *           2 = those whose colour (bits 31:8) isn't bits 31:8 of this
+ *               register
+ *         bit 2 moves the alpha to bits 31:24 of the source pixel, which
+ *         is where it ends up in images that came out of GIMP as bytes
+ *
+ * Addresses and strides only have to be 4-byte aligned.  Each row is
+ * copied like FSABDMA copies a buffer: read in aligned beats, shifted to
+ * line up with the destination, and written in aligned beats with the
+ * ends (and any transparent pixels) masked off.  The next row can be
+ * read while this one is still being written.
+ *
+ * The registers can also be written by AccelCmdQ, which lives in our
+ * clock domain; it watches accel_blit__idle to find out when we're done.
  */
 
 module AccelBlit(/*AUTOARG*/
@@ -21,11 +32,12 @@ module AccelBlit(/*AUTOARG*/
    accel_blit__fsabo_did, accel_blit__fsabo_subdid,
    accel_blit__fsabo_addr, accel_blit__fsabo_len,
    accel_blit__fsabo_data, accel_blit__fsabo_mask,
-   accel_blit__spami_busy_b, accel_blit__spami_data,
+   accel_blit__spami_busy_b, accel_blit__spami_data, accel_blit__idle,
    // Inputs
    accel_blit__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid,
    fsabi_did, fsabi_subdid, fsabi_data, cclk, cclk_rst_b, spamo_valid,
-   spamo_r_nw, spamo_did, spamo_addr, spamo_data
+   spamo_r_nw, spamo_did, spamo_addr, spamo_data, accel_cmdq__blit_wr,
+   accel_cmdq__wr_addr, accel_cmdq__wr_data
    );
 
 	`include "fsab_defines.vh"
@@ -62,6 +74,12 @@ module AccelBlit(/*AUTOARG*/
 	output reg                  accel_blit__spami_busy_b;
 	output reg [SPAM_DATA_HI:0] accel_blit__spami_data;
 	
+	/* Command queue interface (fsabi_clk) */
+	input                       accel_cmdq__blit_wr;
+	input      [7:0]            accel_cmdq__wr_addr;
+	input      [31:0]           accel_cmdq__wr_data;
+	output wire                 accel_blit__idle;
+	
 	`include "clog2.vh"
 	parameter FSAB_DID = FSAB_DID_ACCEL;
 	parameter FSAB_SUBDID = FSAB_SUBDID_ACCEL_BLIT;
@@ -70,21 +88,35 @@ module AccelBlit(/*AUTOARG*/
 	parameter SPAM_ADDRPFX = 24'h100000;
 	parameter SPAM_ADDRMASK = 24'hF00000;
 
-	parameter DEFAULT_RDADDR = 31'h00000000;
-	parameter DEFAULT_RDLEN  = 31'h00000000;
-	parameter DEFAULT_WRADDR = 31'h00000000;
-	parameter DEFAULT_WRROWL = 31'h00000000;
-	parameter DEFAULT_WRROWS = 31'h00000000;
-	parameter DEFAULT_WRDONE = 31'h00000000;
+	parameter DEFAULT_RDADDR   = 31'h00000000;
+	parameter DEFAULT_WRADDR   = 31'h00000000;
+	parameter DEFAULT_WIDTH    = 16'h0000;
+	parameter DEFAULT_WRSTRIDE = 31'h00000000;
+	parameter DEFAULT_RDSTRIDE = 31'h00000000;
+	parameter DEFAULT_MODE     = 32'h00000100;
+
+	parameter MODE_ALPHA = 2'd0;
+	parameter MODE_COPY  = 2'd1;
+	parameter MODE_KEY   = 2'd2;
+
+	/* Number of credits that the arbiter gives us; this must match the
+	 * arbiter's setting for our slot.  Reads don't wait on writes, so
+	 * this is also how many reads we can have in flight at once.
+	 */
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+	
+	parameter RDFIFO_DEPTH = CREDITS * FSAB_LEN_MAX;
+	parameter RDFIFO_HI = clog2(RDFIFO_DEPTH) - 1;
 
 	/* FSAB credit availability logic */
 	wire trans_start;
 	
-	reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
 	wire fsab_credit_avail = (fsab_credits != 0);
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
-			fsab_credits <= FSAB_INITIAL_CREDITS;
+			fsab_credits <= CREDITS;
 		end else begin
 			if (accel_blit__fsabo_credit | trans_start) begin
 			`ifdef verilator
@@ -99,60 +131,197 @@ module AccelBlit(/*AUTOARG*/
 	wire bus_strobe_rdaddr;
 	wire [30:0] bus_rdaddr;
 	
-	wire bus_strobe_rdlen;
-	wire [30:0] bus_rdlen;
+	wire bus_strobe_rows;
+	wire [15:0] bus_rows;
 	
 	wire bus_strobe_wraddr;
 	wire [30:0] bus_wraddr;
 	
-	wire bus_strobe_wrrowl;
-	wire [30:0] bus_wrrowl;
+	wire bus_strobe_width;
+	wire [15:0] bus_width;
+	
+	wire bus_strobe_wrstride;
+	wire [30:0] bus_wrstride;
 	
-	wire bus_strobe_wrrows;
-	wire [30:0] bus_wrrows;
+	wire bus_strobe_rdstride;
+	wire [30:0] bus_rdstride;
 	
-	wire bus_strobe_wrdone;
-	wire [30:0] bus_wrdone;
+	wire bus_strobe_mode;
+	wire [31:0] bus_mode;
 	
-	reg [30:0] wrdone = DEFAULT_WRDONE;
+	/* Settings come in either over SPAM or from the command queue. */
+	wire cmdq_strobe_rdaddr   = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b00000);
+	wire cmdq_strobe_rows     = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b00100);
+	wire cmdq_strobe_wraddr   = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b01000);
+	wire cmdq_strobe_width    = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b01100);
+	wire cmdq_strobe_wrstride = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b10000);
+	wire cmdq_strobe_rdstride = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b10100);
+	wire cmdq_strobe_mode     = accel_cmdq__blit_wr && (accel_cmdq__wr_addr[4:0] == 5'b11000);
 	
-	reg [30:0] rdaddr;
-	reg [30:0] rdlen;
+	wire strobe_rows = bus_strobe_rows || cmdq_strobe_rows;
+	wire [15:0] rows_nx = bus_strobe_rows ? bus_rows : accel_cmdq__wr_data[15:0];
 	
-	reg [30:0] wraddr_cur = DEFAULT_WRADDR;
-	reg [30:0] wraddr_row = DEFAULT_WRADDR;
-	reg [30:0] wrrowl_rem = DEFAULT_WRROWL;
+	reg [30:0] rdaddr = DEFAULT_RDADDR;
+	reg [30:0] wraddr = DEFAULT_WRADDR;
+	reg [15:0] width = DEFAULT_WIDTH;
+	reg [30:0] wrstride = DEFAULT_WRSTRIDE;
+	reg [30:0] rdstride = DEFAULT_RDSTRIDE;
+	reg [31:0] mode = DEFAULT_MODE;
 	
-	reg trans_is_read = 1;
+	/*** Read data FIFO ***/
+	/* Read data lands here as it comes back, and is drained out by
+	 * writes.  Space is reserved when a read is issued, so the FIFO can
+	 * never overflow.
+	 */
+	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
 	
-	reg [FSAB_LEN_HI:0] trans_words_rem = 0;
-	wire [FSAB_LEN_HI:0] trans_words = 8;
-	reg [63:0] rddata [7:0];
-	integer i;
-	initial
-		for (i = 0; i < 8; i = i + 1)
-			rddata[i] = 64'h0;
+	wire                rdfifo_rd;
+	wire [63:0]         rdfifo_rdat;
+	wire [RDFIFO_HI:0]  rdfifo_avail;
+	reg  [RDFIFO_HI:0]  rdfifo_reserved = 0;
 	
-	assign trans_start = !bus_strobe_rdaddr && !bus_strobe_rdlen &&
-	                     fsab_credit_avail && (trans_words_rem == 0) &&
-	                     ((trans_is_read == 1) ? (rdlen != 0)
-	                                           : 1);
+	Fifo #(.DEPTH          (RDFIFO_DEPTH),
+	       .WIDTH          (64))
+	rdfifo(.clk            (fsabi_clk),
+	       .rst_b          (fsabi_rst_b),
+	       .wr_en          (fsabi_decode),
+	       .rd_en          (rdfifo_rd),
+	       .wr_dat         (fsabi_data),
+	       .rd_dat         (rdfifo_rdat),
+	       .empty          (),
+	       .full           (),
+	       .available      (rdfifo_avail),
+	       .afull          (),
+	       .aempty         ());
 	
-	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
+	/*** Row state ***/
+	/* The read side and the write side each walk the rows on their own;
+	 * the write side also needs to know where each row's source started,
+	 * to work out how to line it up.
+	 */
+	wire [17:0] row_len = {width, 2'b00};	/* in bytes */
+	
+	reg [15:0] rd_rows = 0;
+	reg [30:0] rd_row = 0;
+	reg [30:0] rd_addr = 0;
+	reg [15:0] rd_beats_rem = 0;
+	
+	reg [15:0] wr_rows = 0;
+	reg        wr_row_active = 0;
+	reg [30:0] wr_row_src = 0;
+	reg [30:0] wr_row_dst = 0;
+	
+	wire [18:0] rd_setup_end = {16'h0, rd_row[2:0]} + {1'b0, row_len} + 19'd7;
+	wire [18:0] wr_setup_in_end = {16'h0, wr_row_src[2:0]} + {1'b0, row_len} + 19'd7;
+	wire [18:0] wr_setup_out_end = {16'h0, wr_row_dst[2:0]} + {1'b0, row_len} + 19'd7;
+	wire [2:0]  wr_setup_last = wr_row_dst[2:0] + row_len[2:0] - 3'd1;
+	
+	/* As in FSABDMA: each beat that goes out is put together from two
+	 * beats that came in, and if the source is at least as far into its
+	 * beat as the destination is, we pull one in ahead of time.
+	 */
+	reg [2:0]  src_ofs = 0;
+	reg [2:0]  dst_ofs = 0;
+	reg [7:0]  end_mask = 0;	/* byte mask for the last beat of the row */
+	reg [30:0] wr_addr = 0;
+	reg [15:0] wr_beats_rem = 0;
+	reg [15:0] in_rem = 0;		/* beats in for this row that haven't come out of the FIFO */
+	reg        wr_first = 0;
+	reg        prime = 0;
+	reg        prime_1a = 0;
+	reg [63:0] prev = 0;
+	
+	/*** Transaction start ***/
+	/* Writes are started whenever everything that they will pull from
+	 * the FIFO is there, and take precedence, so that the FIFO drains;
+	 * reads are started whenever there is room for what they will bring
+	 * back.  Bursts never cross a 64-byte boundary.  A write occupies the
+	 * bus for a while (wr_words_rem pulls from the FIFO; wr_beat_1a puts
+	 * the data on the bus a cycle later), and nothing else can start
+	 * until it's entirely out the door.
+	 */
+	reg [FSAB_LEN_HI:0] wr_words_rem = 0;
+	reg [FSAB_LEN_HI:0] wr_len = 0;
+	reg [30:0]          wr_burst_addr = 0;
+	reg                 wr_beat_1a = 0;
+	reg                 wr_first_1a = 0;
+	reg                 wr_last_1a = 0;
+	wire wr_busy = (wr_words_rem != 0) || wr_beat_1a;
+	
+	wire [3:0] wr_blk_left = 4'd8 - {1'b0, wr_addr[5:3]};
+	wire [3:0] rd_blk_left = 4'd8 - {1'b0, rd_addr[5:3]};
+	wire [FSAB_LEN_HI:0] wr_burst = (wr_beats_rem < wr_blk_left) ? wr_beats_rem[3:0] : wr_blk_left;
+	wire [FSAB_LEN_HI:0] rd_burst = (rd_beats_rem < rd_blk_left) ? rd_beats_rem[3:0] : rd_blk_left;
+	wire [FSAB_LEN_HI:0] wr_need = (in_rem < wr_burst) ? in_rem[3:0] : wr_burst;
+	
+	/* verilator lint_off WIDTH */
+	wire wr_start = wr_row_active && fsab_credit_avail && !wr_busy && !prime && !prime_1a &&
+	                (wr_beats_rem != 0) && (rdfifo_avail >= wr_need);
+	wire rd_start = fsab_credit_avail && !wr_busy && !wr_start && !strobe_rows &&
+	                (rd_beats_rem != 0) &&
+	                ((rdfifo_reserved + rd_burst) <= RDFIFO_DEPTH);
+	/* verilator lint_on WIDTH */
+	assign trans_start = wr_start || rd_start;
 	
-	wire [63:0] fuck_xilinx = rddata[trans_words_rem - 1];
+	wire rd_setup = (rd_beats_rem == 0) && (rd_rows != 0) && !strobe_rows;
+	wire wr_setup = !wr_row_active && (wr_rows != 0) && !strobe_rows;
+	wire wr_row_done = wr_row_active && (wr_beats_rem == 0) && !wr_busy;
+	
+	wire prime_rd = prime && (rdfifo_avail != 0);
+	wire wr_pop = (wr_words_rem != 0) && (in_rem != 0);
+	assign rdfifo_rd = prime_rd || wr_pop;
+	
+	/*** Output data and masks ***/
+	wire [2:0]   shift = src_ofs - dst_ofs;
+	wire [127:0] funnel = {rdfifo_rdat, prev} >> {shift, 3'b000};
+	wire [7:0]   wr_mask = (wr_first_1a ? (8'hFF << dst_ofs) : 8'hFF) &
+	                       (wr_last_1a ? end_mask : 8'hFF);
+	
+	wire [7:0] alpha_lo = mode[2] ? funnel[31:24] : funnel[7:0];
+	wire [7:0] alpha_hi = mode[2] ? funnel[63:56] : funnel[39:32];
+	
+	reg [1:0] pix_keep;	/* combinatorial */
+	always @(*)
+		case (mode[1:0])
+		MODE_ALPHA: pix_keep = {alpha_hi >= mode[15:8], alpha_lo >= mode[15:8]};
+		MODE_KEY:   pix_keep = {funnel[63:40] != mode[31:8], funnel[31:8] != mode[31:8]};
+		default:    pix_keep = 2'b11;
+		endcase
+	wire [7:0] pix_mask = wr_mask & {{4{pix_keep[1]}}, {4{pix_keep[0]}}};
+	
+	/* Everything that we've read has been written back out. */
+	assign accel_blit__idle = (wr_rows == 0) && (rd_rows == 0) && (rd_beats_rem == 0) &&
+	                          (rdfifo_reserved == 0) && !wr_busy;
 	
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
 			rdaddr <= DEFAULT_RDADDR;
-			rdlen <= DEFAULT_RDLEN;
-			trans_is_read <= 1;
-			trans_words_rem <= 0;
+			wraddr <= DEFAULT_WRADDR;
+			width <= DEFAULT_WIDTH;
+			wrstride <= DEFAULT_WRSTRIDE;
+			rdstride <= DEFAULT_RDSTRIDE;
+			mode <= DEFAULT_MODE;
+			
+			rd_rows <= 0;
+			rd_row <= 0;
+			rd_addr <= 0;
+			rd_beats_rem <= 0;
+			rdfifo_reserved <= 0;
 			
-			wraddr_cur <= DEFAULT_WRADDR;
-			wraddr_row <= DEFAULT_WRADDR;
-			wrrowl_rem <= DEFAULT_WRROWL;
-			wrdone <= DEFAULT_WRDONE;
+			wr_rows <= 0;
+			wr_row_active <= 0;
+			wr_row_src <= 0;
+			wr_row_dst <= 0;
+			wr_beats_rem <= 0;
+			in_rem <= 0;
+			wr_first <= 0;
+			prime <= 0;
+			prime_1a <= 0;
+			
+			wr_words_rem <= 0;
+			wr_beat_1a <= 0;
+			wr_first_1a <= 0;
+			wr_last_1a <= 0;
 			
 			accel_blit__fsabo_valid <= 0;
 			accel_blit__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
@@ -163,70 +332,131 @@ module AccelBlit(/*AUTOARG*/
 			accel_blit__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
 			accel_blit__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
 		end else begin
+			/*** Settings ***/
 			if (bus_strobe_rdaddr)
 				rdaddr <= bus_rdaddr;
-			else if (trans_start && trans_is_read)
-				rdaddr <= rdaddr + {24'h0, trans_words,3'b000};
+			else if (cmdq_strobe_rdaddr)
+				rdaddr <= accel_cmdq__wr_data[30:0];
+			
+			if (bus_strobe_wraddr)
+				wraddr <= bus_wraddr;
+			else if (cmdq_strobe_wraddr)
+				wraddr <= accel_cmdq__wr_data[30:0];
 			
-			if (bus_strobe_rdlen)
-				rdlen <= bus_rdlen;
-			else if (trans_start && trans_is_read)
-				rdlen <= rdlen - 1;
+			if (bus_strobe_width)
+				width <= bus_width;
+			else if (cmdq_strobe_width)
+				width <= accel_cmdq__wr_data[15:0];
 			
-			if (bus_strobe_wraddr || bus_strobe_wrrowl || bus_strobe_wrdone) begin
-				wraddr_cur <= bus_wraddr;
-				wraddr_row <= bus_wraddr;
-				wrrowl_rem <= bus_wrrowl - 1;
-				wrdone <= bus_wrdone;
-			end else if ((trans_words_rem == 1) && !trans_is_read) begin
-				if (wrrowl_rem == 0) begin
-					wrrowl_rem <= bus_wrrowl - 1;
-					wraddr_cur <= wraddr_row + bus_wrrows;
-					wraddr_row <= wraddr_row + bus_wrrows;
-				end else begin
-					wraddr_cur <= wraddr_cur + 64;
-					wrrowl_rem <= wrrowl_rem - 1;
-				end
-				wrdone <= wrdone + 1;
+			if (bus_strobe_wrstride)
+				wrstride <= bus_wrstride;
+			else if (cmdq_strobe_wrstride)
+				wrstride <= accel_cmdq__wr_data[30:0];
+			
+			if (bus_strobe_rdstride)
+				rdstride <= bus_rdstride;
+			else if (cmdq_strobe_rdstride)
+				rdstride <= accel_cmdq__wr_data[30:0];
+			
+			if (bus_strobe_mode)
+				mode <= bus_mode;
+			else if (cmdq_strobe_mode)
+				mode <= accel_cmdq__wr_data;
+			
+			/*** Read side ***/
+			if (strobe_rows) begin
+			`ifdef verilator
+				$display("ACCELBLIT: start: %d rows of %d pixels from %08x (+%d) to %08x (+%d), mode %08x", rows_nx, width, rdaddr, rdstride, wraddr, wrstride, mode);
+			`endif
+				rd_rows <= (width == 0) ? 16'h0 : rows_nx;
+				rd_row <= rdaddr;
+			end else if (rd_setup) begin
+				rd_rows <= rd_rows - 1;
+				rd_row <= rd_row + rdstride;
+				rd_addr <= {rd_row[30:3], 3'b000};
+				rd_beats_rem <= rd_setup_end[18:3];
+			end else if (rd_start) begin
+				rd_addr <= rd_addr + {rd_burst, 3'b000};
+				rd_beats_rem <= rd_beats_rem - rd_burst;
 			end
 			
-			if (trans_start)
-				trans_words_rem <= trans_words;
-			else if (!trans_is_read && (trans_words_rem != 0))
-				trans_words_rem <= trans_words_rem - 1;
-			else if (trans_is_read && fsabi_decode)
-				trans_words_rem <= trans_words_rem - 1;
+			/* verilator lint_off WIDTH */
+			rdfifo_reserved <= rdfifo_reserved + (rd_start ? rd_burst : 0) - (rdfifo_rd ? 1 : 0);
+			/* verilator lint_on WIDTH */
+			
+			/*** Write side ***/
+			if (strobe_rows) begin
+				wr_rows <= (width == 0) ? 16'h0 : rows_nx;
+				wr_row_src <= rdaddr;
+				wr_row_dst <= wraddr;
+			end else if (wr_setup) begin
+				src_ofs <= wr_row_src[2:0];
+				dst_ofs <= wr_row_dst[2:0];
+				end_mask <= 8'hFF >> (3'd7 - wr_setup_last);
+				wr_addr <= {wr_row_dst[30:3], 3'b000};
+				wr_beats_rem <= wr_setup_out_end[18:3];
+				in_rem <= wr_setup_in_end[18:3];
+				wr_first <= 1;
+				prime <= (wr_row_src[2:0] >= wr_row_dst[2:0]);
+				wr_row_active <= 1;
+			end else if (wr_row_done) begin
+				wr_rows <= wr_rows - 1;
+				wr_row_src <= wr_row_src + rdstride;
+				wr_row_dst <= wr_row_dst + wrstride;
+				wr_row_active <= 0;
+			end
 			
-			if (trans_is_read && fsabi_decode && (trans_words_rem == 1))
-				trans_is_read <= 0;
-			else if (!trans_is_read && (trans_words_rem == 1))
-				trans_is_read <= 1;
+			if (rdfifo_rd)
+				in_rem <= in_rem - 1;
 			
-			if (fsabi_decode)
-				rddata[trans_words_rem - 1] <= fsabi_data;
+			if (prime_rd)
+				prime <= 0;
+			prime_1a <= prime_rd;
+			if (prime_1a)
+				prev <= rdfifo_rdat;
 			
-			if (trans_start && trans_is_read) begin
+			if (wr_start) begin
+				wr_words_rem <= wr_burst;
+				wr_len <= wr_burst;
+				wr_burst_addr <= wr_addr;
+			end else if (wr_words_rem != 0)
+				wr_words_rem <= wr_words_rem - 1;
+			
+			if (wr_words_rem != 0) begin
+				wr_addr <= wr_addr + 8;
+				wr_beats_rem <= wr_beats_rem - 1;
+				wr_first <= 0;
+			end
+			wr_beat_1a <= (wr_words_rem != 0);
+			wr_first_1a <= wr_first;
+			wr_last_1a <= (wr_beats_rem == 1);
+			if (wr_beat_1a)
+				prev <= rdfifo_rdat;
+			
+			if (rd_start) begin
 				accel_blit__fsabo_valid <= 1;
 				accel_blit__fsabo_mode <= FSAB_READ;
 				accel_blit__fsabo_did <= FSAB_DID;
 				accel_blit__fsabo_subdid <= FSAB_SUBDID;
-				accel_blit__fsabo_addr <= rdaddr;
-				accel_blit__fsabo_len <= trans_words;
+				accel_blit__fsabo_addr <= rd_addr;
+				accel_blit__fsabo_len <= rd_burst;
 				accel_blit__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
 				accel_blit__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
-				$display("ACCELBLIT: read start: req %x words from %08x", trans_words, rdaddr);
-			end else if ((trans_words_rem != 0) && !trans_is_read) begin
+			`ifdef verilator
+				$display("ACCELBLIT: read start: req %x words from %08x (%d reserved)", rd_burst, rd_addr, rdfifo_reserved);
+			`endif
+			end else if (wr_beat_1a) begin
 				accel_blit__fsabo_valid <= 1;
 				accel_blit__fsabo_mode <= FSAB_WRITE;
 				accel_blit__fsabo_did <= FSAB_DID;
 				accel_blit__fsabo_subdid <= FSAB_SUBDID;
-				accel_blit__fsabo_addr <= wraddr_cur;
-				accel_blit__fsabo_len <= trans_words;
-				accel_blit__fsabo_data <= fuck_xilinx;
-				accel_blit__fsabo_mask <= {{4{fuck_xilinx[32]}},
-				                           {4{fuck_xilinx[0]}}};
-				$display("ACCELBLIT: write: %x words, wraddr_cur %x, data %x, mask %x", trans_words, wraddr_cur, rddata[trans_words_rem - 1],
-					{{4{rddata[trans_words_rem - 1][32]}},{4{rddata[trans_words_rem - 1][0]}}});
+				accel_blit__fsabo_addr <= wr_burst_addr;
+				accel_blit__fsabo_len <= wr_len;
+				accel_blit__fsabo_data <= funnel[63:0];
+				accel_blit__fsabo_mask <= pix_mask;
+			`ifdef verilator
+				$display("ACCELBLIT: write: %x words to %08x, data %x, mask %x", wr_len, wr_burst_addr, funnel[63:0], pix_mask);
+			`endif
 			end else begin
 				accel_blit__fsabo_valid <= 0;
 				accel_blit__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
@@ -273,24 +503,24 @@ module AccelBlit(/*AUTOARG*/
 		           .rst_b_tclk         (fsabi_rst_b),
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b00000)),
 		           .wr_data_cclk       (spamo_data[30:0]));
-	
-	wire wr_done_strobe_RDLEN;
-	CSRAsyncWrite #(.WIDTH       (31),
-	                .RESET_VALUE (DEFAULT_RDLEN))
-		CSR_RDLEN (/* NOT AUTOINST */
+
+	wire wr_done_strobe_ROWS;
+	CSRAsyncWrite #(.WIDTH       (16),
+	                .RESET_VALUE (16'h0000))
+		CSR_ROWS  (/* NOT AUTOINST */
 		           // Outputs
 		           .wr_wait_cclk       (),
-		           .wr_done_strobe_cclk(wr_done_strobe_RDLEN),
-		           .wr_strobe_tclk     (bus_strobe_rdlen),
-		           .wr_data_tclk       (bus_rdlen[30:0]),
+		           .wr_done_strobe_cclk(wr_done_strobe_ROWS),
+		           .wr_strobe_tclk     (bus_strobe_rows),
+		           .wr_data_tclk       (bus_rows[15:0]),
 		           // Inputs
 		           .cclk               (cclk),
 		           .tclk               (fsabi_clk),
 		           .rst_b_cclk         (cclk_rst_b),
 		           .rst_b_tclk         (fsabi_rst_b),
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b00100)),
-		           .wr_data_cclk       (spamo_data[30:0]));
-	
+		           .wr_data_cclk       (spamo_data[15:0]));
+
 	wire wr_done_strobe_WRADDR;
 	CSRAsyncWrite #(.WIDTH       (31),
 	                .RESET_VALUE (DEFAULT_WRADDR))
@@ -307,33 +537,33 @@ module AccelBlit(/*AUTOARG*/
 		           .rst_b_tclk         (fsabi_rst_b),
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b01000)),
 		           .wr_data_cclk       (spamo_data[30:0]));
-	
-	wire wr_done_strobe_WRROWL;
-	CSRAsyncWrite #(.WIDTH       (31),
-	                .RESET_VALUE (DEFAULT_WRROWL))
-		CSR_WRROWL(/* NOT AUTOINST */
+
+	wire wr_done_strobe_WIDTH;
+	CSRAsyncWrite #(.WIDTH       (16),
+	                .RESET_VALUE (DEFAULT_WIDTH))
+		CSR_WIDTH (/* NOT AUTOINST */
 		           // Outputs
 		           .wr_wait_cclk       (),
-		           .wr_done_strobe_cclk(wr_done_strobe_WRROWL),
-		           .wr_strobe_tclk     (bus_strobe_wrrowl),
-		           .wr_data_tclk       (bus_wrrowl[30:0]),
+		           .wr_done_strobe_cclk(wr_done_strobe_WIDTH),
+		           .wr_strobe_tclk     (bus_strobe_width),
+		           .wr_data_tclk       (bus_width[15:0]),
 		           // Inputs
 		           .cclk               (cclk),
 		           .tclk               (fsabi_clk),
 		           .rst_b_cclk         (cclk_rst_b),
 		           .rst_b_tclk         (fsabi_rst_b),
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b01100)),
-		           .wr_data_cclk       (spamo_data[30:0]));
-	
-	wire wr_done_strobe_WRROWS;
+		           .wr_data_cclk       (spamo_data[15:0]));
+
+	wire wr_done_strobe_WRSTRIDE;
 	CSRAsyncWrite #(.WIDTH       (31),
-	                .RESET_VALUE (DEFAULT_WRROWS))
-		CSR_WRROWS(/* NOT AUTOINST */
+	                .RESET_VALUE (DEFAULT_WRSTRIDE))
+		CSR_WRSTRIDE(/* NOT AUTOINST */
 		           // Outputs
 		           .wr_wait_cclk       (),
-		           .wr_done_strobe_cclk(wr_done_strobe_WRROWS),
-		           .wr_strobe_tclk     (bus_strobe_wrrows),
-		           .wr_data_tclk       (bus_wrrows[30:0]),
+		           .wr_done_strobe_cclk(wr_done_strobe_WRSTRIDE),
+		           .wr_strobe_tclk     (bus_strobe_wrstride),
+		           .wr_data_tclk       (bus_wrstride[30:0]),
 		           // Inputs
 		           .cclk               (cclk),
 		           .tclk               (fsabi_clk),
@@ -341,16 +571,16 @@ module AccelBlit(/*AUTOARG*/
 		           .rst_b_tclk         (fsabi_rst_b),
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b10000)),
 		           .wr_data_cclk       (spamo_data[30:0]));
-	
-	wire wr_done_strobe_WRDONE;
+
+	wire wr_done_strobe_RDSTRIDE;
 	CSRAsyncWrite #(.WIDTH       (31),
-	                .RESET_VALUE (DEFAULT_WRDONE))
-		CSR_WRDONE(/* NOT AUTOINST */
+	                .RESET_VALUE (DEFAULT_RDSTRIDE))
+		CSR_RDSTRIDE(/* NOT AUTOINST */
 		           // Outputs
 		           .wr_wait_cclk       (),
-		           .wr_done_strobe_cclk(wr_done_strobe_WRDONE),
-		           .wr_strobe_tclk     (bus_strobe_wrdone),
-		           .wr_data_tclk       (bus_wrdone[30:0]),
+		           .wr_done_strobe_cclk(wr_done_strobe_RDSTRIDE),
+		           .wr_strobe_tclk     (bus_strobe_rdstride),
+		           .wr_data_tclk       (bus_rdstride[30:0]),
 		           // Inputs
 		           .cclk               (cclk),
 		           .tclk               (fsabi_clk),
@@ -359,22 +589,39 @@ module AccelBlit(/*AUTOARG*/
 		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b10100)),
 		           .wr_data_cclk       (spamo_data[30:0]));
 
-	wire [30:0] rd_data_WRDONE;
-	wire rd_done_strobe_WRDONE;
-	CSRAsyncRead #(.WIDTH        (31))
-		CSR_WRDONE_READ     (/* NOT AUTOINST */
+	wire wr_done_strobe_MODE;
+	CSRAsyncWrite #(.WIDTH       (32),
+	                .RESET_VALUE (DEFAULT_MODE))
+		CSR_MODE  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_MODE),
+		           .wr_strobe_tclk     (bus_strobe_mode),
+		           .wr_data_tclk       (bus_mode[31:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b11000)),
+		           .wr_data_cclk       (spamo_data[31:0]));
+
+	wire [15:0] rd_data_ROWS;
+	wire rd_done_strobe_ROWS;
+	CSRAsyncRead #(.WIDTH        (16))
+		CSR_ROWS_READ       (/* NOT AUTOINST */
 				     // Outputs
-				     .rd_data_cclk	(rd_data_WRDONE),
+				     .rd_data_cclk	(rd_data_ROWS),
 				     .rd_wait_cclk	(),
-				     .rd_done_strobe_cclk(rd_done_strobe_WRDONE),
+				     .rd_done_strobe_cclk(rd_done_strobe_ROWS),
 				     .rd_strobe_tclk	(),
 				     // Inputs
 				     .cclk		(cclk),
 				     .tclk		(fsabi_clk),
 				     .rst_b_cclk	(cclk_rst_b),
 				     .rst_b_tclk	(fsabi_rst_b),
-				     .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'b10100)),
-				     .rd_data_tclk	(wrdone[30:0]));
+				     .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'b00100)),
+				     .rd_data_tclk	(wr_rows[15:0]));
 
 	always @(posedge cclk or negedge cclk_rst_b) begin
 		if (!cclk_rst_b) begin
@@ -382,13 +629,14 @@ module AccelBlit(/*AUTOARG*/
 			accel_blit__spami_data <= 0;
 		end else begin 
 			accel_blit__spami_busy_b <= wr_done_strobe_RDADDR |
-			                            wr_done_strobe_RDLEN |
+			                            wr_done_strobe_ROWS |
 			                            wr_done_strobe_WRADDR |
-			                            wr_done_strobe_WRROWL |
-			                            wr_done_strobe_WRROWS |
-			                            wr_done_strobe_WRDONE |
-			                            rd_done_strobe_WRDONE;
-			accel_blit__spami_data <= {32{rd_done_strobe_WRDONE}} & {1'b0, rd_data_WRDONE};
+			                            wr_done_strobe_WIDTH |
+			                            wr_done_strobe_WRSTRIDE |
+			                            wr_done_strobe_RDSTRIDE |
+			                            wr_done_strobe_MODE |
+			                            rd_done_strobe_ROWS;
+			accel_blit__spami_data <= {32{rd_done_strobe_ROWS}} & {16'h0, rd_data_ROWS};
 		end
 	end
 endmodule
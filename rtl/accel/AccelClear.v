@@ -1,7 +1,30 @@
 /* Register mapping:
- * 0000 = datum
- * 0100 = start address
- * 1000 = number of FSAB packets (x8 bytes)
+ * 000000 = datum (background colour, when expanding)
+ * 000100 = start address
+ * 001000 = number of FSAB packets (x8 bytes); writing this starts a linear
+ *          fill at the start address
+ * 001100 = rectangle width, in 32-bit words
+ * 010000 = rectangle row stride, in bytes
+ * 010100 = rectangle rows remaining; writing this starts a rectangle fill
+ * 011000 = foreground colour, when expanding
+ * 011100 = bitmap rows 0 through 3 (row 0 in bits 7:0)
+ * 100000 = bitmap rows 4 through 7
+ * 100100 = expansion: bits 3:0 are the scale (0 turns expansion off); if
+ *          bit 4 is set, background pixels are left alone
+ *
+ * A linear fill wants the start address to be 8-byte aligned.  A rectangle
+ * fill only wants it (and the stride) to be 4-byte aligned; each row goes
+ * out as whole beats, and the half-beats hanging off of either end are
+ * masked.  Either way, bursts never cross a 64-byte boundary.
+ *
+ * With expansion turned on, a rectangle fill draws an 8x8 1-bpp bitmap
+ * instead of a solid colour (for glyphs, mostly): each bit becomes a
+ * scale-by-scale square of foreground or background, with the most
+ * significant bit of each row on the left.  Anything in the rectangle
+ * past the edge of the bitmap comes out as background.
+ *
+ * The registers can also be written by AccelCmdQ, which lives in our
+ * clock domain; it watches accel_clear__idle to find out when we're done.
  */
 
 module AccelClear(/*AUTOARG*/
@@ -11,10 +34,12 @@ module AccelClear(/*AUTOARG*/
    accel_clear__fsabo_addr, accel_clear__fsabo_len,
    accel_clear__fsabo_data, accel_clear__fsabo_mask,
    accel_clear__spami_busy_b, accel_clear__spami_data,
+   accel_clear__idle,
    // Inputs
    accel_clear__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid,
    fsabi_did, fsabi_subdid, fsabi_data, cclk, cclk_rst_b, spamo_valid,
-   spamo_r_nw, spamo_did, spamo_addr, spamo_data
+   spamo_r_nw, spamo_did, spamo_addr, spamo_data, accel_cmdq__clear_wr,
+   accel_cmdq__wr_addr, accel_cmdq__wr_data
    );
 
 	`include "fsab_defines.vh"
@@ -51,6 +76,12 @@ module AccelClear(/*AUTOARG*/
 	output wire                  accel_clear__spami_busy_b;
 	output wire [SPAM_DATA_HI:0] accel_clear__spami_data;
 	
+	/* Command queue interface (fsabi_clk) */
+	input                        accel_cmdq__clear_wr;
+	input       [7:0]            accel_cmdq__wr_addr;
+	input       [31:0]           accel_cmdq__wr_data;
+	output wire                  accel_clear__idle;
+	
 	`include "clog2.vh"
 	parameter FSAB_DID = FSAB_DID_ACCEL;
 	parameter FSAB_SUBDID = FSAB_SUBDID_ACCEL_CLEAR;
@@ -62,6 +93,9 @@ module AccelClear(/*AUTOARG*/
 	parameter DEFAULT_VALUE = 32'h00000000;
 	parameter DEFAULT_ADDR = 31'h00000000;
 	parameter DEFAULT_LENREM = 31'h00000000;
+	parameter DEFAULT_WIDTH = 31'h00000000;
+	parameter DEFAULT_STRIDE = 31'h00000000;
+	parameter DEFAULT_FG = 32'hFFFFFFFF;
 
 	/* FSAB credit availability logic */
 	wire trans_start;
@@ -82,6 +116,7 @@ module AccelClear(/*AUTOARG*/
 	end
 
 	/* Transaction initiation and data state control logic */
+	wire bus_value_wr_strobe;
 	wire [31:0] bus_value;
 	
 	wire bus_addr_wr_strobe;
@@ -90,30 +125,161 @@ module AccelClear(/*AUTOARG*/
 	wire bus_lenrem_wr_strobe;
 	wire [30:0] bus_lenrem;
 	
+	wire bus_width_wr_strobe;
+	wire [30:0] bus_width;
+	
+	wire bus_stride_wr_strobe;
+	wire [30:0] bus_stride;
+	
+	wire bus_rows_wr_strobe;
+	wire [15:0] bus_rows;
+	
+	wire bus_fg_wr_strobe;
+	wire [31:0] bus_fg;
+	
+	wire bus_bm0_wr_strobe;
+	wire [31:0] bus_bm0;
+	
+	wire bus_bm1_wr_strobe;
+	wire [31:0] bus_bm1;
+	
+	wire bus_expand_wr_strobe;
+	wire [4:0] bus_expand;
+	
+	wire cmdq_value_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b000000);
+	wire cmdq_addr_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b000100);
+	wire cmdq_lenrem_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b001000);
+	wire cmdq_width_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b001100);
+	wire cmdq_stride_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b010000);
+	wire cmdq_rows_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b010100);
+	wire cmdq_fg_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b011000);
+	wire cmdq_bm0_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b011100);
+	wire cmdq_bm1_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b100000);
+	wire cmdq_expand_wr_strobe = accel_cmdq__clear_wr && (accel_cmdq__wr_addr[5:0] == 6'b100100);
+	
+	wire addr_wr_strobe = bus_addr_wr_strobe || cmdq_addr_wr_strobe;
+	wire lenrem_wr_strobe = bus_lenrem_wr_strobe || cmdq_lenrem_wr_strobe;
+	wire rows_wr_strobe = bus_rows_wr_strobe || cmdq_rows_wr_strobe;
+	
+	reg [31:0] value = DEFAULT_VALUE;
 	reg [30:0] addr = DEFAULT_ADDR;
 	reg [30:0] lenrem = DEFAULT_LENREM;
-
+	reg [30:0] width = DEFAULT_WIDTH;
+	reg [30:0] stride = DEFAULT_STRIDE;
+	reg [15:0] rows = 0;
+	reg [30:0] row_addr = DEFAULT_ADDR;	/* first byte of the current row */
+	
+	reg [31:0] fg = DEFAULT_FG;
+	reg [63:0] bitmap = 0;
+	reg [3:0]  scale = 0;
+	reg        bg_clear = 0;	/* background is transparent */
+	reg        rect_mode = 0;	/* expansion only happens in rectangles */
+	wire       expand = rect_mode && (scale != 0);
+	
+	/* Per-beat masking: beats_left counts down the beats of the current
+	 * row (or linear fill) as they go out on the bus, and the first and
+	 * last of them get their masks trimmed.
+	 */
+	reg [30:0] beats_left = 0;
+	reg        beat_first = 0;
+	reg [7:0]  head_mask = 8'hFF;
+	reg [7:0]  tail_mask = 8'hFF;
+	
+	/* Setting up a row, starting from a given address; the row is
+	 * rounded out to whole beats.
+	 */
+	wire [30:0] row_next_addr = row_addr + stride;
+	wire [30:0] row_start_addr = rows_wr_strobe ? row_addr : row_next_addr;
+	wire [31:0] row_start_words = {1'b0, width} + {31'h0, row_start_addr[2]};
+	wire [30:0] row_start_beats = row_start_words[31:1] + {30'h0, row_start_words[0]};
+	wire [7:0]  row_head_mask = row_start_addr[2] ? 8'hF0 : 8'hFF;
+	wire [7:0]  row_tail_mask = row_start_words[0] ? 8'h0F : 8'hFF;
+	
 	reg trans_start_1a = 0;
 	reg [FSAB_LEN_HI:0] trans_words_rem = 0;
-	wire [FSAB_LEN_HI:0] trans_words = (lenrem > FSAB_LEN_MAX) ? FSAB_LEN_MAX : lenrem[FSAB_LEN_HI:0];
-	assign trans_start = fsab_credit_avail && (trans_words_rem == 0) && (lenrem != 0) && !bus_addr_wr_strobe && !bus_lenrem_wr_strobe && !trans_start_1a;
+	wire [FSAB_LEN_HI:0] trans_blk_left = 4'd8 - {1'b0, addr[5:3]};
+	wire [FSAB_LEN_HI:0] trans_words = (lenrem > trans_blk_left) ? trans_blk_left : lenrem[FSAB_LEN_HI:0];
+	wire trans_beat = trans_start || (trans_words_rem != 0);
+	wire row_done = (lenrem == 0) && (trans_words_rem == 0) && (rows != 0);
+	assign trans_start = fsab_credit_avail && (trans_words_rem == 0) && (lenrem != 0) && !addr_wr_strobe && !lenrem_wr_strobe && !rows_wr_strobe && !trans_start_1a;
+	assign accel_clear__idle = (lenrem == 0) && (trans_words_rem == 0) && (rows == 0);
 	
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
+			value <= DEFAULT_VALUE;
 			addr <= DEFAULT_ADDR;
 			lenrem <= DEFAULT_LENREM;
+			width <= DEFAULT_WIDTH;
+			stride <= DEFAULT_STRIDE;
+			rows <= 0;
+			row_addr <= DEFAULT_ADDR;
+			beats_left <= 0;
+			beat_first <= 0;
+			head_mask <= 8'hFF;
+			tail_mask <= 8'hFF;
 			trans_words_rem <= 0;
 			trans_start_1a <= 0;
 		end else begin
-			if (bus_addr_wr_strobe)
+			if (bus_value_wr_strobe)
+				value <= bus_value;
+			else if (cmdq_value_wr_strobe)
+				value <= accel_cmdq__wr_data;
+			
+			if (bus_width_wr_strobe)
+				width <= bus_width;
+			else if (cmdq_width_wr_strobe)
+				width <= accel_cmdq__wr_data[30:0];
+			
+			if (bus_stride_wr_strobe)
+				stride <= bus_stride;
+			else if (cmdq_stride_wr_strobe)
+				stride <= accel_cmdq__wr_data[30:0];
+			
+			if (bus_addr_wr_strobe) begin
 				addr <= bus_addr;
-			else if (trans_start)
+				row_addr <= bus_addr;
+			end else if (cmdq_addr_wr_strobe) begin
+				addr <= accel_cmdq__wr_data[30:0];
+				row_addr <= accel_cmdq__wr_data[30:0];
+			end else if (rows_wr_strobe || row_done) begin
+				/* Starting a rectangle, or moving on to its next row. */
+				row_addr <= row_start_addr;
+				addr <= {row_start_addr[30:3], 3'b000};
+			end else if (trans_start)
 				addr <= addr + {24'h0, trans_words,3'b000};
 			
-			if (bus_lenrem_wr_strobe)
-				lenrem <= bus_lenrem;
-			else if (trans_start)
-				lenrem <= lenrem - {27'h0, trans_words};
+			if (bus_rows_wr_strobe)
+				rows <= bus_rows;
+			else if (cmdq_rows_wr_strobe)
+				rows <= accel_cmdq__wr_data[15:0];
+			else if (lenrem_wr_strobe)
+				rows <= 0;
+			else if (row_done)
+				rows <= rows - 1;
+			
+			/* A row_done with one row left just retires it; only
+			 * start another if there are more to come.
+			 */
+			if (bus_lenrem_wr_strobe || cmdq_lenrem_wr_strobe) begin
+				lenrem <= bus_lenrem_wr_strobe ? bus_lenrem : accel_cmdq__wr_data[30:0];
+				beats_left <= bus_lenrem_wr_strobe ? bus_lenrem : accel_cmdq__wr_data[30:0];
+				beat_first <= 1;
+				head_mask <= 8'hFF;
+				tail_mask <= 8'hFF;
+			end else if (rows_wr_strobe || (row_done && (rows != 1))) begin
+				lenrem <= row_start_beats;
+				beats_left <= row_start_beats;
+				beat_first <= 1;
+				head_mask <= row_head_mask;
+				tail_mask <= row_tail_mask;
+			end else begin
+				if (trans_start)
+					lenrem <= lenrem - {27'h0, trans_words};
+				if (trans_beat) begin
+					beats_left <= beats_left - 1;
+					beat_first <= 0;
+				end
+			end
 			
 			if (trans_start)
 				trans_words_rem <= trans_words - 1;
@@ -124,6 +290,96 @@ module AccelClear(/*AUTOARG*/
 		end
 	end
 	
+	wire [7:0] beat_mask = (beat_first ? head_mask : 8'hFF) & ((beats_left == 1) ? tail_mask : 8'hFF);
+	
+	/*** Bitmap expansion ***/
+	/* We walk the bitmap a pixel at a time: px_col is the bitmap column
+	 * that the next pixel out comes from, and px_sub is how far across
+	 * that column's square we are; bm_row and y_sub are the same thing
+	 * going down.  A beat covers two pixels, except for the first beat
+	 * in a row, which covers only one if the row starts halfway in.
+	 */
+	reg [3:0] px_col = 0;
+	reg [3:0] px_sub = 0;
+	reg [3:0] bm_row = 0;
+	reg [3:0] y_sub = 0;
+	
+	wire       lo_skip = beat_first && !head_mask[0];
+	wire [3:0] lo_col = px_col;
+	wire [3:0] lo_sub = px_sub;
+	wire [3:0] hi_col = lo_skip ? lo_col : (lo_sub == scale - 4'd1) ? ((lo_col == 4'd8) ? lo_col : lo_col + 4'd1) : lo_col;
+	wire [3:0] hi_sub = lo_skip ? lo_sub : (lo_sub == scale - 4'd1) ? 4'd0 : lo_sub + 4'd1;
+	wire [3:0] nx_col = (hi_sub == scale - 4'd1) ? ((hi_col == 4'd8) ? hi_col : hi_col + 4'd1) : hi_col;
+	wire [3:0] nx_sub = (hi_sub == scale - 4'd1) ? 4'd0 : hi_sub + 4'd1;
+	
+	wire [7:0] bm_bits = bitmap[{bm_row[2:0], 3'b000} +: 8];
+	wire       lo_bit = !lo_col[3] && !bm_row[3] && bm_bits[3'd7 - lo_col[2:0]];
+	wire       hi_bit = !hi_col[3] && !bm_row[3] && bm_bits[3'd7 - hi_col[2:0]];
+	
+	wire [63:0] beat_data = expand ? {hi_bit ? fg : value, lo_bit ? fg : value} : {value, value};
+	wire [7:0]  beat_keep = (expand && bg_clear) ? {{4{hi_bit}}, {4{lo_bit}}} : 8'hFF;
+	
+	wire row_start = rows_wr_strobe || (row_done && (rows != 1));
+	
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			fg <= DEFAULT_FG;
+			bitmap <= 0;
+			scale <= 0;
+			bg_clear <= 0;
+			rect_mode <= 0;
+			px_col <= 0;
+			px_sub <= 0;
+			bm_row <= 0;
+			y_sub <= 0;
+		end else begin
+			if (bus_fg_wr_strobe)
+				fg <= bus_fg;
+			else if (cmdq_fg_wr_strobe)
+				fg <= accel_cmdq__wr_data;
+			
+			if (bus_bm0_wr_strobe)
+				bitmap[31:0] <= bus_bm0;
+			else if (cmdq_bm0_wr_strobe)
+				bitmap[31:0] <= accel_cmdq__wr_data;
+			
+			if (bus_bm1_wr_strobe)
+				bitmap[63:32] <= bus_bm1;
+			else if (cmdq_bm1_wr_strobe)
+				bitmap[63:32] <= accel_cmdq__wr_data;
+			
+			if (bus_expand_wr_strobe)
+				{bg_clear, scale} <= bus_expand;
+			else if (cmdq_expand_wr_strobe)
+				{bg_clear, scale} <= accel_cmdq__wr_data[4:0];
+			
+			if (lenrem_wr_strobe)
+				rect_mode <= 0;
+			else if (rows_wr_strobe)
+				rect_mode <= 1;
+			
+			if (rows_wr_strobe) begin
+				bm_row <= 0;
+				y_sub <= 0;
+			end else if (row_start) begin
+				if (y_sub == scale - 4'd1) begin
+					y_sub <= 0;
+					if (bm_row != 4'd8)
+						bm_row <= bm_row + 4'd1;
+				end else
+					y_sub <= y_sub + 4'd1;
+			end
+			
+			if (row_start) begin
+				px_col <= 0;
+				px_sub <= 0;
+			end else if (trans_beat && expand) begin
+				px_col <= nx_col;
+				px_sub <= nx_sub;
+			end
+		end
+	end
+	
 
 	always @(posedge fsabi_clk or negedge fsabi_rst_b)
 	begin
@@ -136,15 +392,15 @@ module AccelClear(/*AUTOARG*/
 			accel_clear__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
 			accel_clear__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
 			accel_clear__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
-		end else if ((trans_start || (trans_words_rem != 0)) && fsabi_rst_b) begin
+		end else if (trans_beat && fsabi_rst_b) begin
 			accel_clear__fsabo_valid <= 1;
 			accel_clear__fsabo_mode <= FSAB_WRITE;
 			accel_clear__fsabo_did <= FSAB_DID;
 			accel_clear__fsabo_subdid <= FSAB_SUBDID;
 			accel_clear__fsabo_addr <= addr;
 			accel_clear__fsabo_len <= trans_words;
-			accel_clear__fsabo_data <= {bus_value, bus_value};
-			accel_clear__fsabo_mask <= 8'hFF;
+			accel_clear__fsabo_data <= beat_data;
+			accel_clear__fsabo_mask <= beat_mask & beat_keep;
 		end else
 			accel_clear__fsabo_valid <= 0;
 	end
@@ -172,14 +428,14 @@ module AccelClear(/*AUTOARG*/
 		           // Outputs
 		           .wr_wait_cclk       (),
 		           .wr_done_strobe_cclk(wr_done_strobe_VALUE),
-		           .wr_strobe_tclk     (),
+		           .wr_strobe_tclk     (bus_value_wr_strobe),
 		           .wr_data_tclk       (bus_value[31:0]),
 		           // Inputs
 		           .cclk               (cclk),
 		           .tclk               (fsabi_clk),
 		           .rst_b_cclk         (cclk_rst_b),
 		           .rst_b_tclk         (fsabi_rst_b),
-		           .wr_strobe_cclk     (wr_decode && (spamo_addr[3:0] == 4'b0000)),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b000000)),
 		           .wr_data_cclk       (spamo_data[31:0]));
 	
 	wire wr_done_strobe_ADDR;
@@ -196,7 +452,7 @@ module AccelClear(/*AUTOARG*/
 		           .tclk               (fsabi_clk),
 		           .rst_b_cclk         (cclk_rst_b),
 		           .rst_b_tclk         (fsabi_rst_b),
-		           .wr_strobe_cclk     (wr_decode && (spamo_addr[3:0] == 4'b0100)),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b000100)),
 		           .wr_data_cclk       (spamo_data[30:0]));
 	
 	wire wr_done_strobe_LENREM;
@@ -213,9 +469,128 @@ module AccelClear(/*AUTOARG*/
 		           .tclk               (fsabi_clk),
 		           .rst_b_cclk         (cclk_rst_b),
 		           .rst_b_tclk         (fsabi_rst_b),
-		           .wr_strobe_cclk     (wr_decode && (spamo_addr[3:0] == 4'b1000)),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b001000)),
 		           .wr_data_cclk       (spamo_data[30:0]));
 
+	wire wr_done_strobe_WIDTH;
+	CSRAsyncWrite #(.WIDTH       (31),
+	                .RESET_VALUE (DEFAULT_WIDTH))
+		CSR_WIDTH (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_WIDTH),
+		           .wr_strobe_tclk     (bus_width_wr_strobe),
+		           .wr_data_tclk       (bus_width[30:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b001100)),
+		           .wr_data_cclk       (spamo_data[30:0]));
+	
+	wire wr_done_strobe_STRIDE;
+	CSRAsyncWrite #(.WIDTH       (31),
+	                .RESET_VALUE (DEFAULT_STRIDE))
+		CSR_STRIDE(/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_STRIDE),
+		           .wr_strobe_tclk     (bus_stride_wr_strobe),
+		           .wr_data_tclk       (bus_stride[30:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b010000)),
+		           .wr_data_cclk       (spamo_data[30:0]));
+	
+	wire wr_done_strobe_ROWS;
+	CSRAsyncWrite #(.WIDTH       (16),
+	                .RESET_VALUE (16'h0000))
+		CSR_ROWS  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_ROWS),
+		           .wr_strobe_tclk     (bus_rows_wr_strobe),
+		           .wr_data_tclk       (bus_rows[15:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b010100)),
+		           .wr_data_cclk       (spamo_data[15:0]));
+
+	wire wr_done_strobe_FG;
+	CSRAsyncWrite #(.WIDTH       (32),
+	                .RESET_VALUE (DEFAULT_FG))
+		CSR_FG    (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_FG),
+		           .wr_strobe_tclk     (bus_fg_wr_strobe),
+		           .wr_data_tclk       (bus_fg[31:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b011000)),
+		           .wr_data_cclk       (spamo_data[31:0]));
+	
+	wire wr_done_strobe_BM0;
+	CSRAsyncWrite #(.WIDTH       (32),
+	                .RESET_VALUE (32'h00000000))
+		CSR_BM0   (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_BM0),
+		           .wr_strobe_tclk     (bus_bm0_wr_strobe),
+		           .wr_data_tclk       (bus_bm0[31:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b011100)),
+		           .wr_data_cclk       (spamo_data[31:0]));
+	
+	wire wr_done_strobe_BM1;
+	CSRAsyncWrite #(.WIDTH       (32),
+	                .RESET_VALUE (32'h00000000))
+		CSR_BM1   (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_BM1),
+		           .wr_strobe_tclk     (bus_bm1_wr_strobe),
+		           .wr_data_tclk       (bus_bm1[31:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b100000)),
+		           .wr_data_cclk       (spamo_data[31:0]));
+	
+	wire wr_done_strobe_EXPAND;
+	CSRAsyncWrite #(.WIDTH       (5),
+	                .RESET_VALUE (5'h00))
+		CSR_EXPAND(/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_EXPAND),
+		           .wr_strobe_tclk     (bus_expand_wr_strobe),
+		           .wr_data_tclk       (bus_expand[4:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[5:0] == 6'b100100)),
+		           .wr_data_cclk       (spamo_data[4:0]));
+
 	wire [30:0] rd_data_LENREM;
 	wire rd_done_strobe_LENREM;
 	CSRAsyncRead #(.WIDTH        (31))
@@ -230,11 +605,32 @@ module AccelClear(/*AUTOARG*/
 				     .tclk		(fsabi_clk),
 				     .rst_b_cclk	(cclk_rst_b),
 				     .rst_b_tclk	(fsabi_rst_b),
-				     .rd_strobe_cclk	(rd_decode && (spamo_addr[3:0] == 4'b1000)),
+				     .rd_strobe_cclk	(rd_decode && (spamo_addr[5:0] == 6'b001000)),
 				     .rd_data_tclk	(lenrem[30:0]));
 
-	assign accel_clear__spami_busy_b = wr_done_strobe_VALUE | wr_done_strobe_ADDR | wr_done_strobe_LENREM | rd_done_strobe_LENREM;
-	assign accel_clear__spami_data = {32{rd_done_strobe_LENREM}} & {1'b0, rd_data_LENREM};
+	wire [15:0] rd_data_ROWS;
+	wire rd_done_strobe_ROWS;
+	CSRAsyncRead #(.WIDTH        (16))
+		CSR_ROWS_READ       (/* NOT AUTOINST */
+				     // Outputs
+				     .rd_data_cclk	(rd_data_ROWS),
+				     .rd_wait_cclk	(),
+				     .rd_done_strobe_cclk(rd_done_strobe_ROWS),
+				     .rd_strobe_tclk	(),
+				     // Inputs
+				     .cclk		(cclk),
+				     .tclk		(fsabi_clk),
+				     .rst_b_cclk	(cclk_rst_b),
+				     .rst_b_tclk	(fsabi_rst_b),
+				     .rd_strobe_cclk	(rd_decode && (spamo_addr[5:0] == 6'b010100)),
+				     .rd_data_tclk	(rows[15:0]));
+
+	assign accel_clear__spami_busy_b = wr_done_strobe_VALUE | wr_done_strobe_ADDR | wr_done_strobe_LENREM |
+	                                   wr_done_strobe_WIDTH | wr_done_strobe_STRIDE | wr_done_strobe_ROWS |
+	                                   wr_done_strobe_FG | wr_done_strobe_BM0 | wr_done_strobe_BM1 | wr_done_strobe_EXPAND |
+	                                   rd_done_strobe_LENREM | rd_done_strobe_ROWS;
+	assign accel_clear__spami_data = ({32{rd_done_strobe_LENREM}} & {1'b0, rd_data_LENREM}) |
+	                                 ({32{rd_done_strobe_ROWS}} & {16'h0, rd_data_ROWS});
 endmodule
 
 // Local Variables:
@@ -0,0 +1,429 @@
+/* Command queue front end for the accelerators.
+ *
+ * Software puts commands in a ring in memory, and bumps the head pointer;
+ * we fetch them from the tail, run them one at a time, and bump the tail
+ * pointer as each one finishes.  A command doesn't finish until the
+ * accelerator that it went to has sent out everything that it was going
+ * to, so commands run in order, and the ring slot is free to reuse once
+ * the tail has moved past it.
+ *
+ * Commands are 32 bytes long, and the ring must be 32-byte aligned:
+ * 00 = opcode
+ * 04 + 4n = argument n
+ *
+ * The arguments of a fill or blit are exactly the values of the
+ * accelerator's registers, in register order (so argument 0 goes to
+ * register 00, argument 1 to register 04, and so on); we write them in
+ * the order that the accelerator expects to be set up in, which is to
+ * say, with whatever starts it going written last.
+ *
+ * Opcodes:
+ * 0 = nothing
+ * 1 = fill (AccelClear: value, address, length)
+ * 2 = blit (AccelBlit: read address, rows, write address, width, write
+ *     stride, read stride, mode)
+ * 3 = wait for the start of the next vertical blank
+ * 4 = rectangle fill (AccelClear: value, address, length (ignored; should
+ *     be 0), width, stride, rows)
+ *
+ * Register mapping:
+ * 00 = ring base address
+ * 04 = ring size, in commands (a power of two); writing this resets the
+ *      head and the tail to 0
+ * 08 = head (index of the first slot that software has not filled in)
+ * 0C = tail (index of the next command to run; read-only)
+ * 10 = status: bit 0 is busy (something is queued, or running); bit 1 is
+ *      set while we wait for vblank
+ */
+
+module AccelCmdQ(/*AUTOARG*/
+   // Outputs
+   accel_cmdq__fsabo_valid, accel_cmdq__fsabo_mode,
+   accel_cmdq__fsabo_did, accel_cmdq__fsabo_subdid,
+   accel_cmdq__fsabo_addr, accel_cmdq__fsabo_len,
+   accel_cmdq__fsabo_data, accel_cmdq__fsabo_mask,
+   accel_cmdq__clear_wr, accel_cmdq__blit_wr, accel_cmdq__wr_addr,
+   accel_cmdq__wr_data, accel_cmdq__spami_busy_b,
+   accel_cmdq__spami_data,
+   // Inputs
+   accel_cmdq__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid,
+   fsabi_did, fsabi_subdid, fsabi_data, accel_clear__idle,
+   accel_blit__idle, fb__vblank, cclk, cclk_rst_b, spamo_valid,
+   spamo_r_nw, spamo_did, spamo_addr, spamo_data
+   );
+
+	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
+
+	/* FSAB interface */
+	output reg                  accel_cmdq__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  accel_cmdq__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  accel_cmdq__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  accel_cmdq__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] accel_cmdq__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  accel_cmdq__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] accel_cmdq__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] accel_cmdq__fsabo_mask = 0;
+	input                       accel_cmdq__fsabo_credit;
+
+	input                       fsabi_clk;
+	input                       fsabi_rst_b;
+	input                       fsabi_valid;
+	input      [FSAB_DID_HI:0]  fsabi_did;
+	input      [FSAB_DID_HI:0]  fsabi_subdid;
+	input      [FSAB_DATA_HI:0] fsabi_data;
+
+	/* Accelerator interface (fsabi_clk) */
+	output reg                  accel_cmdq__clear_wr = 0;
+	output reg                  accel_cmdq__blit_wr = 0;
+	output reg [7:0]            accel_cmdq__wr_addr = 0;
+	output reg [31:0]           accel_cmdq__wr_data = 0;
+	input                       accel_clear__idle;
+	input                       accel_blit__idle;
+
+	/* From the framebuffer (fbclk) */
+	input                       fb__vblank;
+
+	/* SPAM interface */
+	input cclk;
+	input cclk_rst_b;
+
+	input                       spamo_valid;
+	input                       spamo_r_nw;
+	input      [SPAM_DID_HI:0]  spamo_did;
+	input      [SPAM_ADDR_HI:0] spamo_addr;
+	input      [SPAM_DATA_HI:0] spamo_data;
+
+	output reg                  accel_cmdq__spami_busy_b = 0;
+	output reg [SPAM_DATA_HI:0] accel_cmdq__spami_data = 0;
+
+	`include "clog2.vh"
+	parameter FSAB_DID = FSAB_DID_ACCEL;
+	parameter FSAB_SUBDID = FSAB_SUBDID_ACCEL_CMDQ;
+
+	parameter SPAM_DID = SPAM_DID_ACCEL;
+	parameter SPAM_ADDRPFX = 24'h200000;
+	parameter SPAM_ADDRMASK = 24'hF00000;
+
+	parameter OP_NOP    = 4'h0;
+	parameter OP_FILL   = 4'h1;
+	parameter OP_BLIT   = 4'h2;
+	parameter OP_VBLANK = 4'h3;
+	parameter OP_RECT   = 4'h4;
+
+	/* FSAB credit availability logic */
+	wire trans_start;
+
+	reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			fsab_credits <= FSAB_INITIAL_CREDITS;
+		end else begin
+			if (accel_cmdq__fsabo_credit | trans_start) begin
+			`ifdef verilator
+				$display("ACCELCMDQ: Credits: %d (+%d, -%d)", fsab_credits, accel_cmdq__fsabo_credit, trans_start);
+			`endif
+			end
+			fsab_credits <= fsab_credits + (accel_cmdq__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+		end
+	end
+
+	/*** vblank ***/
+	/* fb__vblank comes from the pixel clock domain, and is level for
+	 * long enough that a plain synchronizer will do.
+	 */
+	reg vblank_s1 = 0, vblank_s2 = 0, vblank_s3 = 0;
+	always @(posedge fsabi_clk) begin
+		vblank_s1 <= fb__vblank;
+		vblank_s2 <= vblank_s1;
+		vblank_s3 <= vblank_s2;
+	end
+	wire vblank_start = vblank_s2 && !vblank_s3;
+
+	/*** Ring state ***/
+	parameter ST_IDLE   = 3'd0;
+	parameter ST_FETCH  = 3'd1;	/* waiting for the command to come back */
+	parameter ST_DECODE = 3'd2;
+	parameter ST_WRITE  = 3'd3;	/* setting up the accelerator */
+	parameter ST_SETTLE = 3'd4;	/* letting the accelerator get started */
+	parameter ST_RUN    = 3'd5;	/* waiting for it to finish */
+	parameter ST_VBLANK = 3'd6;
+	parameter ST_RETIRE = 3'd7;
+	reg [2:0] state = ST_IDLE;
+
+	wire        bus_strobe_base;
+	wire [30:0] bus_base;
+	wire        bus_strobe_size;
+	wire [15:0] bus_size;
+	wire        bus_strobe_head;
+	wire [15:0] bus_head;
+
+	reg [15:0] ring_mask = 0;
+	reg [15:0] head = 0;
+	reg [15:0] tail = 0;
+
+	reg [31:0] cmd [7:0];
+	reg [1:0]  cmd_beat = 0;
+
+	/* Which accelerator the command goes to, how many registers it
+	 * has, and which one we're on; we start somewhere in the middle and
+	 * wrap around, so that the last one written is the one before the
+	 * one that we started with.
+	 */
+	reg       wr_blit = 0;
+	reg [2:0] wr_nregs = 0;
+	reg [2:0] wr_n = 0;
+	reg [2:0] wr_reg = 0;
+
+	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
+	wire fetch_start = (state == ST_IDLE) && (head != tail) && fsab_credit_avail &&
+	                   !bus_strobe_base && !bus_strobe_size && !bus_strobe_head;
+	assign trans_start = fetch_start;
+
+	wire accel_idle = wr_blit ? accel_blit__idle : accel_clear__idle;
+
+	integer i;
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			state <= ST_IDLE;
+			ring_mask <= 0;
+			head <= 0;
+			tail <= 0;
+			cmd_beat <= 0;
+			for (i = 0; i < 8; i = i + 1)
+				cmd[i] <= 0;
+			wr_blit <= 0;
+			wr_nregs <= 0;
+			wr_n <= 0;
+			wr_reg <= 0;
+			accel_cmdq__clear_wr <= 0;
+			accel_cmdq__blit_wr <= 0;
+			accel_cmdq__wr_addr <= 0;
+			accel_cmdq__wr_data <= 0;
+
+			accel_cmdq__fsabo_valid <= 0;
+			accel_cmdq__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			accel_cmdq__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			accel_cmdq__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			accel_cmdq__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			accel_cmdq__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			accel_cmdq__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			accel_cmdq__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			if (bus_strobe_size) begin
+				ring_mask <= bus_size - 1;
+				head <= 0;
+				tail <= 0;
+			end else if (bus_strobe_head)
+				head <= bus_head & ring_mask;
+
+			accel_cmdq__clear_wr <= 0;
+			accel_cmdq__blit_wr <= 0;
+
+			case (state)
+			ST_IDLE:
+				if (fetch_start) begin
+					cmd_beat <= 0;
+					state <= ST_FETCH;
+				end
+			ST_FETCH:
+				if (fsabi_decode) begin
+					cmd[{cmd_beat, 1'b0}] <= fsabi_data[31:0];
+					cmd[{cmd_beat, 1'b1}] <= fsabi_data[63:32];
+					cmd_beat <= cmd_beat + 1;
+					if (cmd_beat == 2'd3)
+						state <= ST_DECODE;
+				end
+			ST_DECODE: begin
+			`ifdef verilator
+				$display("ACCELCMDQ: command %d: op %d, %08x %08x %08x %08x %08x %08x %08x",
+				         tail, cmd[0][3:0], cmd[1], cmd[2], cmd[3], cmd[4], cmd[5], cmd[6], cmd[7]);
+			`endif
+				case (cmd[0][3:0])
+				OP_FILL: begin
+					wr_blit <= 0;
+					wr_nregs <= 3'd3;
+					wr_n <= 3'd3;
+					wr_reg <= 3'd0;
+					state <= ST_WRITE;
+				end
+				OP_RECT: begin
+					wr_blit <= 0;
+					wr_nregs <= 3'd6;
+					wr_n <= 3'd6;
+					wr_reg <= 3'd0;
+					state <= ST_WRITE;
+				end
+				OP_BLIT: begin
+					wr_blit <= 1;
+					wr_nregs <= 3'd7;
+					wr_n <= 3'd7;
+					wr_reg <= 3'd2;
+					state <= ST_WRITE;
+				end
+				OP_VBLANK:
+					state <= ST_VBLANK;
+				default:
+					state <= ST_RETIRE;
+				endcase
+			end
+			ST_WRITE: begin
+				accel_cmdq__clear_wr <= !wr_blit;
+				accel_cmdq__blit_wr <= wr_blit;
+				accel_cmdq__wr_addr <= {3'b000, wr_reg, 2'b00};
+				accel_cmdq__wr_data <= cmd[{1'b0, wr_reg} + 1];
+				wr_reg <= (wr_reg == wr_nregs - 1) ? 3'd0 : (wr_reg + 1);
+				wr_n <= wr_n - 1;
+				if (wr_n == 1)
+					state <= ST_SETTLE;
+			end
+			ST_SETTLE:
+				/* The last write is on its way out this cycle, and
+				 * the accelerator sees it next cycle.
+				 */
+				state <= ST_RUN;
+			ST_RUN:
+				if (accel_idle)
+					state <= ST_RETIRE;
+			ST_VBLANK:
+				if (vblank_start)
+					state <= ST_RETIRE;
+			ST_RETIRE: begin
+				if (!bus_strobe_size)
+					tail <= (tail + 1) & ring_mask;
+				state <= ST_IDLE;
+			end
+			endcase
+
+			if (fetch_start) begin
+				accel_cmdq__fsabo_valid <= 1;
+				accel_cmdq__fsabo_mode <= FSAB_READ;
+				accel_cmdq__fsabo_did <= FSAB_DID;
+				accel_cmdq__fsabo_subdid <= FSAB_SUBDID;
+				accel_cmdq__fsabo_addr <= {bus_base[30:5], 5'b00000} + {tail, 5'b00000};
+				accel_cmdq__fsabo_len <= 4;
+				accel_cmdq__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				accel_cmdq__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end else begin
+				accel_cmdq__fsabo_valid <= 0;
+				accel_cmdq__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				accel_cmdq__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				accel_cmdq__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				accel_cmdq__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				accel_cmdq__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				accel_cmdq__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				accel_cmdq__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+		end
+	end
+
+	/* Config */
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire wr_done_strobe_BASE;
+	CSRAsyncWrite #(.WIDTH       (31),
+	                .RESET_VALUE (31'h0))
+		CSR_BASE  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_BASE),
+		           .wr_strobe_tclk     (bus_strobe_base),
+		           .wr_data_tclk       (bus_base[30:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b00000)),
+		           .wr_data_cclk       (spamo_data[30:0]));
+
+	wire wr_done_strobe_SIZE;
+	CSRAsyncWrite #(.WIDTH       (16),
+	                .RESET_VALUE (16'h0))
+		CSR_SIZE  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_SIZE),
+		           .wr_strobe_tclk     (bus_strobe_size),
+		           .wr_data_tclk       (bus_size[15:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b00100)),
+		           .wr_data_cclk       (spamo_data[15:0]));
+
+	wire wr_done_strobe_HEAD;
+	CSRAsyncWrite #(.WIDTH       (16),
+	                .RESET_VALUE (16'h0))
+		CSR_HEAD  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_HEAD),
+		           .wr_strobe_tclk     (bus_strobe_head),
+		           .wr_data_tclk       (bus_head[15:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[4:0] == 5'b01000)),
+		           .wr_data_cclk       (spamo_data[15:0]));
+
+	/* The register being read is latched on the cclk side, and held
+	 * until the next read comes along, just like in the arbiter.
+	 */
+	reg [2:0] rd_reg = 0;
+	always @(posedge cclk)
+		if (rd_decode)
+			rd_reg <= spamo_addr[4:2];
+
+	reg [31:0] rd_data;	/* combinatorial */
+	always @(*)
+		case (rd_reg)
+		3'h0: rd_data = {1'b0, bus_base};
+		3'h1: rd_data = {16'h0, ring_mask + 16'h1};
+		3'h2: rd_data = {16'h0, head};
+		3'h3: rd_data = {16'h0, tail};
+		3'h4: rd_data = {30'h0, state == ST_VBLANK, (state != ST_IDLE) || (head != tail)};
+		default: rd_data = 32'h0;
+		endcase
+
+	wire [31:0] rd_data_REG;
+	wire rd_done_strobe_REG;
+	CSRAsyncRead #(.WIDTH        (32))
+		CSR_REG_READ        (/* NOT AUTOINST */
+				     // Outputs
+				     .rd_data_cclk	(rd_data_REG),
+				     .rd_wait_cclk	(),
+				     .rd_done_strobe_cclk(rd_done_strobe_REG),
+				     .rd_strobe_tclk	(),
+				     // Inputs
+				     .cclk		(cclk),
+				     .tclk		(fsabi_clk),
+				     .rst_b_cclk	(cclk_rst_b),
+				     .rst_b_tclk	(fsabi_rst_b),
+				     .rd_strobe_cclk	(rd_decode),
+				     .rd_data_tclk	(rd_data));
+
+	always @(posedge cclk or negedge cclk_rst_b)
+		if (!cclk_rst_b) begin
+			accel_cmdq__spami_busy_b <= 0;
+			accel_cmdq__spami_data <= 0;
+		end else begin
+			accel_cmdq__spami_busy_b <= wr_done_strobe_BASE | wr_done_strobe_SIZE |
+			                            wr_done_strobe_HEAD | rd_done_strobe_REG;
+			accel_cmdq__spami_data <= {32{rd_done_strobe_REG}} & rd_data_REG;
+		end
+endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../console" "../core" "../fsab" "../spam" "../fsab/sim" "../util")
+// End:
@@ -6,6 +6,12 @@ module ACLink(
 	
 	output wire  ac97_strobe,
 	
+	/* PCM in, from the last frame; good from ac97_strobe on. */
+	output wire [19:0] ac97_in_slot3,
+	output wire  ac97_in_slot3_valid,
+	output wire [19:0] ac97_in_slot4,
+	output wire  ac97_in_slot4_valid,
+	
 	input [19:0] ac97_out_slot1,
 	input        ac97_out_slot1_valid,
 	input [19:0] ac97_out_slot2,
@@ -75,6 +81,22 @@ module ACLink(
 	always @(negedge ac97_bitclk)
 		inbits[curbit] <= ac97_sdata_in;
 	
+	/* The input comes in in the same order that the output goes out,
+	 * so slot n starts at bit 16 + 20*(n-1), msb first.
+	 */
+	wire [0:255] infr;
+	genvar b;
+	generate
+	for (b = 0; b < 256; b = b + 1) begin: inorder
+		assign infr[b] = latched_inbits[b];
+	end
+	endgenerate
+	
+	assign ac97_in_slot3_valid = infr[3];
+	assign ac97_in_slot4_valid = infr[4];
+	assign ac97_in_slot3 = infr[56:75];
+	assign ac97_in_slot4 = infr[76:95];
+	
 	/* Bit order is reversed; msb of tag sent first. */
 	wire [0:255] outbits = { /* TAG */
 	                         1'b1,
@@ -0,0 +1,116 @@
+/* IMA ADPCM decoder for the stream.
+ *
+ * Every time step is high, the nibble goes through the usual IMA
+ * predictor, and the result shows up on sample the cycle afterwards.
+ * There are no block headers: the predictor and step index start from
+ * zero on clear, and just carry on from there for as long as the stream
+ * goes on.
+ */
+
+module ADPCMDecode(/*AUTOARG*/
+   // Outputs
+   sample,
+   // Inputs
+   clk, rst_b, clear, step, nibble
+   );
+
+	input clk;
+	input rst_b;
+
+	input clear;
+	input step;
+	input [3:0] nibble;
+
+	output reg signed [15:0] sample = 0;
+
+	reg [6:0] index = 0;
+
+	function [14:0] step_size;
+		input [6:0] i;
+		case (i)
+		7'd0:  step_size = 7;     7'd1:  step_size = 8;
+		7'd2:  step_size = 9;     7'd3:  step_size = 10;
+		7'd4:  step_size = 11;    7'd5:  step_size = 12;
+		7'd6:  step_size = 13;    7'd7:  step_size = 14;
+		7'd8:  step_size = 16;    7'd9:  step_size = 17;
+		7'd10: step_size = 19;    7'd11: step_size = 21;
+		7'd12: step_size = 23;    7'd13: step_size = 25;
+		7'd14: step_size = 28;    7'd15: step_size = 31;
+		7'd16: step_size = 34;    7'd17: step_size = 37;
+		7'd18: step_size = 41;    7'd19: step_size = 45;
+		7'd20: step_size = 50;    7'd21: step_size = 55;
+		7'd22: step_size = 60;    7'd23: step_size = 66;
+		7'd24: step_size = 73;    7'd25: step_size = 80;
+		7'd26: step_size = 88;    7'd27: step_size = 97;
+		7'd28: step_size = 107;   7'd29: step_size = 118;
+		7'd30: step_size = 130;   7'd31: step_size = 143;
+		7'd32: step_size = 157;   7'd33: step_size = 173;
+		7'd34: step_size = 190;   7'd35: step_size = 209;
+		7'd36: step_size = 230;   7'd37: step_size = 253;
+		7'd38: step_size = 279;   7'd39: step_size = 307;
+		7'd40: step_size = 337;   7'd41: step_size = 371;
+		7'd42: step_size = 408;   7'd43: step_size = 449;
+		7'd44: step_size = 494;   7'd45: step_size = 544;
+		7'd46: step_size = 598;   7'd47: step_size = 658;
+		7'd48: step_size = 724;   7'd49: step_size = 796;
+		7'd50: step_size = 876;   7'd51: step_size = 963;
+		7'd52: step_size = 1060;  7'd53: step_size = 1166;
+		7'd54: step_size = 1282;  7'd55: step_size = 1411;
+		7'd56: step_size = 1552;  7'd57: step_size = 1707;
+		7'd58: step_size = 1878;  7'd59: step_size = 2066;
+		7'd60: step_size = 2272;  7'd61: step_size = 2499;
+		7'd62: step_size = 2749;  7'd63: step_size = 3024;
+		7'd64: step_size = 3327;  7'd65: step_size = 3660;
+		7'd66: step_size = 4026;  7'd67: step_size = 4428;
+		7'd68: step_size = 4871;  7'd69: step_size = 5358;
+		7'd70: step_size = 5894;  7'd71: step_size = 6484;
+		7'd72: step_size = 7132;  7'd73: step_size = 7845;
+		7'd74: step_size = 8630;  7'd75: step_size = 9493;
+		7'd76: step_size = 10442; 7'd77: step_size = 11487;
+		7'd78: step_size = 12635; 7'd79: step_size = 13899;
+		7'd80: step_size = 15289; 7'd81: step_size = 16818;
+		7'd82: step_size = 18500; 7'd83: step_size = 20350;
+		7'd84: step_size = 22385; 7'd85: step_size = 24623;
+		7'd86: step_size = 27086; 7'd87: step_size = 29794;
+		default: step_size = 32767;
+		endcase
+	endfunction
+
+	wire [14:0] ss = step_size(index);
+
+	/* diff = (nibble + 1/2) * step / 4, done the way the reference
+	 * decoder does it, so that the rounding comes out the same.
+	 */
+	wire [16:0] diff = {5'b0, ss[14:3]} +
+	                   (nibble[2] ? {2'b0, ss} : 17'h0) +
+	                   (nibble[1] ? {3'b0, ss[14:1]} : 17'h0) +
+	                   (nibble[0] ? {4'b0, ss[14:2]} : 17'h0);
+	wire signed [17:0] pred = nibble[3] ? ({sample[15], sample[15], sample} - {1'b0, diff})
+	                                    : ({sample[15], sample[15], sample} + {1'b0, diff});
+
+	wire signed [7:0] index_adj = nibble[2] ? {4'b0, nibble[1:0], 1'b0} + 8'sd2 : -8'sd1;
+	wire signed [7:0] index_next = $signed({1'b0, index}) + index_adj;
+
+	always @(posedge clk or negedge rst_b)
+		if (!rst_b) begin
+			sample <= 0;
+			index <= 0;
+		end else if (clear) begin
+			sample <= 0;
+			index <= 0;
+		end else if (step) begin
+			if (pred > 32767)
+				sample <= 16'h7FFF;
+			else if (pred < -32768)
+				sample <= 16'h8000;
+			else
+				sample <= pred[15:0];
+
+			if (index_next < 0)
+				index <= 0;
+			else if (index_next > 88)
+				index <= 88;
+			else
+				index <= index_next[6:0];
+		end
+endmodule
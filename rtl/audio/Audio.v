@@ -5,20 +5,37 @@
 `define AUDIO_PCM_VOL        24'h110
 `define AUDIO_REC_SEL        24'h114
 `define AUDIO_REC_GAIN       24'h118
+`define AUDIO_STREAM_VOL     24'h11C
+`define AUDIO_STREAM_FMT     24'h120
+
+/* Stream formats; everything is little-endian, left first, and 8-bit
+ * samples are unsigned.  ADPCM is headerless IMA, low nibble first.
+ */
+`define AUDIO_FMT_S16_STEREO 3'h0
+`define AUDIO_FMT_S16_MONO   3'h1
+`define AUDIO_FMT_U8_STEREO  3'h2
+`define AUDIO_FMT_U8_MONO    3'h3
+`define AUDIO_FMT_IMA_ADPCM  3'h4
 
 module Audio(/*AUTOARG*/
    // Outputs
    ac97_sdata_out, ac97_sync, ac97_reset_b, audio__fsabo_valid,
    audio__fsabo_mode, audio__fsabo_did, audio__fsabo_subdid,
    audio__fsabo_addr, audio__fsabo_len, audio__fsabo_data,
-   audio__fsabo_mask, audio__spami_busy_b, audio__spami_data,
+   audio__fsabo_mask, amix__fsabo_valid, amix__fsabo_mode,
+   amix__fsabo_did, amix__fsabo_subdid, amix__fsabo_addr,
+   amix__fsabo_len, amix__fsabo_data, amix__fsabo_mask,
+   acap__fsabo_valid, acap__fsabo_mode, acap__fsabo_did,
+   acap__fsabo_subdid, acap__fsabo_addr, acap__fsabo_len,
+   acap__fsabo_data, acap__fsabo_mask, audio__spami_busy_b,
+   audio__spami_data,
    // Inouts
    control_vio,
    // Inputs
    ac97_bitclk, ac97_sdata_in, fsabi_clk, fsabi_rst_b, fsabi_valid,
-   fsabi_did, fsabi_subdid, fsabi_data, audio__fsabo_credit, cclk,
-   cclk_rst_b, spamo_valid, spamo_r_nw, spamo_did, spamo_addr,
-   spamo_data
+   fsabi_did, fsabi_subdid, fsabi_data, audio__fsabo_credit,
+   amix__fsabo_credit, acap__fsabo_credit, cclk, cclk_rst_b,
+   spamo_valid, spamo_r_nw, spamo_did, spamo_addr, spamo_data
    );
 	`include "fsab_defines.vh"
 	`include "spam_defines.vh"
@@ -47,6 +64,28 @@ module Audio(/*AUTOARG*/
 	output [FSAB_MASK_HI:0] audio__fsabo_mask;
 	input audio__fsabo_credit;
 
+	/* FSAB, for the sound effect voices */
+	output amix__fsabo_valid;
+	output [FSAB_REQ_HI:0] amix__fsabo_mode;
+	output [FSAB_DID_HI:0] amix__fsabo_did;
+	output [FSAB_DID_HI:0] amix__fsabo_subdid;
+	output [FSAB_ADDR_HI:0] amix__fsabo_addr;
+	output [FSAB_LEN_HI:0] amix__fsabo_len;
+	output [FSAB_DATA_HI:0] amix__fsabo_data;
+	output [FSAB_MASK_HI:0] amix__fsabo_mask;
+	input amix__fsabo_credit;
+
+	/* FSAB, for capture */
+	output acap__fsabo_valid;
+	output [FSAB_REQ_HI:0] acap__fsabo_mode;
+	output [FSAB_DID_HI:0] acap__fsabo_did;
+	output [FSAB_DID_HI:0] acap__fsabo_subdid;
+	output [FSAB_ADDR_HI:0] acap__fsabo_addr;
+	output [FSAB_LEN_HI:0] acap__fsabo_len;
+	output [FSAB_DATA_HI:0] acap__fsabo_data;
+	output [FSAB_MASK_HI:0] acap__fsabo_mask;
+	input acap__fsabo_credit;
+
 	/* SPAM */
 	input cclk;
 	input cclk_rst_b;
@@ -77,22 +116,40 @@ module Audio(/*AUTOARG*/
 	wire        ac97_out_slot12_valid = 0;
 	wire [19:0] ac97_out_slot12 = 'h0;
 
+	`include "clog2.vh"
+	parameter VOICES = 4;		/* sound effect voices, on top of the stream */
+	parameter MIX_HI = 16 + clog2(VOICES);
+
 	/*AUTOWIRE*/
 	// Beginning of automatic wires (for undeclared instantiated-module outputs)
+	wire [19:0]	ac97_in_slot3;		// From link of ACLink.v
+	wire		ac97_in_slot3_valid;	// From link of ACLink.v
+	wire [19:0]	ac97_in_slot4;		// From link of ACLink.v
+	wire		ac97_in_slot4_valid;	// From link of ACLink.v
 	wire [19:0]	ac97_out_slot1;		// From conf of AC97Conf.v
 	wire		ac97_out_slot1_valid;	// From conf of AC97Conf.v
 	wire [19:0]	ac97_out_slot2;		// From conf of AC97Conf.v
 	wire		ac97_out_slot2_valid;	// From conf of AC97Conf.v
 	wire		ac97_strobe;		// From link of ACLink.v
+	wire		acap__spami_busy_b;	// From capture of AudioCapture.v
+	wire [SPAM_DATA_HI:0] acap__spami_data;	// From capture of AudioCapture.v
+	wire [15:0]	adpcm_sample;		// From adpcm of ADPCMDecode.v
+	wire		amix__spami_busy_b;	// From voices of AudioVoices.v
+	wire [SPAM_DATA_HI:0] amix__spami_data;	// From voices of AudioVoices.v
 	wire [63:0]	data;			// From audio_dma of SimpleDMAReadController.v
 	wire		data_ready;		// From audio_dma of SimpleDMAReadController.v
 	wire		fifo_empty;		// From audio_dma of SimpleDMAReadController.v
+	wire		mix_active;		// From voices of AudioVoices.v
+	wire [MIX_HI:0]	mix_l;			// From voices of AudioVoices.v
+	wire [MIX_HI:0]	mix_r;			// From voices of AudioVoices.v
 	// End of automatics
 
-	reg         ac97_out_slot3_valid = 0;
-	reg         ac97_out_slot4_valid = 0;
-	reg         secondhalf = 1;
-	wire        request = secondhalf && !fifo_empty && ac97_strobe;
+	reg         stream_valid = 0;
+	reg  [3:0]  pos = 4'hF;		/* which sample of the word we're on */
+	reg  [3:0]  last_pos;
+	wire        last = (pos >= last_pos);
+	wire        request = last && !fifo_empty && ac97_strobe;
+	reg         strobe_1a = 0;
 
 	wire [15:0] actrl_master_volume;
 	wire [15:0] actrl_mic_volume;
@@ -108,9 +165,20 @@ module Audio(/*AUTOARG*/
 	wire actrl_pcm_busy_b;
 	wire actrl_rec_sel_busy_b;
 	wire actrl_rec_gain_busy_b;
+	wire actrl_stream_busy_b;
+	wire [8:0] actrl_stream_volume;
+	wire actrl_fmt_busy_b;
+	wire [2:0] actrl_stream_format;
+	wire actrl_stream_format_strobe;
 	wire dmac__spami_busy_b;
+	wire [SPAM_DATA_HI:0] dmac__spami_data;
 
+	assign audio__spami_data = dmac__spami_data | amix__spami_data | acap__spami_data;
 	assign audio__spami_busy_b = dmac__spami_busy_b |
+	                             amix__spami_busy_b |
+	                             acap__spami_busy_b |
+	                             actrl_stream_busy_b |
+	                             actrl_fmt_busy_b |
 	                             actrl_master_busy_b |
 	                             actrl_mic_busy_b |
 	                             actrl_line_in_busy_b |
@@ -119,8 +187,60 @@ module Audio(/*AUTOARG*/
 	                             actrl_rec_sel_busy_b |
 	                             actrl_rec_gain_busy_b;
 
-	wire [19:0] ac97_out_slot3 = {secondhalf ? data[47:32] : data[15:0], 4'b0};
-	wire [19:0] ac97_out_slot4 = {secondhalf ? data[63:48] : data[31:16], 4'b0};
+	/* The stream gets scaled by its own volume, and then the voices get
+	 * added in; if that goes past what 16 bits can hold, it clips rather
+	 * than wrapping around.
+	 */
+	function [15:0] saturate;
+		input signed [MIX_HI+1:0] v;
+		begin
+			if (v > 32767)
+				saturate = 16'h7FFF;
+			else if (v < -32768)
+				saturate = 16'h8000;
+			else
+				saturate = v[15:0];
+		end
+	endfunction
+
+	/* Each word out of the FIFO holds 2 to 16 samples, depending on the
+	 * format, and lasts that many frames.
+	 */
+	always @(*)
+		case (actrl_stream_format)
+		`AUDIO_FMT_S16_STEREO: last_pos = 4'd1;
+		`AUDIO_FMT_S16_MONO:   last_pos = 4'd3;
+		`AUDIO_FMT_U8_STEREO:  last_pos = 4'd3;
+		`AUDIO_FMT_U8_MONO:    last_pos = 4'd7;
+		`AUDIO_FMT_IMA_ADPCM:  last_pos = 4'd15;
+		default:               last_pos = 4'd1;
+		endcase
+
+	wire [31:0] word_32 = data[{pos[0], 5'b00000} +: 32];
+	wire [15:0] word_16 = data[{pos[1:0], 4'b0000} +: 16];
+	wire [7:0]  word_8 = data[{pos[2:0], 3'b000} +: 8];
+	wire [3:0]  word_4 = data[{pos[3:0], 2'b00} +: 4];
+
+	reg signed [15:0] stream_l;
+	reg signed [15:0] stream_r;
+	always @(*)
+		case (actrl_stream_format)
+		`AUDIO_FMT_S16_STEREO: {stream_r, stream_l} = word_32;
+		`AUDIO_FMT_S16_MONO:   {stream_r, stream_l} = {word_16, word_16};
+		`AUDIO_FMT_U8_STEREO:  {stream_r, stream_l} = {word_16[15:8] ^ 8'h80, 8'h00, word_16[7:0] ^ 8'h80, 8'h00};
+		`AUDIO_FMT_U8_MONO:    {stream_r, stream_l} = {word_8 ^ 8'h80, 8'h00, word_8 ^ 8'h80, 8'h00};
+		`AUDIO_FMT_IMA_ADPCM:  {stream_r, stream_l} = {adpcm_sample, adpcm_sample};
+		default:               {stream_r, stream_l} = 32'h0;
+		endcase
+	wire signed [25:0] stream_l_scaled = stream_l * $signed({1'b0, actrl_stream_volume});
+	wire signed [25:0] stream_r_scaled = stream_r * $signed({1'b0, actrl_stream_volume});
+	wire signed [MIX_HI+1:0] out_l = (stream_valid ? $signed(stream_l_scaled[24:8]) : 0) + $signed(mix_l);
+	wire signed [MIX_HI+1:0] out_r = (stream_valid ? $signed(stream_r_scaled[24:8]) : 0) + $signed(mix_r);
+
+	wire [19:0] ac97_out_slot3 = {saturate(out_l), 4'b0};
+	wire [19:0] ac97_out_slot4 = {saturate(out_r), 4'b0};
+	wire        ac97_out_slot3_valid = stream_valid || mix_active;
+	wire        ac97_out_slot4_valid = stream_valid || mix_active;
 
 	reg core_aclk_rst_b_1 = 1;
 	reg audio_rst_b = 1;
@@ -129,31 +249,50 @@ module Audio(/*AUTOARG*/
 		audio_rst_b <= core_aclk_rst_b_1;
 	end
 
+	/* If the FIFO has run dry, check again on the next frame, rather than
+	 * waiting out a whole word's worth of silence.
+	 */
 	always @(posedge ac97_bitclk or negedge audio_rst_b) begin
 		if (!audio_rst_b) begin
-			ac97_out_slot3_valid <= 0;
-			ac97_out_slot4_valid <= 0;
-			secondhalf <= 1;
+			stream_valid <= 0;
+			pos <= 4'hF;
 		end
 		else if (ac97_strobe) begin
-			if (!secondhalf) begin
-				ac97_out_slot3_valid <= ac97_out_slot3_valid;
-				ac97_out_slot4_valid <= ac97_out_slot4_valid;
-			end
-			else begin
-				if (!fifo_empty) begin
-					ac97_out_slot3_valid <= 1;
-					ac97_out_slot4_valid <= 1;
-				end
-				else begin
-					ac97_out_slot3_valid <= 0;
-					ac97_out_slot4_valid <= 0;
-				end
-			end
-			secondhalf <= !secondhalf;
+			if (last) begin
+				stream_valid <= !fifo_empty;
+				if (!fifo_empty)
+					pos <= 0;
+			end else
+				pos <= pos + 1;
 		end
 	end
 
+	/* The new word (and the new pos) have shown up by the cycle after the
+	 * strobe; the decoded sample is ready the cycle after that, which is
+	 * long before slot 3 goes out.
+	 */
+	always @(posedge ac97_bitclk)
+		strobe_1a <= ac97_strobe;
+
+	/* ADPCMDecode AUTO_TEMPLATE(
+	                  .sample(adpcm_sample),
+	                  .clk(ac97_bitclk),
+	                  .rst_b(audio_rst_b),
+	                  .clear(actrl_stream_format_strobe),
+	                  .step(strobe_1a && stream_valid && (actrl_stream_format == `AUDIO_FMT_IMA_ADPCM)),
+	                  .nibble(word_4),
+	                  );
+	*/
+	ADPCMDecode adpcm(/*AUTOINST*/
+			  // Outputs
+			  .sample		(adpcm_sample),		 // Templated
+			  // Inputs
+			  .clk			(ac97_bitclk),		 // Templated
+			  .rst_b		(audio_rst_b),		 // Templated
+			  .clear		(actrl_stream_format_strobe), // Templated
+			  .step			(strobe_1a && stream_valid && (actrl_stream_format == `AUDIO_FMT_IMA_ADPCM)), // Templated
+			  .nibble		(word_4));		 // Templated
+
 	/* SimpleDMAReadController AUTO_TEMPLATE(
 	                        .target_clk(ac97_bitclk),
 	                        .target_rst_b(audio_rst_b),
@@ -165,9 +304,10 @@ module Audio(/*AUTOARG*/
 	                        .dmac__fsabo_len(audio__fsabo_len),
 	                        .dmac__fsabo_data(audio__fsabo_data),
 	                        .dmac__fsabo_mask(audio__fsabo_mask),
-	                        .dmac__spami_data(audio__spami_data),
+	                        .dmac__spami_data(dmac__spami_data),
 	                        .dmac__fsabo_credit(audio__fsabo_credit),
 	                        .fifo_empty(fifo_empty),
+	                        .fifo_level(),
                                 );
          */	
 	SimpleDMAReadController audio_dma(/*AUTOINST*/
@@ -183,8 +323,9 @@ module Audio(/*AUTOARG*/
 					  .data			(data[63:0]),
 					  .data_ready		(data_ready),
 					  .fifo_empty		(fifo_empty),	 // Templated
+					  .fifo_level		(),		 // Templated
 					  .dmac__spami_busy_b	(dmac__spami_busy_b),
-					  .dmac__spami_data	(audio__spami_data), // Templated
+					  .dmac__spami_data	(dmac__spami_data), // Templated
 					  // Inputs
 					  .cclk			(cclk),
 					  .cclk_rst_b		(cclk_rst_b),
@@ -209,12 +350,82 @@ module Audio(/*AUTOARG*/
 	defparam audio_dma.DEFAULT_ADDR = 31'h00000000;
 	defparam audio_dma.DEFAULT_LEN = 31'h00000000;
 	defparam audio_dma.SPAM_DID = SPAM_DID_AUDIO;
+	/* Let RING_WATERMARK through, for streaming. */
+	defparam audio_dma.SPAM_ADDRMASK = 24'hFFFFC0;
+
+	AudioVoices voices(/*AUTOINST*/
+			   // Outputs
+			   .amix__fsabo_valid	(amix__fsabo_valid),
+			   .amix__fsabo_mode	(amix__fsabo_mode[FSAB_REQ_HI:0]),
+			   .amix__fsabo_did	(amix__fsabo_did[FSAB_DID_HI:0]),
+			   .amix__fsabo_subdid	(amix__fsabo_subdid[FSAB_DID_HI:0]),
+			   .amix__fsabo_addr	(amix__fsabo_addr[FSAB_ADDR_HI:0]),
+			   .amix__fsabo_len	(amix__fsabo_len[FSAB_LEN_HI:0]),
+			   .amix__fsabo_data	(amix__fsabo_data[FSAB_DATA_HI:0]),
+			   .amix__fsabo_mask	(amix__fsabo_mask[FSAB_MASK_HI:0]),
+			   .amix__spami_busy_b	(amix__spami_busy_b),
+			   .amix__spami_data	(amix__spami_data[SPAM_DATA_HI:0]),
+			   .mix_l		(mix_l[MIX_HI:0]),
+			   .mix_r		(mix_r[MIX_HI:0]),
+			   .mix_active		(mix_active),
+			   // Inputs
+			   .amix__fsabo_credit	(amix__fsabo_credit),
+			   .fsabi_clk		(fsabi_clk),
+			   .fsabi_rst_b		(fsabi_rst_b),
+			   .fsabi_valid		(fsabi_valid),
+			   .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+			   .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+			   .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+			   .cclk		(cclk),
+			   .cclk_rst_b		(cclk_rst_b),
+			   .spamo_valid		(spamo_valid),
+			   .spamo_r_nw		(spamo_r_nw),
+			   .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+			   .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+			   .spamo_data		(spamo_data[SPAM_DATA_HI:0]),
+			   .ac97_bitclk		(ac97_bitclk),
+			   .ac97_strobe		(ac97_strobe));
+	defparam voices.VOICES = VOICES;
+
+	AudioCapture capture(/*AUTOINST*/
+			     // Outputs
+			     .acap__fsabo_valid	(acap__fsabo_valid),
+			     .acap__fsabo_mode	(acap__fsabo_mode[FSAB_REQ_HI:0]),
+			     .acap__fsabo_did	(acap__fsabo_did[FSAB_DID_HI:0]),
+			     .acap__fsabo_subdid(acap__fsabo_subdid[FSAB_DID_HI:0]),
+			     .acap__fsabo_addr	(acap__fsabo_addr[FSAB_ADDR_HI:0]),
+			     .acap__fsabo_len	(acap__fsabo_len[FSAB_LEN_HI:0]),
+			     .acap__fsabo_data	(acap__fsabo_data[FSAB_DATA_HI:0]),
+			     .acap__fsabo_mask	(acap__fsabo_mask[FSAB_MASK_HI:0]),
+			     .acap__spami_busy_b(acap__spami_busy_b),
+			     .acap__spami_data	(acap__spami_data[SPAM_DATA_HI:0]),
+			     // Inputs
+			     .acap__fsabo_credit(acap__fsabo_credit),
+			     .fsabi_clk		(fsabi_clk),
+			     .fsabi_rst_b	(fsabi_rst_b),
+			     .cclk		(cclk),
+			     .cclk_rst_b	(cclk_rst_b),
+			     .spamo_valid	(spamo_valid),
+			     .spamo_r_nw	(spamo_r_nw),
+			     .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+			     .spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
+			     .spamo_data	(spamo_data[SPAM_DATA_HI:0]),
+			     .ac97_bitclk	(ac97_bitclk),
+			     .ac97_strobe	(ac97_strobe),
+			     .ac97_in_slot3	(ac97_in_slot3[19:0]),
+			     .ac97_in_slot3_valid(ac97_in_slot3_valid),
+			     .ac97_in_slot4	(ac97_in_slot4[19:0]),
+			     .ac97_in_slot4_valid(ac97_in_slot4_valid));
 
 	ACLink link(/*AUTOINST*/
 		    // Outputs
 		    .ac97_sdata_out	(ac97_sdata_out),
 		    .ac97_sync		(ac97_sync),
 		    .ac97_strobe	(ac97_strobe),
+		    .ac97_in_slot3	(ac97_in_slot3[19:0]),
+		    .ac97_in_slot3_valid(ac97_in_slot3_valid),
+		    .ac97_in_slot4	(ac97_in_slot4[19:0]),
+		    .ac97_in_slot4_valid(ac97_in_slot4_valid),
 		    // Inputs
 		    .ac97_bitclk	(ac97_bitclk),
 		    .ac97_sdata_in	(ac97_sdata_in),
@@ -349,6 +560,41 @@ module Audio(/*AUTOARG*/
 	                .wr_strobe_cclk     (spam_wr && (spamo_addr == `AUDIO_PCM_VOL)),
 	                .wr_data_cclk       (spamo_data[15:0]));
 
+	CSRAsyncWrite #(.WIDTH       (9),
+	                .RESET_VALUE (9'h100))
+	stream_reg     (/* NOT AUTOINST */
+	                // Outputs
+	                .wr_wait_cclk       (),
+	                .wr_done_strobe_cclk(actrl_stream_busy_b),
+	                .wr_strobe_tclk     (),
+	                .wr_data_tclk       (actrl_stream_volume),
+	                // Inputs
+	                .cclk               (cclk),
+	                .tclk               (ac97_bitclk),
+	                .rst_b_cclk         (cclk_rst_b),
+	                .rst_b_tclk         (audio_rst_b),
+	                .wr_strobe_cclk     (spam_wr && (spamo_addr == `AUDIO_STREAM_VOL)),
+	                .wr_data_cclk       (spamo_data[8:0]));
+
+	/* Writing the format (even the same one again) also starts the
+	 * ADPCM predictor over, so do it before each new stream.
+	 */
+	CSRAsyncWrite #(.WIDTH       (3),
+	                .RESET_VALUE (`AUDIO_FMT_S16_STEREO))
+	fmt_reg        (/* NOT AUTOINST */
+	                // Outputs
+	                .wr_wait_cclk       (),
+	                .wr_done_strobe_cclk(actrl_fmt_busy_b),
+	                .wr_strobe_tclk     (actrl_stream_format_strobe),
+	                .wr_data_tclk       (actrl_stream_format),
+	                // Inputs
+	                .cclk               (cclk),
+	                .tclk               (ac97_bitclk),
+	                .rst_b_cclk         (cclk_rst_b),
+	                .rst_b_tclk         (audio_rst_b),
+	                .wr_strobe_cclk     (spam_wr && (spamo_addr == `AUDIO_STREAM_FMT)),
+	                .wr_data_cclk       (spamo_data[2:0]));
+
 	CSRAsyncWrite #(.WIDTH       (16),
 	                .RESET_VALUE (16'h0000))
 	rec_sel_reg    (/* NOT AUTOINST */
@@ -397,7 +643,7 @@ module Audio(/*AUTOARG*/
 			.TRIG0({0, ac97_sdata_out, ac97_sync, ac97_reset_b, ac97_strobe, ac97_sdata_in,
 			        ac97_out_slot1[19:0], ac97_out_slot1_valid, ac97_out_slot2[19:0], ac97_out_slot2_valid,
 			        ac97_out_slot3[19:0], ac97_out_slot3_valid, ac97_out_slot4[19:0], ac97_out_slot4_valid,
-			        secondhalf, request, data[63:0], data_ready, fifo_empty,
+			        pos[3:0], request, data[63:0], data_ready, fifo_empty,
 			        actrl_master_volume[15:0], actrl_pcm_volume[15:0]})
 		);
 
@@ -0,0 +1,323 @@
+/* PCM-in capture for Audio.
+ *
+ * Samples that come in from the codec get written out to a ring in
+ * memory, in the same format as the stream (16-bit signed stereo, left
+ * first); the registers live at 0x300 in Audio's SPAM space:
+ * 300 = start of the ring (64-byte aligned)
+ * 304 = length of the ring, in bytes (a multiple of 64)
+ * 308 = control: bit 0 starts capturing at the start of the ring (0
+ *       stops)
+ * 30C = write pointer (read only): offset into the ring of the next
+ *       block to be written; everything up to it has gone out
+ * 310 = count (read only): bytes written since capture started, so that
+ *       software can tell if it fell more than a ring behind
+ *
+ * Samples get paired up into words on the AC'97 side, and each word
+ * comes over to fsabi_clk on a toggle (there are hundreds of cycles
+ * between them, so the word itself has long since settled).  Once a
+ * whole block has piled up, it goes out as one 8-beat write.  If memory
+ * can't keep up with that, words get dropped rather than written late.
+ */
+
+module AudioCapture(/*AUTOARG*/
+   // Outputs
+   acap__fsabo_valid, acap__fsabo_mode, acap__fsabo_did,
+   acap__fsabo_subdid, acap__fsabo_addr, acap__fsabo_len,
+   acap__fsabo_data, acap__fsabo_mask, acap__spami_busy_b,
+   acap__spami_data,
+   // Inputs
+   acap__fsabo_credit, fsabi_clk, fsabi_rst_b, cclk, cclk_rst_b,
+   spamo_valid, spamo_r_nw, spamo_did, spamo_addr, spamo_data,
+   ac97_bitclk, ac97_strobe, ac97_in_slot3, ac97_in_slot3_valid,
+   ac97_in_slot4, ac97_in_slot4_valid
+   );
+
+	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
+	`include "clog2.vh"
+
+	/* FSAB interface */
+	output reg                  acap__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  acap__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  acap__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  acap__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] acap__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  acap__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] acap__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] acap__fsabo_mask = 0;
+	input                       acap__fsabo_credit;
+
+	input                       fsabi_clk;
+	input                       fsabi_rst_b;
+
+	/* SPAM interface */
+	input cclk;
+	input cclk_rst_b;
+
+	input                       spamo_valid;
+	input                       spamo_r_nw;
+	input      [SPAM_DID_HI:0]  spamo_did;
+	input      [SPAM_ADDR_HI:0] spamo_addr;
+	input      [SPAM_DATA_HI:0] spamo_data;
+
+	output wire                 acap__spami_busy_b;
+	output reg [SPAM_DATA_HI:0] acap__spami_data;
+
+	/* AC'97 side */
+	input                       ac97_bitclk;
+	input                       ac97_strobe;
+	input      [19:0]           ac97_in_slot3;
+	input                       ac97_in_slot3_valid;
+	input      [19:0]           ac97_in_slot4;
+	input                       ac97_in_slot4_valid;
+
+	parameter FSAB_DID = FSAB_DID_AUDIO;
+	parameter FSAB_SUBDID = FSAB_SUBDID_AUDIO_CAPTURE;
+
+	parameter SPAM_DID = SPAM_DID_AUDIO;
+	parameter SPAM_ADDRPFX = 24'h000300;
+	parameter SPAM_ADDRMASK = 24'hFFFF00;
+	parameter SPAM_WPTR_ADDR = 24'h00030C;
+	parameter SPAM_COUNT_ADDR = 24'h000310;
+
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+
+	/* FSAB credit availability logic */
+	wire trans_start;
+
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge fsabi_clk or negedge fsabi_rst_b)
+		if (!fsabi_rst_b)
+			fsab_credits <= CREDITS;
+		else
+			fsab_credits <= fsab_credits + (acap__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+
+	/*** Registers ***/
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw && (spamo_did == SPAM_DID);
+
+	wire bus_strobe;
+	wire [7:0] bus_addr;
+	wire [31:0] bus_data;
+	wire wr_done_strobe_CAPTURE;
+
+	CSRAsyncWrite #(.WIDTH       (40),
+	                .RESET_VALUE (40'h0))
+		CSR_CAPTURE(/* NOT AUTOINST */
+		            // Outputs
+		            .wr_wait_cclk       (),
+		            .wr_done_strobe_cclk(wr_done_strobe_CAPTURE),
+		            .wr_strobe_tclk     (bus_strobe),
+		            .wr_data_tclk       ({bus_addr, bus_data}),
+		            // Inputs
+		            .cclk               (cclk),
+		            .tclk               (fsabi_clk),
+		            .rst_b_cclk         (cclk_rst_b),
+		            .rst_b_tclk         (fsabi_rst_b),
+		            .wr_strobe_cclk     (wr_decode),
+		            .wr_data_cclk       ({spamo_addr[7:0], spamo_data}));
+
+	reg [30:0] start = 0;
+	reg [30:0] len = 0;
+	reg        on = 0;
+	reg [30:0] off = 0;
+	reg [30:0] count = 0;
+
+	wire [30:0] off_cclk;
+	wire [30:0] count_cclk;
+	wire rd_done_strobe_WPTR;
+	wire rd_done_strobe_COUNT;
+
+	CSRAsyncRead #(.WIDTH        (31))
+		CSR_WPTR (/* NOT AUTOINST */
+		          // Outputs
+		          .rd_data_cclk       (off_cclk),
+		          .rd_wait_cclk       (),
+		          .rd_done_strobe_cclk(rd_done_strobe_WPTR),
+		          .rd_strobe_tclk     (),
+		          // Inputs
+		          .cclk               (cclk),
+		          .tclk               (fsabi_clk),
+		          .rst_b_cclk         (cclk_rst_b),
+		          .rst_b_tclk         (fsabi_rst_b),
+		          .rd_strobe_cclk     (rd_decode && (spamo_addr == SPAM_WPTR_ADDR)),
+		          .rd_data_tclk       (off));
+
+	CSRAsyncRead #(.WIDTH        (31))
+		CSR_COUNT (/* NOT AUTOINST */
+		           // Outputs
+		           .rd_data_cclk       (count_cclk),
+		           .rd_wait_cclk       (),
+		           .rd_done_strobe_cclk(rd_done_strobe_COUNT),
+		           .rd_strobe_tclk     (),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .rd_strobe_cclk     (rd_decode && (spamo_addr == SPAM_COUNT_ADDR)),
+		           .rd_data_tclk       (count));
+
+	always @(*)
+		if (rd_done_strobe_WPTR)
+			acap__spami_data = {1'b0, off_cclk};
+		else if (rd_done_strobe_COUNT)
+			acap__spami_data = {1'b0, count_cclk};
+		else
+			acap__spami_data = {(SPAM_DATA_HI+1){1'b0}};
+
+	assign acap__spami_busy_b = wr_done_strobe_CAPTURE | rd_done_strobe_WPTR | rd_done_strobe_COUNT;
+
+	/*** AC'97 side ***/
+	reg on_s1 = 0, on_aclk = 0;
+	reg        half = 0;
+	reg [31:0] lo = 0;
+	reg [63:0] word = 0;
+	reg        word_tgl = 0;
+
+	always @(posedge ac97_bitclk) begin
+		on_s1 <= on;
+		on_aclk <= on_s1;
+
+		if (!on_aclk)
+			half <= 0;
+		else if (ac97_strobe && (ac97_in_slot3_valid || ac97_in_slot4_valid)) begin
+			if (!half)
+				lo <= {ac97_in_slot4_valid ? ac97_in_slot4[19:4] : 16'h0,
+				       ac97_in_slot3_valid ? ac97_in_slot3[19:4] : 16'h0};
+			else begin
+				word <= {ac97_in_slot4_valid ? ac97_in_slot4[19:4] : 16'h0,
+				         ac97_in_slot3_valid ? ac97_in_slot3[19:4] : 16'h0,
+				         lo};
+				word_tgl <= ~word_tgl;
+			end
+			half <= ~half;
+		end
+	end
+
+	/*** fsabi_clk side ***/
+	reg word_tgl_s1 = 0, word_tgl_s2 = 0, word_tgl_1a = 0;
+	always @(posedge fsabi_clk) begin
+		word_tgl_s1 <= word_tgl;
+		word_tgl_s2 <= word_tgl_s1;
+		word_tgl_1a <= word_tgl_s2;
+	end
+	wire word_go = word_tgl_s2 != word_tgl_1a;
+
+	/* Two blocks' worth, so that one can fill while the other goes out. */
+	reg [63:0] blk [15:0];
+	reg [3:0]  wpos = 0;
+	reg [3:0]  rpos = 0;
+	wire [3:0] avail = wpos - rpos;	/* never 16; see below */
+	reg        sending = 0;
+	reg [2:0]  beat = 0;
+	reg        ctrl_pend = 0;	/* new control write waiting for the block to finish */
+	reg        ctrl_on = 0;
+
+	assign trans_start = on && !sending && !ctrl_pend && (avail >= 8) && fsab_credit_avail;
+	wire       trans_beat = trans_start || sending;
+	wire [2:0] cur_beat = trans_start ? 3'd0 : beat;
+
+	always @(posedge fsabi_clk)
+		if (word_go && on && (wpos + 4'd1 != rpos))
+			blk[wpos] <= word;
+
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			start <= 0;
+			len <= 0;
+			on <= 0;
+			off <= 0;
+			count <= 0;
+			wpos <= 0;
+			rpos <= 0;
+			sending <= 0;
+			beat <= 0;
+			ctrl_pend <= 0;
+			ctrl_on <= 0;
+
+			acap__fsabo_valid <= 0;
+			acap__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			acap__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			acap__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			acap__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			acap__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			acap__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			acap__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			/* Settings */
+			if (bus_strobe)
+				case (bus_addr)
+				8'h00: start <= {bus_data[30:6], 6'b000000};
+				8'h04: len <= {bus_data[30:6], 6'b000000};
+				8'h08: begin
+					ctrl_pend <= 1;
+					ctrl_on <= bus_data[0];
+				end
+				default: begin end
+				endcase
+
+			/* The last block goes out in full before anything
+			 * changes.
+			 */
+			if (ctrl_pend && !sending && !bus_strobe) begin
+				ctrl_pend <= 0;
+				on <= ctrl_on;
+				if (ctrl_on) begin
+					off <= 0;
+					count <= 0;
+					wpos <= 0;
+					rpos <= 0;
+				end
+			end else begin
+				/* Keep one slot empty, so that full and empty
+				 * look different.
+				 */
+				if (word_go && on && (wpos + 4'd1 != rpos))
+					wpos <= wpos + 4'd1;
+
+				if (trans_start) begin
+					sending <= 1;
+					beat <= 1;
+				end else if (sending) begin
+					beat <= beat + 1;
+					if (beat == 7) begin
+						sending <= 0;
+						rpos <= rpos + 4'd8;
+						off <= (off + 64 == len) ? 31'h0 : (off + 64);
+						count <= count + 64;
+					end
+				end
+			end
+
+			if (trans_beat) begin
+				acap__fsabo_valid <= 1;
+				acap__fsabo_mode <= FSAB_WRITE;
+				acap__fsabo_did <= FSAB_DID;
+				acap__fsabo_subdid <= FSAB_SUBDID;
+				acap__fsabo_addr <= start + off;
+				acap__fsabo_len <= 'h8;
+				acap__fsabo_data <= blk[rpos + {1'b0, cur_beat}];
+				acap__fsabo_mask <= 8'hFF;
+			end else begin
+				acap__fsabo_valid <= 0;
+				acap__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				acap__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				acap__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				acap__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				acap__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				acap__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				acap__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+		end
+	end
+
+endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../fsab" "../spam" "../util")
+// End:
@@ -0,0 +1,402 @@
+/* Sound effect voices for Audio.
+ *
+ * Each voice plays a buffer of samples, in the same format as the main
+ * stream (16-bit signed stereo, left first), out of memory on its own; its
+ * registers live at 0x200 + n*0x10 in Audio's SPAM space:
+ * 00 = address of the first sample (64-byte aligned)
+ * 04 = length, in bytes (a multiple of 64)
+ * 08 = volume, in bits 8:0; 0x100 is unity
+ * 0C = control: bit 0 starts the voice from the top (0 stops it), and
+ *      bit 1 makes it loop instead of stopping at the end
+ * and 0x2F0 reads back which voices are still playing.
+ *
+ * Everything happens on fsabi_clk.  Each voice has a little FIFO, which
+ * gets topped up a burst at a time; once a sample, the AC'97 side flips
+ * a toggle, and we walk through the voices, popping a sample off of
+ * each, scaling it, and adding it up.  The sum comes back over to the
+ * AC'97 side at the next frame, long after it has settled, and Audio
+ * mixes it in with the stream.  A voice that runs dry just sits out
+ * until the next burst comes in.
+ */
+
+module AudioVoices(/*AUTOARG*/
+   // Outputs
+   amix__fsabo_valid, amix__fsabo_mode, amix__fsabo_did,
+   amix__fsabo_subdid, amix__fsabo_addr, amix__fsabo_len,
+   amix__fsabo_data, amix__fsabo_mask, amix__spami_busy_b,
+   amix__spami_data, mix_l, mix_r, mix_active,
+   // Inputs
+   amix__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid, fsabi_did,
+   fsabi_subdid, fsabi_data, cclk, cclk_rst_b, spamo_valid, spamo_r_nw,
+   spamo_did, spamo_addr, spamo_data, ac97_bitclk, ac97_strobe
+   );
+
+	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
+	`include "clog2.vh"
+
+	parameter VOICES = 4;		/* at least 2, at most 8 */
+	parameter MIX_HI = 16 + clog2(VOICES);
+
+	/* FSAB interface */
+	output reg                  amix__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  amix__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  amix__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  amix__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] amix__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  amix__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] amix__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] amix__fsabo_mask = 0;
+	input                       amix__fsabo_credit;
+
+	input                       fsabi_clk;
+	input                       fsabi_rst_b;
+	input                       fsabi_valid;
+	input      [FSAB_DID_HI:0]  fsabi_did;
+	input      [FSAB_DID_HI:0]  fsabi_subdid;
+	input      [FSAB_DATA_HI:0] fsabi_data;
+
+	/* SPAM interface */
+	input cclk;
+	input cclk_rst_b;
+
+	input                       spamo_valid;
+	input                       spamo_r_nw;
+	input      [SPAM_DID_HI:0]  spamo_did;
+	input      [SPAM_ADDR_HI:0] spamo_addr;
+	input      [SPAM_DATA_HI:0] spamo_data;
+
+	output wire                 amix__spami_busy_b;
+	output reg [SPAM_DATA_HI:0] amix__spami_data;
+
+	/* AC'97 side */
+	input                       ac97_bitclk;
+	input                       ac97_strobe;	/* once a frame */
+	output reg signed [MIX_HI:0] mix_l = 0;
+	output reg signed [MIX_HI:0] mix_r = 0;
+	output reg                  mix_active = 0;
+
+	parameter FSAB_DID = FSAB_DID_AUDIO;
+	parameter FSAB_SUBDID = FSAB_SUBDID_AUDIO_VOICES;
+
+	parameter SPAM_DID = SPAM_DID_AUDIO;
+	parameter SPAM_ADDRPFX = 24'h000200;
+	parameter SPAM_ADDRMASK = 24'hFFFF00;
+	parameter SPAM_STATUS_ADDR = 24'h0002F0;
+
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+
+	parameter VOICE_HI = clog2(VOICES - 1) - 1;
+	parameter VFIFO_DEPTH = 16;	/* words; two bursts */
+	parameter VFIFO_HI = clog2(VFIFO_DEPTH - 1) - 1;
+
+	/* FSAB credit availability logic */
+	wire trans_start;
+
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge fsabi_clk or negedge fsabi_rst_b)
+		if (!fsabi_rst_b)
+			fsab_credits <= CREDITS;
+		else
+			fsab_credits <= fsab_credits + (amix__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+
+	/*** Registers ***/
+	/* Just like the sprites: everything comes across together, and only
+	 * gets looked at in fsabi_clk.
+	 */
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 (spamo_addr == SPAM_STATUS_ADDR) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire bus_strobe;
+	wire [7:0] bus_addr;
+	wire [31:0] bus_data;
+	wire wr_done_strobe_VOICES;
+
+	CSRAsyncWrite #(.WIDTH       (40),
+	                .RESET_VALUE (40'h0))
+		CSR_VOICES(/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_VOICES),
+		           .wr_strobe_tclk     (bus_strobe),
+		           .wr_data_tclk       ({bus_addr, bus_data}),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode),
+		           .wr_data_cclk       ({spamo_addr[7:0], spamo_data}));
+
+	reg [VOICES-1:0] v_on = 0;
+	wire [VOICES-1:0] status_cclk;
+	wire rd_done_strobe_STATUS;
+
+	CSRAsyncRead #(.WIDTH        (VOICES))
+		CSR_STATUS (/* NOT AUTOINST */
+		            // Outputs
+		            .rd_data_cclk       (status_cclk),
+		            .rd_wait_cclk       (),
+		            .rd_done_strobe_cclk(rd_done_strobe_STATUS),
+		            .rd_strobe_tclk     (),
+		            // Inputs
+		            .cclk               (cclk),
+		            .tclk               (fsabi_clk),
+		            .rst_b_cclk         (cclk_rst_b),
+		            .rst_b_tclk         (fsabi_rst_b),
+		            .rd_strobe_cclk     (rd_decode),
+		            .rd_data_tclk       (v_on));
+
+	always @(*)
+		if (rd_done_strobe_STATUS)
+			amix__spami_data = {{(SPAM_DATA_HI+1-VOICES){1'b0}}, status_cclk};
+		else
+			amix__spami_data = {(SPAM_DATA_HI+1){1'b0}};
+
+	assign amix__spami_busy_b = wr_done_strobe_VOICES | rd_done_strobe_STATUS;
+
+	/*** Voice state ***/
+	reg [30:0]       v_addr    [VOICES-1:0];
+	reg [30:0]       v_len     [VOICES-1:0];
+	reg [8:0]        v_vol     [VOICES-1:0];
+	reg [VOICES-1:0] v_loop = 0;
+	reg [VOICES-1:0] v_restart = 0;	/* waiting for a burst to land first */
+	reg [30:0]       v_fetch   [VOICES-1:0];	/* bytes asked for so far */
+	reg [VFIFO_HI+1:0] v_words [VOICES-1:0];
+	reg [VFIFO_HI:0] v_wpos    [VOICES-1:0];
+	reg [VFIFO_HI:0] v_rpos    [VOICES-1:0];
+	reg [VOICES-1:0] v_half = 0;	/* next sample is the top half of the word */
+
+	reg [63:0] vfifo [VOICES*VFIFO_DEPTH-1:0];
+
+	function [VOICE_HI:0] first_set;
+		input [VOICES-1:0] m;
+		integer k;
+		begin
+			first_set = 0;
+			for (k = VOICES-1; k >= 0; k = k - 1)
+				if (m[k])
+					first_set = k;
+		end
+	endfunction
+
+	/*** Fetch ***/
+	/* Only one burst goes out at a time; even with every voice going,
+	 * that's far more than we need.
+	 */
+	reg              r_pend = 0;
+	reg [VOICE_HI:0] r_voice = 0;
+	reg [2:0]        r_beat = 0;
+
+	reg [VOICES-1:0] want;	/* combinatorial */
+	integer w;
+	always @(*)
+		for (w = 0; w < VOICES; w = w + 1)
+			want[w] = v_on[w] && !v_restart[w] && (v_fetch[w] != v_len[w]) &&
+			          (v_words[w] <= (VFIFO_DEPTH - 8));
+
+	wire [VOICE_HI:0] f_cur = first_set(want);
+	assign trans_start = !r_pend && (want != 0) && fsab_credit_avail;
+
+	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
+
+	/*** Mixing ***/
+	reg tick_tgl = 0;
+	always @(posedge ac97_bitclk)
+		if (ac97_strobe)
+			tick_tgl <= ~tick_tgl;
+
+	reg tick_tgl_s1 = 0, tick_tgl_s2 = 0, tick_tgl_1a = 0;
+	always @(posedge fsabi_clk) begin
+		tick_tgl_s1 <= tick_tgl;
+		tick_tgl_s2 <= tick_tgl_s1;
+		tick_tgl_1a <= tick_tgl_s2;
+	end
+	wire tick = tick_tgl_s2 != tick_tgl_1a;
+
+	reg              m_busy = 0;
+	reg [VOICE_HI:0] m_v = 0;
+	reg              m_any = 0;
+	reg signed [MIX_HI:0] acc_l = 0, acc_r = 0;
+	reg signed [MIX_HI:0] sum_l = 0, sum_r = 0;	/* the last finished sample */
+	reg              sum_active = 0;
+
+	wire [63:0] m_word = vfifo[{m_v, v_rpos[m_v]}];
+	wire signed [15:0] m_l = v_half[m_v] ? m_word[47:32] : m_word[15:0];
+	wire signed [15:0] m_r = v_half[m_v] ? m_word[63:48] : m_word[31:16];
+	wire signed [25:0] m_l_scaled = m_l * $signed({1'b0, v_vol[m_v]});
+	wire signed [25:0] m_r_scaled = m_r * $signed({1'b0, v_vol[m_v]});
+	wire m_has = v_on[m_v] && !v_restart[m_v] && (v_words[m_v] != 0);
+	wire m_pop = m_busy && m_has && v_half[m_v];
+	wire signed [MIX_HI:0] acc_l_next = m_has ? (acc_l + $signed(m_l_scaled[24:8])) : acc_l;
+	wire signed [MIX_HI:0] acc_r_next = m_has ? (acc_r + $signed(m_r_scaled[24:8])) : acc_r;
+
+	always @(posedge ac97_bitclk)
+		if (ac97_strobe) begin
+			mix_l <= sum_l;
+			mix_r <= sum_r;
+			mix_active <= sum_active;
+		end
+
+	always @(posedge fsabi_clk)
+		if (fsabi_decode)
+			vfifo[{r_voice, v_wpos[r_voice]}] <= fsabi_data;
+
+	integer i;
+	reg bus_voice;	/* temporaries */
+	reg fill;
+	reg pop;
+
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			for (i = 0; i < VOICES; i = i + 1) begin
+				v_len[i] <= 0;
+				v_vol[i] <= 9'h100;
+				v_fetch[i] <= 0;
+				v_words[i] <= 0;
+				v_wpos[i] <= 0;
+				v_rpos[i] <= 0;
+			end
+			v_on <= 0;
+			v_loop <= 0;
+			v_restart <= 0;
+			v_half <= 0;
+			r_pend <= 0;
+			r_beat <= 0;
+			m_busy <= 0;
+			sum_l <= 0;
+			sum_r <= 0;
+			sum_active <= 0;
+
+			amix__fsabo_valid <= 0;
+			amix__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			amix__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			amix__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			amix__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			amix__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			amix__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			amix__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			for (i = 0; i < VOICES; i = i + 1) begin
+				bus_voice = bus_strobe && (bus_addr[7:4] == i);
+				fill = fsabi_decode && (r_voice == i);
+				pop = m_pop && (m_v == i);
+
+				if (v_restart[i] && !(r_pend && (r_voice == i))) begin
+					/* Nothing more is on its way in, so it's
+					 * safe to throw out what's in the FIFO.
+					 */
+					v_restart[i] <= 0;
+					v_on[i] <= 1;
+					v_fetch[i] <= 0;
+					v_words[i] <= 0;
+					v_wpos[i] <= 0;
+					v_rpos[i] <= 0;
+					v_half[i] <= 0;
+				end else begin
+					if (trans_start && (f_cur == i)) begin
+						if (v_loop[i] && (v_fetch[i] + 64 == v_len[i]))
+							v_fetch[i] <= 0;
+						else
+							v_fetch[i] <= v_fetch[i] + 64;
+					end
+
+					if (fill)
+						v_wpos[i] <= v_wpos[i] + 1;
+					if (pop)
+						v_rpos[i] <= v_rpos[i] + 1;
+					/* verilator lint_off WIDTH */
+					v_words[i] <= v_words[i] + fill - pop;
+					/* verilator lint_on WIDTH */
+					if (m_busy && m_has && (m_v == i))
+						v_half[i] <= ~v_half[i];
+
+					/* A voice that isn't looping is done once it has
+					 * all come in and been played.
+					 */
+					if (m_busy && (m_v == i) && v_on[i] && !m_has &&
+					    (v_fetch[i] == v_len[i]) && !(r_pend && (r_voice == i)))
+						v_on[i] <= 0;
+				end
+
+				/* Settings go last, so that a new control write
+				 * wins over anything above.
+				 */
+				if (bus_voice)
+					case (bus_addr[3:0])
+					4'h0: v_addr[i] <= {bus_data[30:6], 6'b000000};
+					4'h4: v_len[i] <= {bus_data[30:6], 6'b000000};
+					4'h8: v_vol[i] <= bus_data[8:0];
+					4'hC: begin
+						v_on[i] <= 0;
+						v_loop[i] <= bus_data[1];
+						v_restart[i] <= bus_data[0];
+					end
+					default: begin end
+					endcase
+			end
+
+			/*** Fetch ***/
+			if (trans_start) begin
+				r_pend <= 1;
+				r_voice <= f_cur;
+				r_beat <= 0;
+			end else if (fsabi_decode) begin
+				r_beat <= r_beat + 1;
+				if (r_beat == 7)
+					r_pend <= 0;
+			end
+
+			if (trans_start) begin
+				amix__fsabo_valid <= 1;
+				amix__fsabo_mode <= FSAB_READ;
+				amix__fsabo_did <= FSAB_DID;
+				amix__fsabo_subdid <= FSAB_SUBDID;
+				amix__fsabo_addr <= v_addr[f_cur] + v_fetch[f_cur];
+				amix__fsabo_len <= 'h8;
+				amix__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				amix__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end else begin
+				amix__fsabo_valid <= 0;
+				amix__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				amix__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				amix__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				amix__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				amix__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				amix__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				amix__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+
+			/*** Mix ***/
+			if (tick) begin
+				m_busy <= 1;
+				m_v <= 0;
+				m_any <= 0;
+				acc_l <= 0;
+				acc_r <= 0;
+			end else if (m_busy) begin
+				m_v <= m_v + 1;
+				acc_l <= acc_l_next;
+				acc_r <= acc_r_next;
+				m_any <= m_any || m_has;
+				if (m_v == (VOICES - 1)) begin
+					m_busy <= 0;
+					sum_l <= acc_l_next;
+					sum_r <= acc_r_next;
+					sum_active <= m_any || m_has;
+				end
+			end
+		end
+	end
+
+endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../fsab" "../spam" "../util")
+// End:
@@ -0,0 +1,393 @@
+/* Hardware sprites for the Framebuffer.
+ *
+ * Each sprite has its own registers, at 0x100 + n*0x20 in the
+ * Framebuffer's SPAM space:
+ * 00 = address of the top left pixel (8-byte aligned)
+ * 04 = position: x in bits 11:0, y in bits 27:16; both are two's
+ *      complement, so a sprite can hang off the top or the left
+ * 08 = size: width in bits 11:0 (at most SPRITE_W_MAX pixels; anything
+ *      past that is cut off), height in bits 27:16; a sprite with no
+ *      width or no height is off
+ * 0C = stride from one row to the next, in bytes (8-byte aligned)
+ * 10 = mode, which works just like AccelBlit's: bits 1:0 pick which
+ *      pixels get shown (0 = alpha of at least bits 15:8, 1 = all of them,
+ *      2 = colour isn't bits 31:8), and bit 2 puts the alpha in bits 31:24
+ *
+ * While one line goes out, the rows of every sprite that's on the next
+ * line get read into one half of a double buffer; the position, size and
+ * mode get latched at the same time, so changes show up at the start of a
+ * line.  The lowest-numbered sprite ends up on top.  If the reads for a
+ * line haven't finished by the time the next one starts, the sprites are
+ * left off of the line after that, rather than fetched late.
+ */
+
+module FBSprites(/*AUTOARG*/
+   // Outputs
+   fbspr__fsabo_valid, fbspr__fsabo_mode, fbspr__fsabo_did,
+   fbspr__fsabo_subdid, fbspr__fsabo_addr, fbspr__fsabo_len,
+   fbspr__fsabo_data, fbspr__fsabo_mask, fbspr__spami_busy_b,
+   fbspr__spami_data, spr_hit, spr_rgb,
+   // Inputs
+   fbspr__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid, fsabi_did,
+   fsabi_subdid, fsabi_data, cclk, cclk_rst_b, spamo_valid, spamo_r_nw,
+   spamo_did, spamo_addr, spamo_data, fbclk, line_start, x, y
+   );
+
+	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
+
+	/* FSAB interface */
+	output reg                  fbspr__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  fbspr__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  fbspr__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  fbspr__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] fbspr__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  fbspr__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] fbspr__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] fbspr__fsabo_mask = 0;
+	input                       fbspr__fsabo_credit;
+
+	input                       fsabi_clk;
+	input                       fsabi_rst_b;
+	input                       fsabi_valid;
+	input      [FSAB_DID_HI:0]  fsabi_did;
+	input      [FSAB_DID_HI:0]  fsabi_subdid;
+	input      [FSAB_DATA_HI:0] fsabi_data;
+
+	/* SPAM interface */
+	input cclk;
+	input cclk_rst_b;
+
+	input                       spamo_valid;
+	input                       spamo_r_nw;
+	input      [SPAM_DID_HI:0]  spamo_did;
+	input      [SPAM_ADDR_HI:0] spamo_addr;
+	input      [SPAM_DATA_HI:0] spamo_data;
+
+	output wire                 fbspr__spami_busy_b;
+	output wire [SPAM_DATA_HI:0] fbspr__spami_data;
+
+	/* Scanout (fbclk) */
+	input                       fbclk;
+	input                       line_start;	/* x is 0, and the raster is running */
+	input      [11:0]           x;
+	input      [11:0]           y;
+	output reg                  spr_hit;
+	output reg [23:0]           spr_rgb;
+
+	`include "clog2.vh"
+	parameter SPRITES = 4;		/* at most 8 */
+	parameter SPRITE_W_MAX = 64;	/* the line buffers are sized for this */
+	parameter LAST_LINE = 520;	/* must match SyncGen */
+
+	parameter FSAB_DID = FSAB_DID_FRAME;
+	parameter FSAB_SUBDID = FSAB_SUBDID_FRAME_SPRITES;
+
+	parameter SPAM_DID = SPAM_DID_FRAMEBUFFER;
+	parameter SPAM_ADDRPFX = 24'h000100;
+	parameter SPAM_ADDRMASK = 24'hFFFF00;
+
+	parameter MODE_ALPHA = 2'd0;
+	parameter MODE_COPY  = 2'd1;
+	parameter MODE_KEY   = 2'd2;
+
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+
+	parameter BEATS_MAX = SPRITE_W_MAX / 2;
+	parameter BEATS_HI = clog2(BEATS_MAX) - 1;	/* wide enough for BEATS_MAX itself */
+	parameter BEAT_IDX_HI = clog2(BEATS_MAX - 1) - 1;
+
+	/* FSAB credit availability logic */
+	wire trans_start;
+
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge fsabi_clk or negedge fsabi_rst_b)
+		if (!fsabi_rst_b)
+			fsab_credits <= CREDITS;
+		else
+			fsab_credits <= fsab_credits + (fbspr__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+
+	/*** Registers ***/
+	/* All of the sprite registers come across together, address and all;
+	 * they're only ever looked at in fsabi_clk.
+	 */
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire bus_strobe;
+	wire [7:0] bus_addr;
+	wire [31:0] bus_data;
+
+	CSRAsyncWrite #(.WIDTH       (40),
+	                .RESET_VALUE (40'h0))
+		CSR_SPRITES(/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(fbspr__spami_busy_b),
+		           .wr_strobe_tclk     (bus_strobe),
+		           .wr_data_tclk       ({bus_addr, bus_data}),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode),
+		           .wr_data_cclk       ({spamo_addr[7:0], spamo_data}));
+
+	assign fbspr__spami_data = {(SPAM_DATA_HI+1){1'b0}};
+
+	reg [30:0] spr_addr   [SPRITES-1:0];
+	reg [11:0] spr_x      [SPRITES-1:0];
+	reg [11:0] spr_y      [SPRITES-1:0];
+	reg [11:0] spr_w      [SPRITES-1:0];
+	reg [11:0] spr_h      [SPRITES-1:0];
+	reg [30:0] spr_stride [SPRITES-1:0];
+	reg [31:0] spr_mode   [SPRITES-1:0];
+
+	/*** Line timing ***/
+	/* line_start flips a toggle over in fbclk, which we pick up here.  y
+	 * changed along with x going to 0, so by the time the toggle has made
+	 * it through the synchronizer, y has long since settled.
+	 */
+	reg line_tgl = 0;
+	always @(posedge fbclk)
+		if (line_start)
+			line_tgl <= ~line_tgl;
+
+	reg line_tgl_s1 = 0, line_tgl_s2 = 0, line_tgl_1a = 0;
+	always @(posedge fsabi_clk) begin
+		line_tgl_s1 <= line_tgl;
+		line_tgl_s2 <= line_tgl_s1;
+		line_tgl_1a <= line_tgl_s2;
+	end
+	wire line_go = line_tgl_s2 != line_tgl_1a;
+
+	wire [11:0] ny = (y == LAST_LINE) ? 12'd0 : (y + 12'd1);
+	wire bank = ny[0];
+
+	/*** Per-line descriptors ***/
+	/* Indexed by {bank, sprite}.  Written in fsabi_clk for the next
+	 * line, and read in fbclk for this one; they sit still for a whole
+	 * line before they're looked at.
+	 */
+	reg        desc_act  [2*SPRITES-1:0];
+	reg [11:0] desc_x    [2*SPRITES-1:0];
+	reg [11:0] desc_w    [2*SPRITES-1:0];
+	reg [31:0] desc_mode [2*SPRITES-1:0];
+
+	/* Which row of each sprite the next line is, and how many beats a
+	 * row takes.
+	 */
+	reg [11:0]       row      [SPRITES-1:0];
+	reg [BEATS_HI:0] nbeats   [SPRITES-1:0];
+
+	function [2:0] first_set;
+		input [SPRITES-1:0] m;
+		integer k;
+		begin
+			first_set = 0;
+			for (k = SPRITES-1; k >= 0; k = k - 1)
+				if (m[k])
+					first_set = k;
+		end
+	endfunction
+
+	/*** Fetch ***/
+	/* Both the fetch side and the receive side walk through the sprites
+	 * that are on the line in order; the reads come back in order, so
+	 * the receive side always knows whose pixels it's getting.
+	 */
+	reg [SPRITES-1:0] f_pend = 0;
+	reg               f_loaded = 0;
+	reg [30:0]        f_addr = 0;
+	reg [BEATS_HI:0]  f_rem = 0;
+	wire [2:0]        f_cur = first_set(f_pend);
+
+	reg [SPRITES-1:0] r_pend = 0;
+	reg [BEAT_IDX_HI:0] r_beat = 0;
+	reg               r_bank = 0;
+	wire [2:0]        r_cur = first_set(r_pend);
+
+	wire busy = (f_pend != 0) || (r_pend != 0);
+
+	wire [3:0] f_blk_left = 4'd8 - {1'b0, f_addr[5:3]};
+	/* verilator lint_off WIDTH */
+	wire [FSAB_LEN_HI:0] f_burst = (f_rem < f_blk_left) ? f_rem : f_blk_left;
+	/* verilator lint_on WIDTH */
+	wire f_load = !f_loaded && (f_pend != 0);
+	assign trans_start = f_loaded && fsab_credit_avail;
+
+	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
+
+	integer i;
+	reg [11:0] rel_y;	/* temporaries */
+	reg [11:0] w_clip;
+	reg        on_line;
+
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			for (i = 0; i < SPRITES; i = i + 1) begin
+				spr_w[i] <= 0;
+				spr_h[i] <= 0;
+			end
+			for (i = 0; i < 2*SPRITES; i = i + 1)
+				desc_act[i] <= 0;
+			f_pend <= 0;
+			f_loaded <= 0;
+			r_pend <= 0;
+			r_beat <= 0;
+
+			fbspr__fsabo_valid <= 0;
+			fbspr__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			fbspr__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			fbspr__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			fbspr__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			fbspr__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			fbspr__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			fbspr__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			/*** Settings ***/
+			if (bus_strobe && (bus_addr[7:5] < SPRITES))
+				case (bus_addr[4:0])
+				5'h00: spr_addr[bus_addr[7:5]] <= {bus_data[30:3], 3'b000};
+				5'h04: begin
+					spr_x[bus_addr[7:5]] <= bus_data[11:0];
+					spr_y[bus_addr[7:5]] <= bus_data[27:16];
+				end
+				5'h08: begin
+					spr_w[bus_addr[7:5]] <= bus_data[11:0];
+					spr_h[bus_addr[7:5]] <= bus_data[27:16];
+				end
+				5'h0C: spr_stride[bus_addr[7:5]] <= {bus_data[30:3], 3'b000};
+				5'h10: spr_mode[bus_addr[7:5]] <= bus_data;
+				default: begin end
+				endcase
+
+			/*** New line ***/
+			/* If the last line's reads are still going, its row and
+			 * beat counts are still needed, and the next line goes
+			 * without.
+			 */
+			if (line_go) begin
+				for (i = 0; i < SPRITES; i = i + 1) begin
+					rel_y = ny - spr_y[i];
+					w_clip = (spr_w[i] > SPRITE_W_MAX) ? SPRITE_W_MAX : spr_w[i];
+					on_line = (spr_w[i] != 0) && (rel_y < spr_h[i]);
+
+					desc_act[bank*SPRITES+i] <= !busy && on_line;
+					desc_x[bank*SPRITES+i] <= spr_x[i];
+					desc_w[bank*SPRITES+i] <= w_clip;
+					desc_mode[bank*SPRITES+i] <= spr_mode[i];
+
+					if (!busy) begin
+						row[i] <= rel_y;
+						/* verilator lint_off WIDTH */
+						nbeats[i] <= w_clip[BEATS_HI+1:1] + w_clip[0];
+						/* verilator lint_on WIDTH */
+						f_pend[i] <= on_line;
+						r_pend[i] <= on_line;
+					end
+				end
+				if (!busy) begin
+					r_beat <= 0;
+					r_bank <= bank;
+				end
+			end else if (f_load) begin
+				/* verilator lint_off WIDTH */
+				f_addr <= spr_addr[f_cur] + row[f_cur] * spr_stride[f_cur];
+				/* verilator lint_on WIDTH */
+				f_rem <= nbeats[f_cur];
+				f_loaded <= 1;
+			end else if (trans_start) begin
+				f_addr <= f_addr + {f_burst, 3'b000};
+				f_rem <= f_rem - f_burst;
+				if (f_rem == f_burst) begin
+					f_loaded <= 0;
+					f_pend[f_cur] <= 0;
+				end
+			end
+
+			if (trans_start) begin
+				fbspr__fsabo_valid <= 1;
+				fbspr__fsabo_mode <= FSAB_READ;
+				fbspr__fsabo_did <= FSAB_DID;
+				fbspr__fsabo_subdid <= FSAB_SUBDID;
+				fbspr__fsabo_addr <= f_addr;
+				fbspr__fsabo_len <= f_burst;
+				fbspr__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				fbspr__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end else begin
+				fbspr__fsabo_valid <= 0;
+				fbspr__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				fbspr__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				fbspr__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				fbspr__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				fbspr__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				fbspr__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				fbspr__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+
+			/*** Receive ***/
+			/* verilator lint_off WIDTH */
+			if (fsabi_decode) begin
+				if (r_beat == (nbeats[r_cur] - 1)) begin
+					r_beat <= 0;
+					r_pend[r_cur] <= 0;
+				end else
+					r_beat <= r_beat + 1;
+			end
+			/* verilator lint_on WIDTH */
+		end
+	end
+
+	/*** Compositing ***/
+	/* Each sprite gets its own line buffer, so that they can all be
+	 * looked at at once; they're small enough to live in LUTs, and get
+	 * read asynchronously from fbclk.
+	 */
+	wire [SPRITES-1:0] hits;
+	wire [24*SPRITES-1:0] colours;
+
+	genvar g;
+	generate
+	for (g = 0; g < SPRITES; g = g + 1) begin: spr
+		reg [63:0] linebuf [2*BEATS_MAX-1:0];
+		always @(posedge fsabi_clk)
+			if (fsabi_decode && (r_cur == g))
+				linebuf[{r_bank, r_beat}] <= fsabi_data;
+
+		wire        act  = desc_act[y[0]*SPRITES+g];
+		wire [11:0] rel  = x - desc_x[y[0]*SPRITES+g];
+		wire [31:0] mode = desc_mode[y[0]*SPRITES+g];
+		wire [63:0] word = linebuf[{y[0], rel[BEAT_IDX_HI+1:1]}];
+		wire [31:0] px   = rel[0] ? word[63:32] : word[31:0];
+		wire [7:0]  alpha = mode[2] ? px[31:24] : px[7:0];
+
+		reg keep;	/* combinatorial */
+		always @(*)
+			case (mode[1:0])
+			MODE_ALPHA: keep = alpha >= mode[15:8];
+			MODE_KEY:   keep = px[31:8] != mode[31:8];
+			default:    keep = 1;
+			endcase
+
+		assign hits[g] = act && (rel < desc_w[y[0]*SPRITES+g]) && keep;
+		assign colours[24*g +: 24] = px[31:8];
+	end
+	endgenerate
+
+	integer j;
+	always @(*) begin
+		spr_hit = 0;
+		spr_rgb = 24'h000000;
+		for (j = SPRITES-1; j >= 0; j = j - 1)
+			if (hits[j]) begin
+				spr_hit = 1;
+				spr_rgb = colours[24*j +: 24];
+			end
+	end
+
+endmodule
@@ -1,15 +1,53 @@
+/* Framebuffer scanout.
+ *
+ * The DMA controller's registers live at 0x00-0x1F (see
+ * dma_config_defines.vh); a new start address written there is picked up
+ * at the start of the next frame.  On top of those:
+ * 0x20 = status (read): bit 0 is set during vertical blank
+ * 0x24 = frame count (read): goes up by one at the start of every
+ *        vertical blank
+ * 0x28 = pixel format: bits 1:0 are the format (FB_FMT_*), and bit 2
+ *        doubles every pixel in both directions, for a 320x240 source
+ * 0x2C = underflow count (read): how many times scanout wanted a word that
+ *        the DMA didn't have yet; writing anything here clears it, and
+ *        resets the low-water mark
+ * 0x30 = FIFO low-water mark (read): the fewest words that were waiting in
+ *        the DMA FIFO whenever scanout took one, since the last clear
+ * 0x100 - 0x1FF = hardware sprites, 0x20 bytes apiece (see FBSprites.v);
+ *        these go on top of whatever the pixel format is, and are always
+ *        32-bpp and never doubled
+ * 0x400 - 0x7FC = palette for FB_FMT_8BPP, one entry per word, in the
+ *        same layout as a 32-bpp pixel
+ *
+ * Pixels are packed little-end first.  A 32-bpp pixel has red in bits
+ * 31:24, green in 23:16 and blue in 15:8; an RGB565 pixel has red in bits
+ * 15:11, green in 10:5 and blue in 4:0.
+ *
+ * The pixel format only changes while scanout is stopped (that is, with
+ * the DMA stopped and its FIFO empty), so that it can't change in the
+ * middle of a frame; the DMA's length has to be set to match.
+ *
+ * Scanout stops whenever the FIFO runs dry, and doesn't start again until
+ * the DMA has a whole line (PREFETCH_WORDS) waiting, so that a frame never
+ * starts out hand-to-mouth; a transfer had better be at least that long.
+ */
+
 module Framebuffer(/*AUTOARG*/
    // Outputs
    dvi_vs, dvi_hs, dvi_d, dvi_xclk_p, dvi_xclk_n, dvi_de, dvi_reset_b,
    fb__fsabo_valid, fb__fsabo_mode, fb__fsabo_did, fb__fsabo_subdid,
    fb__fsabo_addr, fb__fsabo_len, fb__fsabo_data, fb__fsabo_mask,
-   fb__spami_busy_b, fb__spami_data,
+   fbspr__fsabo_valid, fbspr__fsabo_mode, fbspr__fsabo_did,
+   fbspr__fsabo_subdid, fbspr__fsabo_addr, fbspr__fsabo_len,
+   fbspr__fsabo_data, fbspr__fsabo_mask, fb__spami_busy_b,
+   fb__spami_data, fb__vblank,
    // Inouts
    dvi_sda, dvi_scl, control_vio,
    // Inputs
    fbclk, fbclk_rst_b, cclk, cclk_rst_b, fsabi_clk, fsabi_rst_b,
    fsabi_valid, fsabi_did, fsabi_subdid, fsabi_data, fb__fsabo_credit,
-   spamo_valid, spamo_r_nw, spamo_did, spamo_addr, spamo_data
+   fbspr__fsabo_credit, spamo_valid, spamo_r_nw, spamo_did, spamo_addr,
+   spamo_data
    );
 
 	`include "fsab_defines.vh"
@@ -46,6 +84,16 @@ module Framebuffer(/*AUTOARG*/
 	output [FSAB_MASK_HI:0] fb__fsabo_mask;
 	input fb__fsabo_credit;
 
+	output fbspr__fsabo_valid;
+	output [FSAB_REQ_HI:0] fbspr__fsabo_mode;
+	output [FSAB_DID_HI:0] fbspr__fsabo_did;
+	output [FSAB_DID_HI:0] fbspr__fsabo_subdid;
+	output [FSAB_ADDR_HI:0] fbspr__fsabo_addr;
+	output [FSAB_LEN_HI:0] fbspr__fsabo_len;
+	output [FSAB_DATA_HI:0] fbspr__fsabo_data;
+	output [FSAB_MASK_HI:0] fbspr__fsabo_mask;
+	input fbspr__fsabo_credit;
+
 	input spamo_valid;
 	input spamo_r_nw;
 	input [SPAM_DID_HI:0] spamo_did;
@@ -55,9 +103,31 @@ module Framebuffer(/*AUTOARG*/
 	output fb__spami_busy_b;
 	output [SPAM_DATA_HI:0] fb__spami_data;
 
+	output reg fb__vblank = 0;	/* fbclk */
+
 	inout [35:0] control_vio;
 
 	parameter DEBUG = "FALSE";
+	parameter DMA_CREDITS = FSAB_INITIAL_CREDITS;	/* must match the arbiter */
+	parameter SPRITES = 4;
+	
+	`include "clog2.vh"
+	/* Room for a few 32-bpp lines; the DMA keeps it topped up a burst at
+	 * a time.
+	 */
+	parameter DMA_FIFO_DEPTH = 1024;	/* must be a power of 2 */
+	parameter DMA_FIFO_HI = clog2(DMA_FIFO_DEPTH) - 2;
+	parameter PREFETCH_WORDS = 320;		/* one 32-bpp line */
+
+	parameter SPAM_DID = SPAM_DID_FRAMEBUFFER;
+	parameter SPAM_ADDRPFX = 24'h000020;
+	parameter SPAM_ADDRMASK = 24'hFFFFE0;
+	parameter SPAM_PAL_ADDRPFX = 24'h000400;
+	parameter SPAM_PAL_ADDRMASK = 24'hFFFC00;
+	
+	parameter FB_FMT_32BPP = 2'd0;
+	parameter FB_FMT_16BPP = 2'd1;
+	parameter FB_FMT_8BPP = 2'd2;
 
 	assign dvi_reset_b = 1'b1;
 
@@ -65,19 +135,27 @@ module Framebuffer(/*AUTOARG*/
 	// Beginning of automatic wires (for undeclared instantiated-module outputs)
 	wire [63:0]	data;			// From frame_dma of SimpleDMAReadController.v
 	wire		data_ready;		// From frame_dma of SimpleDMAReadController.v
+	wire		fb_dma__spami_busy_b;	// From frame_dma of SimpleDMAReadController.v
+	wire [SPAM_DATA_HI:0] fb_dma__spami_data;// From frame_dma of SimpleDMAReadController.v
+	wire		fbspr__spami_busy_b;	// From sprites of FBSprites.v
+	wire [SPAM_DATA_HI:0] fbspr__spami_data;// From sprites of FBSprites.v
 	wire		fifo_empty_0a;		// From frame_dma of SimpleDMAReadController.v
 	wire		iic_done;		// From init of iic_init.v
+	wire		spr_hit;		// From sprites of FBSprites.v
+	wire [23:0]	spr_rgb;		// From sprites of FBSprites.v
 	// End of automatics
 	
 	wire [11:0] x, y;
 	wire border;
 
 	wire vs, hs;
+	wire vblank;
 
-	reg fifo_empty_1a = 1;
+	reg stopped = 1;
+	wire [DMA_FIFO_HI+1:0] fifo_level;
 
 	/* SyncGen AUTO_TEMPLATE (
-		.rst_b(~fifo_empty_1a),
+		.rst_b(~stopped),
 		);
 	*/
 	SyncGen sync(/*AUTOINST*/
@@ -87,28 +165,117 @@ module Framebuffer(/*AUTOARG*/
 		     .x			(x[11:0]),
 		     .y			(y[11:0]),
 		     .border		(border),
+		     .vblank		(vblank),
 		     // Inputs
 		     .fbclk		(fbclk),
-		     .rst_b		(~fifo_empty_1a));	 // Templated
-
-	reg offset = 0; /* 0 if reading the first half of the 8 bytes for colors
-	                   1 if reading the second half of the 8 bytes for colors */
-	reg next_offset = 0;
-
-	reg request = 0;
-
+		     .rst_b		(~stopped));	 // Templated
+
+	/* Registered, since it goes across to other clock domains. */
+	always @(posedge fbclk)
+		fb__vblank <= vblank;
+
+	reg [31:0] frame_count = 0;
+	always @(posedge fbclk or negedge fbclk_rst_b)
+		if (!fbclk_rst_b)
+			frame_count <= 0;
+		else if (vblank && !fb__vblank)
+			frame_count <= frame_count + 1;
+
+	/*** Pixel unpacking ***/
+	/* pix is which pixel of the current 64-bit word is going out, and
+	 * sub is which half of a doubled pixel; when the last pixel of a
+	 * word goes out, we ask the DMA for the next one.
+	 *
+	 * When doubling, each line gets shown twice; the first time, the
+	 * words go into a line buffer as we finish with them, and the second
+	 * time, they come back out of it, and the DMA is left alone.
+	 */
+	wire [2:0] mode_bus;
+	reg mode_wr_pending = 0;
+	reg [2:0] mode = 0;
+	wire [1:0] fmt = mode[1:0];
+	wire dbl = mode[2];
+	
+	reg [2:0] pix = 0;
+	reg sub = 0;
+	wire [2:0] pix_last = (fmt == FB_FMT_32BPP) ? 3'd1 : (fmt == FB_FMT_16BPP) ? 3'd3 : 3'd7;
+	wire word_done = !border && !(dbl && !sub) && (pix == pix_last);
+	wire replay = dbl && y[0];
+	wire request = word_done && !replay;
+	
+	reg [63:0] linebuf [255:0];
+	reg [7:0] lb_idx = 0;
+	wire [7:0] lb_idx_next = (x == 639) ? 8'd0 : (lb_idx + 8'd1);
+	reg [63:0] lb_data = 0;
+	
+	always @(posedge fbclk) begin
+		if (word_done && !replay)
+			linebuf[lb_idx] <= data;
+		if (word_done)
+			lb_data <= linebuf[lb_idx_next];
+	end
+	
+	wire [63:0] cur = replay ? lb_data : data;
+	
+	reg [23:0] palette [255:0];
+	wire [31:0] px32 = pix[0] ? cur[63:32] : cur[31:0];
+	wire [15:0] px16 = cur[{pix[1:0], 4'b0000} +: 16];
+	wire [7:0]  px8  = cur[{pix[2:0], 3'b000} +: 8];
+	wire [23:0] rgb  = (fmt == FB_FMT_32BPP) ? px32[31:8] :
+	                   (fmt == FB_FMT_16BPP) ? {px16[15:11], px16[15:13], px16[10:5], px16[10:9], px16[4:0], px16[4:2]} :
+	                   palette[px8];
+
+	/*** Sprites ***/
+	/* FBSprites AUTO_TEMPLATE (
+		.line_start(x == 0 && !stopped),
+		);
+	*/
+	FBSprites sprites(/*AUTOINST*/
+			  // Outputs
+			  .fbspr__fsabo_valid	(fbspr__fsabo_valid),
+			  .fbspr__fsabo_mode	(fbspr__fsabo_mode[FSAB_REQ_HI:0]),
+			  .fbspr__fsabo_did	(fbspr__fsabo_did[FSAB_DID_HI:0]),
+			  .fbspr__fsabo_subdid	(fbspr__fsabo_subdid[FSAB_DID_HI:0]),
+			  .fbspr__fsabo_addr	(fbspr__fsabo_addr[FSAB_ADDR_HI:0]),
+			  .fbspr__fsabo_len	(fbspr__fsabo_len[FSAB_LEN_HI:0]),
+			  .fbspr__fsabo_data	(fbspr__fsabo_data[FSAB_DATA_HI:0]),
+			  .fbspr__fsabo_mask	(fbspr__fsabo_mask[FSAB_MASK_HI:0]),
+			  .fbspr__spami_busy_b	(fbspr__spami_busy_b),
+			  .fbspr__spami_data	(fbspr__spami_data[SPAM_DATA_HI:0]),
+			  .spr_hit		(spr_hit),
+			  .spr_rgb		(spr_rgb[23:0]),
+			  // Inputs
+			  .fbspr__fsabo_credit	(fbspr__fsabo_credit),
+			  .fsabi_clk		(fsabi_clk),
+			  .fsabi_rst_b		(fsabi_rst_b),
+			  .fsabi_valid		(fsabi_valid),
+			  .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+			  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
+			  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+			  .cclk			(cclk),
+			  .cclk_rst_b		(cclk_rst_b),
+			  .spamo_valid		(spamo_valid),
+			  .spamo_r_nw		(spamo_r_nw),
+			  .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+			  .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+			  .spamo_data		(spamo_data[SPAM_DATA_HI:0]),
+			  .fbclk		(fbclk),
+			  .line_start		(x == 0 && !stopped), // Templated
+			  .x			(x[11:0]),
+			  .y			(y[11:0]));
+	defparam sprites.SPRITES = SPRITES;
+	defparam sprites.SPAM_DID = SPAM_DID;
+
+	wire [23:0] rgb_out = spr_hit ? spr_rgb : rgb;
 
 
 `define MAKE_DDR(n,q,d1,d2) ODDR n (.C(fbclk), .Q(q), .D1(d1), .D2(d2), .R(0), .S(0), .CE(1))
 	
 	wire [7:0] red_p, green_p, blue_p;
 
-	wire first_pixel = (offset == 0);
-	wire second_pixel = (offset == 1);	
-
-	assign red_p   = (border) ? 8'h00 : (second_pixel) ? data[63:56] : (first_pixel) ? data[31:24] : 8'hff;
-	assign green_p = (border) ? 8'h00 : (second_pixel) ? data[55:48] : (first_pixel) ? data[23:16] : 8'h00;
-	assign blue_p  = (border) ? 8'hff : (second_pixel) ? data[47:40] : (first_pixel) ? data[15:8] : 8'h00;
+	assign red_p   = (border) ? 8'h00 : rgb_out[23:16];
+	assign green_p = (border) ? 8'h00 : rgb_out[15:8];
+	assign blue_p  = (border) ? 8'hff : rgb_out[7:0];
 	
 	reg [7:0] red, green, blue;
 	always @(negedge fbclk) begin
@@ -119,8 +286,19 @@ module Framebuffer(/*AUTOARG*/
 
 
 `ifdef verilator
+	/* There's no DVI in simulation; instead, scanout goes to sim/fbsink.cpp,
+	 * which keeps the frame and writes some of them out.  Underflows are
+	 * pixels that we wanted, but that the DMA didn't have yet.
+	 */
 	always @ (posedge fbclk) begin
-		$display("Framebuffer: Read %x for x: %x, y: %x data_ready: %x, border: %x, request: %x, offset: %x", data, x, y, data_ready, border, request, offset);
+		if (!stopped) begin
+			if (!border)
+				$c("{extern void fbsink_pixel(unsigned int, unsigned int, unsigned int); fbsink_pixel(", x, ",", y, ",", {8'h00, red_p, green_p, blue_p}, ");}");
+			if (request && fifo_empty_0a)
+				$c("{extern void fbsink_underflow(unsigned int, unsigned int); fbsink_underflow(", x, ",", y, ");}");
+			if (vblank && !fb__vblank)
+				$c("{extern void fbsink_frame(); fbsink_frame();}");
+		end
 	end
 `endif
 	
@@ -186,10 +364,11 @@ module Framebuffer(/*AUTOARG*/
 	                        .dmac__fsabo_len(fb__fsabo_len),
 	                        .dmac__fsabo_data(fb__fsabo_data),
 	                        .dmac__fsabo_mask(fb__fsabo_mask),
-	                        .dmac__spami_busy_b(fb__spami_busy_b),
-				.dmac__spami_data(fb__spami_data),
+	                        .dmac__spami_busy_b(fb_dma__spami_busy_b),
+				.dmac__spami_data(fb_dma__spami_data),
 	                        .dmac__fsabo_credit(fb__fsabo_credit),
 	                        .fifo_empty(fifo_empty_0a),
+	                        .fifo_level(fifo_level[DMA_FIFO_HI+1:0]),
                                 );
          */	
 	SimpleDMAReadController frame_dma(/*AUTOINST*/
@@ -205,8 +384,9 @@ module Framebuffer(/*AUTOARG*/
 					  .data			(data[63:0]),
 					  .data_ready		(data_ready),
 					  .fifo_empty		(fifo_empty_0a), // Templated
-					  .dmac__spami_busy_b	(fb__spami_busy_b), // Templated
-					  .dmac__spami_data	(fb__spami_data), // Templated
+					  .fifo_level		(fifo_level[DMA_FIFO_HI+1:0]), // Templated
+					  .dmac__spami_busy_b	(fb_dma__spami_busy_b), // Templated
+					  .dmac__spami_data	(fb_dma__spami_data), // Templated
 					  // Inputs
 					  .cclk			(cclk),
 					  .cclk_rst_b		(cclk_rst_b),
@@ -225,12 +405,179 @@ module Framebuffer(/*AUTOARG*/
 					  .target_clk		(fbclk),	 // Templated
 					  .target_rst_b		(fbclk_rst_b),	 // Templated
 					  .request		(request));
-	defparam frame_dma.FIFO_DEPTH = 512;
+	defparam frame_dma.FIFO_DEPTH = DMA_FIFO_DEPTH;
+	defparam frame_dma.CREDITS = DMA_CREDITS;
 	defparam frame_dma.FSAB_DID = FSAB_DID_FRAME;
 	defparam frame_dma.FSAB_SUBDID = FSAB_SUBDID_FRAME_0;
 	defparam frame_dma.DEFAULT_ADDR = 31'h00000000;
 	defparam frame_dma.DEFAULT_LEN = 31'h0012c000; /* 640*480*4 in hex */
-	defparam frame_dma.SPAM_DID = SPAM_DID_FRAMEBUFFER;
+	defparam frame_dma.SPAM_DID = SPAM_DID;
+
+	/* Config */
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire rd_done_strobe_STATUS;
+	wire [SPAM_DATA_HI:0] rd_data_STATUS;
+	CSRAsyncRead #(.WIDTH        (SPAM_DATA_HI+1))
+		CSR_STATUS (/* NOT AUTOINST */
+			    // Outputs
+			    .rd_data_cclk	(rd_data_STATUS),
+			    .rd_wait_cclk	(),
+			    .rd_done_strobe_cclk(rd_done_strobe_STATUS),
+			    .rd_strobe_tclk	(),
+			    // Inputs
+			    .cclk		(cclk),
+			    .tclk		(fbclk),
+			    .rst_b_cclk		(cclk_rst_b),
+			    .rst_b_tclk		(fbclk_rst_b),
+			    .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'h00)),
+			    .rd_data_tclk	({{SPAM_DATA_HI{1'b0}}, fb__vblank}));
+
+	wire rd_done_strobe_FRAME_COUNT;
+	wire [SPAM_DATA_HI:0] rd_data_FRAME_COUNT;
+	CSRAsyncRead #(.WIDTH        (SPAM_DATA_HI+1))
+		CSR_FRAME_COUNT (/* NOT AUTOINST */
+			    // Outputs
+			    .rd_data_cclk	(rd_data_FRAME_COUNT),
+			    .rd_wait_cclk	(),
+			    .rd_done_strobe_cclk(rd_done_strobe_FRAME_COUNT),
+			    .rd_strobe_tclk	(),
+			    // Inputs
+			    .cclk		(cclk),
+			    .tclk		(fbclk),
+			    .rst_b_cclk		(cclk_rst_b),
+			    .rst_b_tclk		(fbclk_rst_b),
+			    .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'h04)),
+			    .rd_data_tclk	(frame_count));
+
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	/* Held, rather than taken as a strobe, since it only gets picked up
+	 * when scanout is stopped.
+	 */
+	wire wr_strobe_MODE;
+	always @(posedge fbclk or negedge fbclk_rst_b)
+		if (!fbclk_rst_b)
+			mode_wr_pending <= 0;
+		else if (wr_strobe_MODE)
+			mode_wr_pending <= 1;
+		else if (stopped)
+			mode_wr_pending <= 0;
+
+	wire wr_done_strobe_MODE;
+	CSRAsyncWrite #(.WIDTH       (3),
+	                .RESET_VALUE (3'b000))
+		CSR_MODE (/* NOT AUTOINST */
+			  // Outputs
+			  .wr_wait_cclk		(),
+			  .wr_done_strobe_cclk	(wr_done_strobe_MODE),
+			  .wr_strobe_tclk	(wr_strobe_MODE),
+			  .wr_data_tclk		(mode_bus[2:0]),
+			  // Inputs
+			  .cclk			(cclk),
+			  .tclk			(fbclk),
+			  .rst_b_cclk		(cclk_rst_b),
+			  .rst_b_tclk		(fbclk_rst_b),
+			  .wr_strobe_cclk	(wr_decode && (spamo_addr[4:0] == 5'h08)),
+			  .wr_data_cclk		(spamo_data[2:0]));
+
+	/* Underflow telemetry.  Only counted while scanout is going; once the
+	 * FIFO runs dry, we stop until it fills back up, so each underflow
+	 * gets counted about once.
+	 */
+	wire wr_strobe_STATS;
+	reg [31:0] underflows = 0;
+	reg [DMA_FIFO_HI+1:0] fifo_min = DMA_FIFO_DEPTH;
+	always @(posedge fbclk or negedge fbclk_rst_b)
+		if (!fbclk_rst_b) begin
+			underflows <= 0;
+			fifo_min <= DMA_FIFO_DEPTH;
+		end else if (wr_strobe_STATS) begin
+			underflows <= 0;
+			fifo_min <= DMA_FIFO_DEPTH;
+		end else if (!stopped && request) begin
+			if (fifo_empty_0a)
+				underflows <= underflows + 1;
+			if (fifo_level < fifo_min)
+				fifo_min <= fifo_level;
+		end
+
+	wire wr_done_strobe_STATS;
+	CSRAsyncWrite #(.WIDTH       (1),
+	                .RESET_VALUE (1'b0))
+		CSR_STATS (/* NOT AUTOINST */
+			   // Outputs
+			   .wr_wait_cclk	(),
+			   .wr_done_strobe_cclk	(wr_done_strobe_STATS),
+			   .wr_strobe_tclk	(wr_strobe_STATS),
+			   .wr_data_tclk	(),
+			   // Inputs
+			   .cclk		(cclk),
+			   .tclk		(fbclk),
+			   .rst_b_cclk		(cclk_rst_b),
+			   .rst_b_tclk		(fbclk_rst_b),
+			   .wr_strobe_cclk	(wr_decode && (spamo_addr[4:0] == 5'h0C)),
+			   .wr_data_cclk	(1'b0));
+
+	wire rd_done_strobe_UNDERFLOWS;
+	wire [SPAM_DATA_HI:0] rd_data_UNDERFLOWS;
+	CSRAsyncRead #(.WIDTH        (SPAM_DATA_HI+1))
+		CSR_UNDERFLOWS (/* NOT AUTOINST */
+			    // Outputs
+			    .rd_data_cclk	(rd_data_UNDERFLOWS),
+			    .rd_wait_cclk	(),
+			    .rd_done_strobe_cclk(rd_done_strobe_UNDERFLOWS),
+			    .rd_strobe_tclk	(),
+			    // Inputs
+			    .cclk		(cclk),
+			    .tclk		(fbclk),
+			    .rst_b_cclk		(cclk_rst_b),
+			    .rst_b_tclk		(fbclk_rst_b),
+			    .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'h0C)),
+			    .rd_data_tclk	(underflows));
+
+	wire rd_done_strobe_FIFO_MIN;
+	wire [SPAM_DATA_HI:0] rd_data_FIFO_MIN;
+	CSRAsyncRead #(.WIDTH        (SPAM_DATA_HI+1))
+		CSR_FIFO_MIN (/* NOT AUTOINST */
+			    // Outputs
+			    .rd_data_cclk	(rd_data_FIFO_MIN),
+			    .rd_wait_cclk	(),
+			    .rd_done_strobe_cclk(rd_done_strobe_FIFO_MIN),
+			    .rd_strobe_tclk	(),
+			    // Inputs
+			    .cclk		(cclk),
+			    .tclk		(fbclk),
+			    .rst_b_cclk		(cclk_rst_b),
+			    .rst_b_tclk		(fbclk_rst_b),
+			    .rd_strobe_cclk	(rd_decode && (spamo_addr[4:0] == 5'h10)),
+			    .rd_data_tclk	({{(SPAM_DATA_HI-DMA_FIFO_HI-1){1'b0}}, fifo_min}));
+
+	/* The palette is written from cclk, and read (asynchronously) from
+	 * fbclk; it's small enough to live in LUTs.
+	 */
+	wire pal_wr_decode = spamo_valid && !spamo_r_nw &&
+	                     ((spamo_addr & SPAM_PAL_ADDRMASK) == SPAM_PAL_ADDRPFX) &&
+	                     (spamo_did == SPAM_DID);
+	reg pal_busy_b = 0;
+	always @(posedge cclk) begin
+		pal_busy_b <= pal_wr_decode;
+		if (pal_wr_decode)
+			palette[spamo_addr[9:2]] <= spamo_data[31:8];
+	end
+
+	assign fb__spami_busy_b = fb_dma__spami_busy_b | rd_done_strobe_STATUS | rd_done_strobe_FRAME_COUNT |
+	                          wr_done_strobe_MODE | pal_busy_b | fbspr__spami_busy_b |
+	                          wr_done_strobe_STATS | rd_done_strobe_UNDERFLOWS | rd_done_strobe_FIFO_MIN;
+	assign fb__spami_data = fb_dma__spami_data | fbspr__spami_data |
+	                        (rd_done_strobe_STATUS ? rd_data_STATUS : 0) |
+	                        (rd_done_strobe_FRAME_COUNT ? rd_data_FRAME_COUNT : 0) |
+	                        (rd_done_strobe_UNDERFLOWS ? rd_data_UNDERFLOWS : 0) |
+	                        (rd_done_strobe_FIFO_MIN ? rd_data_FIFO_MIN : 0);
 
 	wire wee;
 	/* iic_init AUTO_TEMPLATE(
@@ -254,29 +601,38 @@ module Framebuffer(/*AUTOARG*/
 		       .Reset_n		(fbclk_rst_b),		 // Templated
 		       .Pixel_clk_greater_than_65Mhz(1'b0));	 // Templated
 
-	always @(*) begin
-		if (offset == 1) begin
-			next_offset = 0;
-			request = 1;
-		end
-		else begin
-			request = 0;
-			next_offset = 1;
-		end
-		if (border) begin
-			request = 0;
-			next_offset = offset;
-		end	
-	end
-
 	always @ (posedge fbclk or negedge fbclk_rst_b) begin
 		if (!fbclk_rst_b) begin
-			offset <= 0;
-			fifo_empty_1a <= 1;
+			pix <= 0;
+			sub <= 0;
+			lb_idx <= 0;
+			mode <= 0;
+			stopped <= 1;
 		end
 		else begin
-			offset <= next_offset;
-			fifo_empty_1a <= fifo_empty_0a;
+			if (stopped) begin
+				/* Scanout is stopped, so start over cleanly. */
+				pix <= 0;
+				sub <= 0;
+				lb_idx <= 0;
+				if (mode_wr_pending)
+					mode <= mode_bus;
+			end else if (!border) begin
+				if (dbl && !sub)
+					sub <= 1;
+				else begin
+					sub <= 0;
+					pix <= (pix == pix_last) ? 3'd0 : (pix + 3'd1);
+				end
+				if (word_done)
+					lb_idx <= lb_idx_next;
+			end
+			/* verilator lint_off WIDTH */
+			if (fifo_empty_0a)
+				stopped <= 1;
+			else if (fifo_level >= PREFETCH_WORDS)
+				stopped <= 0;
+			/* verilator lint_on WIDTH */
 		end
 	end
 
@@ -294,7 +650,7 @@ module Framebuffer(/*AUTOARG*/
 		chipscope_ila ila0 (
 			.CONTROL(control0),	
 			.CLK(fbclk), // IN
-			.TRIG0({0, request, offset, fbclk_rst_b, next_offset, border, data_ready, data[63:0], red[7:0], green[7:0], blue[7:0], x[11:0], y[11:0], vs, hs})
+			.TRIG0({0, request, pix, sub, fbclk_rst_b, replay, border, data_ready, data[63:0], red[7:0], green[7:0], blue[7:0], x[11:0], y[11:0], vs, hs})
 		);
 
 		chipscope_ila ila1 (
@@ -1,6 +1,6 @@
 module SyncGen(/*AUTOARG*/
    // Outputs
-   vs, hs, x, y, border,
+   vs, hs, x, y, border, vblank,
    // Inputs
    fbclk, rst_b
    );
@@ -10,6 +10,7 @@ module SyncGen(/*AUTOARG*/
 	output reg vs, hs;
 	output reg [11:0] x, y;
 	output reg border;
+	output reg vblank;
 	
 	parameter XRES = 640;
 	parameter XFPORCH = 24;
@@ -44,5 +45,6 @@ module SyncGen(/*AUTOARG*/
 		hs = (x >= (XRES + XFPORCH)) && (x < (XRES + XFPORCH + XSYNC));
 		vs = (y >= (YRES + YFPORCH)) && (y < (YRES + YFPORCH + YSYNC));
 		border = (x >= XRES) || (y >= YRES);
+		vblank = (y >= YRES);
 	end
 endmodule
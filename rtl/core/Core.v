@@ -17,6 +17,7 @@ module Core(/*AUTOARG*/
 
 	`include "fsab_defines.vh"
 	`include "spam_defines.vh"
+	`include "region_defines.vh"
 
 	output wire                  ic__fsabo_valid;
 	output wire [FSAB_REQ_HI:0]  ic__fsabo_mode;
@@ -57,6 +58,18 @@ module Core(/*AUTOARG*/
 	inout [35:0] control_vio;
 	
 	parameter DEBUG = "FALSE";
+	parameter SYNC_CLOCKS = "FALSE";	/* "TRUE" if clk and fsabi_clk are the same clock */
+	
+	/* Tightly coupled memories.  The D-TCM is reachable only from
+	 * Memory; the I-TCM is reachable from both Fetch and Memory (so that
+	 * code can get copied into it).  Sizes are log2(bytes).
+	 */
+	parameter DTCM = "TRUE";
+	parameter DTCM_BASE = 32'h40000000;
+	parameter DTCM_SIZE_BITS = 14;
+	parameter ITCM = "FALSE";
+	parameter ITCM_BASE = 32'h40800000;
+	parameter ITCM_SIZE_BITS = 14;
 
 	/*AUTOWIRE*/
 	// Beginning of automatic wires (for undeclared instantiated-module outputs)
@@ -76,16 +89,16 @@ module Core(/*AUTOARG*/
 	wire [31:0]	dc__addr_3a;		// From memory of Memory.v
 	wire [35:0]	dc__control1;		// To/From dcache of DCache.v
 	wire [2:0]	dc__data_size_3a;	// From memory of Memory.v
-	wire [31:0]	dc__rd_data_4a;		// From dcache of DCache.v
 	wire		dc__rd_req_3a;		// From memory of Memory.v
-	wire		dc__rw_wait_3a;		// From dcache of DCache.v
 	wire [31:0]	dc__wr_data_3a;		// From memory of Memory.v
 	wire		dc__wr_req_3a;		// From memory of Memory.v
+	wire [31:0]	dcache__rd_data_4a;	// From dcache of DCache.v
+	wire		dcache__rw_wait_3a;	// From dcache of DCache.v
 	wire [35:0]	ic__control2;		// To/From icache of ICache.v
 	wire [31:0]	ic__rd_addr_0a;		// From fetch of Fetch.v
-	wire [31:0]	ic__rd_data_1a;		// From icache of ICache.v
 	wire		ic__rd_req_0a;		// From fetch of Fetch.v
-	wire		ic__rd_wait_0a;		// From icache of ICache.v
+	wire [31:0]	icache__rd_data_1a;	// From icache of ICache.v
+	wire		icache__rd_wait_0a;	// From icache of ICache.v
 	wire [31:0]	insn_1a;		// From fetch of Fetch.v
 	wire [31:0]	insn_2a;		// From issue of Issue.v
 	wire [31:0]	insn_3a;		// From execute of Execute.v
@@ -101,6 +114,9 @@ module Core(/*AUTOARG*/
 	wire [31:0]	pc_2a;			// From issue of Issue.v
 	wire [31:0]	pc_3a;			// From execute of Execute.v
 	wire [31:0]	pc_4a;			// From memory of Memory.v
+	wire [REGION_ATTR_HI:0] ra__attr_3a;	// From regionattr of RegionAttr.v
+	wire		ra__spami_busy_b;	// From regionattr of RegionAttr.v
+	wire [SPAM_DATA_HI:0] ra__spami_data;	// From regionattr of RegionAttr.v
 	wire		regfile_write;		// From writeback of Writeback.v
 	wire [31:0]	regfile_write_data;	// From writeback of Writeback.v
 	wire [3:0]	regfile_write_reg;	// From writeback of Writeback.v
@@ -149,10 +165,95 @@ module Core(/*AUTOARG*/
 	wire execute_out_backflush = jmp;
 	wire writeback_out_backflush = jmp_out_writeback;
 
+	/*** Tightly coupled memories ***/
+	
+	/* Anything that hits in a TCM gets masked off from the caches, and
+	 * the results get muxed back in on the other side.  The TCMs never
+	 * stall, so the wait signals come straight from the caches.
+	 */
+	wire        dtcm__sel_3a, dtcm__sel_4a;
+	wire [31:0] dtcm__rd_data_4a;
+	wire        itcm__sel_3a, itcm__sel_4a;
+	wire [31:0] itcm__rd_data_4a;
+	wire        itcm__isel_0a, itcm__isel_1a;
+	wire [31:0] itcm__ird_data_1a;
+	
+	wire tcm_sel_3a = dtcm__sel_3a || itcm__sel_3a;
+	
+	wire        dc__rw_wait_3a = dcache__rw_wait_3a;
+	wire [31:0] dc__rd_data_4a = dtcm__sel_4a ? dtcm__rd_data_4a :
+	                             itcm__sel_4a ? itcm__rd_data_4a :
+	                             dcache__rd_data_4a;
+	wire        ic__rd_wait_0a = icache__rd_wait_0a;
+	wire [31:0] ic__rd_data_1a = itcm__isel_1a ? itcm__ird_data_1a : icache__rd_data_1a;
+	
+	generate
+	if (DTCM == "TRUE") begin: dtcm_gen
+		TCM dtcm(/* NOT AUTOINST */
+			.clk(clk),
+			.rst_b(rst_b),
+			.tcm__addr_3a(dc__addr_3a),
+			.tcm__rd_req_3a(dc__rd_req_3a),
+			.tcm__wr_req_3a(dc__wr_req_3a),
+			.tcm__wr_data_3a(dc__wr_data_3a),
+			.tcm__sel_3a(dtcm__sel_3a),
+			.tcm__sel_4a(dtcm__sel_4a),
+			.tcm__rd_data_4a(dtcm__rd_data_4a),
+			.tcm__ird_addr_0a(32'h0),
+			.tcm__ird_req_0a(1'b0),
+			.tcm__isel_0a(),
+			.tcm__isel_1a(),
+			.tcm__ird_data_1a());
+		defparam dtcm.BASE = DTCM_BASE;
+		defparam dtcm.SIZE_BITS = DTCM_SIZE_BITS;
+		defparam dtcm.IPORT = "FALSE";
+		defparam dtcm.DEBUG = DEBUG;
+	end else begin: dtcm_tieoff
+		assign dtcm__sel_3a = 0;
+		assign dtcm__sel_4a = 0;
+		assign dtcm__rd_data_4a = 32'h0;
+	end
+	
+	if (ITCM == "TRUE") begin: itcm_gen
+		TCM itcm(/* NOT AUTOINST */
+			.clk(clk),
+			.rst_b(rst_b),
+			.tcm__addr_3a(dc__addr_3a),
+			.tcm__rd_req_3a(dc__rd_req_3a),
+			.tcm__wr_req_3a(dc__wr_req_3a),
+			.tcm__wr_data_3a(dc__wr_data_3a),
+			.tcm__sel_3a(itcm__sel_3a),
+			.tcm__sel_4a(itcm__sel_4a),
+			.tcm__rd_data_4a(itcm__rd_data_4a),
+			.tcm__ird_addr_0a(ic__rd_addr_0a),
+			.tcm__ird_req_0a(ic__rd_req_0a),
+			.tcm__isel_0a(itcm__isel_0a),
+			.tcm__isel_1a(itcm__isel_1a),
+			.tcm__ird_data_1a(itcm__ird_data_1a));
+		defparam itcm.BASE = ITCM_BASE;
+		defparam itcm.SIZE_BITS = ITCM_SIZE_BITS;
+		defparam itcm.IPORT = "TRUE";
+		defparam itcm.DEBUG = DEBUG;
+	end else begin: itcm_tieoff
+		assign itcm__sel_3a = 0;
+		assign itcm__sel_4a = 0;
+		assign itcm__rd_data_4a = 32'h0;
+		assign itcm__isel_0a = 0;
+		assign itcm__isel_1a = 0;
+		assign itcm__ird_data_1a = 32'h0;
+	end
+	endgenerate
+
+	/* ICache AUTO_TEMPLATE (
+		.ic__rd_req_0a(ic__rd_req_0a && !itcm__isel_0a),
+		.ic__rd_wait_0a(icache__rd_wait_0a),
+		.ic__rd_data_1a(icache__rd_data_1a[31:0]),
+		);
+	*/
 	ICache icache(/*AUTOINST*/
 		      // Outputs
-		      .ic__rd_wait_0a	(ic__rd_wait_0a),
-		      .ic__rd_data_1a	(ic__rd_data_1a[31:0]),
+		      .ic__rd_wait_0a	(icache__rd_wait_0a),	 // Templated
+		      .ic__rd_data_1a	(icache__rd_data_1a[31:0]), // Templated
 		      .ic__fsabo_valid	(ic__fsabo_valid),
 		      .ic__fsabo_mode	(ic__fsabo_mode[FSAB_REQ_HI:0]),
 		      .ic__fsabo_did	(ic__fsabo_did[FSAB_DID_HI:0]),
@@ -167,7 +268,7 @@ module Core(/*AUTOARG*/
 		      .clk		(clk),
 		      .rst_b		(rst_b),
 		      .ic__rd_addr_0a	(ic__rd_addr_0a[31:0]),
-		      .ic__rd_req_0a	(ic__rd_req_0a),
+		      .ic__rd_req_0a	(ic__rd_req_0a && !itcm__isel_0a), // Templated
 		      .ic__fsabo_credit	(ic__fsabo_credit),
 		      .fsabi_valid	(fsabi_valid),
 		      .fsabi_did	(fsabi_did[FSAB_DID_HI:0]),
@@ -176,10 +277,39 @@ module Core(/*AUTOARG*/
 		      .fsabi_clk	(fsabi_clk),
 		      .fsabi_rst_b	(fsabi_rst_b));
 
+	/* RegionAttr AUTO_TEMPLATE (
+		.ra__addr_3a(dc__addr_3a[31:0]),
+		);
+	*/
+	RegionAttr regionattr(/*AUTOINST*/
+			      // Outputs
+			      .ra__attr_3a	(ra__attr_3a[REGION_ATTR_HI:0]),
+			      .ra__spami_busy_b	(ra__spami_busy_b),
+			      .ra__spami_data	(ra__spami_data[SPAM_DATA_HI:0]),
+			      // Inputs
+			      .clk		(clk),
+			      .rst_b		(rst_b),
+			      .ra__addr_3a	(dc__addr_3a[31:0]),	 // Templated
+			      .spamo_valid	(spamo_valid),
+			      .spamo_r_nw	(spamo_r_nw),
+			      .spamo_did	(spamo_did[SPAM_DID_HI:0]),
+			      .spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
+			      .spamo_data	(spamo_data[SPAM_DATA_HI:0]));
+
+	/* DCache AUTO_TEMPLATE (
+		.dc__rd_req_3a(dc__rd_req_3a && !tcm_sel_3a),
+		.dc__wr_req_3a(dc__wr_req_3a && !tcm_sel_3a),
+		.dc__rw_wait_3a(dcache__rw_wait_3a),
+		.dc__rd_data_4a(dcache__rd_data_4a[31:0]),
+		.dc__attr_3a(ra__attr_3a[REGION_ATTR_HI:0]),
+		.spami_busy_b(spami_busy_b | ra__spami_busy_b),
+		.spami_data(spami_data[SPAM_DATA_HI:0] | ra__spami_data[SPAM_DATA_HI:0]),
+		);
+	*/
 	DCache dcache(/*AUTOINST*/
 		      // Outputs
-		      .dc__rw_wait_3a	(dc__rw_wait_3a),
-		      .dc__rd_data_4a	(dc__rd_data_4a[31:0]),
+		      .dc__rw_wait_3a	(dcache__rw_wait_3a),	 // Templated
+		      .dc__rd_data_4a	(dcache__rd_data_4a[31:0]), // Templated
 		      .dc__fsabo_valid	(dc__fsabo_valid),
 		      .dc__fsabo_mode	(dc__fsabo_mode[FSAB_REQ_HI:0]),
 		      .dc__fsabo_did	(dc__fsabo_did[FSAB_DID_HI:0]),
@@ -199,9 +329,10 @@ module Core(/*AUTOARG*/
 		      .clk		(clk),
 		      .rst_b		(rst_b),
 		      .dc__addr_3a	(dc__addr_3a[31:0]),
-		      .dc__rd_req_3a	(dc__rd_req_3a),
-		      .dc__wr_req_3a	(dc__wr_req_3a),
+		      .dc__rd_req_3a	(dc__rd_req_3a && !tcm_sel_3a), // Templated
+		      .dc__wr_req_3a	(dc__wr_req_3a && !tcm_sel_3a), // Templated
 		      .dc__wr_data_3a	(dc__wr_data_3a[31:0]),
+		      .dc__attr_3a	(ra__attr_3a[REGION_ATTR_HI:0]), // Templated
 		      .dc__fsabo_credit	(dc__fsabo_credit),
 		      .fsabi_valid	(fsabi_valid),
 		      .fsabi_did	(fsabi_did[FSAB_DID_HI:0]),
@@ -209,8 +340,8 @@ module Core(/*AUTOARG*/
 		      .fsabi_data	(fsabi_data[FSAB_DATA_HI:0]),
 		      .fsabi_clk	(fsabi_clk),
 		      .fsabi_rst_b	(fsabi_rst_b),
-		      .spami_busy_b	(spami_busy_b),
-		      .spami_data	(spami_data[SPAM_DATA_HI:0]));
+		      .spami_busy_b	(spami_busy_b | ra__spami_busy_b), // Templated
+		      .spami_data	(spami_data[SPAM_DATA_HI:0] | ra__spami_data[SPAM_DATA_HI:0])); // Templated
 
 	/* Fetch AUTO_TEMPLATE (
 		.jmp_0a(jmp),
@@ -441,6 +572,8 @@ module Core(/*AUTOARG*/
 
 	defparam icache.DEBUG = DEBUG;
 	defparam dcache.DEBUG = DEBUG;
+	defparam icache.SYNC_CLOCKS = SYNC_CLOCKS;
+	defparam dcache.SYNC_CLOCKS = SYNC_CLOCKS;
 
 	generate
 	if (DEBUG == "TRUE") begin: debug
@@ -1,4 +1,17 @@
-/* 16 cache entries, 64-byte long cache lines */
+/* 16 cache entries, 64-byte long cache lines
+ *
+ * Each access also comes with a region attribute (from RegionAttr):
+ *  - cacheable accesses work as they always have (write-through, no
+ *    write-allocate).
+ *  - uncached reads go out to the FSAB as single-word reads, and never
+ *    allocate; uncached writes go out just like cacheable ones.
+ *  - write-combining writes get gathered into a one-line buffer, which is
+ *    sent out as a single 64-byte burst when it fills up, when some
+ *    other access needs to go out to the bus (or to SPAM) after it, or
+ *    when nothing has been written to it for a while.  If the line also
+ *    happens to be in the cache, it gets updated, just like with any
+ *    other write.  Write-combining reads behave like uncached reads.
+ */
 
 module DCache(/*AUTOARG*/
    // Outputs
@@ -10,12 +23,13 @@ module DCache(/*AUTOARG*/
    dc__control1,
    // Inputs
    clk, rst_b, dc__addr_3a, dc__rd_req_3a, dc__wr_req_3a,
-   dc__wr_data_3a, dc__fsabo_credit, fsabi_valid, fsabi_did,
+   dc__wr_data_3a, dc__attr_3a, dc__fsabo_credit, fsabi_valid, fsabi_did,
    fsabi_subdid, fsabi_data, fsabi_clk, fsabi_rst_b, spami_busy_b,
    spami_data
    );
 	`include "fsab_defines.vh"
 	`include "spam_defines.vh"
+	`include "region_defines.vh"
 
 	input clk;
 	input rst_b;
@@ -27,6 +41,7 @@ module DCache(/*AUTOARG*/
 	output reg        dc__rw_wait_3a;
 	input      [31:0] dc__wr_data_3a;
 	output reg [31:0] dc__rd_data_4a;
+	input      [REGION_ATTR_HI:0] dc__attr_3a;
 
 	/* FSAB interface */
 	output reg                  dc__fsabo_valid;
@@ -59,20 +74,22 @@ module DCache(/*AUTOARG*/
 	inout [35:0] dc__control1;
 	
 	parameter DEBUG = "FALSE";
+	parameter SYNC_CLOCKS = "FALSE";	/* "TRUE" if clk and fsabi_clk are the same clock */
+	parameter WC_IDLE_HI = 5;	/* flush the WC buffer after 2^WC_IDLE_HI cycles without a write */
 	
 	/*** FSAB credit availability logic ***/
 	
-	/* This makes the assumption that all outbound transactions will be
-	 * exactly one cycle long.  This is correct now, but if we move to a
-	 * writeback cache, it will no longer be correct!
+	/* Write-combining flushes are eight beats long, so only the first
+	 * beat of a transaction (fsab_start) consumes a credit.
 	 */
 	
+	reg fsab_start;
 	reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;	/* XXX needs resettability */
 	wire fsab_credit_avail = (fsab_credits != 0);
 	always @(posedge clk) begin
-		if (dc__fsabo_credit | dc__fsabo_valid)
-			$display("DCACHE: Credits: %d (+%d, -%d)", fsab_credits, dc__fsabo_credit, dc__fsabo_valid);
-		fsab_credits <= fsab_credits + (dc__fsabo_credit ? 1 : 0) - (dc__fsabo_valid ? 1 : 0);
+		if (dc__fsabo_credit | fsab_start)
+			$display("DCACHE: Credits: %d (+%d, -%d)", fsab_credits, dc__fsabo_credit, fsab_start);
+		fsab_credits <= fsab_credits + (dc__fsabo_credit ? 1 : 0) - (fsab_start ? 1 : 0);
 	end
 	
 	/* [31 tag 10] [9 cache index 6] [5 data index 0]
@@ -103,11 +120,55 @@ module DCache(/*AUTOARG*/
 	
 	wire cache_hit_3a = cache_valid[idx_3a] && (cache_tags[idx_3a] == tag_3a);
 	
+	wire cacheable_3a = !dc__addr_3a[31] && (dc__attr_3a == REGION_CACHEABLE);
+	wire uncached_3a = !dc__addr_3a[31] && (dc__attr_3a != REGION_CACHEABLE);	/* for reads, WC is uncached */
+	wire wc_3a = !dc__addr_3a[31] && (dc__attr_3a == REGION_WC);
+	
+	/*** Uncached read state ***/
+	
+	/* An uncached read completes by setting uc_valid; the next cycle,
+	 * the access that asked for it (which has been stalled in 3a the
+	 * whole time) sees uc_hit_3a, and consumes it.
+	 */
+	reg uc_valid = 0;
+	reg [31:0] uc_addr = 0;
+	reg [31:0] uc_data_fclk = 0;
+	wire uc_hit_3a = uc_valid && (uc_addr[31:2] == dc__addr_3a[31:2]);
+	
+	/*** Write-combining buffer ***/
+	
+	/* wc_valid stays high until the last beat of the flush has gone
+	 * out, so nothing else can sneak out onto the bus ahead of it.
+	 */
+	reg        wc_valid = 0;
+	reg [25:0] wc_line = 0;		/* addr[31:6] */
+	reg [15:0] wc_words = 0;	/* which words in the line have been written */
+	reg [31:0] wc_data [15:0];
+	reg        wc_flushing = 0;
+	reg  [2:0] wc_beat = 0;
+	reg [WC_IDLE_HI:0] wc_idle = 0;	/* cycles since the last write into the buffer */
+	
+	wire wc_hit_3a = wc_valid && (wc_line == dc__addr_3a[31:6]);
+	wire wc_full = (wc_words == 16'hFFFF);
+	wire wc_stale = wc_idle[WC_IDLE_HI];
+	
+	/* Does this access need the WC buffer out of the way first?  Only
+	 * WC writes to the same line and cacheable read hits can get
+	 * around it.
+	 */
+	wire wc_drain_3a = (dc__rd_req_3a || dc__wr_req_3a) &&
+	                   !(dc__wr_req_3a && wc_3a && wc_hit_3a) &&
+	                   !(dc__rd_req_3a && cacheable_3a && cache_hit_3a);
+	wire wc_flush_start = rst_b && wc_valid && !wc_flushing && fsab_credit_avail && (wc_full || wc_stale || wc_drain_3a);
+	wire wc_accept_3a = rst_b && dc__wr_req_3a && wc_3a && !wc_flushing && !wc_flush_start && (!wc_valid || wc_hit_3a);
 	
 	reg read_pending = 0;
-	wire start_read = rst_b && dc__rd_req_3a && !dc__addr_3a[31] && !cache_hit_3a && !read_pending && fsab_credit_avail;
+	wire start_read = rst_b && dc__rd_req_3a && cacheable_3a && !cache_hit_3a && !read_pending && fsab_credit_avail && !wc_valid;
+	wire start_uc_read = rst_b && dc__rd_req_3a && uncached_3a && !uc_hit_3a && !read_pending && fsab_credit_avail && !wc_valid;
+	wire start_write = rst_b && dc__wr_req_3a && !dc__addr_3a[31] && !wc_3a && fsab_credit_avail && !wc_valid;
 	always @(*)
 	begin
+		fsab_start = 0;
 		dc__fsabo_valid = 0;
 		dc__fsabo_mode = {(FSAB_REQ_HI+1){1'bx}};
 		dc__fsabo_did = {(FSAB_DID_HI+1){1'bx}};
@@ -124,7 +185,19 @@ module DCache(/*AUTOARG*/
 		 * worry about credits.
 		 */
 		
-		if (start_read) begin
+		if (wc_flushing || wc_flush_start) begin
+			fsab_start = wc_flush_start;
+			dc__fsabo_valid = 1;
+			dc__fsabo_mode = FSAB_WRITE;
+			dc__fsabo_did = FSAB_DID_CPU;
+			dc__fsabo_subdid = FSAB_SUBDID_CPU_DCACHE;
+			dc__fsabo_addr = {wc_line[24:0], 3'b000, 3'b000 /* 64-bit aligned */};
+			dc__fsabo_len = 'h8;
+			dc__fsabo_data = {wc_data[{wc_beat,1'b1}], wc_data[{wc_beat,1'b0}]};
+			dc__fsabo_mask = {{4{wc_words[{wc_beat,1'b1}]}}, {4{wc_words[{wc_beat,1'b0}]}}};
+			$display("DCACHE: WC FLUSH: Addr %08x, beat %d, data %016x, mask %02x", {wc_line, 6'b0}, wc_beat, dc__fsabo_data, dc__fsabo_mask);
+		end else if (start_read) begin
+			fsab_start = 1;
 			dc__fsabo_valid = 1;
 			dc__fsabo_mode = FSAB_READ;
 			dc__fsabo_did = FSAB_DID_CPU;
@@ -132,7 +205,17 @@ module DCache(/*AUTOARG*/
 			dc__fsabo_addr = {dc__addr_3a[30:6], 3'b000, 3'b000 /* 64-bit aligned */};
 			dc__fsabo_len = 'h8; /* 64 byte cache lines, 8 byte reads */
 			$display("DCACHE: Starting read: Addr %08x", dc__fsabo_addr);
-		end else if (dc__wr_req_3a && fsab_credit_avail) begin
+		end else if (start_uc_read) begin
+			fsab_start = 1;
+			dc__fsabo_valid = 1;
+			dc__fsabo_mode = FSAB_READ;
+			dc__fsabo_did = FSAB_DID_CPU;
+			dc__fsabo_subdid = FSAB_SUBDID_CPU_DCACHE;
+			dc__fsabo_addr = {dc__addr_3a[30:3], 3'b000 /* 64-bit aligned */};
+			dc__fsabo_len = 'h1;
+			$display("DCACHE: Starting uncached read: Addr %08x", dc__addr_3a);
+		end else if (start_write) begin
+			fsab_start = 1;
 			dc__fsabo_valid = 1;
 			dc__fsabo_mode = FSAB_WRITE;
 			dc__fsabo_did = FSAB_DID_CPU;
@@ -146,6 +229,7 @@ module DCache(/*AUTOARG*/
 	end
 	
 	reg [31:0] fill_addr = 0;
+	reg fill_uc = 0;
 	wire [21:0] fill_tag = fill_addr[31:10];
 	wire [3:0] fill_idx = fill_addr[9:6];
 	
@@ -163,43 +247,99 @@ module DCache(/*AUTOARG*/
 	 */
 	reg current_read = 0;
 	reg current_read_fclk_s1 = 0;
-	reg current_read_fclk = 0;
+	reg current_read_fclk_s2 = 0;
 	reg completed_read_fclk = 0;
 	reg completed_read_s1 = 0;
-	reg completed_read = 0;
+	reg completed_read_s2 = 0;
+	
+	/* If the core and the FSAB are on the very same clock, none of the
+	 * synchronizers are needed, and skipping them saves four cycles on
+	 * every miss.
+	 */
+	wire current_read_fclk = (SYNC_CLOCKS == "TRUE") ? current_read : current_read_fclk_s2;
+	wire completed_read = (SYNC_CLOCKS == "TRUE") ? completed_read_fclk : completed_read_s2;
 	always @(posedge clk or negedge rst_b) begin
 		if (!rst_b) begin
 			for (i = 0; i < 16; i = i + 1)
 				cache_valid[i] <= 1'b0;
 			read_pending <= 0;
 			fill_addr <= 0;
-			completed_read <= 0;
+			fill_uc <= 0;
+			uc_valid <= 0;
+			uc_addr <= 0;
+			wc_valid <= 0;
+			wc_words <= 0;
+			wc_flushing <= 0;
+			wc_beat <= 0;
+			wc_idle <= 0;
+			completed_read_s2 <= 0;
 			completed_read_s1 <= 0;
 			current_read <= 0;
 		end else begin
 			completed_read_s1 <= completed_read_fclk;
-			completed_read <= completed_read_s1;
+			completed_read_s2 <= completed_read_s1;
 		
 			if (start_read) begin
 				read_pending <= 1;
 				current_read <= ~current_read;
 				fill_addr <= {dc__addr_3a[31:6], 6'b0};
+				fill_uc <= 0;
 				cache_valid[fill_idx] <= 0;
+			end else if (start_uc_read) begin
+				read_pending <= 1;
+				current_read <= ~current_read;
+				fill_addr <= dc__addr_3a;
+				fill_uc <= 1;
 			end else if ((completed_read == current_read) && read_pending) begin
-				cache_tags[fill_idx] <= fill_tag;
-				cache_valid[fill_idx] <= 1;
+				if (fill_uc) begin
+					uc_valid <= 1;
+					uc_addr <= fill_addr;
+				end else begin
+					cache_tags[fill_idx] <= fill_tag;
+					cache_valid[fill_idx] <= 1;
+				end
 				read_pending <= 0;
+			end else if ((dc__rd_req_3a || dc__wr_req_3a) && uc_valid) begin
+				/* Either it got consumed, or whoever asked for it
+				 * got flushed; either way, it's stale now.
+				 */
+				uc_valid <= 0;
+			end
+			
+			if (wc_flush_start) begin
+				wc_flushing <= 1;
+				wc_beat <= 1;
+			end else if (wc_flushing) begin
+				if (wc_beat == 7) begin
+					wc_flushing <= 0;
+					wc_valid <= 0;
+					wc_words <= 0;
+				end
+				wc_beat <= wc_beat + 1;
+			end else if (wc_accept_3a) begin
+				wc_valid <= 1;
+				wc_line <= dc__addr_3a[31:6];
+				wc_words[dc__addr_3a[5:2]] <= 1'b1;
+				wc_data[dc__addr_3a[5:2]] <= dc__wr_data_3a;
 			end
 			
+			if (wc_accept_3a || !wc_valid || wc_flushing)
+				wc_idle <= 0;
+			else if (!wc_stale)
+				wc_idle <= wc_idle + 1;
+			
 			/* This is written like this because XST is sort of silly about this sort of thing. */
 			
-			if ((dc__rd_req_3a || dc__wr_req_3a) && cache_hit_3a && dc__addr_3a[2]) begin
+			/* WC reads don't come from the cache, but WC writes
+			 * still have to keep a cached copy of the line current.
+			 */
+			if (((dc__rd_req_3a && !wc_3a) || dc__wr_req_3a) && cache_hit_3a && dc__addr_3a[2]) begin
 				if (dc__wr_req_3a)
 					cache_data_hi[{idx_3a,dc__addr_3a[5:3]}] <= dc__wr_data_3a;
 				curdata_hi_4a <= cache_data_hi[{idx_3a,dc__addr_3a[5:3]}];
 			end
 			
-			if ((dc__rd_req_3a || dc__wr_req_3a) && cache_hit_3a && ~dc__addr_3a[2]) begin
+			if (((dc__rd_req_3a && !wc_3a) || dc__wr_req_3a) && cache_hit_3a && ~dc__addr_3a[2]) begin
 				if (dc__wr_req_3a)
 					cache_data_lo[{idx_3a,dc__addr_3a[5:3]}] <= dc__wr_data_3a;
 				curdata_lo_4a <= cache_data_lo[{idx_3a,dc__addr_3a[5:3]}];
@@ -228,17 +368,22 @@ module DCache(/*AUTOARG*/
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
 			current_read_fclk_s1 <= 0;
-			current_read_fclk <= 0;
+			current_read_fclk_s2 <= 0;
 			current_read_1a_fclk <= 0;
 			completed_read_fclk <= 0;
 			cache_fill_pos_fclk <= 0;
 		end else begin
 			current_read_fclk_s1 <= current_read;
-			current_read_fclk <= current_read_fclk_s1;
+			current_read_fclk_s2 <= current_read_fclk_s1;
 			current_read_1a_fclk <= current_read_fclk;
 			
 			if (current_read_fclk ^ current_read_1a_fclk) begin
 				cache_fill_pos_fclk <= 0;
+			end else if (fsabi_valid && (fsabi_did == FSAB_DID_CPU) && (fsabi_subdid == FSAB_SUBDID_CPU_DCACHE) && fill_uc) begin
+				$display("DCACHE: UNCACHED FILL: FSAB addr %08x; FSAB data %016x", fill_addr, fsabi_data);
+				
+				uc_data_fclk <= fill_addr[2] ? fsabi_data[63:32] : fsabi_data[31:0];
+				completed_read_fclk <= current_read_fclk;
 			end else if (fsabi_valid && (fsabi_did == FSAB_DID_CPU) && (fsabi_subdid == FSAB_SUBDID_CPU_DCACHE)) begin
 				$display("DCACHE: FILL: rd addr %08x; FSAB addr %08x; FSAB data %016x", dc__addr_3a, fill_addr, fsabi_data);
 				
@@ -270,7 +415,7 @@ module DCache(/*AUTOARG*/
 		spamo_did = 4'hx;
 		spamo_addr = 24'hxxxxxx;
 		spamo_data = 32'hxxxxxxxx;
-		if ((dc__rd_req_3a || dc__wr_req_3a) && dc__addr_3a[31] && !spam_intrans && rst_b) begin
+		if ((dc__rd_req_3a || dc__wr_req_3a) && dc__addr_3a[31] && !spam_intrans && !wc_valid && rst_b) begin
 			spamo_valid = 1'b1;
 			spamo_r_nw = dc__rd_req_3a;
 			spamo_did = dc__addr_3a[27:24];
@@ -312,33 +457,51 @@ module DCache(/*AUTOARG*/
 	reg [31:0] dc__addr_4a = 0;
 	reg dc__rw_wait_4a = 0;
 	reg dc__rd_req_4a = 0;
+	reg uc_sel_4a = 0;
+	reg [31:0] uc_data_4a = 0;
 	always @(posedge clk or negedge rst_b) begin
 		if (!rst_b) begin
 			dc__addr_4a <= 32'h0;
 			dc__rw_wait_4a <= 0;
 			dc__rd_req_4a <= 0;
+			uc_sel_4a <= 0;
 		end else begin
 			dc__addr_4a <= dc__addr_3a;
 			dc__rw_wait_4a <= dc__rw_wait_3a;
 			dc__rd_req_4a <= dc__rd_req_3a;
+			uc_sel_4a <= dc__rd_req_3a && uncached_3a;
+			if (dc__rd_req_3a && uncached_3a && uc_hit_3a)
+				uc_data_4a <= uc_data_fclk;	/* stable once uc_valid is set */
 		end
 	end
 	
 	always @(*) begin
 		if (!dc__addr_3a[31]) /* FSAB */ begin
-			dc__rw_wait_3a = (dc__rd_req_3a && !cache_hit_3a) || (dc__wr_req_3a && !fsab_credit_avail);
-			if (dc__rd_req_3a && !cache_hit_3a)
+			if (dc__rd_req_3a && cacheable_3a)
+				dc__rw_wait_3a = !cache_hit_3a;
+			else if (dc__rd_req_3a)
+				dc__rw_wait_3a = !uc_hit_3a;
+			else if (dc__wr_req_3a && wc_3a)
+				dc__rw_wait_3a = !wc_accept_3a;
+			else if (dc__wr_req_3a)
+				dc__rw_wait_3a = !start_write;
+			else
+				dc__rw_wait_3a = 0;
+			if (dc__rd_req_3a && cacheable_3a && !cache_hit_3a)
 				$display("DCACHE: Stalling due to cache miss (credits %d)", fsab_credits);
-			if (dc__wr_req_3a && !fsab_credit_avail)
-				$display("DCACHE: Stalling due to insufficient credits to write");
+			if (dc__rd_req_3a && uncached_3a && !uc_hit_3a)
+				$display("DCACHE: Stalling due to uncached read (credits %d)", fsab_credits);
+			if (dc__wr_req_3a && !wc_3a && !start_write)
+				$display("DCACHE: Stalling due to insufficient credits to write, or WC flush");
 		end else /* SPAM */ begin
-			dc__rw_wait_3a = !spami_busy_b && ((spam_intrans && (spam_timeout_3a != 0)) || spamo_valid);
+			dc__rw_wait_3a = wc_valid || (!spami_busy_b && ((spam_intrans && (spam_timeout_3a != 0)) || spamo_valid));
 		end
 	end
 	
 	always @(*) begin
 		if (!dc__addr_4a[31]) /* FSAB */ begin
-			dc__rd_data_4a = dc__addr_4a[2] ? curdata_hi_4a : curdata_lo_4a;
+			dc__rd_data_4a = uc_sel_4a ? uc_data_4a :
+			                 dc__addr_4a[2] ? curdata_hi_4a : curdata_lo_4a;
 			if (!dc__rw_wait_4a && dc__rd_req_4a)
 				$display("DCACHE: READ COMPLETE: Addr %08x, data %08x", dc__addr_4a, dc__rd_data_4a);
 		end else /* SPAM */ begin
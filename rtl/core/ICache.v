@@ -47,6 +47,7 @@ module ICache(/*AUTOARG*/
 	inout [35:0] ic__control2;
 	
 	parameter DEBUG = "FALSE";
+	parameter SYNC_CLOCKS = "FALSE";	/* "TRUE" if clk and fsabi_clk are the same clock */
 
 	/*** FSAB credit availability logic ***/
 	
@@ -203,10 +204,17 @@ module ICache(/*AUTOARG*/
 	 */
 	reg current_read = 0;
 	reg current_read_fclk_s1 = 0;
-	reg current_read_fclk = 0;
+	reg current_read_fclk_s2 = 0;
 	reg completed_read_fclk = 0;
 	reg completed_read_s1 = 0;
-	reg completed_read = 0;
+	reg completed_read_s2 = 0;
+	
+	/* If the core and the FSAB are on the very same clock, none of the
+	 * synchronizers are needed, and skipping them saves four cycles on
+	 * every miss.
+	 */
+	wire current_read_fclk = (SYNC_CLOCKS == "TRUE") ? current_read : current_read_fclk_s2;
+	wire completed_read = (SYNC_CLOCKS == "TRUE") ? completed_read_fclk : completed_read_s2;
 	
 	/* XST can eat it.  Apparently I have to decompose all of my logic
 	 * into primitive instantatiations if I want xst to not
@@ -232,12 +240,12 @@ module ICache(/*AUTOARG*/
 					cache_tags[i * NWAYS + j] <= {22{1'b1}};
 			read_pending <= 0;
 			fill_addr <= 0;
-			completed_read <= 0;
+			completed_read_s2 <= 0;
 			completed_read_s1 <= 0;
 			current_read <= 0;
 		end else begin
 			completed_read_s1 <= completed_read_fclk;
-			completed_read <= completed_read_s1;
+			completed_read_s2 <= completed_read_s1;
 			cache_valid[fill_idx] <= cache_valid_next;
 		
 			if (start_read) begin
@@ -282,13 +290,13 @@ module ICache(/*AUTOARG*/
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
 			current_read_fclk_s1 <= 0;
-			current_read_fclk <= 0;
+			current_read_fclk_s2 <= 0;
 			current_read_1a_fclk <= 0;
 			completed_read_fclk <= 0;
 			cache_fill_pos_fclk <= 0;
 		end else begin
 			current_read_fclk_s1 <= current_read;
-			current_read_fclk <= current_read_fclk_s1;
+			current_read_fclk_s2 <= current_read_fclk_s1;
 			current_read_1a_fclk <= current_read_fclk;
 			
 			if (current_read_fclk ^ current_read_1a_fclk) begin
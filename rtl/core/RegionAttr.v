@@ -0,0 +1,110 @@
+/* Region attribute table.  Each entry matches addresses for which
+ * (addr & mask) == base, and hands back an attribute (REGION_*) that tells
+ * DCache how to treat them.  The lowest-numbered matching entry wins;
+ * anything that matches nothing is cacheable.  An entry with a mask of
+ * zero is disabled (which is how they all come out of reset).
+ *
+ * This lives on SPAM_DID_CORE, and is answered from inside the core, so
+ * it never sees the outside SPAM bus.
+ *
+ * Register mapping, for entry n:
+ * n0 = base
+ * n4 = mask
+ * n8 = attribute
+ */
+
+module RegionAttr(/*AUTOARG*/
+   // Outputs
+   ra__attr_3a, ra__spami_busy_b, ra__spami_data,
+   // Inputs
+   clk, rst_b, ra__addr_3a, spamo_valid, spamo_r_nw, spamo_did,
+   spamo_addr, spamo_data
+   );
+	`include "spam_defines.vh"
+	`include "region_defines.vh"
+
+	input clk;
+	input rst_b;
+
+	input      [31:0]             ra__addr_3a;
+	output reg [REGION_ATTR_HI:0] ra__attr_3a;
+
+	input                         spamo_valid;
+	input                         spamo_r_nw;
+	input      [SPAM_DID_HI:0]    spamo_did;
+	input      [SPAM_ADDR_HI:0]   spamo_addr;
+	input      [SPAM_DATA_HI:0]   spamo_data;
+
+	output reg                    ra__spami_busy_b = 0;
+	output reg [SPAM_DATA_HI:0]   ra__spami_data = 0;
+
+	parameter ENTRIES = 4;
+
+	parameter SPAM_DID = SPAM_DID_CORE;
+	parameter SPAM_ADDRPFX = 24'h000000;
+	parameter SPAM_ADDRMASK = 24'hFFFF00;
+
+	reg [31:0]             ra_base [ENTRIES-1:0];
+	reg [31:0]             ra_mask [ENTRIES-1:0];
+	reg [REGION_ATTR_HI:0] ra_attr [ENTRIES-1:0];
+
+	integer i;
+	initial
+		for (i = 0; i < ENTRIES; i = i + 1) begin
+			ra_base[i] = 0;
+			ra_mask[i] = 0;
+			ra_attr[i] = REGION_CACHEABLE;
+		end
+
+	/*** Lookup ***/
+	always @(*) begin
+		ra__attr_3a = REGION_CACHEABLE;
+		for (i = ENTRIES - 1; i >= 0; i = i - 1)
+			if ((ra_mask[i] != 0) && ((ra__addr_3a & ra_mask[i]) == ra_base[i]))
+				ra__attr_3a = ra_attr[i];
+	end
+
+	/*** Config ***/
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire [3:0] entry = spamo_addr[7:4];
+
+	always @(posedge clk or negedge rst_b)
+		if (!rst_b) begin
+			for (i = 0; i < ENTRIES; i = i + 1) begin
+				ra_base[i] <= 0;
+				ra_mask[i] <= 0;
+				ra_attr[i] <= REGION_CACHEABLE;
+			end
+			ra__spami_busy_b <= 0;
+			ra__spami_data <= 0;
+		end else begin
+			ra__spami_busy_b <= wr_decode || rd_decode;
+			ra__spami_data <= 0;
+
+			if (wr_decode && (entry < ENTRIES)) begin
+			`ifdef verilator
+				$display("REGION: entry %d, reg %d <= %08x", entry, spamo_addr[3:2], spamo_data);
+			`endif
+				case (spamo_addr[3:2])
+				2'b00: ra_base[entry] <= spamo_data;
+				2'b01: ra_mask[entry] <= spamo_data;
+				2'b10: ra_attr[entry] <= spamo_data[REGION_ATTR_HI:0];
+				default: begin end
+				endcase
+			end
+
+			if (rd_decode && (entry < ENTRIES))
+				case (spamo_addr[3:2])
+				2'b00: ra__spami_data <= ra_base[entry];
+				2'b01: ra__spami_data <= ra_mask[entry];
+				2'b10: ra__spami_data <= {{(SPAM_DATA_HI-REGION_ATTR_HI){1'b0}}, ra_attr[entry]};
+				default: ra__spami_data <= 0;
+				endcase
+		end
+endmodule
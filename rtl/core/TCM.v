@@ -0,0 +1,101 @@
+/* Tightly coupled memory: a chunk of block RAM that hangs directly off of
+ * the core, next to the caches.  Anything that decodes into the TCM's
+ * window never goes near the FSAB (or any clock domain crossing), so
+ * accesses always complete in one cycle and never stall the pipeline.
+ *
+ * The data port is always there, since that's how stuff gets into the
+ * TCM in the first place (crt0 copies .tcm down from its load address).
+ * If IPORT is "TRUE", a second read-only port is generated for Fetch, and
+ * the TCM can be used as an I-TCM.
+ *
+ * BASE must be aligned to the size of the TCM, and must not have bit 31
+ * set (that's SPAM space, and DCache will go off and do a SPAM cycle).
+ */
+
+module TCM(/*AUTOARG*/
+   // Outputs
+   tcm__sel_3a, tcm__sel_4a, tcm__rd_data_4a, tcm__isel_0a, tcm__isel_1a,
+   tcm__ird_data_1a,
+   // Inputs
+   clk, rst_b, tcm__addr_3a, tcm__rd_req_3a, tcm__wr_req_3a,
+   tcm__wr_data_3a, tcm__ird_addr_0a, tcm__ird_req_0a
+   );
+	parameter [31:0] BASE = 32'h40000000;
+	parameter SIZE_BITS = 14;	/* log2(bytes); 14 = 16KB */
+	parameter IPORT = "FALSE";
+	parameter DEBUG = "FALSE";
+
+	input clk;
+	input rst_b;
+
+	/* Data side, from Memory */
+	input      [31:0] tcm__addr_3a;
+	input             tcm__rd_req_3a;
+	input             tcm__wr_req_3a;
+	input      [31:0] tcm__wr_data_3a;
+	output wire       tcm__sel_3a;
+	output reg        tcm__sel_4a = 0;
+	output reg [31:0] tcm__rd_data_4a = 0;
+
+	/* Instruction side, from Fetch */
+	input      [31:0] tcm__ird_addr_0a;
+	input             tcm__ird_req_0a;
+	output wire       tcm__isel_0a;
+	output reg        tcm__isel_1a = 0;
+	output reg [31:0] tcm__ird_data_1a = 0;
+
+	reg [31:0] tcm_data [(1 << (SIZE_BITS - 2)) - 1:0];
+
+	integer i;
+	initial
+		for (i = 0; i < (1 << (SIZE_BITS - 2)); i = i + 1)
+			tcm_data[i] = 0;
+
+	wire [SIZE_BITS-3:0] idx_3a = tcm__addr_3a[SIZE_BITS-1:2];
+
+	assign tcm__sel_3a = (tcm__addr_3a[31:SIZE_BITS] == BASE[31:SIZE_BITS]) &&
+	                     (tcm__rd_req_3a || tcm__wr_req_3a);
+
+	/* Every write here is a full word.  STRB gets turned into a
+	 * read-modify-write by Memory, so that comes out right; STRH (and
+	 * SWPB) don't, and clobber the rest of the word with copies of the
+	 * stored value, same as they do everywhere else in memory.
+	 */
+	always @(posedge clk or negedge rst_b)
+		if (!rst_b) begin
+			tcm__sel_4a <= 0;
+		end else begin
+			tcm__sel_4a <= tcm__sel_3a;
+
+			if (tcm__sel_3a) begin
+				if (tcm__wr_req_3a)
+					tcm_data[idx_3a] <= tcm__wr_data_3a;
+				tcm__rd_data_4a <= tcm_data[idx_3a];
+			end
+		end
+
+`ifdef verilator
+	always @(posedge clk)
+		if ((DEBUG == "TRUE") && tcm__sel_3a && tcm__wr_req_3a)
+			$display("TCM: WRITE: Addr %08x, data %08x", tcm__addr_3a, tcm__wr_data_3a);
+`endif
+
+	generate
+	if (IPORT == "TRUE") begin: iport
+		wire [SIZE_BITS-3:0] iidx_0a = tcm__ird_addr_0a[SIZE_BITS-1:2];
+
+		assign tcm__isel_0a = (tcm__ird_addr_0a[31:SIZE_BITS] == BASE[31:SIZE_BITS]) && tcm__ird_req_0a;
+
+		always @(posedge clk or negedge rst_b)
+			if (!rst_b) begin
+				tcm__isel_1a <= 0;
+			end else begin
+				tcm__isel_1a <= tcm__isel_0a;
+				if (tcm__isel_0a)
+					tcm__ird_data_1a <= tcm_data[iidx_0a];
+			end
+	end else begin: iport_tieoff
+		assign tcm__isel_0a = 0;
+	end
+	endgenerate
+endmodule
@@ -0,0 +1,5 @@
+parameter REGION_ATTR_HI = 1;
+
+parameter REGION_CACHEABLE = 2'b00;
+parameter REGION_UNCACHED = 2'b01;
+parameter REGION_WC = 2'b10;
@@ -92,6 +92,7 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] accel_blit__fsabo_mode;// From accelblit of AccelBlit.v
 	wire [FSAB_DID_HI:0] accel_blit__fsabo_subdid;// From accelblit of AccelBlit.v
 	wire		accel_blit__fsabo_valid;// From accelblit of AccelBlit.v
+	wire		accel_blit__idle;// From accelblit of AccelBlit.v
 	wire		accel_blit__spami_busy_b;// From accelblit of AccelBlit.v
 	wire [SPAM_DATA_HI:0] accel_blit__spami_data;// From accelblit of AccelBlit.v
 	wire [FSAB_ADDR_HI:0] accel_clear__fsabo_addr;// From accelclear of AccelClear.v
@@ -103,8 +104,42 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] accel_clear__fsabo_mode;// From accelclear of AccelClear.v
 	wire [FSAB_DID_HI:0] accel_clear__fsabo_subdid;// From accelclear of AccelClear.v
 	wire		accel_clear__fsabo_valid;// From accelclear of AccelClear.v
+	wire		accel_clear__idle;// From accelclear of AccelClear.v
 	wire		accel_clear__spami_busy_b;// From accelclear of AccelClear.v
 	wire [SPAM_DATA_HI:0] accel_clear__spami_data;// From accelclear of AccelClear.v
+	wire		accel_cmdq__blit_wr;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__clear_wr;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_ADDR_HI:0] accel_cmdq__fsabo_addr;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__fsabo_credit;// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] accel_cmdq__fsabo_data;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_DID_HI:0] accel_cmdq__fsabo_did;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_LEN_HI:0] accel_cmdq__fsabo_len;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_MASK_HI:0] accel_cmdq__fsabo_mask;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_REQ_HI:0] accel_cmdq__fsabo_mode;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_DID_HI:0] accel_cmdq__fsabo_subdid;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__fsabo_valid;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__spami_busy_b;// From accelcmdq of AccelCmdQ.v
+	wire [SPAM_DATA_HI:0] accel_cmdq__spami_data;// From accelcmdq of AccelCmdQ.v
+	wire [7:0] accel_cmdq__wr_addr;	// From accelcmdq of AccelCmdQ.v
+	wire [31:0] accel_cmdq__wr_data;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_ADDR_HI:0] acap__fsabo_addr;	// From audio of Audio.v
+	wire		acap__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] acap__fsabo_data;	// From audio of Audio.v
+	wire [FSAB_DID_HI:0] acap__fsabo_did;	// From audio of Audio.v
+	wire [FSAB_LEN_HI:0] acap__fsabo_len;	// From audio of Audio.v
+	wire [FSAB_MASK_HI:0] acap__fsabo_mask;	// From audio of Audio.v
+	wire [FSAB_REQ_HI:0] acap__fsabo_mode;	// From audio of Audio.v
+	wire [FSAB_DID_HI:0] acap__fsabo_subdid;// From audio of Audio.v
+	wire		acap__fsabo_valid;	// From audio of Audio.v
+	wire [FSAB_ADDR_HI:0] amix__fsabo_addr;	// From audio of Audio.v
+	wire		amix__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] amix__fsabo_data;	// From audio of Audio.v
+	wire [FSAB_DID_HI:0] amix__fsabo_did;	// From audio of Audio.v
+	wire [FSAB_LEN_HI:0] amix__fsabo_len;	// From audio of Audio.v
+	wire [FSAB_MASK_HI:0] amix__fsabo_mask;	// From audio of Audio.v
+	wire [FSAB_REQ_HI:0] amix__fsabo_mode;	// From audio of Audio.v
+	wire [FSAB_DID_HI:0] amix__fsabo_subdid;// From audio of Audio.v
+	wire		amix__fsabo_valid;	// From audio of Audio.v
 	wire [FSAB_ADDR_HI:0] audio__fsabo_addr;// From audio of Audio.v
 	wire		audio__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
 	wire [FSAB_DATA_HI:0] audio__fsabo_data;// From audio of Audio.v
@@ -117,10 +152,12 @@ module System(/*AUTOARG*/
 	wire		audio__spami_busy_b;	// From audio of Audio.v
 	wire [SPAM_DATA_HI:0] audio__spami_data;// From audio of Audio.v
 	wire		cclk_preload_ready_b;	// From preload of FSABPreload.v
+	wire		arb__spami_busy_b;	// From fsabarbiter of FSABArbiter.v
+	wire [SPAM_DATA_HI:0] arb__spami_data;	// From fsabarbiter of FSABArbiter.v
 	wire		cio__spami_busy_b;	// From conio of SPAM_ConsoleIO.v
 	wire [SPAM_DATA_HI:0] cio__spami_data;	// From conio of SPAM_ConsoleIO.v
 	wire [FSAB_ADDR_HI:0] dc__fsabo_addr;	// From core of Core.v
-	wire		dc__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire		dc__fsabo_credit;	// From l2 of FSABL2.v
 	wire [FSAB_DATA_HI:0] dc__fsabo_data;	// From core of Core.v
 	wire [FSAB_DID_HI:0] dc__fsabo_did;	// From core of Core.v
 	wire [FSAB_LEN_HI:0] dc__fsabo_len;	// From core of Core.v
@@ -128,6 +165,17 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] dc__fsabo_mode;	// From core of Core.v
 	wire [FSAB_DID_HI:0] dc__fsabo_subdid;	// From core of Core.v
 	wire		dc__fsabo_valid;	// From core of Core.v
+	wire [FSAB_ADDR_HI:0] dma__fsabo_addr;	// From dma of FSABDMA.v
+	wire		dma__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] dma__fsabo_data;	// From dma of FSABDMA.v
+	wire [FSAB_DID_HI:0] dma__fsabo_did;	// From dma of FSABDMA.v
+	wire [FSAB_LEN_HI:0] dma__fsabo_len;	// From dma of FSABDMA.v
+	wire [FSAB_MASK_HI:0] dma__fsabo_mask;	// From dma of FSABDMA.v
+	wire [FSAB_REQ_HI:0] dma__fsabo_mode;	// From dma of FSABDMA.v
+	wire [FSAB_DID_HI:0] dma__fsabo_subdid;	// From dma of FSABDMA.v
+	wire		dma__fsabo_valid;	// From dma of FSABDMA.v
+	wire		dma__spami_busy_b;	// From dma of FSABDMA.v
+	wire [SPAM_DATA_HI:0] dma__spami_data;	// From dma of FSABDMA.v
 	wire [FSAB_ADDR_HI:0] fb__fsabo_addr;	// From fb of Framebuffer.v
 	wire		fb__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
 	wire [FSAB_DATA_HI:0] fb__fsabo_data;	// From fb of Framebuffer.v
@@ -139,6 +187,16 @@ module System(/*AUTOARG*/
 	wire		fb__fsabo_valid;	// From fb of Framebuffer.v
 	wire		fb__spami_busy_b;	// From fb of Framebuffer.v
 	wire [SPAM_DATA_HI:0] fb__spami_data;	// From fb of Framebuffer.v
+	wire		fb__vblank;	// From fb of Framebuffer.v
+	wire [FSAB_ADDR_HI:0] fbspr__fsabo_addr;	// From fb of Framebuffer.v
+	wire		fbspr__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] fbspr__fsabo_data;	// From fb of Framebuffer.v
+	wire [FSAB_DID_HI:0] fbspr__fsabo_did;	// From fb of Framebuffer.v
+	wire [FSAB_LEN_HI:0] fbspr__fsabo_len;	// From fb of Framebuffer.v
+	wire [FSAB_MASK_HI:0] fbspr__fsabo_mask;	// From fb of Framebuffer.v
+	wire [FSAB_REQ_HI:0] fbspr__fsabo_mode;	// From fb of Framebuffer.v
+	wire [FSAB_DID_HI:0] fbspr__fsabo_subdid;	// From fb of Framebuffer.v
+	wire		fbspr__fsabo_valid;	// From fb of Framebuffer.v
 	wire		fclk_mem_rst;		// From mem of FSABMemory.v
 	wire [FSAB_DATA_HI:0] fsabi_data;	// From mem of FSABMemory.v
 	wire [FSAB_DID_HI:0] fsabi_did;		// From mem of FSABMemory.v
@@ -154,7 +212,7 @@ module System(/*AUTOARG*/
 	wire [FSAB_DID_HI:0] fsabo_subdid;	// From fsabarbiter of FSABArbiter.v
 	wire		fsabo_valid;		// From fsabarbiter of FSABArbiter.v
 	wire [FSAB_ADDR_HI:0] ic__fsabo_addr;	// From core of Core.v
-	wire		ic__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire		ic__fsabo_credit;	// From l2 of FSABL2.v
 	wire [FSAB_DATA_HI:0] ic__fsabo_data;	// From core of Core.v
 	wire [FSAB_DID_HI:0] ic__fsabo_did;	// From core of Core.v
 	wire [FSAB_LEN_HI:0] ic__fsabo_len;	// From core of Core.v
@@ -162,6 +220,28 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] ic__fsabo_mode;	// From core of Core.v
 	wire [FSAB_DID_HI:0] ic__fsabo_subdid;	// From core of Core.v
 	wire		ic__fsabo_valid;	// From core of Core.v
+	wire [FSAB_ADDR_HI:0] l2dc__fsabo_addr;	// From l2 of FSABL2.v
+	wire		l2dc__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] l2dc__fsabo_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2dc__fsabo_did;	// From l2 of FSABL2.v
+	wire [FSAB_LEN_HI:0] l2dc__fsabo_len;	// From l2 of FSABL2.v
+	wire [FSAB_MASK_HI:0] l2dc__fsabo_mask;	// From l2 of FSABL2.v
+	wire [FSAB_REQ_HI:0] l2dc__fsabo_mode;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2dc__fsabo_subdid;	// From l2 of FSABL2.v
+	wire		l2dc__fsabo_valid;	// From l2 of FSABL2.v
+	wire [FSAB_ADDR_HI:0] l2ic__fsabo_addr;	// From l2 of FSABL2.v
+	wire		l2ic__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] l2ic__fsabo_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2ic__fsabo_did;	// From l2 of FSABL2.v
+	wire [FSAB_LEN_HI:0] l2ic__fsabo_len;	// From l2 of FSABL2.v
+	wire [FSAB_MASK_HI:0] l2ic__fsabo_mask;	// From l2 of FSABL2.v
+	wire [FSAB_REQ_HI:0] l2ic__fsabo_mode;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2ic__fsabo_subdid;	// From l2 of FSABL2.v
+	wire		l2ic__fsabo_valid;	// From l2 of FSABL2.v
+	wire [FSAB_DATA_HI:0] l2__fsabi_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2__fsabi_did;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2__fsabi_subdid;	// From l2 of FSABL2.v
+	wire		l2__fsabi_valid;	// From l2 of FSABL2.v
 	wire		lcd__spami_busy_b;	// From lcd of SPAM_LCD.v
 	wire [SPAM_DATA_HI:0] lcd__spami_data;	// From lcd of SPAM_LCD.v
 	wire		phy_init_done;		// From mem of FSABMemory.v
@@ -176,6 +256,15 @@ module System(/*AUTOARG*/
 	wire		pre__fsabo_valid;	// From preload of FSABPreload.v
 	wire		ps2__spami_busy_b;	// From ps2 of PS2.v
 	wire [SPAM_DATA_HI:0] ps2__spami_data;	// From ps2 of PS2.v
+	wire [FSAB_ADDR_HI:0] sace__fsabo_addr;	// From sysace of SPAM_SysACE.v
+	wire		sace__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] sace__fsabo_data;	// From sysace of SPAM_SysACE.v
+	wire [FSAB_DID_HI:0] sace__fsabo_did;	// From sysace of SPAM_SysACE.v
+	wire [FSAB_LEN_HI:0] sace__fsabo_len;	// From sysace of SPAM_SysACE.v
+	wire [FSAB_MASK_HI:0] sace__fsabo_mask;	// From sysace of SPAM_SysACE.v
+	wire [FSAB_REQ_HI:0] sace__fsabo_mode;	// From sysace of SPAM_SysACE.v
+	wire [FSAB_DID_HI:0] sace__fsabo_subdid;// From sysace of SPAM_SysACE.v
+	wire		sace__fsabo_valid;	// From sysace of SPAM_SysACE.v
 	wire		sace__spami_busy_b;	// From sysace of SPAM_SysACE.v
 	wire [SPAM_DATA_HI:0] sace__spami_data;	// From sysace of SPAM_SysACE.v
 	wire [SPAM_ADDR_HI:0] spamo_addr;	// From core of Core.v
@@ -244,14 +333,32 @@ module System(/*AUTOARG*/
 	
 	/*** Rest of the system (c.c) ***/
 	
-	wire spami_busy_b = cio__spami_busy_b | lcd__spami_busy_b | fb__spami_busy_b | sace__spami_busy_b | audio__spami_busy_b | ps2__spami_busy_b | timer__spami_busy_b | accel_clear__spami_busy_b | accel_blit__spami_busy_b;
-	wire [SPAM_DATA_HI:0] spami_data = cio__spami_data[SPAM_DATA_HI:0] | lcd__spami_data[SPAM_DATA_HI:0] | fb__spami_data[SPAM_DATA_HI:0] | sace__spami_data[SPAM_DATA_HI:0] | audio__spami_data[SPAM_DATA_HI:0] | ps2__spami_data[SPAM_DATA_HI:0] | timer__spami_data[SPAM_DATA_HI:0] | accel_clear__spami_data[SPAM_DATA_HI:0] | accel_blit__spami_data[SPAM_DATA_HI:0];
-
-	parameter FSAB_DEVICES = 7;
-	parameter FSAB_DEVICES_HI = 2;
-	/*AUTO_LISP(setq list-of-prefixes '("pre" "fb" "audio" "ic" "dc" "accel_clear" "accel_blit"))*/
-	wire [FSAB_DEVICES-1:0] fsabo_clks = {cclk, fbclk, aclk, cclk, cclk, fclk, fclk};
-	wire [FSAB_DEVICES-1:0] fsabo_rst_bs = {cclk_rst_b, fbclk_rst_b, ac97_reset_b, cclk_rst_b, cclk_rst_b, fclk_rst_b, fclk_rst_b};
+	wire spami_busy_b = cio__spami_busy_b | arb__spami_busy_b | lcd__spami_busy_b | fb__spami_busy_b | sace__spami_busy_b | audio__spami_busy_b | ps2__spami_busy_b | timer__spami_busy_b | accel_clear__spami_busy_b | accel_blit__spami_busy_b | dma__spami_busy_b | accel_cmdq__spami_busy_b;
+	wire [SPAM_DATA_HI:0] spami_data = cio__spami_data[SPAM_DATA_HI:0] | arb__spami_data[SPAM_DATA_HI:0] | lcd__spami_data[SPAM_DATA_HI:0] | fb__spami_data[SPAM_DATA_HI:0] | sace__spami_data[SPAM_DATA_HI:0] | audio__spami_data[SPAM_DATA_HI:0] | ps2__spami_data[SPAM_DATA_HI:0] | timer__spami_data[SPAM_DATA_HI:0] | accel_clear__spami_data[SPAM_DATA_HI:0] | accel_blit__spami_data[SPAM_DATA_HI:0] | dma__spami_data[SPAM_DATA_HI:0] | accel_cmdq__spami_data[SPAM_DATA_HI:0];
+
+	/* Set L2 to "TRUE" to put a unified L2 between the core and the
+	 * arbiter.  The L2 runs on fclk, and all of its traffic comes out of
+	 * the l2dc port.
+	 */
+	parameter L2 = "FALSE";
+
+	/* Set SYNC_CLOCKS to "TRUE" only if cclk and fclk are the very same
+	 * clock; that drops the clock crossing synchronizers out of the cache
+	 * miss paths and the arbiter.
+	 */
+	parameter SYNC_CLOCKS = "FALSE";
+
+	parameter FSAB_DEVICES = 13;
+	parameter FSAB_DEVICES_HI = 3;
+	/* Scanout and the blitter stream big linear reads, so they get more
+	 * credits (and deeper arbiter FIFOs) to keep enough reads in flight to
+	 * cover the memory latency.  Everybody else makes do with the default.
+	 */
+	parameter STREAM_CREDITS = 8;
+	parameter MEM_CREDITS = FSAB_MEM_CREDITS;
+	/*AUTO_LISP(setq list-of-prefixes '("sace" "acap" "amix" "fbspr" "accel_cmdq" "dma" "pre" "fb" "audio" "l2ic" "l2dc" "accel_clear" "accel_blit"))*/
+	wire [FSAB_DEVICES-1:0] fsabo_clks = {sace_clk, fclk, fclk, fclk, fclk, fclk, cclk, fbclk, aclk, cclk, (L2 == "TRUE") ? fclk : cclk, fclk, fclk};
+	wire [FSAB_DEVICES-1:0] fsabo_rst_bs = {cclk_rst_b, fclk_rst_b, fclk_rst_b, fclk_rst_b, fclk_rst_b, fclk_rst_b, cclk_rst_b, fbclk_rst_b, ac97_reset_b, cclk_rst_b, (L2 == "TRUE") ? fclk_rst_b : cclk_rst_b, fclk_rst_b, fclk_rst_b};
 	
 
 	/* XXX: fsabi_rst_b synch? */
@@ -260,6 +367,7 @@ module System(/*AUTOARG*/
 		.fsabi_rst_b(fclk_rst_b),
 		.fsabi_clk(fclk),
 		.clk(cclk),
+		.fsabi_\(valid\|did\|subdid\|data\)(l2__fsabi_\1[]),
 		);
 	*/
 	Core core(/*AUTOINST*/
@@ -292,15 +400,16 @@ module System(/*AUTOARG*/
 		  .rst_b		(cclk_rst_b & cclk_preload_ready_b), // Templated
 		  .ic__fsabo_credit	(ic__fsabo_credit),
 		  .dc__fsabo_credit	(dc__fsabo_credit),
-		  .fsabi_valid		(fsabi_valid),
-		  .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
-		  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
-		  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		  .fsabi_valid		(l2__fsabi_valid),	 // Templated
+		  .fsabi_did		(l2__fsabi_did[FSAB_DID_HI:0]), // Templated
+		  .fsabi_subdid		(l2__fsabi_subdid[FSAB_DID_HI:0]), // Templated
+		  .fsabi_data		(l2__fsabi_data[FSAB_DATA_HI:0]), // Templated
 		  .fsabi_clk		(fclk),			 // Templated
 		  .fsabi_rst_b		(fclk_rst_b),		 // Templated
 		  .spami_busy_b		(spami_busy_b),
 		  .spami_data		(spami_data[SPAM_DATA_HI:0]));
 	defparam core.DEBUG = "FALSE";
+	defparam core.SYNC_CLOCKS = SYNC_CLOCKS;
 	
 	wire [8:0] sys_odata;
 	wire sys_tookdata;
@@ -378,6 +487,14 @@ module System(/*AUTOARG*/
 			   .sace_mpce_n		(sace_mpce_n),
 			   .sace_mpwe_n		(sace_mpwe_n),
 			   .sace_mpoe_n		(sace_mpoe_n),
+			   .sace__fsabo_valid	(sace__fsabo_valid),
+			   .sace__fsabo_mode	(sace__fsabo_mode[FSAB_REQ_HI:0]),
+			   .sace__fsabo_did	(sace__fsabo_did[FSAB_DID_HI:0]),
+			   .sace__fsabo_subdid	(sace__fsabo_subdid[FSAB_DID_HI:0]),
+			   .sace__fsabo_addr	(sace__fsabo_addr[FSAB_ADDR_HI:0]),
+			   .sace__fsabo_len	(sace__fsabo_len[FSAB_LEN_HI:0]),
+			   .sace__fsabo_data	(sace__fsabo_data[FSAB_DATA_HI:0]),
+			   .sace__fsabo_mask	(sace__fsabo_mask[FSAB_MASK_HI:0]),
 			   // Inouts
 			   .sace_mpd		(sace_mpd[15:0]),
 			   .control_vio		(control_vio[35:0]),
@@ -389,10 +506,76 @@ module System(/*AUTOARG*/
 			   .spamo_did		(spamo_did[SPAM_DID_HI:0]),
 			   .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
 			   .spamo_data		(spamo_data[SPAM_DATA_HI:0]),
-			   .sace_clk		(sace_clk));
+			   .sace_clk		(sace_clk),
+			   .sace__fsabo_credit	(sace__fsabo_credit));
 	defparam sysace.DEBUG = "FALSE";
 
 	
+	/* FSABL2 AUTO_TEMPLATE (
+		.cclk(cclk),
+		.cclk_rst_b(cclk_rst_b),
+		.fsabi_clk(fclk),
+		.fsabi_rst_b(fclk_rst_b),
+		); */
+	FSABL2 l2(/*AUTOINST*/
+		  // Outputs
+		  .ic__fsabo_credit	(ic__fsabo_credit),
+		  .dc__fsabo_credit	(dc__fsabo_credit),
+		  .l2__fsabi_valid	(l2__fsabi_valid),
+		  .l2__fsabi_did	(l2__fsabi_did[FSAB_DID_HI:0]),
+		  .l2__fsabi_subdid	(l2__fsabi_subdid[FSAB_DID_HI:0]),
+		  .l2__fsabi_data	(l2__fsabi_data[FSAB_DATA_HI:0]),
+		  .l2ic__fsabo_valid	(l2ic__fsabo_valid),
+		  .l2ic__fsabo_mode	(l2ic__fsabo_mode[FSAB_REQ_HI:0]),
+		  .l2ic__fsabo_did	(l2ic__fsabo_did[FSAB_DID_HI:0]),
+		  .l2ic__fsabo_subdid	(l2ic__fsabo_subdid[FSAB_DID_HI:0]),
+		  .l2ic__fsabo_addr	(l2ic__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .l2ic__fsabo_len	(l2ic__fsabo_len[FSAB_LEN_HI:0]),
+		  .l2ic__fsabo_data	(l2ic__fsabo_data[FSAB_DATA_HI:0]),
+		  .l2ic__fsabo_mask	(l2ic__fsabo_mask[FSAB_MASK_HI:0]),
+		  .l2dc__fsabo_valid	(l2dc__fsabo_valid),
+		  .l2dc__fsabo_mode	(l2dc__fsabo_mode[FSAB_REQ_HI:0]),
+		  .l2dc__fsabo_did	(l2dc__fsabo_did[FSAB_DID_HI:0]),
+		  .l2dc__fsabo_subdid	(l2dc__fsabo_subdid[FSAB_DID_HI:0]),
+		  .l2dc__fsabo_addr	(l2dc__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .l2dc__fsabo_len	(l2dc__fsabo_len[FSAB_LEN_HI:0]),
+		  .l2dc__fsabo_data	(l2dc__fsabo_data[FSAB_DATA_HI:0]),
+		  .l2dc__fsabo_mask	(l2dc__fsabo_mask[FSAB_MASK_HI:0]),
+		  // Inputs
+		  .cclk			(cclk),			 // Templated
+		  .cclk_rst_b		(cclk_rst_b),		 // Templated
+		  .fsabi_clk		(fclk),			 // Templated
+		  .fsabi_rst_b		(fclk_rst_b),		 // Templated
+		  .ic__fsabo_valid	(ic__fsabo_valid),
+		  .ic__fsabo_mode	(ic__fsabo_mode[FSAB_REQ_HI:0]),
+		  .ic__fsabo_did	(ic__fsabo_did[FSAB_DID_HI:0]),
+		  .ic__fsabo_subdid	(ic__fsabo_subdid[FSAB_DID_HI:0]),
+		  .ic__fsabo_addr	(ic__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .ic__fsabo_len	(ic__fsabo_len[FSAB_LEN_HI:0]),
+		  .ic__fsabo_data	(ic__fsabo_data[FSAB_DATA_HI:0]),
+		  .ic__fsabo_mask	(ic__fsabo_mask[FSAB_MASK_HI:0]),
+		  .dc__fsabo_valid	(dc__fsabo_valid),
+		  .dc__fsabo_mode	(dc__fsabo_mode[FSAB_REQ_HI:0]),
+		  .dc__fsabo_did	(dc__fsabo_did[FSAB_DID_HI:0]),
+		  .dc__fsabo_subdid	(dc__fsabo_subdid[FSAB_DID_HI:0]),
+		  .dc__fsabo_addr	(dc__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .dc__fsabo_len	(dc__fsabo_len[FSAB_LEN_HI:0]),
+		  .dc__fsabo_data	(dc__fsabo_data[FSAB_DATA_HI:0]),
+		  .dc__fsabo_mask	(dc__fsabo_mask[FSAB_MASK_HI:0]),
+		  .l2ic__fsabo_credit	(l2ic__fsabo_credit),
+		  .l2dc__fsabo_credit	(l2dc__fsabo_credit),
+		  .fsabi_valid		(fsabi_valid),
+		  .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+		  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
+		  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		  .fsabo_valid		(fsabo_valid),
+		  .fsabo_mode		(fsabo_mode[FSAB_REQ_HI:0]),
+		  .fsabo_did		(fsabo_did[FSAB_DID_HI:0]),
+		  .fsabo_addr		(fsabo_addr[FSAB_ADDR_HI:0]),
+		  .fsabo_len		(fsabo_len[FSAB_LEN_HI:0]));
+	defparam l2.ENABLE = L2;
+	defparam l2.SYNC_CLOCKS = SYNC_CLOCKS;
+
 	/* FSABArbiter AUTO_TEMPLATE (
 		.clk(fclk),
 		.rst_b(fclk_rst_b),
@@ -405,11 +588,13 @@ module System(/*AUTOARG*/
 		.fsabo_datas(@"(template \"__fsabo_data[FSAB_DATA_HI:0]\")"),
 		.fsabo_masks(@"(template \"__fsabo_mask[FSAB_MASK_HI:0]\")"),
 		.fsabo_credits(@"(template \"__fsabo_credit\")"),
+		.cclk(cclk),
+		.cclk_rst_b(cclk_rst_b),
 		); */
 	FSABArbiter fsabarbiter(
 		/*AUTOINST*/
 				// Outputs
-				.fsabo_credits	({pre__fsabo_credit,fb__fsabo_credit,audio__fsabo_credit,ic__fsabo_credit,dc__fsabo_credit,accel_clear__fsabo_credit,accel_blit__fsabo_credit}), // Templated
+				.fsabo_credits	({sace__fsabo_credit,acap__fsabo_credit,amix__fsabo_credit,fbspr__fsabo_credit,accel_cmdq__fsabo_credit,dma__fsabo_credit,pre__fsabo_credit,fb__fsabo_credit,audio__fsabo_credit,l2ic__fsabo_credit,l2dc__fsabo_credit,accel_clear__fsabo_credit,accel_blit__fsabo_credit}), // Templated
 				.fsabo_valid	(fsabo_valid),
 				.fsabo_mode	(fsabo_mode[FSAB_REQ_HI:0]),
 				.fsabo_did	(fsabo_did[FSAB_DID_HI:0]),
@@ -418,22 +603,40 @@ module System(/*AUTOARG*/
 				.fsabo_len	(fsabo_len[FSAB_LEN_HI:0]),
 				.fsabo_data	(fsabo_data[FSAB_DATA_HI:0]),
 				.fsabo_mask	(fsabo_mask[FSAB_MASK_HI:0]),
+				.arb__spami_busy_b(arb__spami_busy_b),
+				.arb__spami_data(arb__spami_data[SPAM_DATA_HI:0]),
 				// Inputs
 				.clk		(fclk),		 // Templated
 				.rst_b		(fclk_rst_b),	 // Templated
-				.fsabo_valids	({pre__fsabo_valid,fb__fsabo_valid,audio__fsabo_valid,ic__fsabo_valid,dc__fsabo_valid,accel_clear__fsabo_valid,accel_blit__fsabo_valid}), // Templated
-				.fsabo_modes	({pre__fsabo_mode[FSAB_REQ_HI:0],fb__fsabo_mode[FSAB_REQ_HI:0],audio__fsabo_mode[FSAB_REQ_HI:0],ic__fsabo_mode[FSAB_REQ_HI:0],dc__fsabo_mode[FSAB_REQ_HI:0],accel_clear__fsabo_mode[FSAB_REQ_HI:0],accel_blit__fsabo_mode[FSAB_REQ_HI:0]}), // Templated
-				.fsabo_dids	({pre__fsabo_did[FSAB_DID_HI:0],fb__fsabo_did[FSAB_DID_HI:0],audio__fsabo_did[FSAB_DID_HI:0],ic__fsabo_did[FSAB_DID_HI:0],dc__fsabo_did[FSAB_DID_HI:0],accel_clear__fsabo_did[FSAB_DID_HI:0],accel_blit__fsabo_did[FSAB_DID_HI:0]}), // Templated
-				.fsabo_subdids	({pre__fsabo_subdid[FSAB_DID_HI:0],fb__fsabo_subdid[FSAB_DID_HI:0],audio__fsabo_subdid[FSAB_DID_HI:0],ic__fsabo_subdid[FSAB_DID_HI:0],dc__fsabo_subdid[FSAB_DID_HI:0],accel_clear__fsabo_subdid[FSAB_DID_HI:0],accel_blit__fsabo_subdid[FSAB_DID_HI:0]}), // Templated
-				.fsabo_addrs	({pre__fsabo_addr[FSAB_ADDR_HI:0],fb__fsabo_addr[FSAB_ADDR_HI:0],audio__fsabo_addr[FSAB_ADDR_HI:0],ic__fsabo_addr[FSAB_ADDR_HI:0],dc__fsabo_addr[FSAB_ADDR_HI:0],accel_clear__fsabo_addr[FSAB_ADDR_HI:0],accel_blit__fsabo_addr[FSAB_ADDR_HI:0]}), // Templated
-				.fsabo_lens	({pre__fsabo_len[FSAB_LEN_HI:0],fb__fsabo_len[FSAB_LEN_HI:0],audio__fsabo_len[FSAB_LEN_HI:0],ic__fsabo_len[FSAB_LEN_HI:0],dc__fsabo_len[FSAB_LEN_HI:0],accel_clear__fsabo_len[FSAB_LEN_HI:0],accel_blit__fsabo_len[FSAB_LEN_HI:0]}), // Templated
-				.fsabo_datas	({pre__fsabo_data[FSAB_DATA_HI:0],fb__fsabo_data[FSAB_DATA_HI:0],audio__fsabo_data[FSAB_DATA_HI:0],ic__fsabo_data[FSAB_DATA_HI:0],dc__fsabo_data[FSAB_DATA_HI:0],accel_clear__fsabo_data[FSAB_DATA_HI:0],accel_blit__fsabo_data[FSAB_DATA_HI:0]}), // Templated
-				.fsabo_masks	({pre__fsabo_mask[FSAB_MASK_HI:0],fb__fsabo_mask[FSAB_MASK_HI:0],audio__fsabo_mask[FSAB_MASK_HI:0],ic__fsabo_mask[FSAB_MASK_HI:0],dc__fsabo_mask[FSAB_MASK_HI:0],accel_clear__fsabo_mask[FSAB_MASK_HI:0],accel_blit__fsabo_mask[FSAB_MASK_HI:0]}), // Templated
+				.fsabo_valids	({sace__fsabo_valid,acap__fsabo_valid,amix__fsabo_valid,fbspr__fsabo_valid,accel_cmdq__fsabo_valid,dma__fsabo_valid,pre__fsabo_valid,fb__fsabo_valid,audio__fsabo_valid,l2ic__fsabo_valid,l2dc__fsabo_valid,accel_clear__fsabo_valid,accel_blit__fsabo_valid}), // Templated
+				.fsabo_modes	({sace__fsabo_mode[FSAB_REQ_HI:0],acap__fsabo_mode[FSAB_REQ_HI:0],amix__fsabo_mode[FSAB_REQ_HI:0],fbspr__fsabo_mode[FSAB_REQ_HI:0],accel_cmdq__fsabo_mode[FSAB_REQ_HI:0],dma__fsabo_mode[FSAB_REQ_HI:0],pre__fsabo_mode[FSAB_REQ_HI:0],fb__fsabo_mode[FSAB_REQ_HI:0],audio__fsabo_mode[FSAB_REQ_HI:0],l2ic__fsabo_mode[FSAB_REQ_HI:0],l2dc__fsabo_mode[FSAB_REQ_HI:0],accel_clear__fsabo_mode[FSAB_REQ_HI:0],accel_blit__fsabo_mode[FSAB_REQ_HI:0]}), // Templated
+				.fsabo_dids	({sace__fsabo_did[FSAB_DID_HI:0],acap__fsabo_did[FSAB_DID_HI:0],amix__fsabo_did[FSAB_DID_HI:0],fbspr__fsabo_did[FSAB_DID_HI:0],accel_cmdq__fsabo_did[FSAB_DID_HI:0],dma__fsabo_did[FSAB_DID_HI:0],pre__fsabo_did[FSAB_DID_HI:0],fb__fsabo_did[FSAB_DID_HI:0],audio__fsabo_did[FSAB_DID_HI:0],l2ic__fsabo_did[FSAB_DID_HI:0],l2dc__fsabo_did[FSAB_DID_HI:0],accel_clear__fsabo_did[FSAB_DID_HI:0],accel_blit__fsabo_did[FSAB_DID_HI:0]}), // Templated
+				.fsabo_subdids	({sace__fsabo_subdid[FSAB_DID_HI:0],acap__fsabo_subdid[FSAB_DID_HI:0],amix__fsabo_subdid[FSAB_DID_HI:0],fbspr__fsabo_subdid[FSAB_DID_HI:0],accel_cmdq__fsabo_subdid[FSAB_DID_HI:0],dma__fsabo_subdid[FSAB_DID_HI:0],pre__fsabo_subdid[FSAB_DID_HI:0],fb__fsabo_subdid[FSAB_DID_HI:0],audio__fsabo_subdid[FSAB_DID_HI:0],l2ic__fsabo_subdid[FSAB_DID_HI:0],l2dc__fsabo_subdid[FSAB_DID_HI:0],accel_clear__fsabo_subdid[FSAB_DID_HI:0],accel_blit__fsabo_subdid[FSAB_DID_HI:0]}), // Templated
+				.fsabo_addrs	({sace__fsabo_addr[FSAB_ADDR_HI:0],acap__fsabo_addr[FSAB_ADDR_HI:0],amix__fsabo_addr[FSAB_ADDR_HI:0],fbspr__fsabo_addr[FSAB_ADDR_HI:0],accel_cmdq__fsabo_addr[FSAB_ADDR_HI:0],dma__fsabo_addr[FSAB_ADDR_HI:0],pre__fsabo_addr[FSAB_ADDR_HI:0],fb__fsabo_addr[FSAB_ADDR_HI:0],audio__fsabo_addr[FSAB_ADDR_HI:0],l2ic__fsabo_addr[FSAB_ADDR_HI:0],l2dc__fsabo_addr[FSAB_ADDR_HI:0],accel_clear__fsabo_addr[FSAB_ADDR_HI:0],accel_blit__fsabo_addr[FSAB_ADDR_HI:0]}), // Templated
+				.fsabo_lens	({sace__fsabo_len[FSAB_LEN_HI:0],acap__fsabo_len[FSAB_LEN_HI:0],amix__fsabo_len[FSAB_LEN_HI:0],fbspr__fsabo_len[FSAB_LEN_HI:0],accel_cmdq__fsabo_len[FSAB_LEN_HI:0],dma__fsabo_len[FSAB_LEN_HI:0],pre__fsabo_len[FSAB_LEN_HI:0],fb__fsabo_len[FSAB_LEN_HI:0],audio__fsabo_len[FSAB_LEN_HI:0],l2ic__fsabo_len[FSAB_LEN_HI:0],l2dc__fsabo_len[FSAB_LEN_HI:0],accel_clear__fsabo_len[FSAB_LEN_HI:0],accel_blit__fsabo_len[FSAB_LEN_HI:0]}), // Templated
+				.fsabo_datas	({sace__fsabo_data[FSAB_DATA_HI:0],acap__fsabo_data[FSAB_DATA_HI:0],amix__fsabo_data[FSAB_DATA_HI:0],fbspr__fsabo_data[FSAB_DATA_HI:0],accel_cmdq__fsabo_data[FSAB_DATA_HI:0],dma__fsabo_data[FSAB_DATA_HI:0],pre__fsabo_data[FSAB_DATA_HI:0],fb__fsabo_data[FSAB_DATA_HI:0],audio__fsabo_data[FSAB_DATA_HI:0],l2ic__fsabo_data[FSAB_DATA_HI:0],l2dc__fsabo_data[FSAB_DATA_HI:0],accel_clear__fsabo_data[FSAB_DATA_HI:0],accel_blit__fsabo_data[FSAB_DATA_HI:0]}), // Templated
+				.fsabo_masks	({sace__fsabo_mask[FSAB_MASK_HI:0],acap__fsabo_mask[FSAB_MASK_HI:0],amix__fsabo_mask[FSAB_MASK_HI:0],fbspr__fsabo_mask[FSAB_MASK_HI:0],accel_cmdq__fsabo_mask[FSAB_MASK_HI:0],dma__fsabo_mask[FSAB_MASK_HI:0],pre__fsabo_mask[FSAB_MASK_HI:0],fb__fsabo_mask[FSAB_MASK_HI:0],audio__fsabo_mask[FSAB_MASK_HI:0],l2ic__fsabo_mask[FSAB_MASK_HI:0],l2dc__fsabo_mask[FSAB_MASK_HI:0],accel_clear__fsabo_mask[FSAB_MASK_HI:0],accel_blit__fsabo_mask[FSAB_MASK_HI:0]}), // Templated
 				.fsabo_clks	(fsabo_clks[FSAB_DEVICES-1:0]),
 				.fsabo_rst_bs	(fsabo_rst_bs[FSAB_DEVICES-1:0]),
-				.fsabo_credit	(fsabo_credit));
+				.fsabo_credit	(fsabo_credit),
+				.cclk		(cclk),		 // Templated
+				.cclk_rst_b	(cclk_rst_b),	 // Templated
+				.spamo_valid	(spamo_valid),
+				.spamo_r_nw	(spamo_r_nw),
+				.spamo_did	(spamo_did[SPAM_DID_HI:0]),
+				.spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
+				.spamo_data	(spamo_data[SPAM_DATA_HI:0]));
 	defparam fsabarbiter.FSAB_DEVICES = FSAB_DEVICES;
 	defparam fsabarbiter.FSAB_DEVICES_HI = FSAB_DEVICES_HI;
+	/* Scanout (and its sprites) and audio (voices and capture too) are real-time,
+	 * and the CPU stalls on its misses; everything else can wait.  Software
+	 * can change these later.
+	 */
+	defparam fsabarbiter.DEFAULT_PRIOS = {2'd0, 2'd3, 2'd3, 2'd3, 2'd0, 2'd0, 2'd0, 2'd3, 2'd3, 2'd2, 2'd2, 2'd0, 2'd0};
+	defparam fsabarbiter.SYNC_DEVICES = {1'b0, 1'b1, 1'b1, 1'b1, 1'b1, 1'b1, (SYNC_CLOCKS == "TRUE"), 1'b0, 1'b0, (SYNC_CLOCKS == "TRUE"),
+	                                     (SYNC_CLOCKS == "TRUE") || (L2 == "TRUE"), 1'b1, 1'b1};
+	defparam fsabarbiter.DEVICE_CREDITS = {8'd0, 8'd0, 8'd0, 8'd0, 8'd0, 8'd0, 8'd0, STREAM_CREDITS[7:0], 8'd0, 8'd0, 8'd0, 8'd0, STREAM_CREDITS[7:0]};
+	defparam fsabarbiter.MEM_CREDITS = MEM_CREDITS;
 	
 
 
@@ -483,6 +686,7 @@ module System(/*AUTOARG*/
 		       .fsabo_data	(fsabo_data[FSAB_DATA_HI:0]),
 		       .fsabo_mask	(fsabo_mask[FSAB_MASK_HI:0]));
 	defparam mem.DEBUG = "FALSE";
+	defparam mem.CREDITS = MEM_CREDITS;
 	
 	reg fsabo_triggered = 0;
 	reg [21:0] fsabo_recent = 0;
@@ -550,8 +754,17 @@ module System(/*AUTOARG*/
 		       .fb__fsabo_len	(fb__fsabo_len[FSAB_LEN_HI:0]),
 		       .fb__fsabo_data	(fb__fsabo_data[FSAB_DATA_HI:0]),
 		       .fb__fsabo_mask	(fb__fsabo_mask[FSAB_MASK_HI:0]),
+		       .fbspr__fsabo_valid(fbspr__fsabo_valid),
+		       .fbspr__fsabo_mode(fbspr__fsabo_mode[FSAB_REQ_HI:0]),
+		       .fbspr__fsabo_did(fbspr__fsabo_did[FSAB_DID_HI:0]),
+		       .fbspr__fsabo_subdid(fbspr__fsabo_subdid[FSAB_DID_HI:0]),
+		       .fbspr__fsabo_addr(fbspr__fsabo_addr[FSAB_ADDR_HI:0]),
+		       .fbspr__fsabo_len(fbspr__fsabo_len[FSAB_LEN_HI:0]),
+		       .fbspr__fsabo_data(fbspr__fsabo_data[FSAB_DATA_HI:0]),
+		       .fbspr__fsabo_mask(fbspr__fsabo_mask[FSAB_MASK_HI:0]),
 		       .fb__spami_busy_b(fb__spami_busy_b),
 		       .fb__spami_data	(fb__spami_data[SPAM_DATA_HI:0]),
+		       .fb__vblank	(fb__vblank),
 		       // Inouts
 		       .dvi_sda		(dvi_sda),
 		       .dvi_scl		(dvi_scl),
@@ -568,12 +781,14 @@ module System(/*AUTOARG*/
 		       .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
 		       .fsabi_data	(fsabi_data[FSAB_DATA_HI:0]),
 		       .fb__fsabo_credit(fb__fsabo_credit),
+		       .fbspr__fsabo_credit(fbspr__fsabo_credit),
 		       .spamo_valid	(spamo_valid),
 		       .spamo_r_nw	(spamo_r_nw),
 		       .spamo_did	(spamo_did[SPAM_DID_HI:0]),
 		       .spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
 		       .spamo_data	(spamo_data[SPAM_DATA_HI:0]));
 	defparam fb.DEBUG = "FALSE";
+	defparam fb.DMA_CREDITS = STREAM_CREDITS;
 
 	/* Audio AUTO_TEMPLATE (
 		.fsabi_rst_b(fclk_rst_b),
@@ -594,6 +809,22 @@ module System(/*AUTOARG*/
 		     .audio__fsabo_len	(audio__fsabo_len[FSAB_LEN_HI:0]),
 		     .audio__fsabo_data	(audio__fsabo_data[FSAB_DATA_HI:0]),
 		     .audio__fsabo_mask	(audio__fsabo_mask[FSAB_MASK_HI:0]),
+		     .amix__fsabo_valid	(amix__fsabo_valid),
+		     .amix__fsabo_mode	(amix__fsabo_mode[FSAB_REQ_HI:0]),
+		     .amix__fsabo_did	(amix__fsabo_did[FSAB_DID_HI:0]),
+		     .amix__fsabo_subdid(amix__fsabo_subdid[FSAB_DID_HI:0]),
+		     .amix__fsabo_addr	(amix__fsabo_addr[FSAB_ADDR_HI:0]),
+		     .amix__fsabo_len	(amix__fsabo_len[FSAB_LEN_HI:0]),
+		     .amix__fsabo_data	(amix__fsabo_data[FSAB_DATA_HI:0]),
+		     .amix__fsabo_mask	(amix__fsabo_mask[FSAB_MASK_HI:0]),
+		     .acap__fsabo_valid	(acap__fsabo_valid),
+		     .acap__fsabo_mode	(acap__fsabo_mode[FSAB_REQ_HI:0]),
+		     .acap__fsabo_did	(acap__fsabo_did[FSAB_DID_HI:0]),
+		     .acap__fsabo_subdid(acap__fsabo_subdid[FSAB_DID_HI:0]),
+		     .acap__fsabo_addr	(acap__fsabo_addr[FSAB_ADDR_HI:0]),
+		     .acap__fsabo_len	(acap__fsabo_len[FSAB_LEN_HI:0]),
+		     .acap__fsabo_data	(acap__fsabo_data[FSAB_DATA_HI:0]),
+		     .acap__fsabo_mask	(acap__fsabo_mask[FSAB_MASK_HI:0]),
 		     .audio__spami_busy_b(audio__spami_busy_b),
 		     .audio__spami_data	(audio__spami_data[SPAM_DATA_HI:0]),
 		     // Inouts
@@ -608,6 +839,8 @@ module System(/*AUTOARG*/
 		     .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
 		     .fsabi_data	(fsabi_data[FSAB_DATA_HI:0]),
 		     .audio__fsabo_credit(audio__fsabo_credit),
+		     .amix__fsabo_credit(amix__fsabo_credit),
+		     .acap__fsabo_credit(acap__fsabo_credit),
 		     .cclk		(cclk),
 		     .cclk_rst_b	(cclk_rst_b),
 		     .spamo_valid	(spamo_valid),
@@ -667,6 +900,7 @@ module System(/*AUTOARG*/
 			      .accel_clear__fsabo_mask(accel_clear__fsabo_mask[FSAB_MASK_HI:0]),
 			      .accel_clear__spami_busy_b(accel_clear__spami_busy_b),
 			      .accel_clear__spami_data(accel_clear__spami_data[SPAM_DATA_HI:0]),
+			      .accel_clear__idle(accel_clear__idle),
 			      // Inputs
 			      .accel_clear__fsabo_credit(accel_clear__fsabo_credit),
 			      .fsabi_clk	(fclk),		 // Templated
@@ -681,7 +915,10 @@ module System(/*AUTOARG*/
 			      .spamo_r_nw	(spamo_r_nw),
 			      .spamo_did	(spamo_did[SPAM_DID_HI:0]),
 			      .spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
-			      .spamo_data	(spamo_data[SPAM_DATA_HI:0]));
+			      .spamo_data	(spamo_data[SPAM_DATA_HI:0]),
+			      .accel_cmdq__clear_wr(accel_cmdq__clear_wr),
+			      .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			      .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]));
 	
 	/* AccelBlit AUTO_TEMPLATE (
 		.fsabi_rst_b(fclk_rst_b),
@@ -700,6 +937,7 @@ module System(/*AUTOARG*/
 			    .accel_blit__fsabo_mask(accel_blit__fsabo_mask[FSAB_MASK_HI:0]),
 			    .accel_blit__spami_busy_b(accel_blit__spami_busy_b),
 			    .accel_blit__spami_data(accel_blit__spami_data[SPAM_DATA_HI:0]),
+			    .accel_blit__idle	(accel_blit__idle),
 			    // Inputs
 			    .accel_blit__fsabo_credit(accel_blit__fsabo_credit),
 			    .fsabi_clk		(fclk),		 // Templated
@@ -714,8 +952,84 @@ module System(/*AUTOARG*/
 			    .spamo_r_nw		(spamo_r_nw),
 			    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
 			    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+			    .spamo_data		(spamo_data[SPAM_DATA_HI:0]),
+			    .accel_cmdq__blit_wr(accel_cmdq__blit_wr),
+			    .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			    .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]));
+	defparam accelblit.CREDITS = STREAM_CREDITS;
+
+	/* AccelCmdQ AUTO_TEMPLATE (
+		.fsabi_rst_b(fclk_rst_b),
+		.fsabi_clk(fclk),
+		);
+	*/
+	AccelCmdQ accelcmdq(/*AUTOINST*/
+			    // Outputs
+			    .accel_cmdq__fsabo_valid(accel_cmdq__fsabo_valid),
+			    .accel_cmdq__fsabo_mode(accel_cmdq__fsabo_mode[FSAB_REQ_HI:0]),
+			    .accel_cmdq__fsabo_did(accel_cmdq__fsabo_did[FSAB_DID_HI:0]),
+			    .accel_cmdq__fsabo_subdid(accel_cmdq__fsabo_subdid[FSAB_DID_HI:0]),
+			    .accel_cmdq__fsabo_addr(accel_cmdq__fsabo_addr[FSAB_ADDR_HI:0]),
+			    .accel_cmdq__fsabo_len(accel_cmdq__fsabo_len[FSAB_LEN_HI:0]),
+			    .accel_cmdq__fsabo_data(accel_cmdq__fsabo_data[FSAB_DATA_HI:0]),
+			    .accel_cmdq__fsabo_mask(accel_cmdq__fsabo_mask[FSAB_MASK_HI:0]),
+			    .accel_cmdq__clear_wr(accel_cmdq__clear_wr),
+			    .accel_cmdq__blit_wr(accel_cmdq__blit_wr),
+			    .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			    .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]),
+			    .accel_cmdq__spami_busy_b(accel_cmdq__spami_busy_b),
+			    .accel_cmdq__spami_data(accel_cmdq__spami_data[SPAM_DATA_HI:0]),
+			    // Inputs
+			    .accel_cmdq__fsabo_credit(accel_cmdq__fsabo_credit),
+			    .fsabi_clk		(fclk),		 // Templated
+			    .fsabi_rst_b	(fclk_rst_b),	 // Templated
+			    .fsabi_valid	(fsabi_valid),
+			    .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+			    .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+			    .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+			    .accel_clear__idle	(accel_clear__idle),
+			    .accel_blit__idle	(accel_blit__idle),
+			    .fb__vblank		(fb__vblank),
+			    .cclk		(cclk),
+			    .cclk_rst_b		(cclk_rst_b),
+			    .spamo_valid	(spamo_valid),
+			    .spamo_r_nw		(spamo_r_nw),
+			    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+			    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
 			    .spamo_data		(spamo_data[SPAM_DATA_HI:0]));
 
+	/* FSABDMA AUTO_TEMPLATE (
+		.fsabi_clk(fclk),
+		.fsabi_rst_b(fclk_rst_b),
+		); */
+	FSABDMA dma(/*AUTOINST*/
+		    // Outputs
+		    .dma__fsabo_valid	(dma__fsabo_valid),
+		    .dma__fsabo_mode	(dma__fsabo_mode[FSAB_REQ_HI:0]),
+		    .dma__fsabo_did	(dma__fsabo_did[FSAB_DID_HI:0]),
+		    .dma__fsabo_subdid	(dma__fsabo_subdid[FSAB_DID_HI:0]),
+		    .dma__fsabo_addr	(dma__fsabo_addr[FSAB_ADDR_HI:0]),
+		    .dma__fsabo_len	(dma__fsabo_len[FSAB_LEN_HI:0]),
+		    .dma__fsabo_data	(dma__fsabo_data[FSAB_DATA_HI:0]),
+		    .dma__fsabo_mask	(dma__fsabo_mask[FSAB_MASK_HI:0]),
+		    .dma__spami_busy_b	(dma__spami_busy_b),
+		    .dma__spami_data	(dma__spami_data[SPAM_DATA_HI:0]),
+		    // Inputs
+		    .dma__fsabo_credit	(dma__fsabo_credit),
+		    .fsabi_clk		(fclk),		 // Templated
+		    .fsabi_rst_b	(fclk_rst_b),	 // Templated
+		    .fsabi_valid	(fsabi_valid),
+		    .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+		    .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+		    .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		    .cclk		(cclk),
+		    .cclk_rst_b		(cclk_rst_b),
+		    .spamo_valid	(spamo_valid),
+		    .spamo_r_nw		(spamo_r_nw),
+		    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+		    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+		    .spamo_data		(spamo_data[SPAM_DATA_HI:0]));
+
 endmodule
 
 module DCM(input fclk, output cclk, input rst, output ready);
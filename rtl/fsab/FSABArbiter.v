@@ -1,15 +1,36 @@
+/* QoS register mapping (SPAM_DID_FSAB), 0x20 apart, for device n:
+ * n*20 + 00 = priority class (0-3; higher wins)
+ * n*20 + 04 = token bucket period, in clk cycles per token (0 = no
+ *             reservation)
+ * n*20 + 08 = token bucket depth (0-15 tokens)
+ * n*20 + 0C = latency cap, in clk cycles (0 = none)
+ * n*20 + 10 = starvation counter: total cycles spent waiting for a grant
+ *             (read-only; any write clears it)
+ * n*20 + 14 = longest wait for a single grant, in cycles (ditto)
+ * The window is big enough for every device that FSAB_DEVICES_HI can
+ * number, so all of them can be reached.
+ *
+ * Selection goes: anything that has waited longer than its latency cap,
+ * then anything that holds a token, then by priority class; ties go to
+ * the highest-numbered device, as they always have.
+ */
+
 module FSABArbiter(/*AUTOARG*/
    // Outputs
    fsabo_credits, fsabo_valid, fsabo_mode, fsabo_did, fsabo_subdid,
-   fsabo_addr, fsabo_len, fsabo_data, fsabo_mask,
+   fsabo_addr, fsabo_len, fsabo_data, fsabo_mask, arb__spami_busy_b,
+   arb__spami_data,
    // Inputs
    clk, rst_b, fsabo_valids, fsabo_modes, fsabo_dids, fsabo_subdids,
    fsabo_addrs, fsabo_lens, fsabo_datas, fsabo_masks, fsabo_clks,
-   fsabo_rst_bs, fsabo_credit
+   fsabo_rst_bs, fsabo_credit, cclk, cclk_rst_b, spamo_valid,
+   spamo_r_nw, spamo_did, spamo_addr, spamo_data
    );
 	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
 
 	parameter FSAB_DEVICES = 3;	/* Can be changed externally. */
+	parameter SYNC_DEVICES = 0;	/* Bit n set: device n is clocked by clk. */
 
 	input                                       clk;
 	input                                       rst_b;
@@ -35,9 +56,42 @@ module FSABArbiter(/*AUTOARG*/
 	output wire [FSAB_DATA_HI:0]                fsabo_data;
 	output wire [FSAB_MASK_HI:0]                fsabo_mask;
 	input                                       fsabo_credit;
+	
+	/* SPAM interface, for QoS configuration */
+	input                                       cclk;
+	input                                       cclk_rst_b;
+	
+	input                                       spamo_valid;
+	input                                       spamo_r_nw;
+	input [SPAM_DID_HI:0]                       spamo_did;
+	input [SPAM_ADDR_HI:0]                      spamo_addr;
+	input [SPAM_DATA_HI:0]                      spamo_data;
+	
+	output reg                                  arb__spami_busy_b = 0;
+	output reg [SPAM_DATA_HI:0]                 arb__spami_data = 0;
+
+	parameter SPAM_DID = SPAM_DID_FSAB;
+	parameter SPAM_ADDRPFX = 24'h000000;
+	
+	/* Two bits per device, device 0 in the bottom. */
+	parameter DEFAULT_PRIOS = 0;
+	
+	/* Eight bits per device, device 0 in the bottom; this is how many
+	 * credits each client starts with, and sizes its FIFOs to match.  A
+	 * zero means FSAB_INITIAL_CREDITS.
+	 */
+	parameter DEVICE_CREDITS = 0;
+	
+	/* How many requests the memory controller will queue up for us. */
+	parameter MEM_CREDITS = FSAB_MEM_CREDITS;
 
 	`include "clog2.vh"
 	parameter FSAB_DEVICES_HI = clog2(FSAB_DEVICES)+1;
+	parameter MEM_CREDITS_HI = clog2(MEM_CREDITS)-1;
+	
+	/* QoS register number: {device, register}, from spamo_addr[QOS_REG_HI+2:2]. */
+	parameter QOS_REG_HI = FSAB_DEVICES_HI + 3;
+	parameter SPAM_ADDRMASK = (24'hFFFFFF << (QOS_REG_HI + 3)) & 24'hFFFFFF;
 
 	/* The theory internal to these state machines (generated with a
 	 * genvar, so that we can split out the input bit vectors) is that
@@ -98,56 +152,189 @@ module FSABArbiter(/*AUTOARG*/
 				     .inp_mask		(fsabo_masks[`ARB_BITS(FSAB_MASK_HI)]),
 				     .start_trans	(fifo_start[i]));
 		defparam fifo.myindex = i;
+		defparam fifo.SYNC_CLOCKS = ((SYNC_DEVICES >> i) & 1) ? "TRUE" : "FALSE";
+		defparam fifo.CREDITS = ((DEVICE_CREDITS >> (i * 8)) & 8'hFF) ? ((DEVICE_CREDITS >> (i * 8)) & 8'hFF)
+		                                                             : FSAB_INITIAL_CREDITS;
 	end
 	endgenerate
 	
 	/*** Outbound credit availability ***/
-	reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;
+	reg [MEM_CREDITS_HI:0] fsab_credits = MEM_CREDITS;
 	wire fsab_credit_avail = (fsab_credits != 0);
 	always @(posedge clk or negedge rst_b)
 		if (!rst_b) begin
-			fsab_credits <= FSAB_INITIAL_CREDITS;
+			fsab_credits <= MEM_CREDITS;
 		end else begin
 			if (fsabo_credit | (|fifo_start))
 				$display("ARB: %5d: Credits: %d (+%d, -%d)", $time, fsab_credits, fsabo_credit, |fifo_start);
 			fsab_credits <= fsab_credits + (fsabo_credit ? 1 : 0) - ((|fifo_start) ? 1 : 0);
 		end
 	
+	/*** QoS state ***/
+	reg  [1:0]  qos_prio [FSAB_DEVICES-1:0];
+	reg  [15:0] qos_tb_period [FSAB_DEVICES-1:0];
+	reg  [15:0] qos_tb_timer [FSAB_DEVICES-1:0];
+	reg  [3:0]  qos_tb_depth [FSAB_DEVICES-1:0];
+	reg  [3:0]  qos_tb_tokens [FSAB_DEVICES-1:0];
+	reg  [15:0] qos_lat_cap [FSAB_DEVICES-1:0];
+	reg  [15:0] qos_wait [FSAB_DEVICES-1:0];
+	reg  [15:0] qos_max_wait [FSAB_DEVICES-1:0];
+	reg  [31:0] qos_starve [FSAB_DEVICES-1:0];
+	
+	wire        qos_wr_strobe;
+	wire [QOS_REG_HI:0] qos_wr_reg;	/* {device, register} */
+	wire [31:0] qos_wr_data;
+	
+	/* A device is waiting if it has a request queued up, but isn't
+	 * currently being served.
+	 */
+	wire [FSAB_DEVICES-1:0] qos_waiting = fifo_empty_b & ~fifo_active;
+	
+	reg [FSAB_DEVICES-1:0] qos_tb_refill;	/* combinatorial */
+	
+	integer ii;	/* must be distinct from 'i', due to genvar i */
+	initial
+		for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1) begin
+			qos_prio[ii] = (DEFAULT_PRIOS >> (ii * 2)) & 2'b11;
+			qos_tb_period[ii] = 0;
+			qos_tb_timer[ii] = 0;
+			qos_tb_depth[ii] = 0;
+			qos_tb_tokens[ii] = 0;
+			qos_lat_cap[ii] = 0;
+			qos_wait[ii] = 0;
+			qos_max_wait[ii] = 0;
+			qos_starve[ii] = 0;
+		end
+	
+	/* verilator lint_off WIDTH */
+	always @(*)
+		for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1)
+			qos_tb_refill[ii] = (qos_tb_timer[ii] >= (qos_tb_period[ii] - 1));
+	
+	always @(posedge clk or negedge rst_b)
+		if (!rst_b) begin
+			for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1) begin
+				qos_prio[ii] <= (DEFAULT_PRIOS >> (ii * 2)) & 2'b11;
+				qos_tb_period[ii] <= 0;
+				qos_tb_timer[ii] <= 0;
+				qos_tb_depth[ii] <= 0;
+				qos_tb_tokens[ii] <= 0;
+				qos_lat_cap[ii] <= 0;
+				qos_wait[ii] <= 0;
+				qos_max_wait[ii] <= 0;
+				qos_starve[ii] <= 0;
+			end
+		end else begin
+			for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1) begin
+				/* Token bucket refill; a grant spends a token. */
+				if (qos_tb_period[ii] == 0) begin
+					qos_tb_timer[ii] <= 0;
+					qos_tb_tokens[ii] <= 0;
+				end else begin
+					qos_tb_timer[ii] <= qos_tb_refill[ii] ? 0 : (qos_tb_timer[ii] + 1);
+					qos_tb_tokens[ii] <= qos_tb_tokens[ii]
+					                     + ((qos_tb_refill[ii] && (qos_tb_tokens[ii] < qos_tb_depth[ii])) ? 1 : 0)
+					                     - ((fifo_start[ii] && (qos_tb_tokens[ii] != 0)) ? 1 : 0);
+				end
+				
+				/* Wait tracking. */
+				if (fifo_start[ii]) begin
+					if (qos_wait[ii] > qos_max_wait[ii])
+						qos_max_wait[ii] <= qos_wait[ii];
+					qos_wait[ii] <= 0;
+				end else if (qos_waiting[ii]) begin
+					if (qos_wait[ii] != 16'hFFFF)
+						qos_wait[ii] <= qos_wait[ii] + 1;
+					if (qos_starve[ii] != 32'hFFFFFFFF)
+						qos_starve[ii] <= qos_starve[ii] + 1;
+				end
+			end
+			
+			if (qos_wr_strobe && (qos_wr_reg[QOS_REG_HI:3] < FSAB_DEVICES)) begin
+			`ifdef verilator
+				$display("ARB: QoS: device %d, reg %d <= %08x", qos_wr_reg[QOS_REG_HI:3], qos_wr_reg[2:0], qos_wr_data);
+			`endif
+				case (qos_wr_reg[2:0])
+				3'h0: qos_prio[qos_wr_reg[QOS_REG_HI:3]] <= qos_wr_data[1:0];
+				3'h1: qos_tb_period[qos_wr_reg[QOS_REG_HI:3]] <= qos_wr_data[15:0];
+				3'h2: qos_tb_depth[qos_wr_reg[QOS_REG_HI:3]] <= qos_wr_data[3:0];
+				3'h3: qos_lat_cap[qos_wr_reg[QOS_REG_HI:3]] <= qos_wr_data[15:0];
+				3'h4: qos_starve[qos_wr_reg[QOS_REG_HI:3]] <= 0;
+				3'h5: qos_max_wait[qos_wr_reg[QOS_REG_HI:3]] <= 0;
+				default: begin end
+				endcase
+			end
+		end
+	/* verilator lint_on WIDTH */
+	
+	/* {urgent, holds a token, priority class} */
+	reg [3:0] qos_score [FSAB_DEVICES-1:0];	/* combinatorial */
+	always @(*)
+		for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1)
+			qos_score[ii] = {(qos_lat_cap[ii] != 0) && (qos_wait[ii] >= qos_lat_cap[ii]),
+			                 (qos_tb_tokens[ii] != 0),
+			                 qos_prio[ii]};
+
 	/*** Device selection ***/
-	reg [FSAB_DEVICES_HI:0] current_device_next = {(FSAB_DEVICES_HI+1){1'b0}};
+	/* The winner is picked a cycle ahead of time, while the current
+	 * transaction is still draining, so that the scoring logic stays
+	 * off of the path from 'current transaction is done' to 'next FIFO
+	 * starts reading'.  A FIFO drops 'active' on the cycle that its last
+	 * beat is on the bus, and we start the preselected one right then,
+	 * so its first beat goes out on the very next cycle.
+	 *
+	 * The preselection can be stale by a cycle: if the device it picked
+	 * has since gone empty, we just don't start anything this time
+	 * around.
+	 */
+	reg [FSAB_DEVICES_HI:0] current_device_next = {(FSAB_DEVICES_HI+1){1'b0}};	/* combinatorial */
 	reg [FSAB_DEVICES_HI:0] current_device = {(FSAB_DEVICES_HI+1){1'b0}};
+	reg [FSAB_DEVICES_HI:0] presel_device = {(FSAB_DEVICES_HI+1){1'b0}};
+	reg                     presel_valid = 0;
 	wire new_selection = !fifo_active[current_device];
 
-	/* XXX: Currently, selection is unfair (the largest numbered device
-	 * gets to go the most often).  It would be nice to make this fair.
-	 */
-
-	integer ii;	/* must be distinct from 'i', due to genvar i */
+	reg [3:0] best_score;	/* combinatorial */
+	reg best_found;
+	
 	/* verilator lint_off WIDTH */ /* assigning an int to a reg */
 	always @(*) begin
 		current_device_next = {(FSAB_DEVICES_HI+1){1'b0}};
+		best_score = 4'h0;
+		best_found = 0;
 		for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1)
-			if (fifo_empty_b[ii])
+			if (fifo_empty_b[ii] && (!best_found || (qos_score[ii] >= best_score))) begin
 				current_device_next = ii;
+				best_score = qos_score[ii];
+				best_found = 1;
+			end
 	end
 	/* verilator lint_on WIDTH */ /* assigning an int to a reg */
 	
 	always @(posedge clk or negedge rst_b)
 		if (!rst_b) begin
 			current_device <= {(FSAB_DEVICES_HI+1){1'b0}};
+			presel_device <= {(FSAB_DEVICES_HI+1){1'b0}};
+			presel_valid <= 0;
 		end else begin
-			if (new_selection)
-				current_device <= current_device_next;
+			presel_device <= current_device_next;
+			presel_valid <= best_found;
+			if (|fifo_start)
+				current_device <= presel_device;
 		end
 	
 	/* verilator lint_off WIDTH */ /* comparing an int to a reg */
 	always @(*)
 		for (ii = 0; ii < FSAB_DEVICES; ii = ii + 1)
-			fifo_start[ii] = new_selection && (current_device_next == ii) && fifo_empty_b[ii] && fsab_credit_avail;
+			fifo_start[ii] = new_selection && presel_valid && (presel_device == ii) && fifo_empty_b[ii] && fsab_credit_avail;
 	/* verilator lint_on WIDTH */ /* comparing an int to a reg */
 	
 	/*** Output routing ***/
-	assign fsabo_valid = fifo_valid[current_device] & fifo_active[current_device];	/* Mask off bogons that might be left over. */
+	/* A FIFO only ever raises out_valid the cycle after it did a dfif
+	 * read, and it only does those while it's the current device (or on
+	 * the cycle it gets started, which is when the mux switches over to
+	 * it), so there's nothing to mask off here.
+	 */
+	assign fsabo_valid = fifo_valid[current_device];
 	assign fsabo_mode = fifo_mode[current_device];
 	assign fsabo_did = fifo_did[current_device];
 	assign fsabo_subdid = fifo_subdid[current_device];
@@ -156,4 +343,79 @@ module FSABArbiter(/*AUTOARG*/
 	assign fsabo_data = fifo_data[current_device];
 	assign fsabo_mask = fifo_mask[current_device];
 	
+	/*** QoS configuration ***/
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	
+	wire wr_done_strobe_QOS;
+	CSRAsyncWrite #(.WIDTH       (QOS_REG_HI + 33),
+	                .RESET_VALUE ({(QOS_REG_HI + 33){1'b0}}))
+		CSR_QOS   (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_QOS),
+		           .wr_strobe_tclk     (qos_wr_strobe),
+		           .wr_data_tclk       ({qos_wr_reg, qos_wr_data}),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (rst_b),
+		           .wr_strobe_cclk     (wr_decode),
+		           .wr_data_cclk       ({spamo_addr[QOS_REG_HI+2:2], spamo_data}));
+	
+	/* The register being read is latched on the cclk side, and held
+	 * until the next read comes along; by the time the read strobe has
+	 * made it across to clk, it has been stable for a long time.
+	 */
+	reg [QOS_REG_HI:0] qos_rd_reg = 0;
+	always @(posedge cclk)
+		if (rd_decode)
+			qos_rd_reg <= spamo_addr[QOS_REG_HI+2:2];
+	
+	reg [31:0] qos_rd_data;	/* combinatorial */
+	/* verilator lint_off WIDTH */
+	always @(*)
+		if (qos_rd_reg[QOS_REG_HI:3] >= FSAB_DEVICES)
+			qos_rd_data = 32'h0;
+		else case (qos_rd_reg[2:0])
+		3'h0: qos_rd_data = {30'h0, qos_prio[qos_rd_reg[QOS_REG_HI:3]]};
+		3'h1: qos_rd_data = {16'h0, qos_tb_period[qos_rd_reg[QOS_REG_HI:3]]};
+		3'h2: qos_rd_data = {28'h0, qos_tb_depth[qos_rd_reg[QOS_REG_HI:3]]};
+		3'h3: qos_rd_data = {16'h0, qos_lat_cap[qos_rd_reg[QOS_REG_HI:3]]};
+		3'h4: qos_rd_data = qos_starve[qos_rd_reg[QOS_REG_HI:3]];
+		3'h5: qos_rd_data = {16'h0, qos_max_wait[qos_rd_reg[QOS_REG_HI:3]]};
+		default: qos_rd_data = 32'h0;
+		endcase
+	/* verilator lint_on WIDTH */
+	
+	wire [31:0] rd_data_QOS;
+	wire rd_done_strobe_QOS;
+	CSRAsyncRead #(.WIDTH        (32))
+		CSR_QOS_READ        (/* NOT AUTOINST */
+				     // Outputs
+				     .rd_data_cclk	(rd_data_QOS),
+				     .rd_wait_cclk	(),
+				     .rd_done_strobe_cclk(rd_done_strobe_QOS),
+				     .rd_strobe_tclk	(),
+				     // Inputs
+				     .cclk		(cclk),
+				     .tclk		(clk),
+				     .rst_b_cclk	(cclk_rst_b),
+				     .rst_b_tclk	(rst_b),
+				     .rd_strobe_cclk	(rd_decode),
+				     .rd_data_tclk	(qos_rd_data));
+	
+	always @(posedge cclk or negedge cclk_rst_b)
+		if (!cclk_rst_b) begin
+			arb__spami_busy_b <= 0;
+			arb__spami_data <= 0;
+		end else begin
+			arb__spami_busy_b <= wr_done_strobe_QOS | rd_done_strobe_QOS;
+			arb__spami_data <= {32{rd_done_strobe_QOS}} & rd_data_QOS;
+		end
 endmodule
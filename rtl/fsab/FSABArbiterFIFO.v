@@ -39,20 +39,35 @@ module FSABArbiterFIFO(/*AUTOARG*/
 	output wire                  active;
 
 	parameter myindex = 0;
+	
+	/* If the input side is clocked by the very same clock as the output
+	 * side, set this to "TRUE"; we then use plain synchronous FIFOs, and
+	 * hand credits back directly, rather than paying for the
+	 * synchronizers on every transaction.
+	 */
+	parameter SYNC_CLOCKS = "FALSE";
+	
+	/* How many requests the client may have outstanding at once; this
+	 * sizes both FIFOs, and must match the client's own idea of how
+	 * many credits it started with.
+	 */
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
 
 	/*** Inbound credit synchronization ***/
 	wire inp_credit_oclk;
-	reg [FSAB_CREDITS_HI:0] inp_credits_iclk = 'h0;
-	reg [FSAB_CREDITS_HI:0] inp_credits_oclk = 'h0;
-	wire [FSAB_CREDITS_HI:0] inp_credits_oclk_next = inp_credit_oclk ? (inp_credits_oclk + 1) : inp_credits_oclk;
+	reg [CREDITS_HI:0] inp_credits_iclk = 'h0;
+	reg [CREDITS_HI:0] inp_credits_oclk = 'h0;
+	wire [CREDITS_HI:0] inp_credits_oclk_next = inp_credit_oclk ? (inp_credits_oclk + 1) : inp_credits_oclk;
 	
-	reg [FSAB_CREDITS_HI:0] inp_credits_g_oclk = 'h0;
-	reg [FSAB_CREDITS_HI:0] inp_credits_oclk_g_iclk_s1 = 'h0;
-	reg [FSAB_CREDITS_HI:0] inp_credits_oclk_g_iclk = 'h0;
+	reg [CREDITS_HI:0] inp_credits_g_oclk = 'h0;
+	reg [CREDITS_HI:0] inp_credits_oclk_g_iclk_s1 = 'h0;
+	reg [CREDITS_HI:0] inp_credits_oclk_g_iclk = 'h0;
 	
-	wire [FSAB_CREDITS_HI:0] inp_credits_g_iclk = (inp_credits_iclk >> 1) ^ inp_credits_iclk;
+	wire [CREDITS_HI:0] inp_credits_g_iclk = (inp_credits_iclk >> 1) ^ inp_credits_iclk;
 	
-	assign inp_credit = inp_credits_oclk_g_iclk != inp_credits_g_iclk;
+	assign inp_credit = (SYNC_CLOCKS == "TRUE") ? inp_credit_oclk
+	                                           : (inp_credits_oclk_g_iclk != inp_credits_g_iclk);
 	
 	/* The grey code must be flopped on both the oclk and the iclk
 	 * side:
@@ -90,7 +105,7 @@ module FSABArbiterFIFO(/*AUTOARG*/
 	
 	/*** Inbound request FIFO (RFIF) ***/
 
-`define ARB_RFIF_DEPTH (FSAB_INITIAL_CREDITS)
+`define ARB_RFIF_DEPTH (CREDITS)
 `define ARB_RFIF_WIDTH (FSAB_REQ_HI+1 + FSAB_DID_HI+1 + FSAB_DID_HI+1 + FSAB_ADDR_HI+1 + FSAB_LEN_HI+1)
 	wire rfif_wr_0a_iclk;
 	wire rfif_rd_0a_oclk;
@@ -98,18 +113,36 @@ module FSABArbiterFIFO(/*AUTOARG*/
 	wire rfif_full_0a_iclk;
 	reg  [`ARB_RFIF_WIDTH-1:0] rfif_wdat_0a_iclk = 'h0;
 	wire [`ARB_RFIF_WIDTH-1:0] rfif_rdat_1a_oclk;
-	AsyncFifo #(.DEPTH          (`ARB_RFIF_DEPTH),
-	            .WIDTH          (`ARB_RFIF_WIDTH))
-	rfif       (.iclk           (iclk),
-	            .oclk           (oclk),
-	            .iclk_rst_b     (iclk_rst_b),
-	            .oclk_rst_b     (oclk_rst_b),
-	            .wr_en          (rfif_wr_0a_iclk),
-	            .rd_en          (rfif_rd_0a_oclk),
-	            .wr_dat         (rfif_wdat_0a_iclk),
-	            .rd_dat         (rfif_rdat_1a_oclk),
-	            .empty          (rfif_empty_0a_oclk),
-	            .full           (rfif_full_0a_iclk));
+	generate
+	if (SYNC_CLOCKS == "TRUE") begin: rfif_sync
+		Fifo #(.DEPTH          (`ARB_RFIF_DEPTH),
+		       .WIDTH          (`ARB_RFIF_WIDTH))
+		rfif  (.clk            (oclk),
+		       .rst_b          (oclk_rst_b),
+		       .wr_en          (rfif_wr_0a_iclk),
+		       .rd_en          (rfif_rd_0a_oclk),
+		       .wr_dat         (rfif_wdat_0a_iclk),
+		       .rd_dat         (rfif_rdat_1a_oclk),
+		       .empty          (rfif_empty_0a_oclk),
+		       .full           (rfif_full_0a_iclk),
+		       .available      (),
+		       .afull          (),
+		       .aempty         ());
+	end else begin: rfif_async
+		AsyncFifo #(.DEPTH          (`ARB_RFIF_DEPTH),
+		            .WIDTH          (`ARB_RFIF_WIDTH))
+		rfif       (.iclk           (iclk),
+		            .oclk           (oclk),
+		            .iclk_rst_b     (iclk_rst_b),
+		            .oclk_rst_b     (oclk_rst_b),
+		            .wr_en          (rfif_wr_0a_iclk),
+		            .rd_en          (rfif_rd_0a_oclk),
+		            .wr_dat         (rfif_wdat_0a_iclk),
+		            .rd_dat         (rfif_rdat_1a_oclk),
+		            .empty          (rfif_empty_0a_oclk),
+		            .full           (rfif_full_0a_iclk));
+	end
+	endgenerate
 	
 	`ifdef verilator
 	always @(posedge oclk)
@@ -154,7 +187,7 @@ module FSABArbiterFIFO(/*AUTOARG*/
 		end
 	
 	/*** Inbound data FIFO (DFIF) ***/
-`define ARB_DFIF_DEPTH (FSAB_INITIAL_CREDITS * FSAB_LEN_MAX)
+`define ARB_DFIF_DEPTH (CREDITS * FSAB_LEN_MAX)
 `define ARB_DFIF_WIDTH (FSAB_DATA_HI+1 + FSAB_MASK_HI+1)
 
 	wire dfif_wr_0a_iclk;
@@ -164,18 +197,36 @@ module FSABArbiterFIFO(/*AUTOARG*/
 	wire [`ARB_DFIF_WIDTH-1:0] dfif_wdat_0a_iclk;
 	wire [`ARB_DFIF_WIDTH-1:0] dfif_rdat_1a_oclk;
 
-	AsyncFifo #(.DEPTH          (`ARB_DFIF_DEPTH),
-	            .WIDTH          (`ARB_DFIF_WIDTH))
-	dfif       (.iclk           (iclk),
-	            .oclk           (oclk),
-	            .iclk_rst_b     (iclk_rst_b),
-	            .oclk_rst_b     (oclk_rst_b),
-	            .wr_en          (dfif_wr_0a_iclk),
-	            .rd_en          (dfif_rd_0a_oclk),
-	            .wr_dat         (dfif_wdat_0a_iclk),
-	            .rd_dat         (dfif_rdat_1a_oclk),
-	            .empty          (dfif_empty_0a_oclk),
-	            .full           (dfif_full_0a_iclk));
+	generate
+	if (SYNC_CLOCKS == "TRUE") begin: dfif_sync
+		Fifo #(.DEPTH          (`ARB_DFIF_DEPTH),
+		       .WIDTH          (`ARB_DFIF_WIDTH))
+		dfif  (.clk            (oclk),
+		       .rst_b          (oclk_rst_b),
+		       .wr_en          (dfif_wr_0a_iclk),
+		       .rd_en          (dfif_rd_0a_oclk),
+		       .wr_dat         (dfif_wdat_0a_iclk),
+		       .rd_dat         (dfif_rdat_1a_oclk),
+		       .empty          (dfif_empty_0a_oclk),
+		       .full           (dfif_full_0a_iclk),
+		       .available      (),
+		       .afull          (),
+		       .aempty         ());
+	end else begin: dfif_async
+		AsyncFifo #(.DEPTH          (`ARB_DFIF_DEPTH),
+		            .WIDTH          (`ARB_DFIF_WIDTH))
+		dfif       (.iclk           (iclk),
+		            .oclk           (oclk),
+		            .iclk_rst_b     (iclk_rst_b),
+		            .oclk_rst_b     (oclk_rst_b),
+		            .wr_en          (dfif_wr_0a_iclk),
+		            .rd_en          (dfif_rd_0a_oclk),
+		            .wr_dat         (dfif_wdat_0a_iclk),
+		            .rd_dat         (dfif_rdat_1a_oclk),
+		            .empty          (dfif_empty_0a_oclk),
+		            .full           (dfif_full_0a_iclk));
+	end
+	endgenerate
 	
 	`ifdef verilator
 	always @(posedge oclk)
@@ -226,70 +277,51 @@ module FSABArbiterFIFO(/*AUTOARG*/
 	 */
 	assign empty_b = !rfif_empty_0a_oclk;
 	
-	/* Active determines whether we have a request waiting (i.e., we did
-	 * an RFIF read).  It is high as long as we are serving it (which
-	 * might be more than the number of cycles in 'len', since we might
-	 * not have all of the data in the dfif yet).
+	/* The first beat of every transaction is read out of the dfif along
+	 * with the rfif read (0a); on the next cycle (1a), the header shows
+	 * up, and we find out how many more beats there are.  We keep right
+	 * on reading from the dfif in that cycle, so a write goes out with no
+	 * bubble after its first beat.  After that, the count of beats still
+	 * owed lives in mem_cur_req_len_rem_0a.
 	 */
 	reg  [FSAB_LEN_HI:0]  mem_cur_req_len_rem_0a = 'h0;
-	reg                   mem_cur_req_active_0a = 0;
-	reg                   mem_cur_req_active_1a = 0;
-	wire [FSAB_ADDR_HI:0] mem_cur_req_addr_1a;
-	reg  [FSAB_ADDR_HI:0] mem_cur_req_addr_1a_r = 0;
+	wire [FSAB_LEN_HI:0]  mem_cur_req_need_0a =
+		rfif_rd_1a ? (((rfif_mode_1a == FSAB_WRITE) && (rfif_len_1a > 1)) ? (rfif_len_1a - 1) : 'h0)
+		           : mem_cur_req_len_rem_0a;
+	wire                  mem_cur_req_cont_0a = (mem_cur_req_need_0a != 0) && !dfif_empty_0a_oclk;
 	
-	/* If we just finished reading from the dfif for the last time
-	 * (i.e., we just went inactive), then we can release a credit. 
-	 * This is as distinct from releasing a credit every time we read
-	 * from rfif, which is incorrect because there may not yet be space
-	 * in the dfif yet.  (Compare this to the empty_b issue, which is
-	 * the opposite.)
-	 *
-	 * Alternatively, if we were doing no dfif reading at all (we just
-	 * ate a READ packet), then we're done, too.
+	/* Active is high as long as we still have dfif reads to do for this
+	 * transaction (which might be more than the number of cycles in
+	 * 'len', since we might not have all of the data in the dfif yet).
+	 * It goes low on the cycle that the last beat is on the output
+	 * bus, so the arbiter can start the next transaction right then,
+	 * and have its first beat follow immediately.
 	 */
-	assign inp_credit_oclk = (mem_cur_req_active_1a && !mem_cur_req_active_0a) ||
-	                         (rfif_rd_1a && (rfif_mode_1a == FSAB_READ));
+	assign active = (mem_cur_req_need_0a != 0);
 	
-	/* Similarly, we're active as long as something is showing up on the
-	 * output bus (mem_cur_req_active_1a), or we just did a read and
-	 * we're thinking about it.
+	/* We can release a credit once the last dfif read for a transaction
+	 * is done; this is as distinct from releasing a credit every time
+	 * we read from rfif, which is incorrect because there may not yet
+	 * be space in the dfif yet.  (Compare this to the empty_b issue,
+	 * which is the opposite.)  A READ packet, or a single-beat write, is
+	 * done as soon as we know what it is.
 	 */
-	assign active = mem_cur_req_active_1a || mem_cur_req_active_0a || rfif_rd_1a;
+	assign inp_credit_oclk = (rfif_rd_1a && (mem_cur_req_need_0a == 0)) ||
+	                         (mem_cur_req_cont_0a && (mem_cur_req_need_0a == 1));
 	
-	/* TODO: This means that dfif does one read, then pauses one cycle,
-	 * then continues doing the read until we run out of data.  Can the
-	 * one-cycle pause be removed easily?
-	 *
-	 * This is the same problem as in FSABSimMemory.
-	 */
-	assign rfif_rd_0a_oclk = !rfif_empty_0a_oclk && !mem_cur_req_active_0a && !rfif_rd_1a && start_trans;
+	assign rfif_rd_0a_oclk = !rfif_empty_0a_oclk && !active && start_trans;
 	assign dfif_rd_0a_oclk = rfif_rd_0a_oclk || /* We must always do a read from dfif on rfif. */
-  	                         (mem_cur_req_active_0a &&
-	                          (rfif_mode_1a == FSAB_WRITE) &&
-	                          (mem_cur_req_len_rem_0a != 'h1) &&
-	                          (mem_cur_req_len_rem_0a != 'h0) &&
-	                          !dfif_empty_0a_oclk);
+	                         mem_cur_req_cont_0a;
 	
 	always @(posedge oclk or negedge oclk_rst_b)
 		if (!oclk_rst_b) begin
 			mem_cur_req_len_rem_0a <= 'h0;
-			mem_cur_req_active_0a <= 0;
-			mem_cur_req_active_1a <= 0;
-			mem_cur_req_addr_1a_r <= 0;
 		end else begin
-			mem_cur_req_active_1a <= mem_cur_req_active_0a;
-		
-			if (rfif_rd_1a && (rfif_mode_1a == FSAB_WRITE)) begin
-				`ifdef verilator
+			`ifdef verilator
+			if (rfif_rd_1a)
 				$display("ARB[%2d]: %5d: RFIF was just read; it was a %d word %s at %08x", myindex, $time, rfif_len_1a, (rfif_mode_1a == FSAB_WRITE) ? "WRITE" : "READ", rfif_addr_1a);
-				`endif
-				mem_cur_req_active_0a <= 1;
-				mem_cur_req_len_rem_0a <= rfif_len_1a;
-			end else if (dfif_rd_0a_oclk)
-				mem_cur_req_len_rem_0a <= mem_cur_req_len_rem_0a - 1;
-			else if (mem_cur_req_len_rem_0a == 'h1 || mem_cur_req_len_rem_0a == 'h0) begin
-				mem_cur_req_active_0a <= 0;
-			end
+			`endif
+			mem_cur_req_len_rem_0a <= mem_cur_req_need_0a - (mem_cur_req_cont_0a ? 'h1 : 'h0);
 		end
 	
 	/*** External interface assignments ***/
@@ -0,0 +1,500 @@
+/* General-purpose memory-to-memory DMA engine.
+ *
+ * Software builds a chain of descriptors in memory, and writes the
+ * address of the first one to the descriptor register; the engine then
+ * walks the chain, doing each copy in turn, until it gets to a
+ * descriptor whose next pointer is zero.  Addresses and lengths are in
+ * bytes, and can be anything at all: the data gets shifted around to
+ * line up with the destination, and the ends are masked off.  The source
+ * and destination must not overlap.
+ *
+ * Descriptors are 32 bytes long, and must be 32-byte aligned:
+ * 00 = source address
+ * 04 = destination address
+ * 08 = length (in bytes)
+ * 0C = flags
+ * 10 = next descriptor (0 to end the chain)
+ *
+ * If bit 0 of the flags is set, the engine writes the flags back with
+ * bit 31 set once that descriptor's data has all gone out.  Everything
+ * that we send stays in order, so anyone who reads that back from memory
+ * (uncached!) will see the data, too.
+ *
+ * None of this is coherent with the core's caches; software has to make
+ * sure that it doesn't have stale copies of the destination around.
+ *
+ * Register mapping:
+ * 00 = descriptor address: writing starts a chain (and is ignored if one
+ *      is already running); reads back the current descriptor
+ * 04 = status: bit 0 is busy; bit 1 is done (set when a chain finishes,
+ *      and cleared when the next one starts)
+ * 08 = number of descriptors finished since the chain was started
+ */
+
+module FSABDMA(/*AUTOARG*/
+   // Outputs
+   dma__fsabo_valid, dma__fsabo_mode, dma__fsabo_did,
+   dma__fsabo_subdid, dma__fsabo_addr, dma__fsabo_len,
+   dma__fsabo_data, dma__fsabo_mask, dma__spami_busy_b,
+   dma__spami_data,
+   // Inputs
+   dma__fsabo_credit, fsabi_clk, fsabi_rst_b, fsabi_valid, fsabi_did,
+   fsabi_subdid, fsabi_data, cclk, cclk_rst_b, spamo_valid,
+   spamo_r_nw, spamo_did, spamo_addr, spamo_data
+   );
+
+	`include "fsab_defines.vh"
+	`include "spam_defines.vh"
+
+	/* FSAB interface */
+	output reg                  dma__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  dma__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  dma__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  dma__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] dma__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  dma__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] dma__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] dma__fsabo_mask = 0;
+	input                       dma__fsabo_credit;
+
+	input                       fsabi_clk;
+	input                       fsabi_rst_b;
+	input                       fsabi_valid;
+	input      [FSAB_DID_HI:0]  fsabi_did;
+	input      [FSAB_DID_HI:0]  fsabi_subdid;
+	input      [FSAB_DATA_HI:0] fsabi_data;
+
+	/* SPAM interface */
+	input cclk;
+	input cclk_rst_b;
+
+	input                       spamo_valid;
+	input                       spamo_r_nw;
+	input      [SPAM_DID_HI:0]  spamo_did;
+	input      [SPAM_ADDR_HI:0] spamo_addr;
+	input      [SPAM_DATA_HI:0] spamo_data;
+
+	output reg                  dma__spami_busy_b = 0;
+	output reg [SPAM_DATA_HI:0] dma__spami_data = 0;
+
+	`include "clog2.vh"
+	parameter FSAB_DID = FSAB_DID_DMA;
+	parameter FSAB_SUBDID = FSAB_SUBDID_DMA;
+
+	parameter SPAM_DID = SPAM_DID_DMA;
+	parameter SPAM_ADDRPFX = 24'h000000;
+	parameter SPAM_ADDRMASK = 24'hFFFF00;
+
+	/* Number of credits that the arbiter gives us; this must match the
+	 * arbiter's setting for our slot.
+	 */
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+
+	parameter RDFIFO_DEPTH = CREDITS * FSAB_LEN_MAX;
+	parameter RDFIFO_HI = clog2(RDFIFO_DEPTH) - 1;
+
+	/* FSAB credit availability logic */
+	wire trans_start;
+
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			fsab_credits <= CREDITS;
+		end else begin
+			if (dma__fsabo_credit | trans_start) begin
+			`ifdef verilator
+				$display("DMA: Credits: %d (+%d, -%d)", fsab_credits, dma__fsabo_credit, trans_start);
+			`endif
+			end
+			fsab_credits <= fsab_credits + (dma__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+		end
+	end
+
+	/*** Chain state ***/
+	parameter ST_IDLE      = 3'd0;
+	parameter ST_DESC_RD   = 3'd1;	/* waiting to send the descriptor read */
+	parameter ST_DESC_WAIT = 3'd2;	/* waiting for the descriptor to come back */
+	parameter ST_SETUP     = 3'd3;
+	parameter ST_COPY      = 3'd4;
+	parameter ST_STATUS    = 3'd5;	/* waiting to send the status write */
+	parameter ST_NEXT      = 3'd6;
+	reg [2:0] state = ST_IDLE;
+
+	wire        bus_strobe_desc;
+	wire [30:0] bus_desc;
+
+	reg [30:0] desc_addr = 0;
+	reg [1:0]  desc_beat = 0;
+	reg [31:0] desc_src = 0;
+	reg [31:0] desc_dst = 0;
+	reg [31:0] desc_len = 0;
+	reg [31:0] desc_flags = 0;
+	reg [31:0] desc_next = 0;
+
+	reg        done = 0;
+	reg [31:0] count = 0;
+
+	/*** Copy state ***/
+
+	/* Data is read in aligned beats starting at the source's beat, and
+	 * written in aligned beats starting at the destination's beat; each
+	 * beat that goes out is put together from two beats that came in,
+	 * shifted by the difference in the two alignments.  If the source
+	 * is further into its beat than the destination is, then the first
+	 * beat out needs the first two beats in, so we have to pull one in
+	 * ahead of time ("prime").  Beats in and beats out differ in number
+	 * by at most one; when we run out of beats in, the rest is masked
+	 * off anyway.
+	 */
+	reg [2:0]  src_ofs = 0;
+	reg [2:0]  dst_ofs = 0;
+	reg [7:0]  end_mask = 0;	/* byte mask for the very last beat */
+	reg [30:0] rd_addr = 0;
+	reg [29:0] rd_beats_rem = 0;
+	reg [30:0] wr_addr = 0;
+	reg [29:0] wr_beats_rem = 0;
+	reg [29:0] in_rem = 0;		/* beats in that haven't come out of the FIFO */
+	reg        wr_first = 0;
+	reg        prime = 0;
+	reg        prime_1a = 0;
+	reg [63:0] prev = 0;
+
+	wire [32:0] setup_in_end = desc_src[2:0] + desc_len + 7;
+	wire [32:0] setup_out_end = desc_dst[2:0] + desc_len + 7;
+	wire [2:0]  setup_last = desc_dst[2:0] + desc_len[2:0] - 1;
+
+	/*** Read data FIFO ***/
+	wire fsabi_decode = fsabi_valid && fsabi_did == FSAB_DID && fsabi_subdid == FSAB_SUBDID;
+
+	wire                rdfifo_rd;
+	wire [63:0]         rdfifo_rdat;
+	wire [RDFIFO_HI:0]  rdfifo_avail;
+	reg  [RDFIFO_HI:0]  rdfifo_reserved = 0;
+
+	/* While we wait for a descriptor, nothing else can be on its way
+	 * back, so the data coming back is the descriptor.
+	 */
+	Fifo #(.DEPTH          (RDFIFO_DEPTH),
+	       .WIDTH          (64))
+	rdfifo(.clk            (fsabi_clk),
+	       .rst_b          (fsabi_rst_b),
+	       .wr_en          (fsabi_decode && (state != ST_DESC_WAIT)),
+	       .rd_en          (rdfifo_rd),
+	       .wr_dat         (fsabi_data),
+	       .rd_dat         (rdfifo_rdat),
+	       .empty          (),
+	       .full           (),
+	       .available      (rdfifo_avail),
+	       .afull          (),
+	       .aempty         ());
+
+	/*** Transaction start ***/
+
+	/* Bursts never cross a 64-byte boundary.  As in AccelBlit, writes go
+	 * first when we can do them, and occupy the bus until they are out
+	 * the door; wr_words_rem pulls from the FIFO, and wr_beat_1a puts
+	 * the data on the bus a cycle later.  A write only starts once
+	 * everything that it will pull from the FIFO is there.
+	 */
+	reg [FSAB_LEN_HI:0] wr_words_rem = 0;
+	reg [FSAB_LEN_HI:0] wr_len = 0;
+	reg [30:0]          wr_burst_addr = 0;
+	reg                 wr_beat_1a = 0;
+	reg                 wr_first_1a = 0;
+	reg                 wr_last_1a = 0;
+	wire wr_busy = (wr_words_rem != 0) || wr_beat_1a;
+
+	wire [3:0] wr_blk_left = 4'd8 - {1'b0, wr_addr[5:3]};
+	wire [3:0] rd_blk_left = 4'd8 - {1'b0, rd_addr[5:3]};
+	wire [FSAB_LEN_HI:0] wr_burst = (wr_beats_rem < wr_blk_left) ? wr_beats_rem[3:0] : wr_blk_left;
+	wire [FSAB_LEN_HI:0] rd_burst = (rd_beats_rem < rd_blk_left) ? rd_beats_rem[3:0] : rd_blk_left;
+	wire [FSAB_LEN_HI:0] wr_need = (in_rem < wr_burst) ? in_rem[3:0] : wr_burst;
+
+	/* verilator lint_off WIDTH */
+	wire wr_start = (state == ST_COPY) && fsab_credit_avail && !wr_busy && !prime && !prime_1a &&
+	                (wr_beats_rem != 0) && (rdfifo_avail >= wr_need);
+	wire rd_start = (state == ST_COPY) && fsab_credit_avail && !wr_busy && !wr_start &&
+	                (rd_beats_rem != 0) && ((rdfifo_reserved + rd_burst) <= RDFIFO_DEPTH);
+	/* verilator lint_on WIDTH */
+	wire desc_start = (state == ST_DESC_RD) && fsab_credit_avail;
+	wire stat_start = (state == ST_STATUS) && fsab_credit_avail;
+	assign trans_start = wr_start || rd_start || desc_start || stat_start;
+
+	wire prime_rd = prime && (rdfifo_avail != 0);
+	wire wr_pop = (wr_words_rem != 0) && (in_rem != 0);
+	assign rdfifo_rd = prime_rd || wr_pop;
+
+	wire [2:0]   shift = src_ofs - dst_ofs;
+	wire [127:0] funnel = {rdfifo_rdat, prev} >> {shift, 3'b000};
+	wire [7:0]   wr_mask = (wr_first_1a ? (8'hFF << dst_ofs) : 8'hFF) &
+	                       (wr_last_1a ? end_mask : 8'hFF);
+
+	wire copy_done = (wr_beats_rem == 0) && !wr_busy;
+
+	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
+		if (!fsabi_rst_b) begin
+			state <= ST_IDLE;
+			desc_addr <= 0;
+			desc_beat <= 0;
+			done <= 0;
+			count <= 0;
+
+			rd_beats_rem <= 0;
+			wr_beats_rem <= 0;
+			in_rem <= 0;
+			wr_first <= 0;
+			prime <= 0;
+			prime_1a <= 0;
+			rdfifo_reserved <= 0;
+
+			wr_words_rem <= 0;
+			wr_beat_1a <= 0;
+			wr_first_1a <= 0;
+			wr_last_1a <= 0;
+
+			dma__fsabo_valid <= 0;
+			dma__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			dma__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			dma__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			dma__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			dma__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			dma__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			dma__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			/*** Walking the chain ***/
+			case (state)
+			ST_IDLE:
+				if (bus_strobe_desc) begin
+				`ifdef verilator
+					$display("DMA: starting chain at %08x", bus_desc);
+				`endif
+					desc_addr <= bus_desc;
+					done <= 0;
+					count <= 0;
+					state <= ST_DESC_RD;
+				end
+			ST_DESC_RD:
+				if (desc_start) begin
+					desc_beat <= 0;
+					state <= ST_DESC_WAIT;
+				end
+			ST_DESC_WAIT:
+				if (fsabi_decode) begin
+					case (desc_beat)
+					2'd0: {desc_dst, desc_src} <= fsabi_data;
+					2'd1: {desc_flags, desc_len} <= fsabi_data;
+					2'd2: desc_next <= fsabi_data[31:0];
+					default: begin end
+					endcase
+					desc_beat <= desc_beat + 1;
+					if (desc_beat == 2'd2)
+						state <= ST_SETUP;
+				end
+			ST_SETUP: begin
+			`ifdef verilator
+				$display("DMA: desc %08x: %d bytes from %08x to %08x, flags %08x, next %08x", {desc_addr[30:5], 5'b0}, desc_len, desc_src, desc_dst, desc_flags, desc_next);
+			`endif
+				src_ofs <= desc_src[2:0];
+				dst_ofs <= desc_dst[2:0];
+				end_mask <= 8'hFF >> (3'd7 - setup_last);
+				rd_addr <= {desc_src[30:3], 3'b000};
+				wr_addr <= {desc_dst[30:3], 3'b000};
+				rd_beats_rem <= setup_in_end[32:3];
+				wr_beats_rem <= setup_out_end[32:3];
+				in_rem <= setup_in_end[32:3];
+				wr_first <= 1;
+				prime <= (desc_src[2:0] >= desc_dst[2:0]) && (desc_len != 0);
+				if (desc_len == 0)
+					state <= desc_flags[0] ? ST_STATUS : ST_NEXT;
+				else
+					state <= ST_COPY;
+			end
+			ST_COPY:
+				if (copy_done)
+					state <= desc_flags[0] ? ST_STATUS : ST_NEXT;
+			ST_STATUS:
+				if (stat_start)
+					state <= ST_NEXT;
+			ST_NEXT: begin
+				count <= count + 1;
+				if (desc_next != 0) begin
+					desc_addr <= desc_next[30:0];
+					state <= ST_DESC_RD;
+				end else begin
+				`ifdef verilator
+					$display("DMA: chain done");
+				`endif
+					done <= 1;
+					state <= ST_IDLE;
+				end
+			end
+			default: state <= ST_IDLE;
+			endcase
+
+			/*** Copying ***/
+			if (rd_start) begin
+				rd_addr <= rd_addr + {rd_burst, 3'b000};
+				rd_beats_rem <= rd_beats_rem - rd_burst;
+			end
+
+			/* verilator lint_off WIDTH */
+			rdfifo_reserved <= rdfifo_reserved + (rd_start ? rd_burst : 0) - (rdfifo_rd ? 1 : 0);
+			/* verilator lint_on WIDTH */
+
+			if (rdfifo_rd)
+				in_rem <= in_rem - 1;
+
+			if (prime_rd)
+				prime <= 0;
+			prime_1a <= prime_rd;
+			if (prime_1a)
+				prev <= rdfifo_rdat;
+
+			if (wr_start) begin
+				wr_words_rem <= wr_burst;
+				wr_len <= wr_burst;
+				wr_burst_addr <= wr_addr;
+			end else if (wr_words_rem != 0)
+				wr_words_rem <= wr_words_rem - 1;
+
+			if (wr_words_rem != 0) begin
+				wr_addr <= wr_addr + 8;
+				wr_beats_rem <= wr_beats_rem - 1;
+				wr_first <= 0;
+			end
+			wr_beat_1a <= (wr_words_rem != 0);
+			wr_first_1a <= wr_first;
+			wr_last_1a <= (wr_beats_rem == 1);
+			if (wr_beat_1a)
+				prev <= rdfifo_rdat;
+
+			/*** FSAB ***/
+			if (desc_start) begin
+				dma__fsabo_valid <= 1;
+				dma__fsabo_mode <= FSAB_READ;
+				dma__fsabo_did <= FSAB_DID;
+				dma__fsabo_subdid <= FSAB_SUBDID;
+				dma__fsabo_addr <= {desc_addr[30:5], 5'b00000};
+				dma__fsabo_len <= 3;
+				dma__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				dma__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end else if (stat_start) begin
+				dma__fsabo_valid <= 1;
+				dma__fsabo_mode <= FSAB_WRITE;
+				dma__fsabo_did <= FSAB_DID;
+				dma__fsabo_subdid <= FSAB_SUBDID;
+				dma__fsabo_addr <= {desc_addr[30:5], 5'b01000};
+				dma__fsabo_len <= 1;
+				dma__fsabo_data <= {desc_flags | 32'h80000000, desc_len};
+				dma__fsabo_mask <= 8'hF0;
+			end else if (rd_start) begin
+				dma__fsabo_valid <= 1;
+				dma__fsabo_mode <= FSAB_READ;
+				dma__fsabo_did <= FSAB_DID;
+				dma__fsabo_subdid <= FSAB_SUBDID;
+				dma__fsabo_addr <= rd_addr;
+				dma__fsabo_len <= rd_burst;
+				dma__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				dma__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			`ifdef verilator
+				$display("DMA: read start: %d words from %08x (%d reserved)", rd_burst, rd_addr, rdfifo_reserved);
+			`endif
+			end else if (wr_beat_1a) begin
+				dma__fsabo_valid <= 1;
+				dma__fsabo_mode <= FSAB_WRITE;
+				dma__fsabo_did <= FSAB_DID;
+				dma__fsabo_subdid <= FSAB_SUBDID;
+				dma__fsabo_addr <= wr_burst_addr;
+				dma__fsabo_len <= wr_len;
+				dma__fsabo_data <= funnel[63:0];
+				dma__fsabo_mask <= wr_mask;
+			`ifdef verilator
+				$display("DMA: write: %d words to %08x, data %x, mask %x", wr_len, wr_burst_addr, funnel[63:0], wr_mask);
+			`endif
+			end else begin
+				dma__fsabo_valid <= 0;
+				dma__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				dma__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				dma__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				dma__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				dma__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				dma__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				dma__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+		end
+	end
+
+	/* Config */
+	wire wr_decode = spamo_valid && !spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+	wire rd_decode = spamo_valid && spamo_r_nw &&
+	                 ((spamo_addr & SPAM_ADDRMASK) == SPAM_ADDRPFX) &&
+	                 (spamo_did == SPAM_DID);
+
+	wire wr_done_strobe_DESC;
+	CSRAsyncWrite #(.WIDTH       (31),
+	                .RESET_VALUE (31'h0))
+		CSR_DESC  (/* NOT AUTOINST */
+		           // Outputs
+		           .wr_wait_cclk       (),
+		           .wr_done_strobe_cclk(wr_done_strobe_DESC),
+		           .wr_strobe_tclk     (bus_strobe_desc),
+		           .wr_data_tclk       (bus_desc[30:0]),
+		           // Inputs
+		           .cclk               (cclk),
+		           .tclk               (fsabi_clk),
+		           .rst_b_cclk         (cclk_rst_b),
+		           .rst_b_tclk         (fsabi_rst_b),
+		           .wr_strobe_cclk     (wr_decode && (spamo_addr[7:2] == 6'h00)),
+		           .wr_data_cclk       (spamo_data[30:0]));
+
+	/* The register being read is latched on the cclk side, and held
+	 * until the next read comes along, just like in the arbiter.
+	 */
+	reg [5:0] rd_reg = 0;
+	always @(posedge cclk)
+		if (rd_decode)
+			rd_reg <= spamo_addr[7:2];
+
+	reg [31:0] rd_data;	/* combinatorial */
+	always @(*)
+		case (rd_reg)
+		6'h00: rd_data = {1'b0, desc_addr};
+		6'h01: rd_data = {30'h0, done, state != ST_IDLE};
+		6'h02: rd_data = count;
+		default: rd_data = 32'h0;
+		endcase
+
+	wire [31:0] rd_data_REG;
+	wire rd_done_strobe_REG;
+	CSRAsyncRead #(.WIDTH        (32))
+		CSR_REG_READ        (/* NOT AUTOINST */
+				     // Outputs
+				     .rd_data_cclk	(rd_data_REG),
+				     .rd_wait_cclk	(),
+				     .rd_done_strobe_cclk(rd_done_strobe_REG),
+				     .rd_strobe_tclk	(),
+				     // Inputs
+				     .cclk		(cclk),
+				     .tclk		(fsabi_clk),
+				     .rst_b_cclk	(cclk_rst_b),
+				     .rst_b_tclk	(fsabi_rst_b),
+				     .rd_strobe_cclk	(rd_decode),
+				     .rd_data_tclk	(rd_data));
+
+	always @(posedge cclk or negedge cclk_rst_b)
+		if (!cclk_rst_b) begin
+			dma__spami_busy_b <= 0;
+			dma__spami_data <= 0;
+		end else begin
+			dma__spami_busy_b <= wr_done_strobe_DESC | rd_done_strobe_REG;
+			dma__spami_data <= {32{rd_done_strobe_REG}} & rd_data_REG;
+		end
+endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../util")
+// End:
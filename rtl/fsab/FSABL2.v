@@ -0,0 +1,603 @@
+/* Unified second-level cache for the core.
+ *
+ * This sits between the core's I- and D-cache FSAB ports and the system
+ * arbiter.  Internally, a two-port FSABArbiter takes care of getting both
+ * of the core's ports into the fsabi clock domain; from there, the L2
+ * looks like memory to the core (it hands back credits, and answers reads
+ * on l2__fsabi), and like one more FSAB client to the system arbiter.
+ *
+ * What gets cached is line-aligned 8-word reads, which is what the L1s
+ * ask for when they miss.  Everything else (uncached reads from the
+ * DCache, for instance) is forwarded with its original DID and subdid,
+ * and the response goes straight back to the requester.  Writes are
+ * write-through with no allocation: they are always forwarded, and if
+ * they hit, the line is updated in place.  Writes are assumed not to
+ * cross a line boundary, which is true for everything the L1s do.
+ *
+ * The DMA clients (framebuffer, audio, accelerators, the DMA engine) are
+ * on the system arbiter directly, so they never see the L2 at all.  To
+ * keep it from holding on to stale lines, the L2 watches the system
+ * arbiter's output to memory (fsabo_*), and drops any line that a write
+ * from anyone other than the core touches.  The L1s are still not
+ * coherent with DMA writes; software has to take care of those.
+ *
+ * If ENABLE is not "TRUE", this is just wires: the I- and D-cache ports
+ * go straight through to the l2ic and l2dc ports.  If it is "TRUE",
+ * everything goes out on the l2dc port (which then needs to be clocked
+ * with fsabi_clk in the system arbiter!), and l2ic is idle.
+ */
+
+module FSABL2(/*AUTOARG*/
+   // Outputs
+   ic__fsabo_credit, dc__fsabo_credit, l2__fsabi_valid, l2__fsabi_did,
+   l2__fsabi_subdid, l2__fsabi_data, l2ic__fsabo_valid,
+   l2ic__fsabo_mode, l2ic__fsabo_did, l2ic__fsabo_subdid,
+   l2ic__fsabo_addr, l2ic__fsabo_len, l2ic__fsabo_data,
+   l2ic__fsabo_mask, l2dc__fsabo_valid, l2dc__fsabo_mode,
+   l2dc__fsabo_did, l2dc__fsabo_subdid, l2dc__fsabo_addr,
+   l2dc__fsabo_len, l2dc__fsabo_data, l2dc__fsabo_mask,
+   // Inputs
+   cclk, cclk_rst_b, fsabi_clk, fsabi_rst_b, ic__fsabo_valid,
+   ic__fsabo_mode, ic__fsabo_did, ic__fsabo_subdid, ic__fsabo_addr,
+   ic__fsabo_len, ic__fsabo_data, ic__fsabo_mask, dc__fsabo_valid,
+   dc__fsabo_mode, dc__fsabo_did, dc__fsabo_subdid, dc__fsabo_addr,
+   dc__fsabo_len, dc__fsabo_data, dc__fsabo_mask, l2ic__fsabo_credit,
+   l2dc__fsabo_credit, fsabi_valid, fsabi_did, fsabi_subdid, fsabi_data,
+   fsabo_valid, fsabo_mode, fsabo_did, fsabo_addr, fsabo_len
+   );
+	`include "fsab_defines.vh"
+
+	parameter ENABLE = "FALSE";
+	parameter SYNC_CLOCKS = "FALSE";	/* "TRUE" if cclk and fsabi_clk are the same clock */
+	parameter NWAYS = 4;
+	parameter NWAYS_HI = 1;
+	parameter SETS_BITS = 8;	/* 256 sets * 4 ways * 64 byte lines = 64KB */
+
+	input cclk;
+	input cclk_rst_b;
+	input fsabi_clk;
+	input fsabi_rst_b;
+
+	/* From the core (cclk) */
+	input                       ic__fsabo_valid;
+	input      [FSAB_REQ_HI:0]  ic__fsabo_mode;
+	input      [FSAB_DID_HI:0]  ic__fsabo_did;
+	input      [FSAB_DID_HI:0]  ic__fsabo_subdid;
+	input      [FSAB_ADDR_HI:0] ic__fsabo_addr;
+	input      [FSAB_LEN_HI:0]  ic__fsabo_len;
+	input      [FSAB_DATA_HI:0] ic__fsabo_data;
+	input      [FSAB_MASK_HI:0] ic__fsabo_mask;
+	output wire                 ic__fsabo_credit;
+
+	input                       dc__fsabo_valid;
+	input      [FSAB_REQ_HI:0]  dc__fsabo_mode;
+	input      [FSAB_DID_HI:0]  dc__fsabo_did;
+	input      [FSAB_DID_HI:0]  dc__fsabo_subdid;
+	input      [FSAB_ADDR_HI:0] dc__fsabo_addr;
+	input      [FSAB_LEN_HI:0]  dc__fsabo_len;
+	input      [FSAB_DATA_HI:0] dc__fsabo_data;
+	input      [FSAB_MASK_HI:0] dc__fsabo_mask;
+	output wire                 dc__fsabo_credit;
+
+	/* Back to the core (fsabi_clk) */
+	output wire                  l2__fsabi_valid;
+	output wire [FSAB_DID_HI:0]  l2__fsabi_did;
+	output wire [FSAB_DID_HI:0]  l2__fsabi_subdid;
+	output wire [FSAB_DATA_HI:0] l2__fsabi_data;
+
+	/* To the system arbiter */
+	output wire                  l2ic__fsabo_valid;
+	output wire [FSAB_REQ_HI:0]  l2ic__fsabo_mode;
+	output wire [FSAB_DID_HI:0]  l2ic__fsabo_did;
+	output wire [FSAB_DID_HI:0]  l2ic__fsabo_subdid;
+	output wire [FSAB_ADDR_HI:0] l2ic__fsabo_addr;
+	output wire [FSAB_LEN_HI:0]  l2ic__fsabo_len;
+	output wire [FSAB_DATA_HI:0] l2ic__fsabo_data;
+	output wire [FSAB_MASK_HI:0] l2ic__fsabo_mask;
+	input                        l2ic__fsabo_credit;
+
+	output wire                  l2dc__fsabo_valid;
+	output wire [FSAB_REQ_HI:0]  l2dc__fsabo_mode;
+	output wire [FSAB_DID_HI:0]  l2dc__fsabo_did;
+	output wire [FSAB_DID_HI:0]  l2dc__fsabo_subdid;
+	output wire [FSAB_ADDR_HI:0] l2dc__fsabo_addr;
+	output wire [FSAB_LEN_HI:0]  l2dc__fsabo_len;
+	output wire [FSAB_DATA_HI:0] l2dc__fsabo_data;
+	output wire [FSAB_MASK_HI:0] l2dc__fsabo_mask;
+	input                        l2dc__fsabo_credit;
+
+	/* From memory (fsabi_clk) */
+	input                       fsabi_valid;
+	input      [FSAB_DID_HI:0]  fsabi_did;
+	input      [FSAB_DID_HI:0]  fsabi_subdid;
+	input      [FSAB_DATA_HI:0] fsabi_data;
+
+	/* What the system arbiter sends to memory (fsabi_clk), for snooping */
+	input                       fsabo_valid;
+	input      [FSAB_REQ_HI:0]  fsabo_mode;
+	input      [FSAB_DID_HI:0]  fsabo_did;
+	input      [FSAB_ADDR_HI:0] fsabo_addr;
+	input      [FSAB_LEN_HI:0]  fsabo_len;
+
+	/* [30 tag TAG_LO] [TAG_LO-1 set 6] [5 word 3] [2 byte 0] */
+	parameter TAG_LO = SETS_BITS + 6;
+	parameter TAG_HI = FSAB_ADDR_HI - TAG_LO;
+
+	parameter L2_IDLE   = 3'd0;
+	parameter L2_DECODE = 3'd1;
+	parameter L2_LOOKUP = 3'd2;
+	parameter L2_HIT    = 3'd3;
+	parameter L2_FILL   = 3'd4;
+	parameter L2_BYPASS = 3'd5;
+	parameter L2_WRITE  = 3'd6;
+	parameter L2_DONE   = 3'd7;
+
+	generate
+	if (ENABLE == "TRUE") begin: l2
+		/*** Core-side arbitration and clock crossing ***/
+		wire                  arb__fsabo_valid;
+		wire [FSAB_REQ_HI:0]  arb__fsabo_mode;
+		wire [FSAB_DID_HI:0]  arb__fsabo_did;
+		wire [FSAB_DID_HI:0]  arb__fsabo_subdid;
+		wire [FSAB_ADDR_HI:0] arb__fsabo_addr;
+		wire [FSAB_LEN_HI:0]  arb__fsabo_len;
+		wire [FSAB_DATA_HI:0] arb__fsabo_data;
+		wire [FSAB_MASK_HI:0] arb__fsabo_mask;
+		reg                   arb__fsabo_credit = 0;
+
+		FSABArbiter arb(/* NOT AUTOINST */
+				// Outputs
+				.fsabo_credits	({ic__fsabo_credit,dc__fsabo_credit}),
+				.fsabo_valid	(arb__fsabo_valid),
+				.fsabo_mode	(arb__fsabo_mode),
+				.fsabo_did	(arb__fsabo_did),
+				.fsabo_subdid	(arb__fsabo_subdid),
+				.fsabo_addr	(arb__fsabo_addr),
+				.fsabo_len	(arb__fsabo_len),
+				.fsabo_data	(arb__fsabo_data),
+				.fsabo_mask	(arb__fsabo_mask),
+				.arb__spami_busy_b(),
+				.arb__spami_data(),
+				// Inputs
+				.clk		(fsabi_clk),
+				.rst_b		(fsabi_rst_b),
+				.fsabo_valids	({ic__fsabo_valid,dc__fsabo_valid}),
+				.fsabo_modes	({ic__fsabo_mode,dc__fsabo_mode}),
+				.fsabo_dids	({ic__fsabo_did,dc__fsabo_did}),
+				.fsabo_subdids	({ic__fsabo_subdid,dc__fsabo_subdid}),
+				.fsabo_addrs	({ic__fsabo_addr,dc__fsabo_addr}),
+				.fsabo_lens	({ic__fsabo_len,dc__fsabo_len}),
+				.fsabo_datas	({ic__fsabo_data,dc__fsabo_data}),
+				.fsabo_masks	({ic__fsabo_mask,dc__fsabo_mask}),
+				.fsabo_clks	({cclk,cclk}),
+				.fsabo_rst_bs	({cclk_rst_b,cclk_rst_b}),
+				.fsabo_credit	(arb__fsabo_credit),
+				.cclk		(cclk),
+				.cclk_rst_b	(cclk_rst_b),
+				.spamo_valid	(1'b0),
+				.spamo_r_nw	(1'b0),
+				.spamo_did	(4'h0),
+				.spamo_addr	(24'h0),
+				.spamo_data	(32'h0));
+		defparam arb.FSAB_DEVICES = 2;
+		/* The RFIF and DFIF below are sized for this many requests. */
+		defparam arb.MEM_CREDITS = FSAB_INITIAL_CREDITS;
+		defparam arb.SYNC_DEVICES = (SYNC_CLOCKS == "TRUE") ? 2'b11 : 2'b00;
+
+		/*** Inbound request and data FIFOs ***/
+		/* Same deal as FSABSimMemory: every transaction puts one entry
+		 * in the RFIF, and one entry per beat in the DFIF (reads get
+		 * one DFIF entry, which is thrown away).
+		 */
+`define L2_RFIF_HI (FSAB_REQ_HI+1 + FSAB_DID_HI+1 + FSAB_DID_HI+1 + FSAB_ADDR_HI+1 + FSAB_LEN_HI)
+`define L2_DFIF_HI (FSAB_DATA_HI+1 + FSAB_MASK_HI)
+		wire rfif_wr;
+		reg rfif_rd;
+		wire rfif_empty;
+		wire [`L2_RFIF_HI:0] rfif_rdat;
+		wire dfif_wr;
+		reg dfif_rd;
+		wire dfif_empty;
+		wire [`L2_DFIF_HI:0] dfif_rdat;
+
+		Fifo rfif(.clk(fsabi_clk),
+		          .rst_b(fsabi_rst_b),
+
+		          .wr_en(rfif_wr),
+		          .wr_dat({arb__fsabo_mode, arb__fsabo_did, arb__fsabo_subdid,
+		                   arb__fsabo_addr, arb__fsabo_len}),
+
+		          .rd_en(rfif_rd),
+		          .rd_dat(rfif_rdat),
+
+		          .empty(rfif_empty));
+		defparam rfif.WIDTH = `L2_RFIF_HI + 1;
+		defparam rfif.DEPTH = FSAB_INITIAL_CREDITS;
+
+		Fifo dfif(.clk(fsabi_clk),
+		          .rst_b(fsabi_rst_b),
+
+		          .wr_en(dfif_wr),
+		          .wr_dat({arb__fsabo_data, arb__fsabo_mask}),
+
+		          .rd_en(dfif_rd),
+		          .rd_dat(dfif_rdat),
+
+		          .empty(dfif_empty));
+		defparam dfif.WIDTH = `L2_DFIF_HI + 1;
+		defparam dfif.DEPTH = FSAB_INITIAL_CREDITS * FSAB_LEN_MAX;
+
+		reg [FSAB_LEN_HI:0] inp_cur_req_len_rem_1a = 0;
+		wire inp_cur_req_done_1a = (inp_cur_req_len_rem_1a == 0) || (inp_cur_req_len_rem_1a == 1);
+		assign rfif_wr = arb__fsabo_valid && inp_cur_req_done_1a;
+		assign dfif_wr = arb__fsabo_valid;
+
+		always @(posedge fsabi_clk or negedge fsabi_rst_b)
+			if (!fsabi_rst_b)
+				inp_cur_req_len_rem_1a <= 0;
+			else if (arb__fsabo_valid && inp_cur_req_done_1a && (arb__fsabo_mode == FSAB_WRITE))
+				inp_cur_req_len_rem_1a <= arb__fsabo_len;
+			else if (arb__fsabo_valid && inp_cur_req_len_rem_1a != 0)
+				inp_cur_req_len_rem_1a <= inp_cur_req_len_rem_1a - 1;
+
+		wire [FSAB_REQ_HI:0]  rfif_mode;
+		wire [FSAB_DID_HI:0]  rfif_did;
+		wire [FSAB_DID_HI:0]  rfif_subdid;
+		wire [FSAB_ADDR_HI:0] rfif_addr;
+		wire [FSAB_LEN_HI:0]  rfif_len;
+		wire [FSAB_DATA_HI:0] dfif_data;
+		wire [FSAB_MASK_HI:0] dfif_mask;
+		assign {rfif_mode, rfif_did, rfif_subdid, rfif_addr, rfif_len} = rfif_rdat;
+		assign {dfif_data, dfif_mask} = dfif_rdat;
+
+		/*** Outbound credits ***/
+		reg fsab_start;	/* combinatorial */
+		reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;
+		wire fsab_credit_avail = (fsab_credits != 0);
+		always @(posedge fsabi_clk or negedge fsabi_rst_b)
+			if (!fsabi_rst_b)
+				fsab_credits <= FSAB_INITIAL_CREDITS;
+			else
+				fsab_credits <= fsab_credits + (l2dc__fsabo_credit ? 1 : 0) - (fsab_start ? 1 : 0);
+
+		/*** Tags and data ***/
+		reg [(NWAYS << SETS_BITS)-1:0] l2_valid = 0;
+		reg [TAG_HI:0] l2_tags [(NWAYS << SETS_BITS)-1:0];
+		reg [NWAYS_HI:0] l2_evict_next [(1 << SETS_BITS)-1:0];
+		reg [FSAB_DATA_HI:0] l2_data [(NWAYS << (SETS_BITS+3))-1:0 /* {way,set,word} */];	//synthesis attribute ram_style of l2_data is block
+
+		integer i;
+		initial
+			for (i = 0; i < (1 << SETS_BITS); i = i + 1)
+				l2_evict_next[i] = 0;
+
+		/*** Snooping ***/
+		/* Only the first beat of a write carries anything worth looking
+		 * at, so count off the rest of the burst the same way as on the
+		 * way in.  A write can straddle two lines if it is not aligned,
+		 * so both the first and the last word get looked up.
+		 */
+		reg [FSAB_LEN_HI:0] snoop_len_rem_1a = 0;
+		wire snoop_req_done_1a = (snoop_len_rem_1a == 0) || (snoop_len_rem_1a == 1);
+
+		always @(posedge fsabi_clk or negedge fsabi_rst_b)
+			if (!fsabi_rst_b)
+				snoop_len_rem_1a <= 0;
+			else if (fsabo_valid && snoop_req_done_1a && (fsabo_mode == FSAB_WRITE))
+				snoop_len_rem_1a <= fsabo_len;
+			else if (fsabo_valid && snoop_len_rem_1a != 0)
+				snoop_len_rem_1a <= snoop_len_rem_1a - 1;
+
+		wire snoop_inval = fsabo_valid && snoop_req_done_1a && (fsabo_mode == FSAB_WRITE) &&
+		                   (fsabo_did != FSAB_DID_CPU);
+		/* verilator lint_off WIDTH */
+		wire [FSAB_ADDR_HI:0] snoop_last_addr = fsabo_addr + ((fsabo_len - 1) << 3);
+		/* verilator lint_on WIDTH */
+		wire [SETS_BITS-1:0] snoop_set0 = fsabo_addr[TAG_LO-1:6];
+		wire [TAG_HI:0]      snoop_tag0 = fsabo_addr[FSAB_ADDR_HI:TAG_LO];
+		wire [SETS_BITS-1:0] snoop_set1 = snoop_last_addr[TAG_LO-1:6];
+		wire [TAG_HI:0]      snoop_tag1 = snoop_last_addr[FSAB_ADDR_HI:TAG_LO];
+
+		/*** Current request ***/
+		reg [2:0]             state = L2_IDLE;
+		reg [FSAB_REQ_HI:0]   req_mode = 0;
+		reg [FSAB_DID_HI:0]   req_did = 0;
+		reg [FSAB_DID_HI:0]   req_subdid = 0;
+		reg [FSAB_ADDR_HI:0]  req_addr = 0;
+		reg [FSAB_LEN_HI:0]   req_len = 0;
+		reg [FSAB_DATA_HI:0]  req_data = 0;	/* first beat of a write */
+		reg [FSAB_MASK_HI:0]  req_mask = 0;
+
+		wire [SETS_BITS-1:0] req_set = req_addr[TAG_LO-1:6];
+		wire [TAG_HI:0]      req_tag = req_addr[FSAB_ADDR_HI:TAG_LO];
+		wire req_cacheable = (req_mode == FSAB_READ) && (req_len == FSAB_LEN_MAX) && (req_addr[5:3] == 3'b000);
+
+		/* A write that lands on the line that is being filled might
+		 * have gotten to memory before or after our read did, so the
+		 * fill can't be trusted.
+		 */
+		wire snoop_fill = snoop_inval && (((snoop_set0 == req_set) && (snoop_tag0 == req_tag)) ||
+		                                  ((snoop_set1 == req_set) && (snoop_tag1 == req_tag)));
+
+		reg lookup_hit;	/* combinatorial */
+		reg [NWAYS_HI:0] lookup_way;
+		always @(*) begin
+			lookup_hit = 0;
+			lookup_way = {(NWAYS_HI+1){1'bx}};
+			for (i = 0; i < NWAYS; i = i + 1)
+				/* verilator lint_off WIDTH */
+				if (l2_valid[{i[NWAYS_HI:0], req_set}] && (l2_tags[{i[NWAYS_HI:0], req_set}] == req_tag)) begin
+				/* verilator lint_on WIDTH */
+					lookup_hit = 1;
+					lookup_way = i[NWAYS_HI:0];
+				end
+		end
+
+		reg [NWAYS_HI:0] way = 0;	/* hit way, or fill victim */
+		reg              wr_hit = 0;
+		reg              fill_stale = 0;	/* line got written while we were filling it */
+		reg [2:0]        beat = 0;	/* hit/fill position */
+		reg [FSAB_LEN_HI:0] beats_rem = 0;	/* bypass or write beats left */
+		reg [FSAB_LEN_HI:0] dfif_rem = 0;	/* DFIF entries left to read */
+		reg              wbeat_pending = 0;	/* dfif_rdat holds a write beat */
+
+		reg                  hit_valid_1a = 0;
+		reg [FSAB_DATA_HI:0] hit_data_1a = 0;
+
+		wire fill_decode = fsabi_valid && (fsabi_did == FSAB_DID_CPU) && (fsabi_subdid == FSAB_SUBDID_CPU_L2);
+		wire bypass_decode = fsabi_valid && (fsabi_did == req_did) && (fsabi_subdid == req_subdid);
+
+		/* Outbound beats come either from the first beat that was
+		 * stashed away at decode time, or from the DFIF.
+		 */
+		wire [FSAB_DATA_HI:0] wbeat_data = wbeat_pending ? dfif_data : req_data;
+		wire [FSAB_MASK_HI:0] wbeat_mask = wbeat_pending ? dfif_mask : req_mask;
+		wire [2:0] wbeat_word = req_addr[5:3] + (req_len - beats_rem);
+
+		reg                  out_valid;	/* combinatorial */
+		reg [FSAB_REQ_HI:0]  out_mode;
+		reg [FSAB_DID_HI:0]  out_did;
+		reg [FSAB_DID_HI:0]  out_subdid;
+		reg [FSAB_ADDR_HI:0] out_addr;
+		reg [FSAB_LEN_HI:0]  out_len;
+		reg [FSAB_DATA_HI:0] out_data;
+		reg [FSAB_MASK_HI:0] out_mask;
+
+		wire start_write = (state == L2_LOOKUP) && (req_mode == FSAB_WRITE) && fsab_credit_avail;
+		wire write_beat = start_write || ((state == L2_WRITE) && wbeat_pending);
+
+		always @(*) begin
+			out_valid = 0;
+			out_mode = {(FSAB_REQ_HI+1){1'bx}};
+			out_did = {(FSAB_DID_HI+1){1'bx}};
+			out_subdid = {(FSAB_DID_HI+1){1'bx}};
+			out_addr = {(FSAB_ADDR_HI+1){1'bx}};
+			out_len = {(FSAB_LEN_HI+1){1'bx}};
+			out_data = {(FSAB_DATA_HI+1){1'bx}};
+			out_mask = {(FSAB_MASK_HI+1){1'bx}};
+			fsab_start = 0;
+
+			if (state == L2_LOOKUP && fsab_credit_avail && !(req_cacheable && lookup_hit)) begin
+				fsab_start = 1;
+				out_valid = 1;
+				out_mode = req_mode;
+				out_did = req_cacheable ? FSAB_DID_CPU : req_did;
+				out_subdid = req_cacheable ? FSAB_SUBDID_CPU_L2 : req_subdid;
+				out_addr = req_addr;
+				out_len = req_len;
+				out_data = req_data;
+				out_mask = req_mask;
+			end else if (state == L2_WRITE && wbeat_pending) begin
+				out_valid = 1;
+				out_mode = FSAB_WRITE;
+				out_did = req_did;
+				out_subdid = req_subdid;
+				out_addr = req_addr;
+				out_len = req_len;
+				out_data = dfif_data;
+				out_mask = dfif_mask;
+			end
+		end
+
+		always @(*) begin
+			rfif_rd = (state == L2_IDLE) && !rfif_empty;
+			dfif_rd = ((state == L2_IDLE) && !rfif_empty) ||
+			          ((start_write || (state == L2_WRITE)) && (dfif_rem != 0) && !dfif_empty);
+		end
+
+		always @(posedge fsabi_clk or negedge fsabi_rst_b)
+			if (!fsabi_rst_b) begin
+				state <= L2_IDLE;
+				l2_valid <= 0;
+				arb__fsabo_credit <= 0;
+				hit_valid_1a <= 0;
+				wbeat_pending <= 0;
+			end else begin
+				arb__fsabo_credit <= 0;
+				hit_valid_1a <= 0;
+				wbeat_pending <= dfif_rd && (state != L2_IDLE);
+
+				case (state)
+				L2_IDLE:
+					if (!rfif_empty)
+						state <= L2_DECODE;
+				L2_DECODE: begin
+					req_mode <= rfif_mode;
+					req_did <= rfif_did;
+					req_subdid <= rfif_subdid;
+					req_addr <= rfif_addr;
+					req_len <= rfif_len;
+					req_data <= dfif_data;
+					req_mask <= dfif_mask;
+					dfif_rem <= (rfif_mode == FSAB_WRITE) ? (rfif_len - 1) : 0;
+					state <= L2_LOOKUP;
+				end
+				L2_LOOKUP:
+					if (req_cacheable && lookup_hit) begin
+					`ifdef verilator
+						$display("L2: HIT: Addr %08x, way %d", req_addr, lookup_way);
+					`endif
+						way <= lookup_way;
+						beat <= 0;
+						state <= L2_HIT;
+					end else if (req_cacheable && fsab_credit_avail) begin
+					`ifdef verilator
+						$display("L2: MISS: Addr %08x, evicting way %d", req_addr, l2_evict_next[req_set]);
+					`endif
+						way <= l2_evict_next[req_set];
+						/* verilator lint_off WIDTH */
+						l2_valid[{l2_evict_next[req_set], req_set}] <= 0;
+						l2_tags[{l2_evict_next[req_set], req_set}] <= req_tag;
+						l2_evict_next[req_set] <= (l2_evict_next[req_set] == (NWAYS - 1)) ? 0 : l2_evict_next[req_set] + 1;
+						/* verilator lint_on WIDTH */
+						fill_stale <= 0;
+						beat <= 0;
+						state <= L2_FILL;
+					end else if ((req_mode == FSAB_READ) && fsab_credit_avail) begin
+						beats_rem <= req_len;
+						state <= L2_BYPASS;
+					end else if (start_write) begin
+						wr_hit <= lookup_hit;
+						way <= lookup_way;
+						beats_rem <= req_len - 1;
+						if (dfif_rd)
+							dfif_rem <= dfif_rem - 1;
+						state <= (req_len == 1) ? L2_DONE : L2_WRITE;
+					end
+				L2_HIT: begin
+					hit_valid_1a <= 1;	/* hit_data_1a is read below */
+					beat <= beat + 1;
+					if (beat == 7)
+						state <= L2_DONE;
+				end
+				L2_FILL: begin
+					if (snoop_fill)
+						fill_stale <= 1;
+					if (fill_decode) begin
+						beat <= beat + 1;
+						if (beat == 7) begin
+							l2_valid[{way, req_set}] <= !fill_stale && !snoop_fill;
+							state <= L2_DONE;
+						end
+					end
+				end
+				L2_BYPASS:
+					if (bypass_decode) begin
+						beats_rem <= beats_rem - 1;
+						if (beats_rem == 1)
+							state <= L2_DONE;
+					end
+				L2_WRITE: begin
+					if (dfif_rd)
+						dfif_rem <= dfif_rem - 1;
+					if (wbeat_pending) begin
+						beats_rem <= beats_rem - 1;
+						if (beats_rem == 1)
+							state <= L2_DONE;
+					end
+				end
+				L2_DONE: begin
+					/* Everything from this transaction has been
+					 * pulled out of the RFIF and DFIF, so the
+					 * arbiter can have its credit back.
+					 */
+					arb__fsabo_credit <= 1;
+					state <= L2_IDLE;
+				end
+				endcase
+
+				/* Comes last, so that it wins over a fill finishing
+				 * up on the same line.
+				 */
+				if (snoop_inval)
+					for (i = 0; i < NWAYS; i = i + 1) begin
+						/* verilator lint_off WIDTH */
+						if (l2_tags[{i[NWAYS_HI:0], snoop_set0}] == snoop_tag0)
+							l2_valid[{i[NWAYS_HI:0], snoop_set0}] <= 0;
+						if (l2_tags[{i[NWAYS_HI:0], snoop_set1}] == snoop_tag1)
+							l2_valid[{i[NWAYS_HI:0], snoop_set1}] <= 0;
+						/* verilator lint_on WIDTH */
+					end
+			end
+
+		/* Data array: line fills, write-through hits, and hit reads.
+		 * No reset, because block RAM.  At the start of a write, the
+		 * first beat comes from req_data, and the hit information
+		 * comes straight from the lookup.
+		 */
+		wire [NWAYS_HI:0] wr_way = start_write ? lookup_way : way;
+		wire [2:0] wr_word = start_write ? req_addr[5:3] : wbeat_word;
+		wire wr_en = write_beat && (start_write ? lookup_hit : wr_hit);
+
+		always @(posedge fsabi_clk) begin
+			hit_data_1a <= l2_data[{way, req_set, beat}];
+
+			if ((state == L2_FILL) && fill_decode)
+				l2_data[{way, req_set, beat}] <= fsabi_data;
+			else if (wr_en)
+				for (i = 0; i <= FSAB_MASK_HI; i = i + 1)
+					if (wbeat_mask[i])
+						l2_data[{wr_way, req_set, wr_word}][i*8 +: 8] <= wbeat_data[i*8 +: 8];
+		end
+
+		/*** Outputs ***/
+		assign l2ic__fsabo_valid = 0;
+		assign l2ic__fsabo_mode = {(FSAB_REQ_HI+1){1'bx}};
+		assign l2ic__fsabo_did = {(FSAB_DID_HI+1){1'bx}};
+		assign l2ic__fsabo_subdid = {(FSAB_DID_HI+1){1'bx}};
+		assign l2ic__fsabo_addr = {(FSAB_ADDR_HI+1){1'bx}};
+		assign l2ic__fsabo_len = {(FSAB_LEN_HI+1){1'bx}};
+		assign l2ic__fsabo_data = {(FSAB_DATA_HI+1){1'bx}};
+		assign l2ic__fsabo_mask = {(FSAB_MASK_HI+1){1'bx}};
+
+		assign l2dc__fsabo_valid = out_valid;
+		assign l2dc__fsabo_mode = out_mode;
+		assign l2dc__fsabo_did = out_did;
+		assign l2dc__fsabo_subdid = out_subdid;
+		assign l2dc__fsabo_addr = out_addr;
+		assign l2dc__fsabo_len = out_len;
+		assign l2dc__fsabo_data = out_data;
+		assign l2dc__fsabo_mask = out_mask;
+
+		/* Bypassed reads come back with the requester's own DID, so
+		 * they go straight through; line fills get forwarded on as
+		 * they arrive, relabeled for whoever asked.  Hits are the only
+		 * things we drive ourselves, and there can be nothing of the
+		 * core's in flight on fsabi while we're doing that.
+		 */
+		assign l2__fsabi_valid = hit_valid_1a || fsabi_valid;
+		assign l2__fsabi_did = hit_valid_1a ? req_did : fsabi_did;
+		assign l2__fsabi_subdid = (hit_valid_1a || fill_decode) ? req_subdid : fsabi_subdid;
+		assign l2__fsabi_data = hit_valid_1a ? hit_data_1a : fsabi_data;
+	end else begin: l2_bypass
+		assign l2ic__fsabo_valid = ic__fsabo_valid;
+		assign l2ic__fsabo_mode = ic__fsabo_mode;
+		assign l2ic__fsabo_did = ic__fsabo_did;
+		assign l2ic__fsabo_subdid = ic__fsabo_subdid;
+		assign l2ic__fsabo_addr = ic__fsabo_addr;
+		assign l2ic__fsabo_len = ic__fsabo_len;
+		assign l2ic__fsabo_data = ic__fsabo_data;
+		assign l2ic__fsabo_mask = ic__fsabo_mask;
+		assign ic__fsabo_credit = l2ic__fsabo_credit;
+
+		assign l2dc__fsabo_valid = dc__fsabo_valid;
+		assign l2dc__fsabo_mode = dc__fsabo_mode;
+		assign l2dc__fsabo_did = dc__fsabo_did;
+		assign l2dc__fsabo_subdid = dc__fsabo_subdid;
+		assign l2dc__fsabo_addr = dc__fsabo_addr;
+		assign l2dc__fsabo_len = dc__fsabo_len;
+		assign l2dc__fsabo_data = dc__fsabo_data;
+		assign l2dc__fsabo_mask = dc__fsabo_mask;
+		assign dc__fsabo_credit = l2dc__fsabo_credit;
+
+		assign l2__fsabi_valid = fsabi_valid;
+		assign l2__fsabi_did = fsabi_did;
+		assign l2__fsabi_subdid = fsabi_subdid;
+		assign l2__fsabi_data = fsabi_data;
+	end
+	endgenerate
+endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../console" "../core" "../fsab" "../spam" "../fsab/sim" "../util")
+// End:
@@ -1,4 +1,19 @@
-/* XXX TODO BUG HERE: writes and reads not length 8 bad */
+/* FSAB front end for the DDR2 MIG.
+ *
+ * Requests come in through the IFIFs, and get broken up into bursts (one
+ * MIG command, 64 bytes) in a small scheduling window.  From the window,
+ * we pick whatever's best for the DRAM to do next: a burst to a row that
+ * we think is already open first, then one that doesn't turn the bus
+ * around, then the oldest.  Requests from the same DID are never
+ * reordered against each other, and neither is anything against a write
+ * to the same burst, so as far as any one client can tell, it's all in
+ * order.  If the oldest burst keeps getting passed over, we give up and
+ * go in order for a while.
+ *
+ * Read data comes back from the MIG in the order that we issued it, and
+ * goes back out on the FSAB, trimmed to just the beats that were asked
+ * for.
+ */
 module FSABMemory(/*AUTOARG*/
    // Outputs
    ddr2_a, ddr2_ba, ddr2_cas_n, ddr2_ck, ddr2_ck_n, ddr2_cke,
@@ -58,54 +73,55 @@ module FSABMemory(/*AUTOARG*/
 	output wire [FSAB_DATA_HI:0] fsabi_data;
 	
 	parameter DEBUG = "FALSE";
+	
+	/* How many requests we'll take at once; the arbiter's MEM_CREDITS
+	 * must match this.  Must be a power of two.
+	 */
+	parameter CREDITS = FSAB_MEM_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;	/* queue pointers, with one spare bit */
+	
+	/* Scheduling window, in bursts. */
+	parameter WINDOW = 4;
+	parameter WINDOW_HI = clog2(WINDOW - 1) - 1;
+	
+	/* How many times in a row the oldest entry can be passed over before
+	 * we fall back to strict age order.
+	 */
+	parameter STARVE_LIMIT = 15;
+
+	/* The MIG maps app_af_addr (in units of 64 bits) as {row, bank,
+	 * column}; these pick the bank and row out of a byte address.
+	 */
+`define MEM_BANK(a) a[COL_WIDTH+BANK_WIDTH+2:COL_WIDTH+3]
+`define MEM_ROW(a)  a[COL_WIDTH+BANK_WIDTH+ROW_WIDTH+2:COL_WIDTH+BANK_WIDTH+3]
 
 	/***********************************/
 	/*** Fifo interface declarations ***/
 	/***********************************/
 
-`define IRFIF_DEPTH (FSAB_INITIAL_CREDITS)
+`define IRFIF_DEPTH (CREDITS)
 `define IRFIF_WIDTH (FSAB_REQ_HI+1 + FSAB_DID_HI+1 + FSAB_DID_HI+1 + FSAB_ADDR_HI+1 + FSAB_LEN_HI+1)
 	wire irfif_wr_0a;
 	wire irfif_rd_0a;
+	wire irfif_empty_0a;
 	wire [`IRFIF_WIDTH-1:0] irfif_wdat_0a;
 	wire [`IRFIF_WIDTH-1:0] irfif_rdat_1a;
 
-	/* DDR: double wide, half as deep */
-`define IDFIF_DEPTH (FSAB_INITIAL_CREDITS * FSAB_LEN_MAX / 2)
-`define IDFIF_WIDTH (2*(FSAB_DATA_HI+1 + FSAB_MASK_HI+1))
+	/* One entry per FSAB beat of write data; reads don't put anything
+	 * in here.
+	 */
+`define IDFIF_DEPTH (CREDITS * FSAB_LEN_MAX)
+`define IDFIF_WIDTH (FSAB_DATA_HI+1 + FSAB_MASK_HI+1)
 	wire idfif_wr_0a;
 	wire idfif_rd_0a;
+	wire idfif_empty_0a;
 	wire [`IDFIF_WIDTH-1:0] idfif_wdat_0a;
 	wire [`IDFIF_WIDTH-1:0] idfif_rdat_1a;
 
-	/* XXX TODO: Is this what we want? */
-`define OFIF_DEPTH (FSAB_INITIAL_CREDITS)
-
-`define ORFIF_DEPTH (OFIF_DEPTH)
-`define ORFIF_WIDTH (FSAB_DID_HI+1 + FSAB_DID_HI+1 + FSAB_LEN_HI+1)
-	wire orfif_wr_0a;
-	wire orfif_rd_0a;
-	wire [`ORFIF_WIDTH-1:0] orfif_wdat_0a;
-	wire [`ORFIF_WIDTH-1:0] orfif_rdat_1a;
-
-`define ODFIF_WIDTH (2*(FSAB_DATA_HI+1))
-`define ODFIF_DEPTH (OFIF_DEPTH * FSAB_LEN_MAX / 2)
-	wire odfif_wr_0a;
-	wire odfif_rd_0a;
-	wire [`ODFIF_WIDTH-1:0] odfif_wdat_0a;
-	wire [`ODFIF_WIDTH-1:0] odfif_rdat_1a;
-
 	/************************************/
 	/*** Demux & control declarations ***/
 	/************************************/
 
-	/* OxFIF credits */
-`define OFIF_INITIAL_CREDITS FSAB_INITIAL_CREDITS
-`define OFIF_CREDIT_WIDTH (clog2(`OFIF_INITIAL_CREDITS))
-	reg [`OFIF_CREDIT_WIDTH-1:0] ofif_credits = `OFIF_INITIAL_CREDITS;
-	wire ofif_credit;
-	wire ofif_debit;
-
 	/* FSAB -> IFIF */
 	reg [FSAB_LEN_HI:0] fsabo_cur_req_len_rem_0a = 0;
 	wire fsabo_cur_req_done_0a;
@@ -116,23 +132,11 @@ module FSABMemory(/*AUTOARG*/
 	wire [FSAB_DID_HI:0]  irfif_subdid_1a;
 	wire [FSAB_ADDR_HI:0] irfif_addr_1a;
 	wire [FSAB_LEN_HI:0]  irfif_len_1a;
-	wire [FSAB_LEN_HI:0]  irfif_ddr_len_1a;
-
-	wire [FSAB_DATA_HI:0] idfif_data_1a;
-	wire [FSAB_MASK_HI:0] idfif_mask_1a;
-	wire [FSAB_DATA_HI:0] idfif_data2_1a;
-	wire [FSAB_MASK_HI:0] idfif_mask2_1a;
-
-	reg [FSAB_DATA_HI:0] fsabo_prev_data;
-	reg [FSAB_MASK_HI:0] fsabo_prev_mask;
 	
-	/* IFIF -> MIG */
-	wire mem_stall_0a;
-	reg irfif_rd_1a = 0;
-	reg idfif_rd_1a = 0;
-
-	reg fsabo_want_prev = 0;
-
+	/* IFIF -> window */
+	reg                   ld_done = 0;
+	
+	/* Window -> MIG */
 	wire [MIG_CMD_WIDTH-1:0] app_af_cmd;
 	wire [30:0]              app_af_addr;
 	wire                     app_af_wren;
@@ -142,225 +146,451 @@ module FSABMemory(/*AUTOARG*/
 	wire [2*DQ_WIDTH-1:0]    app_wdf_data;
 	wire [2*DM_WIDTH-1:0]    app_wdf_mask_data;
 
-`define ICNT_WIDTH (clog2(FSAB_INITIAL_CREDITS)-1)
-	reg [`ICNT_WIDTH:0] ifif_reqs_queued_0a = 0;
-	wire ifif_have_req;
-
-	wire idfif_req_queued_0a;
-
-	/* MIG -> OFIF */
-
-	/* OFIF -> FSAB */
+	/* MIG -> FSAB */
 	wire [2*DQ_WIDTH-1:0]    rd_data_fifo_out; 
 	wire                     rd_data_valid;
-	reg [FSAB_LEN_HI:0]      ofif_resp_len_rem_0a = 0;
-	wire                     ofif_resp_active_0a;
-
-	wire [FSAB_DID_HI:0]  orfif_did_1a;
-	wire [FSAB_DID_HI:0]  orfif_subdid_1a;
-	wire [FSAB_LEN_HI:0]  orfif_len_1a;
-	reg orfif_rd_1a = 0;
-	reg odfif_rd_1a = 0;
-	wire orfif_empty_0a;
-	wire odfif_empty_0a;
-
-	wire [FSAB_DATA_HI:0] odfif_data_1a, odfif_data2_1a;
 
 	/*****************************/
 	/*** Demux & control logic ***/
 	/*****************************/
 
-	/*** OFIF credits ***/
-
-	always @(posedge clk0_tb or posedge rst0_tb)
-		if (rst0_tb) begin
-			ofif_credits <= `OFIF_INITIAL_CREDITS;
-		end else begin
-			ofif_credits <= ofif_credits
-			                + (ofif_debit ? -1 : 0)
-			                + (ofif_credit ? 1 : 0);
-		end
-
 	/*** FSAB -> IFIF ***/
 
+	/* Requests go into irfif as they come in.  Write data goes into
+	 * idfif one FSAB beat per entry, exactly as it came; the loader
+	 * works out where it lands.
+	 */
 	assign irfif_wdat_0a = {fsabo_mode, fsabo_did, fsabo_subdid,
 	                       fsabo_addr, fsabo_len};
 	assign irfif_wr_0a = fsabo_new_req_0a;
 	assign fsabo_cur_req_done_0a = (fsabo_cur_req_len_rem_0a==0);
 	assign fsabo_new_req_0a = fsabo_valid && fsabo_cur_req_done_0a;
-	wire   idfif_align_mess_0a = (fsabo_new_req_0a && fsabo_addr[3]);
-	assign idfif_wdat_0a = idfif_align_mess_0a ? { fsabo_data, fsabo_mask, {(FSAB_DATA_HI+1){1'h0}},  {(FSAB_MASK_HI+1){1'h0}} }
-	                                           : { fsabo_data, (fsabo_cur_req_done_0a ? {(FSAB_MASK_HI+1){1'h0}} : fsabo_mask), fsabo_prev_data, fsabo_prev_mask};
-	assign idfif_wr_0a = (fsabo_valid && idfif_align_mess_0a) ||
-		             (fsabo_want_prev && (fsabo_valid || fsabo_cur_req_done_0a));
-	
-	assign idfif_req_queued_0a = idfif_wr_0a && (fsabo_cur_req_done_0a || fsabo_cur_req_len_rem_0a == 1);
-	assign ifif_have_req = ifif_reqs_queued_0a != 0;
+	assign idfif_wdat_0a = {fsabo_data, fsabo_mask};
+	assign idfif_wr_0a = fsabo_valid && (!fsabo_cur_req_done_0a || (fsabo_mode == FSAB_WRITE));
 	
 	always @(posedge clk0_tb or posedge rst0_tb)
 		if (rst0_tb) begin
 			fsabo_cur_req_len_rem_0a <= 0;
 		end else begin
-			if (fsabo_valid && fsabo_cur_req_done_0a && (fsabo_mode == FSAB_WRITE))
+			if (fsabo_new_req_0a && (fsabo_mode == FSAB_WRITE) && (fsabo_len > 1))
 				fsabo_cur_req_len_rem_0a <= fsabo_len - 1;
 			else if (fsabo_valid && fsabo_cur_req_len_rem_0a != 0)
 				fsabo_cur_req_len_rem_0a <= fsabo_cur_req_len_rem_0a - 1;
 		end
 
-	always @(posedge clk0_tb or posedge rst0_tb)
-		if (rst0_tb) begin
-			fsabo_prev_data <= 0;
-			fsabo_prev_mask <= {(FSAB_MASK_HI+1){1'h0}};
-		end else if (fsabo_valid) begin
-			fsabo_prev_data <= fsabo_data;
-			fsabo_prev_mask <= fsabo_mask;
-		end
-
-	always @(posedge clk0_tb or posedge rst0_tb)
-		if (rst0_tb) begin
-			fsabo_want_prev <= 0;
-		end else if (fsabo_valid && !idfif_align_mess_0a && (!fsabo_want_prev || fsabo_new_req_0a)) begin
-			fsabo_want_prev <= 1;
-		end else if (idfif_wr_0a) begin
-			fsabo_want_prev <= 0;
-		end
-
-	always @(posedge clk0_tb or posedge rst0_tb)
-		if (rst0_tb) begin
-			ifif_reqs_queued_0a <= 0;
-		end else begin
-			ifif_reqs_queued_0a <= ifif_reqs_queued_0a + (idfif_req_queued_0a ? 1 : 0)
-			                                           + (irfif_rd_0a ? -1 : 0);
+	/*** Scheduling window ***/
+	
+	/* Each entry is one burst's worth (64 bytes) of a request: which
+	 * burst, and which beats of it the requester cares about.  Write
+	 * data lives in slot_data, indexed by {entry, beat}, with a valid
+	 * bit per beat; beats that never got written go out masked.
+	 *
+	 * slot_older[i][j] is set if entry j was already there when entry i
+	 * was allocated.
+	 */
+	reg  [WINDOW-1:0]          slot_v = {WINDOW{1'b0}};
+	reg  [WINDOW-1:0]          slot_busy = {WINDOW{1'b0}};	/* write data still going out */
+	reg  [WINDOW-1:0]          slot_loaded = {WINDOW{1'b0}};
+	reg  [FSAB_REQ_HI:0]       slot_mode [WINDOW-1:0];
+	reg  [FSAB_DID_HI:0]       slot_did [WINDOW-1:0];
+	reg  [FSAB_DID_HI:0]       slot_subdid [WINDOW-1:0];
+	reg  [FSAB_ADDR_HI:6]      slot_addr [WINDOW-1:0];
+	reg  [2:0]                 slot_first [WINDOW-1:0];
+	reg  [2:0]                 slot_last [WINDOW-1:0];
+	reg  [7:0]                 slot_beats [WINDOW-1:0];
+	reg  [WINDOW-1:0]          slot_older [WINDOW-1:0];
+	reg  [`IDFIF_WIDTH-1:0]    slot_data [WINDOW*8-1:0];
+	
+	integer i, j;
+	initial
+		for (i = 0; i < WINDOW; i = i + 1) begin
+			slot_mode[i] = FSAB_READ;
+			slot_did[i] = 0;
+			slot_subdid[i] = 0;
+			slot_addr[i] = 0;
+			slot_first[i] = 0;
+			slot_last[i] = 0;
+			slot_beats[i] = 0;
+			slot_older[i] = 0;
 		end
-
-	/*** IFIF -> MIG ***/
 	
-	/* http://upload.wikimedia.org/wikipedia/commons/d/d5/F-4_parts_distribution.jpg */
-
-	/* irfif_rd is assigned later */
+	/*** IFIF -> window ***/
+	
+	/* The loader takes one request at a time out of irfif, and puts it
+	 * into one window entry -- or two, if it crosses a burst boundary. 
+	 * For writes, it then moves the data over, one beat per cycle.  The
+	 * credit goes back to the arbiter once all of it is out of the
+	 * IFIFs.  (A length of 0 is taken to be 1.)
+	 */
+	parameter LD_IDLE = 2'd0;
+	parameter LD_HDR  = 2'd1;
+	parameter LD_DATA = 2'd2;
+	reg [1:0] ld_state = LD_IDLE;
+	
+	reg [WINDOW-1:0]    slot_free;	/* combinatorial */
+	reg [WINDOW_HI:0]   ld_slot_a, ld_slot_b;
+	reg                 ld_found_a, ld_found_b;
+	always @(*) begin
+		slot_free = ~slot_v & ~slot_busy;
+		ld_slot_a = 0;
+		ld_slot_b = 0;
+		ld_found_a = 0;
+		ld_found_b = 0;
+		/* verilator lint_off WIDTH */
+		for (i = WINDOW - 1; i >= 0; i = i - 1)
+			if (slot_free[i]) begin
+				ld_slot_b = ld_slot_a;
+				ld_found_b = ld_found_a;
+				ld_slot_a = i;
+				ld_found_a = 1;
+			end
+		/* verilator lint_on WIDTH */
+	end
+	
+	wire [FSAB_LEN_HI:0] ld_len_1a = (irfif_len_1a == 0) ? 1 : irfif_len_1a;
+	/* Last beat, counting from the start of the first burst. */
+	wire [3:0]           ld_end_1a = irfif_addr_1a[5:3] + ld_len_1a - 1;
+	wire                 ld_cross_1a = ld_end_1a[3];
+	
+	reg [WINDOW_HI:0]   ld_slot_a_r = 0;
+	reg [WINDOW_HI:0]   ld_slot_b_r = 0;
+	reg                 ld_cross_r = 0;
+	reg [3:0]           ld_pos = 0;
+	reg [FSAB_LEN_HI:0] ld_rem = 0;
+	reg                 ld_wr_1a = 0;
+	reg [3:0]           ld_wr_pos_1a = 0;
+	reg                 ld_wr_last_1a = 0;
+	
+	wire [WINDOW_HI:0]  ld_wr_slot_1a = ld_wr_pos_1a[3] ? ld_slot_b_r : ld_slot_a_r;
+	
+	/* We always wait for two free entries, so the header never has to
+	 * wait once it's out.
+	 */
+	assign irfif_rd_0a = (ld_state == LD_IDLE) && !irfif_empty_0a && ld_found_a && ld_found_b;
+	assign idfif_rd_0a = (ld_state == LD_DATA) && (ld_rem != 0) && !idfif_empty_0a;
+	assign fsabo_credit = ld_done;
 	
 	assign {irfif_mode_1a, irfif_did_1a, irfif_subdid_1a, irfif_addr_1a,
 	        irfif_len_1a} = irfif_rdat_1a;
-	/* XXX TODO BUG HERE: misaligned write can cause an extra thing */
-	assign irfif_ddr_len_1a = (irfif_len_1a + 1) / 2;
-	assign {idfif_data2_1a,idfif_mask2_1a,idfif_data_1a,idfif_mask_1a} = idfif_rdat_1a;
-
+	
+	always @(posedge clk0_tb)
+		if (ld_wr_1a)
+			slot_data[{ld_wr_slot_1a, ld_wr_pos_1a[2:0]}] <= idfif_rdat_1a;
 
-	wire ixfif_active_0a;
-	reg  ixfif_active_1a = 0;
+	/*** Window -> MIG ***/
 	
-	/* Invariant -- between every request, ixfif_cur_mig_wr_cyc_0a dies
-	 * to zero.
+	/* The bank state is only a guess -- the MIG closes rows behind our
+	 * back for refresh -- but it's a good one.
 	 */
-	reg [2:0] ixfif_cur_mig_wr_cyc_0a = 0;
-	reg [2:0] ixfif_cur_mig_wr_cyc_1a = 0;
-	wire ixfif_burst_fill_0a = (ixfif_cur_mig_wr_cyc_0a >= irfif_ddr_len_1a) && (ixfif_cur_mig_wr_cyc_0a != 0);
-	reg ixfif_burst_fill_1a = 0;
-
-	/* XXX: is ofif_credits needed? */
-	assign irfif_rd_0a = ifif_have_req &&
-	                     !ixfif_active_1a &&
-	                     !irfif_rd_1a &&
-	                     (ofif_credits != 0) && /* This could be optimized to only stall on READs by adding */
-	                     !app_wdf_afull &&      /* a wait state after the rfif was read, if we had to. */
-	                     !app_af_afull; /* I'M ALMOST FULL! */
-	assign idfif_rd_0a = irfif_rd_0a ||
-	                     (ixfif_active_0a && !ixfif_burst_fill_0a);
-	assign fsabo_credit = ixfif_active_1a && !ixfif_active_0a;
-
-	/* There must always be a space here to allow time for
-	 * ixfif_cur_mig_wr_cyc_0a to reset.
+	reg [ROW_WIDTH-1:0]   bank_row [(1 << BANK_WIDTH)-1:0];
+	reg [(1 << BANK_WIDTH)-1:0] bank_open = 0;
+	initial
+		for (i = 0; i < (1 << BANK_WIDTH); i = i + 1)
+			bank_row[i] = 0;
+	
+	reg [FSAB_REQ_HI:0]   sch_last_mode = FSAB_READ;
+	reg [3:0]             sch_passed = 0;
+	wire                  sch_starving = (sch_passed >= STARVE_LIMIT);
+	
+	/* Write data goes out over four cycles once a write is issued. */
+	reg                   wr_busy = 0;
+	reg [WINDOW_HI:0]     wr_slot = 0;
+	reg [1:0]             wr_word = 0;
+	
+	reg [CREDITS_HI:0]    ofif_credits = CREDITS;	/* read bursts we have room to take back */
+	
+	wire can_write = !wr_busy && !app_af_afull && !app_wdf_afull;
+	wire can_read = (ofif_credits != 0) && !app_af_afull;
+	
+	reg [WINDOW-1:0] sch_elig;	/* combinatorial */
+	reg [WINDOW-1:0] sch_oldest;
+	reg [1:0]        sch_score [WINDOW-1:0];
+	reg [WINDOW-1:0] sch_win;
+	reg [WINDOW_HI:0] sch_slot;
+	reg              sch_issue;
+	
+	always @(*) begin
+		for (i = 0; i < WINDOW; i = i + 1) begin
+			sch_elig[i] = slot_v[i] && slot_loaded[i] &&
+			              ((slot_mode[i] == FSAB_WRITE) ? can_write : can_read);
+			for (j = 0; j < WINDOW; j = j + 1)
+				if (slot_v[j] && slot_older[i][j] &&
+				    ((slot_did[j] == slot_did[i]) ||
+				     ((slot_addr[j] == slot_addr[i]) &&
+				      ((slot_mode[i] == FSAB_WRITE) || (slot_mode[j] == FSAB_WRITE)))))
+					sch_elig[i] = 0;
+			
+			sch_oldest[i] = slot_v[i] && ((slot_older[i] & slot_v) == 0);
+			
+			sch_score[i] = sch_starving ? 2'b00 :
+			               {bank_open[`MEM_BANK(slot_addr[i])] &&
+			                (bank_row[`MEM_BANK(slot_addr[i])] == `MEM_ROW(slot_addr[i])),
+			                slot_mode[i] == sch_last_mode};
+		end
+		
+		/* Best score wins; ties go to the oldest. */
+		for (i = 0; i < WINDOW; i = i + 1) begin
+			sch_win[i] = sch_elig[i];
+			for (j = 0; j < WINDOW; j = j + 1)
+				if ((j != i) && sch_elig[j] &&
+				    ((sch_score[j] > sch_score[i]) ||
+				     ((sch_score[j] == sch_score[i]) && slot_older[i][j])))
+					sch_win[i] = 0;
+		end
+		
+		sch_slot = 0;
+		sch_issue = 0;
+		/* verilator lint_off WIDTH */
+		for (i = 0; i < WINDOW; i = i + 1)
+			if (sch_win[i]) begin
+				sch_slot = i;
+				sch_issue = 1;
+			end
+		/* verilator lint_on WIDTH */
+	end
+	
+	/* Outbound to the MIG; all registered. */
+	reg                      af_wren_r = 0;
+	reg [MIG_CMD_WIDTH-1:0]  af_cmd_r = MIG_READ;
+	reg [30:0]               af_addr_r = 0;
+	reg                      wdf_wren_r = 0;
+	reg [2*DQ_WIDTH-1:0]     wdf_data_r = 0;
+	reg [2*DM_WIDTH-1:0]     wdf_mask_r = 0;
+	
+	assign app_af_wren = af_wren_r;
+	assign app_af_cmd = af_cmd_r;
+	assign app_af_addr = af_addr_r;
+	assign app_wdf_wren = wdf_wren_r;
+	assign app_wdf_data = wdf_data_r;
+	assign app_wdf_mask_data = wdf_mask_r;
+	
+	/* One MIG write data word is two FSAB beats, low address in the low
+	 * half; the MIG's mask is active high.
 	 */
-	assign ixfif_active_0a = irfif_rd_0a || /* we have a new request... */
-	                         (ixfif_active_1a && /* there is an old request, */
-	                          (irfif_mode_1a == FSAB_WRITE) && /* and it was a write, */
-	                          (ixfif_cur_mig_wr_cyc_1a != 3)); /* and the previous read was not the end */
-
-	assign app_af_cmd = irfif_mode_1a == FSAB_WRITE ? MIG_WRITE : MIG_READ;
-	/* The address should have the lower 3 bits trimmed, and the 4th set
-	 * to 0; this is the write granularity available.
+	wire [WINDOW_HI:0]     wdf_slot = wr_busy ? wr_slot : sch_slot;
+	wire [1:0]             wdf_word = wr_busy ? wr_word : 2'd0;
+	wire [`IDFIF_WIDTH-1:0] wdf_lo = slot_data[{wdf_slot, wdf_word, 1'b0}];
+	wire [`IDFIF_WIDTH-1:0] wdf_hi = slot_data[{wdf_slot, wdf_word, 1'b1}];
+	wire [7:0]             wdf_beats = slot_beats[wdf_slot];
+	wire [FSAB_MASK_HI:0]  wdf_lo_mask = wdf_beats[{wdf_word, 1'b0}] ? wdf_lo[FSAB_MASK_HI:0] : 0;
+	wire [FSAB_MASK_HI:0]  wdf_hi_mask = wdf_beats[{wdf_word, 1'b1}] ? wdf_hi[FSAB_MASK_HI:0] : 0;
+	
+	/*** MIG -> FSAB ***/
+	
+	/* Read data comes back from the MIG in the order that we asked for
+	 * it, four 128-bit words per burst, into rbuf.  Each read burst has
+	 * an entry in the output queue, in the same order, so the output
+	 * queue index is also the rbuf burst index.
 	 */
-	assign app_af_addr = {irfif_addr_1a[30:4], 1'b0};
-	assign app_af_wren = irfif_rd_1a;
-
-	assign app_wdf_wren = (irfif_mode_1a == FSAB_WRITE) && ixfif_active_1a;
-	assign app_wdf_data = {idfif_data2_1a, idfif_data_1a};
-	assign app_wdf_mask_data = ixfif_burst_fill_1a ? {8'hFF, 8'hFF} : ~{idfif_mask2_1a, idfif_mask_1a};
-
-	assign ofif_debit = irfif_rd_1a && irfif_mode_1a == FSAB_READ;
-
+	reg  [FSAB_DID_HI:0]   oq_did [CREDITS-1:0];
+	reg  [FSAB_DID_HI:0]   oq_subdid [CREDITS-1:0];
+	reg  [2:0]             oq_first [CREDITS-1:0];
+	reg  [2:0]             oq_last [CREDITS-1:0];
+	reg  [CREDITS_HI:0]    oq_wpos = 0;
+	reg  [CREDITS_HI:0]    oq_rpos = 0;
+	wire                   oq_empty = (oq_wpos == oq_rpos);
+	wire [CREDITS_HI-1:0]  oq_head = oq_rpos[CREDITS_HI-1:0];
+	
+	reg  [2*DQ_WIDTH-1:0]  rbuf [CREDITS*4-1:0];
+	reg  [CREDITS_HI:0]    rb_wpos = 0;	/* burst being filled */
+	reg  [1:0]             rb_wword = 0;	/* words of it that are in */
+	
+	always @(posedge clk0_tb)
+		if (rd_data_valid)
+			rbuf[{rb_wpos[CREDITS_HI-1:0], rb_wword}] <= rd_data_fifo_out;
+	
+	reg        ob_started = 0;
+	reg  [2:0] ob_beat = 0;
+	wire [2:0] ob_cur_beat = ob_started ? ob_beat : oq_first[oq_head];
+	wire       ob_ready = !oq_empty &&
+	                      ((rb_wpos != oq_rpos) || (ob_cur_beat[2:1] < rb_wword));
+	wire       ob_done = ob_ready && (ob_cur_beat == oq_last[oq_head]);
+	wire [2*DQ_WIDTH-1:0] ob_word = rbuf[{oq_head, ob_cur_beat[2:1]}];
+	
+	assign fsabi_valid = ob_ready;
+	assign fsabi_did = oq_did[oq_head];
+	assign fsabi_subdid = oq_subdid[oq_head];
+	assign fsabi_data = ob_cur_beat[0] ? ob_word[2*DQ_WIDTH-1:DQ_WIDTH] : ob_word[DQ_WIDTH-1:0];
+	
+	/*** The big state update ***/
+	
 	always @(posedge clk0_tb or posedge rst0_tb)
 		if (rst0_tb) begin
-			ixfif_active_1a <= 0;
-			ixfif_cur_mig_wr_cyc_0a <= 0;
-			ixfif_cur_mig_wr_cyc_1a <= 0;
-			ixfif_burst_fill_1a <= 0;
+			ld_state <= LD_IDLE;
+			ld_done <= 0;
+			ld_slot_a_r <= 0;
+			ld_slot_b_r <= 0;
+			ld_cross_r <= 0;
+			ld_pos <= 0;
+			ld_rem <= 0;
+			ld_wr_1a <= 0;
+			ld_wr_pos_1a <= 0;
+			ld_wr_last_1a <= 0;
+			slot_v <= {WINDOW{1'b0}};
+			slot_busy <= {WINDOW{1'b0}};
+			slot_loaded <= {WINDOW{1'b0}};
+			bank_open <= 0;
+			sch_last_mode <= FSAB_READ;
+			sch_passed <= 0;
+			wr_busy <= 0;
+			wr_slot <= 0;
+			wr_word <= 0;
+			ofif_credits <= CREDITS;
+			af_wren_r <= 0;
+			wdf_wren_r <= 0;
+			oq_wpos <= 0;
+			oq_rpos <= 0;
+			rb_wpos <= 0;
+			rb_wword <= 0;
+			ob_started <= 0;
+			ob_beat <= 0;
 		end else begin
-			ixfif_active_1a <= ixfif_active_0a;
-			if (ixfif_active_0a)
-				ixfif_cur_mig_wr_cyc_0a <= ixfif_cur_mig_wr_cyc_0a + 1;
-			else
-				ixfif_cur_mig_wr_cyc_0a <= 0;	/* Reset in the read case. */
+			/*** Loader ***/
+			ld_done <= 0;
+			ld_wr_1a <= idfif_rd_0a;
+			ld_wr_pos_1a <= ld_pos;
+			ld_wr_last_1a <= (ld_rem == 1);
+			
+			case (ld_state)
+			LD_IDLE:
+				if (irfif_rd_0a) begin
+					ld_slot_a_r <= ld_slot_a;
+					ld_slot_b_r <= ld_slot_b;
+					ld_state <= LD_HDR;
+				end
+			LD_HDR: begin
+			`ifdef verilator
+				$display("MEM: %5d: load %d word %s at %08x into %d%s", $time, ld_len_1a, (irfif_mode_1a == FSAB_WRITE) ? "WRITE" : "READ", irfif_addr_1a, ld_slot_a_r, ld_cross_1a ? " (and the next)" : "");
+			`endif
+				slot_v[ld_slot_a_r] <= 1;
+				slot_loaded[ld_slot_a_r] <= (irfif_mode_1a == FSAB_READ);
+				slot_mode[ld_slot_a_r] <= irfif_mode_1a;
+				slot_did[ld_slot_a_r] <= irfif_did_1a;
+				slot_subdid[ld_slot_a_r] <= irfif_subdid_1a;
+				slot_addr[ld_slot_a_r] <= irfif_addr_1a[FSAB_ADDR_HI:6];
+				slot_first[ld_slot_a_r] <= irfif_addr_1a[5:3];
+				slot_last[ld_slot_a_r] <= ld_cross_1a ? 3'd7 : ld_end_1a[2:0];
+				slot_beats[ld_slot_a_r] <= 8'h00;
+				slot_older[ld_slot_a_r] <= slot_v;
+				for (i = 0; i < WINDOW; i = i + 1)
+					slot_older[i][ld_slot_a_r] <= 0;
+				
+				if (ld_cross_1a) begin
+					slot_v[ld_slot_b_r] <= 1;
+					slot_loaded[ld_slot_b_r] <= (irfif_mode_1a == FSAB_READ);
+					slot_mode[ld_slot_b_r] <= irfif_mode_1a;
+					slot_did[ld_slot_b_r] <= irfif_did_1a;
+					slot_subdid[ld_slot_b_r] <= irfif_subdid_1a;
+					slot_addr[ld_slot_b_r] <= irfif_addr_1a[FSAB_ADDR_HI:6] + 1;
+					slot_first[ld_slot_b_r] <= 3'd0;
+					slot_last[ld_slot_b_r] <= ld_end_1a[2:0];
+					slot_beats[ld_slot_b_r] <= 8'h00;
+					/* verilator lint_off WIDTH */
+					for (i = 0; i < WINDOW; i = i + 1)
+						slot_older[ld_slot_b_r][i] <= slot_v[i] || (i == ld_slot_a_r);
+					/* verilator lint_on WIDTH */
+					for (i = 0; i < WINDOW; i = i + 1)
+						slot_older[i][ld_slot_b_r] <= 0;
+				end
 				
-			ixfif_cur_mig_wr_cyc_1a <= ixfif_cur_mig_wr_cyc_0a;
+				ld_cross_r <= ld_cross_1a;
+				ld_pos <= {1'b0, irfif_addr_1a[5:3]};
+				ld_rem <= ld_len_1a;
+				if (irfif_mode_1a == FSAB_WRITE)
+					ld_state <= LD_DATA;
+				else begin
+					ld_done <= 1;
+					ld_state <= LD_IDLE;
+				end
+			end
+			LD_DATA: begin
+				if (idfif_rd_0a) begin
+					ld_pos <= ld_pos + 1;
+					ld_rem <= ld_rem - 1;
+				end
+				
+				if (ld_wr_1a) begin
+					slot_beats[ld_wr_slot_1a][ld_wr_pos_1a[2:0]] <= 1'b1;
+					if (ld_wr_last_1a) begin
+						slot_loaded[ld_slot_a_r] <= 1;
+						if (ld_cross_r)
+							slot_loaded[ld_slot_b_r] <= 1;
+						ld_done <= 1;
+						ld_state <= LD_IDLE;
+					end
+				end
+			end
+			default: ld_state <= LD_IDLE;
+			endcase
 			
-			ixfif_burst_fill_1a <= ixfif_burst_fill_0a;
-		end
-
-	/*** MIG -> OFIF ***/
-
-	assign orfif_wdat_0a = {irfif_did_1a, irfif_subdid_1a, irfif_len_1a};
-	assign orfif_wr_0a = irfif_rd_1a && irfif_mode_1a == FSAB_READ;
-	assign odfif_wdat_0a = rd_data_fifo_out;
-	assign odfif_wr_0a = rd_data_valid;
-
-	/*** OFIF -> FSAB ***/
-
-	assign {orfif_did_1a, orfif_subdid_1a, orfif_len_1a} = orfif_rdat_1a;
-	assign {odfif_data2_1a, odfif_data_1a} = odfif_rdat_1a;
-
-	assign orfif_rd_0a = !orfif_empty_0a && !odfif_empty_0a && !ofif_resp_active_0a;
-	assign odfif_rd_0a = orfif_rd_0a || (ofif_resp_active_0a && !odfif_rd_1a);
-
-	assign ofif_resp_active_0a = (orfif_rd_1a && orfif_len_1a != 1) ||
-	                             (ofif_resp_len_rem_0a != 1 && ofif_resp_len_rem_0a != 0);
-
-	assign ofif_credit = fsabi_valid && !ofif_resp_active_0a;
-
-	assign fsabi_data = (!odfif_rd_1a) ? odfif_data2_1a : odfif_data_1a;
-	assign fsabi_valid = orfif_rd_1a || ofif_resp_len_rem_0a != 0;
-	assign fsabi_did = orfif_did_1a;
-	assign fsabi_subdid = orfif_subdid_1a;
-
-	always @(posedge clk0_tb or posedge rst0_tb)
-		if (rst0_tb) begin
-			ofif_resp_len_rem_0a <= 0;
-		end else begin
-			if (orfif_rd_1a)
-				ofif_resp_len_rem_0a <= orfif_len_1a - 1;
-			else if (ofif_resp_len_rem_0a != 0)
-				ofif_resp_len_rem_0a <= ofif_resp_len_rem_0a - 1;
-		end
-
-	/*********************/
-	/*** Pipe-throughs ***/
-	/*********************/
-
-	always @(posedge clk0_tb or posedge rst0_tb) begin
-		if (rst0_tb) begin
-			irfif_rd_1a <= 0;
-			idfif_rd_1a <= 0;
-			orfif_rd_1a <= 0;
-			odfif_rd_1a <= 0;
-		end else begin
-			if (! mem_stall_0a) begin
-				irfif_rd_1a <= irfif_rd_0a;
-				idfif_rd_1a <= idfif_rd_0a;
+			/*** Scheduler ***/
+			af_wren_r <= sch_issue;
+			if (sch_issue) begin
+			`ifdef verilator
+				$display("MEM: %5d: issue %d: %s burst at %08x, beats %d-%d%s", $time, sch_slot, (slot_mode[sch_slot] == FSAB_WRITE) ? "WRITE" : "READ", {slot_addr[sch_slot], 6'b0}, slot_first[sch_slot], slot_last[sch_slot], sch_score[sch_slot][1] ? " (row hit)" : "");
+			`endif
+				af_cmd_r <= (slot_mode[sch_slot] == FSAB_WRITE) ? MIG_WRITE : MIG_READ;
+				/* verilator lint_off WIDTH */
+				af_addr_r <= {slot_addr[sch_slot], 3'b000};
+				/* verilator lint_on WIDTH */
+				
+				slot_v[sch_slot] <= 0;
+				bank_open[`MEM_BANK(slot_addr[sch_slot])] <= 1;
+				bank_row[`MEM_BANK(slot_addr[sch_slot])] <= `MEM_ROW(slot_addr[sch_slot]);
+				sch_last_mode <= slot_mode[sch_slot];
+				
+				if (sch_oldest[sch_slot])
+					sch_passed <= 0;
+				else if (!sch_starving)
+					sch_passed <= sch_passed + 1;
+				
+				if (slot_mode[sch_slot] == FSAB_WRITE) begin
+					slot_busy[sch_slot] <= 1;
+					wr_busy <= 1;
+					wr_slot <= sch_slot;
+					wr_word <= 2'd1;
+				end else begin
+					oq_did[oq_wpos[CREDITS_HI-1:0]] <= slot_did[sch_slot];
+					oq_subdid[oq_wpos[CREDITS_HI-1:0]] <= slot_subdid[sch_slot];
+					oq_first[oq_wpos[CREDITS_HI-1:0]] <= slot_first[sch_slot];
+					oq_last[oq_wpos[CREDITS_HI-1:0]] <= slot_last[sch_slot];
+					oq_wpos <= oq_wpos + 1;
+				end
 			end
-			orfif_rd_1a <= orfif_rd_0a;
-			odfif_rd_1a <= odfif_rd_0a;
+			
+			/* Write data: word 0 goes along with the command, and the
+			 * rest follow on the next three cycles.
+			 */
+			wdf_wren_r <= wr_busy || (sch_issue && (slot_mode[sch_slot] == FSAB_WRITE));
+			wdf_data_r <= {wdf_hi[`IDFIF_WIDTH-1:FSAB_MASK_HI+1], wdf_lo[`IDFIF_WIDTH-1:FSAB_MASK_HI+1]};
+			wdf_mask_r <= ~{wdf_hi_mask, wdf_lo_mask};
+			if (wr_busy) begin
+				wr_word <= wr_word + 1;
+				if (wr_word == 2'd3) begin
+					wr_busy <= 0;
+					slot_busy[wr_slot] <= 0;
+				end
+			end
+			
+			/*** Read return ***/
+			if (rd_data_valid) begin
+				rb_wword <= rb_wword + 1;
+				if (rb_wword == 2'd3)
+					rb_wpos <= rb_wpos + 1;
+			end
+			
+			if (ob_done) begin
+				ob_started <= 0;
+				oq_rpos <= oq_rpos + 1;
+			end else if (ob_ready) begin
+				ob_started <= 1;
+				ob_beat <= ob_cur_beat + 1;
+			end
+			
+			ofif_credits <= ofif_credits
+			                - ((sch_issue && (slot_mode[sch_slot] == FSAB_READ)) ? 1 : 0)
+			                + (ob_done ? 1 : 0);
 		end
-	end
 
 	/**************/
 	/*** Blocks ***/
@@ -374,9 +604,10 @@ module FSABMemory(/*AUTOARG*/
 	       .wr_en   (irfif_wr_0a),
 	       .rd_en   (irfif_rd_0a),
 	       .wr_dat  (irfif_wdat_0a),
-	       .rd_dat  (irfif_rdat_1a));
+	       .rd_dat  (irfif_rdat_1a),
+	       .empty   (irfif_empty_0a));
 
-	Fifo  #(.DEPTH   (FSAB_INITIAL_CREDITS * FSAB_LEN_MAX / 2),
+	Fifo  #(.DEPTH   (`IDFIF_DEPTH),
 	        .WIDTH   (`IDFIF_WIDTH))
 	idfif
 	       (.clk     (clk0_tb),
@@ -384,30 +615,8 @@ module FSABMemory(/*AUTOARG*/
 	        .wr_en   (idfif_wr_0a),
 	        .rd_en   (idfif_rd_0a),
 	        .wr_dat  (idfif_wdat_0a),
-	        .rd_dat  (idfif_rdat_1a));
-
-	Fifo  #(.DEPTH   (FSAB_INITIAL_CREDITS),
-	        .WIDTH   (`ORFIF_WIDTH))
-	orfif
-	       (.clk     (clk0_tb),
-	        .rst_b   (~rst0_tb),
-	        .wr_en   (orfif_wr_0a),
-	        .rd_en   (orfif_rd_0a),
-	        .wr_dat  (orfif_wdat_0a),
-	        .rd_dat  (orfif_rdat_1a),
-	        .empty   (orfif_empty_0a));
-
-	Fifo  #(.DEPTH   (FSAB_INITIAL_CREDITS * FSAB_LEN_MAX / 2),
-	        .WIDTH   (`ODFIF_WIDTH))
-	odfif
-	       (.clk     (clk0_tb),
-	        .rst_b   (~rst0_tb),
-	        .wr_en   (odfif_wr_0a),
-	        .rd_en   (odfif_rd_0a),
-	        .wr_dat  (odfif_wdat_0a),
-	        .rd_dat  (odfif_rdat_1a),
-	        .empty   (odfif_empty_0a));
-
+	        .rd_dat  (idfif_rdat_1a),
+	        .empty   (idfif_empty_0a));
 	mig #(/*AUTOINSTPARAM*/
 	      // Parameters
 	      .BANK_WIDTH		(BANK_WIDTH),
@@ -505,12 +714,12 @@ module FSABMemory(/*AUTOARG*/
 	chipscope_ila ila0 (
 		.CONTROL(control0), // INOUT BUS [35:0]
 		.CLK(clk0_tb), // IN
-		.TRIG0({ixfif_active_0a, ixfif_cur_mig_wr_cyc_0a[1:0], ixfif_burst_fill_0a,
-		        fsabo_want_prev, fsabo_cur_req_done_0a, app_af_wren, app_wdf_wren,
-		        app_af_afull, app_wdf_afull, mem_cur_req_active_0a, ifif_reqs_queued_0a[2:0],
-		        irfif_ddr_len_1a[3:0], ifif_have_req, reading_req_0a,
-		        reading_req_1a, irfif_wr_0a, irfif_rd_0a, idfif_wr_0a,
-		        idfif_rd_0a, rst0_tb, fsabo_mode[0], fsabo_did[3:0],
+		.TRIG0({ld_state[1:0], ld_slot_a_r[1:0], ld_slot_b_r[1:0], ld_cross_r,
+		        ld_rem[3:0], ld_wr_1a, ld_wr_last_1a, ld_done,
+		        slot_v[3:0], slot_busy[3:0], slot_loaded[3:0],
+		        fsabo_cur_req_done_0a, irfif_wr_0a, irfif_rd_0a, irfif_empty_0a,
+		        idfif_wr_0a, idfif_rd_0a, idfif_empty_0a,
+		        rst0_tb, fsabo_mode[0], fsabo_did[3:0],
 		        fsabo_subdid[3:0], fsabo_addr[30:0], fsabo_len[3:0], fsabo_data[63:0],
 		        fsabo_mask[7:0], fsabo_credit, fsabo_valid}) // IN BUS [255:0]
 	);
@@ -519,11 +728,11 @@ module FSABMemory(/*AUTOARG*/
 		.CONTROL(control1), // INOUT BUS [35:0]
 		.CLK(clk0_tb), // IN
 		.TRIG0({app_af_wren, app_wdf_wren, app_af_cmd[2:0],
-		        orfif_wr_0a, irfif_did_1a[3:0], irfif_subdid_1a[3:0], ofif_debit,
-		        rd_data_valid, odfif_wr_0a,
-		        orfif_rd_0a, odfif_rd_0a, orfif_rd_1a, odfif_rd_1a, orfif_empty_0a,
-		        orfif_did_1a[3:0], orfif_subdid_1a[3:0], orfif_len_1a[3:0],
-		        ofif_resp_len_rem_0a[3:0], ofif_resp_active_0a, ofif_credit,
+		        sch_issue, sch_slot[1:0], sch_elig[3:0], sch_oldest[3:0],
+		        sch_starving, sch_passed[3:0], sch_last_mode[0], bank_open[3:0],
+		        wr_busy, wr_slot[1:0], wr_word[1:0], ofif_credits[3:0],
+		        rd_data_valid, rb_wpos[3:0], rb_wword[1:0],
+		        oq_wpos[3:0], oq_rpos[3:0], ob_started, ob_beat[2:0], ob_ready, ob_done,
 		        fsabi_valid, fsabi_did[3:0], fsabi_subdid[3:0], fsabi_data[63:0]})
 	);
 
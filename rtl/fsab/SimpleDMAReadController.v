@@ -1,12 +1,27 @@
 
 /* Read 64 bytes at a time through the FSAB bus */
 
+/* A new start address only takes effect when the next transfer starts
+ * (for the framebuffer, at the start of the next frame); until then, the
+ * status register says that it's pending.
+ */
+
+/* In ring mode (DMA_RING), the buffer from NEXT_START to NEXT_START+LEN
+ * gets read over and over, but we never fetch past RING_LIMIT, which is
+ * the number of bytes that software has put in the ring since the
+ * transfer started.  FIFO_BYTES_READ counts up the same way, so software
+ * can refill anything up to FIFO_BYTES_READ+LEN; the RING_LOW status bit
+ * says that we are within RING_WATERMARK bytes of running dry.  A ring
+ * transfer only ends when the command register gets set to something
+ * else.
+ */
+
 module SimpleDMAReadController(/*AUTOARG*/
    // Outputs
    dmac__fsabo_valid, dmac__fsabo_mode, dmac__fsabo_did,
    dmac__fsabo_subdid, dmac__fsabo_addr, dmac__fsabo_len,
    dmac__fsabo_data, dmac__fsabo_mask, data, data_ready, fifo_empty,
-   dmac__spami_busy_b, dmac__spami_data,
+   fifo_level, dmac__spami_busy_b, dmac__spami_data,
    // Inputs
    cclk, cclk_rst_b, dmac__fsabo_credit, fsabi_clk, fsabi_rst_b,
    fsabi_valid, fsabi_did, fsabi_subdid, fsabi_data, spamo_valid,
@@ -54,6 +69,7 @@ module SimpleDMAReadController(/*AUTOARG*/
         output reg [63:0]           data;
 	output reg                  data_ready;
 	output                      fifo_empty;
+	output     [FIFO_HI+1:0]    fifo_level;	/* words that the user can have right now */
 
 
 	output                      dmac__spami_busy_b;
@@ -72,6 +88,10 @@ module SimpleDMAReadController(/*AUTOARG*/
 
 	parameter DEFAULT_ADDR = 31'h00000000;
 	parameter DEFAULT_LEN = 31'h00000000;
+	
+	/* Must match the arbiter's setting for our slot. */
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
 
 
 `ifdef verilator	
@@ -92,7 +112,6 @@ module SimpleDMAReadController(/*AUTOARG*/
 
 	wire start_read;	
 	wire fifo_almost_full;
-	reg read_pending = 0;
 	reg triggered = 0;
 
         /* Config */ 
@@ -103,6 +122,20 @@ module SimpleDMAReadController(/*AUTOARG*/
 	reg [FSAB_ADDR_HI:0] curr_start_addr_tclk;
 	wire [FSAB_ADDR_HI:0] curr_start_addr_cclk;
 
+	/* Next Start Addr written, but not yet started on */
+	wire next_start_written;
+	reg start_pending_tclk = 0;
+
+	/* Status register, as a whole */
+	wire [2:0] status_tclk;
+	wire [2:0] status_cclk;
+
+	/* Ring mode */
+	reg ring = 0;
+	reg [FSAB_ADDR_HI:0] ring_issued = 0;
+	wire [FSAB_ADDR_HI:0] ring_limit;
+	wire [FSAB_ADDR_HI:0] ring_watermark;
+
 	/* Total Bytes Delivered */
 	reg [FSAB_ADDR_HI:0] total_bytes_delivered_tclk = 0;
 	wire [FSAB_ADDR_HI:0] total_bytes_delivered_cclk;
@@ -122,11 +155,11 @@ module SimpleDMAReadController(/*AUTOARG*/
 	
 	wire start_trans;
 	
-	reg [FSAB_CREDITS_HI:0] fsab_credits = FSAB_INITIAL_CREDITS;
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
 	wire fsab_credit_avail = (fsab_credits != 0);
 	always @(posedge target_clk or negedge target_rst_b) begin
 		if (!target_rst_b) begin
-			fsab_credits <= FSAB_INITIAL_CREDITS;
+			fsab_credits <= CREDITS;
 		end else begin
 			if (dmac__fsabo_credit | dmac__fsabo_valid) begin
 			`ifdef verilator
@@ -137,12 +170,36 @@ module SimpleDMAReadController(/*AUTOARG*/
 		end
 	end
 
-
-	/* TODO: This is only reading 8 bytes from FSAB at a time.
-	   Needs to do a batch read. (Possibly reading 64 bytes at a time like a cache?) */
-	assign fifo_almost_full = ((FIFO_DEPTH-8) < curr_fifo_length);
+	/*** Reads in flight ***/
+	/* We issue a read whenever we have a credit and room in the queue
+	 * for everything that's already on its way, so up to CREDITS reads
+	 * can be outstanding at once.  Completions come back on fsabi_clk;
+	 * the completion count crosses over as a grey code, just like the
+	 * credit return in FSABArbiterFIFO, and each time it moves, we
+	 * retire one read (and make its 8 words visible to the user side).
+	 */
+	reg [CREDITS_HI+1:0] reads_issued = 0;
+	reg [CREDITS_HI+1:0] reads_retired = 0;
+	wire [CREDITS_HI+1:0] reads_in_flight = reads_issued - reads_retired;
+	
+	reg [CREDITS_HI+1:0] reads_completed_fclk = 0;
+	reg [CREDITS_HI+1:0] reads_completed_g_fclk = 0;
+	reg [CREDITS_HI+1:0] reads_completed_g_s1 = 0;
+	reg [CREDITS_HI+1:0] reads_completed_g = 0;
+	wire [CREDITS_HI+1:0] reads_retired_g = (reads_retired >> 1) ^ reads_retired;
+	wire read_retire = (reads_completed_g != reads_retired_g);
+	
+	wire ring_stopping = (command_register != DMA_RING);
+	wire ring_caught_up = (ring_issued[FSAB_ADDR_HI:6] == ring_limit[FSAB_ADDR_HI:6]);
+	wire issue_done = ring ? (ring_caught_up || ring_stopping) : (next_fsab_addr == end_addr);
+	wire transfer_done = issue_done && (reads_in_flight == 0) && (!ring || ring_stopping);
+
+	/* verilator lint_off WIDTH */
+	assign fifo_almost_full = ((FIFO_DEPTH-8) < (curr_fifo_length + {reads_in_flight, 3'b000}));
+	/* verilator lint_on WIDTH */
 	assign fifo_empty = (curr_fifo_length == 0);
-	assign start_read = !fifo_almost_full && !read_pending && fsab_credit_avail && triggered;
+	assign fifo_level = curr_fifo_length;
+	assign start_read = !fifo_almost_full && !issue_done && fsab_credit_avail && triggered;
 
 	always @(*)
 	begin
@@ -165,15 +222,6 @@ module SimpleDMAReadController(/*AUTOARG*/
 		end	
 	end
 
-			
-
-	reg current_read = 0;
-	reg current_read_fclk_s1 = 0;
-	reg current_read_fclk = 0;
-	reg completed_read_fclk = 0;
-	reg completed_read_s1 = 0;
-	reg completed_read = 0;
-
 	always @(*) begin
 		command_register_next = command_register;
 		
@@ -191,10 +239,10 @@ module SimpleDMAReadController(/*AUTOARG*/
 
 	always @(posedge target_clk or negedge target_rst_b) begin
 		if (!target_rst_b) begin
-			read_pending <= 0;
-			current_read <= 0;
-			completed_read <= 0;
-			completed_read_s1 <= 0;
+			reads_issued <= 0;
+			reads_retired <= 0;
+			reads_completed_g_s1 <= 0;
+			reads_completed_g <= 0;
 			curr_fifo_length <= 0;
 			curr_start_addr_tclk <= DEFAULT_ADDR;
 			next_fsab_addr <= DEFAULT_ADDR;
@@ -202,13 +250,21 @@ module SimpleDMAReadController(/*AUTOARG*/
 			command_register <= DMA_STOP;
 			end_addr <= DEFAULT_ADDR+DEFAULT_LEN;
 			fifo_bytes_read_tclk <= 0;
+			start_pending_tclk <= 0;
+			ring <= 0;
+			ring_issued <= 0;
 		end else begin
-			completed_read_s1 <= completed_read_fclk;
-			completed_read <= completed_read_s1;
+			reads_completed_g_s1 <= reads_completed_g_fclk;
+			reads_completed_g <= reads_completed_g_s1;
 
 			command_register <= command_register_next;
 
 			curr_fifo_length <= next_fifo_length;
+			
+			if (start_read)
+				reads_issued <= reads_issued + 1;
+			if (read_retire)
+				reads_retired <= reads_retired + 1;
 
 			if (!triggered) begin
 				case (command_register)
@@ -217,12 +273,23 @@ module SimpleDMAReadController(/*AUTOARG*/
 						next_fsab_addr <= next_start_addr;
 						curr_start_addr_tclk <= next_start_addr;
 						end_addr <= next_start_addr+next_len;
+						start_pending_tclk <= 0;
 					end
 					DMA_AUTOTRIGGER: begin
 						triggered <= 1;
 						next_fsab_addr <= next_start_addr;
 						curr_start_addr_tclk <= next_start_addr;
 						end_addr <= next_start_addr+next_len;
+						start_pending_tclk <= 0;
+					end
+					DMA_RING: begin
+						triggered <= 1;
+						ring <= 1;
+						ring_issued <= 0;
+						next_fsab_addr <= next_start_addr;
+						curr_start_addr_tclk <= next_start_addr;
+						end_addr <= next_start_addr+next_len;
+						start_pending_tclk <= 0;
 					end
 					DMA_STOP: begin
 					end
@@ -234,20 +301,27 @@ module SimpleDMAReadController(/*AUTOARG*/
 				endcase 
 			end else begin
 				if (start_read) begin
-					read_pending <= 1;
-					current_read <= ~current_read;
-				end else if ((completed_read == current_read) && read_pending) begin
-					read_pending <= 0;
-					if (end_addr == next_fsab_addr + 64) begin
-						triggered <= 0;
-						fifo_bytes_read_tclk <= 0;
-					end
-					else begin
-						fifo_bytes_read_tclk <= fifo_bytes_read_tclk + 64;
+					if (ring && (next_fsab_addr + 64 == end_addr))
+						next_fsab_addr <= curr_start_addr_tclk;
+					else
 						next_fsab_addr <= next_fsab_addr + 64;
-					end
+					ring_issued <= ring_issued + 64;
 				end
-			end	
+				
+				/* Everything has been issued and has come back;
+				 * that's the end of this transfer.
+				 */
+				if (transfer_done) begin
+					triggered <= 0;
+					ring <= 0;
+					fifo_bytes_read_tclk <= 0;
+				end else if (read_retire)
+					fifo_bytes_read_tclk <= fifo_bytes_read_tclk + 64;
+			end
+
+			/* A write that lands just as we start wasn't in time. */
+			if (next_start_written)
+				start_pending_tclk <= 1;
 		end
 	end
 
@@ -267,26 +341,24 @@ module SimpleDMAReadController(/*AUTOARG*/
 		end
 	end
 
+	/* Reads come back in the order that we issued them, so all we need
+	 * to keep track of on this side is where in a packet we are.
+	 */
 	reg [2:0] fifo_fill_pos_fclk = 0;
-	reg current_read_1a_fclk = 0;
+	wire read_complete_fclk = fsabi_valid && (fsabi_did == FSAB_DID) && (fsabi_subdid == FSAB_SUBDID) &&
+	                          (fifo_fill_pos_fclk == 7);
+	wire [CREDITS_HI+1:0] reads_completed_fclk_next = reads_completed_fclk + (read_complete_fclk ? 1 : 0);
 				
 	always @(posedge fsabi_clk or negedge fsabi_rst_b) begin
 		if (!fsabi_rst_b) begin
-			current_read_fclk_s1 <= 0;
-			current_read_fclk <= 0;
-			completed_read_fclk <= 0;
+			reads_completed_fclk <= 0;
+			reads_completed_g_fclk <= 0;
 			fifo_fill_pos_fclk <= 0;
-			current_read_1a_fclk <= 0;
 			fifo_wpos <= 0;
 		end else begin
-			current_read_fclk_s1 <= current_read;
-			current_read_fclk <= current_read_fclk_s1;
-			current_read_1a_fclk <= current_read_fclk;
-			if (current_read_fclk ^ current_read_1a_fclk) begin
-				fifo_fill_pos_fclk <= 0;
-			end else if (fsabi_valid && (fsabi_did == FSAB_DID) && (fsabi_subdid == FSAB_SUBDID)) begin
-				if (fifo_fill_pos_fclk == 7) /* Done? */
-					completed_read_fclk <= current_read_fclk;
+			reads_completed_fclk <= reads_completed_fclk_next;
+			reads_completed_g_fclk <= (reads_completed_fclk_next >> 1) ^ reads_completed_fclk_next;
+			if (fsabi_valid && (fsabi_did == FSAB_DID) && (fsabi_subdid == FSAB_SUBDID)) begin
 				fifo[fifo_wpos] <= fsabi_data;
 				fifo_wpos <= fifo_wpos + 1;
 				fifo_fill_pos_fclk <= fifo_fill_pos_fclk + 1;	
@@ -299,7 +371,7 @@ module SimpleDMAReadController(/*AUTOARG*/
 		if (request && !fifo_empty) begin
 			next_fifo_length = next_fifo_length - 1;
 		end
-		if (triggered & ((completed_read == current_read) && read_pending)) begin
+		if (read_retire) begin
 			next_fifo_length = next_fifo_length + 8;
 		end 
 	end
@@ -330,7 +402,7 @@ module SimpleDMAReadController(/*AUTOARG*/
 		                    // Outputs
 		                    .wr_wait_cclk       (),
 		                    .wr_done_strobe_cclk(wr_done_strobe_NEXT_START_REG),
-		                    .wr_strobe_tclk     (),
+		                    .wr_strobe_tclk     (next_start_written),
 		                    .wr_data_tclk       (next_start_addr[FSAB_ADDR_HI:0]),
 		                    // Inputs
 		                    .cclk               (cclk),
@@ -357,6 +429,40 @@ module SimpleDMAReadController(/*AUTOARG*/
 		                  .wr_strobe_cclk     (wr_decode && (spamo_addr[DMA_SPAM_ADDR_HI:0] == NEXT_LEN_REG_ADDR)),
 		                  .wr_data_cclk       (spamo_data[FSAB_ADDR_HI:0]));
 	
+	wire wr_done_strobe_RING_LIMIT_REG;
+	CSRAsyncWrite #(.WIDTH       (FSAB_ADDR_HI+1),
+	               .RESET_VALUE (0))
+		CSR_RING_LIMIT_REG (/* NOT AUTOINST */
+		                    // Outputs
+		                    .wr_wait_cclk       (),
+		                    .wr_done_strobe_cclk(wr_done_strobe_RING_LIMIT_REG),
+		                    .wr_strobe_tclk     (),
+		                    .wr_data_tclk       (ring_limit[FSAB_ADDR_HI:0]),
+		                    // Inputs
+		                    .cclk               (cclk),
+		                    .tclk               (target_clk),
+		                    .rst_b_cclk         (cclk_rst_b),
+		                    .rst_b_tclk         (target_rst_b),
+		                    .wr_strobe_cclk     (wr_decode && (spamo_addr[DMA_SPAM_ADDR_HI:0] == RING_LIMIT_REG_ADDR)),
+		                    .wr_data_cclk       (spamo_data[FSAB_ADDR_HI:0]));
+
+	wire wr_done_strobe_RING_WATERMARK_REG;
+	CSRAsyncWrite #(.WIDTH       (FSAB_ADDR_HI+1),
+	               .RESET_VALUE (0))
+		CSR_RING_WATERMARK_REG (/* NOT AUTOINST */
+		                        // Outputs
+		                        .wr_wait_cclk       (),
+		                        .wr_done_strobe_cclk(wr_done_strobe_RING_WATERMARK_REG),
+		                        .wr_strobe_tclk     (),
+		                        .wr_data_tclk       (ring_watermark[FSAB_ADDR_HI:0]),
+		                        // Inputs
+		                        .cclk               (cclk),
+		                        .tclk               (target_clk),
+		                        .rst_b_cclk         (cclk_rst_b),
+		                        .rst_b_tclk         (target_rst_b),
+		                        .wr_strobe_cclk     (wr_decode && (spamo_addr[DMA_SPAM_ADDR_HI:0] == RING_WATERMARK_REG_ADDR)),
+		                        .wr_data_cclk       (spamo_data[FSAB_ADDR_HI:0]));
+	
 	wire wr_done_strobe_COMMAND_REG;
 	CSRAsyncWrite #(.WIDTH       (COMMAND_REGISTER_HI+1),
 	               .RESET_VALUE (DMA_STOP))
@@ -378,6 +484,7 @@ module SimpleDMAReadController(/*AUTOARG*/
 	wire rd_done_strobe_FIFO_BYTES_READ;
 	wire rd_done_strobe_TOTAL_BYTES_DELIVERED;
 	wire rd_done_strobe_CURR_START_ADDR;
+	wire rd_done_strobe_STATUS;
 	CSRAsyncRead #(.WIDTH        (FSAB_ADDR_HI+1))
 		CSR_FIFO_BYTES_READ (/* NOT AUTOINST */
 				     // Outputs
@@ -423,6 +530,25 @@ module SimpleDMAReadController(/*AUTOARG*/
 				     .rd_strobe_cclk	(rd_decode && (spamo_addr[DMA_SPAM_ADDR_HI:0] == CURR_START_REG_ADDR)),
 				     .rd_data_tclk	(curr_start_addr_tclk));
 
+	assign status_tclk[DMA_STATUS_START_PENDING] = start_pending_tclk;
+	assign status_tclk[DMA_STATUS_BUSY] = triggered || !fifo_empty;
+	assign status_tclk[DMA_STATUS_RING_LOW] = ring && ((ring_limit - fifo_bytes_read_tclk) < ring_watermark);
+	
+	CSRAsyncRead #(.WIDTH        (3))
+		CSR_STATUS (/* NOT AUTOINST */
+				     // Outputs
+				     .rd_data_cclk	(status_cclk),
+				     .rd_wait_cclk	(),
+				     .rd_done_strobe_cclk(rd_done_strobe_STATUS),
+				     .rd_strobe_tclk	(),
+				     // Inputs
+				     .cclk		(cclk),
+				     .tclk		(target_clk),
+				     .rst_b_cclk	(cclk_rst_b),
+				     .rst_b_tclk	(target_rst_b),
+				     .rd_strobe_cclk	(rd_decode && (spamo_addr[DMA_SPAM_ADDR_HI:0] == STATUS_REG_ADDR)),
+				     .rd_data_tclk	(status_tclk));
+
 
 	always @ (*) begin
 		if (rd_done_strobe_FIFO_BYTES_READ) begin
@@ -434,12 +560,15 @@ module SimpleDMAReadController(/*AUTOARG*/
 		else if (rd_done_strobe_CURR_START_ADDR) begin
 			dmac__spami_data = {{(SPAM_DATA_HI-FSAB_ADDR_HI){1'b0}}, curr_start_addr_cclk};
 		end
+		else if (rd_done_strobe_STATUS) begin
+			dmac__spami_data = {{(SPAM_DATA_HI-2){1'b0}}, status_cclk};
+		end
 		else begin
 			dmac__spami_data = 0;
 		end
 	end
 
-	assign dmac__spami_busy_b = wr_done_strobe_COMMAND_REG | wr_done_strobe_NEXT_LEN_REG | wr_done_strobe_NEXT_START_REG | rd_done_strobe_FIFO_BYTES_READ | rd_done_strobe_TOTAL_BYTES_DELIVERED | rd_done_strobe_CURR_START_ADDR;
+	assign dmac__spami_busy_b = wr_done_strobe_COMMAND_REG | wr_done_strobe_NEXT_LEN_REG | wr_done_strobe_NEXT_START_REG | wr_done_strobe_RING_LIMIT_REG | wr_done_strobe_RING_WATERMARK_REG | rd_done_strobe_FIFO_BYTES_READ | rd_done_strobe_TOTAL_BYTES_DELIVERED | rd_done_strobe_CURR_START_ADDR | rd_done_strobe_STATUS;
 
 
 	always @(posedge cclk) begin
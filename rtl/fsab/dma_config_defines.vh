@@ -1,13 +1,22 @@
-parameter DMA_SPAM_ADDR_HI = 4;
-parameter NEXT_START_REG_ADDR = 5'h000;
-parameter NEXT_LEN_REG_ADDR = 5'h004;
-parameter COMMAND_REG_ADDR = 5'h008;
-parameter FIFO_BYTES_READ_REG_ADDR = 5'h00c;
-parameter TOTAL_BYTES_DELIVERED_REG_ADDR = 5'h010;
-parameter CURR_START_REG_ADDR = 5'h014; 
+parameter DMA_SPAM_ADDR_HI = 5;
+parameter NEXT_START_REG_ADDR = 6'h000;
+parameter NEXT_LEN_REG_ADDR = 6'h004;
+parameter COMMAND_REG_ADDR = 6'h008;
+parameter FIFO_BYTES_READ_REG_ADDR = 6'h00c;
+parameter TOTAL_BYTES_DELIVERED_REG_ADDR = 6'h010;
+parameter CURR_START_REG_ADDR = 6'h014; 
+parameter STATUS_REG_ADDR = 6'h018;
+parameter RING_LIMIT_REG_ADDR = 6'h01c;
+/* Only reachable if the instance's SPAM_ADDRMASK lets 0x20 through. */
+parameter RING_WATERMARK_REG_ADDR = 6'h020;
+
+/* Status register bits. */
+parameter DMA_STATUS_START_PENDING = 0;	/* NEXT_START hasn't been picked up yet */
+parameter DMA_STATUS_BUSY = 1;		/* transferring, or the FIFO isn't empty yet */
+parameter DMA_STATUS_RING_LOW = 2;	/* ring: fewer than RING_WATERMARK bytes left to fetch */
 
 parameter COMMAND_REGISTER_HI = 1;
 parameter DMA_STOP = 2'b00;
 parameter DMA_TRIGGER_ONCE = 2'b01;
 parameter DMA_AUTOTRIGGER = 2'b10;
-
+parameter DMA_RING = 2'b11;
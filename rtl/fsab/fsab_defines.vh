@@ -9,16 +9,27 @@ parameter FSAB_DID_CPU = 4'h0;
 parameter FSAB_SUBDID_CPU_ICACHE = 4'h0;
 parameter FSAB_SUBDID_CPU_DCACHE = 4'h1;
 parameter FSAB_SUBDID_CPU_DMAC = 4'h2;
+parameter FSAB_SUBDID_CPU_L2 = 4'h3;
 
 parameter FSAB_DID_FRAME = 4'h1;
 parameter FSAB_SUBDID_FRAME_0 = 4'h0;
+parameter FSAB_SUBDID_FRAME_SPRITES = 4'h1;
 
 parameter FSAB_DID_AUDIO = 4'h2;
 parameter FSAB_SUBDID_AUDIO = 4'h0;
+parameter FSAB_SUBDID_AUDIO_VOICES = 4'h1;
+parameter FSAB_SUBDID_AUDIO_CAPTURE = 4'h2;
 
 parameter FSAB_DID_ACCEL = 4'h3;
 parameter FSAB_SUBDID_ACCEL_CLEAR = 4'h0;
 parameter FSAB_SUBDID_ACCEL_BLIT = 4'h1;
+parameter FSAB_SUBDID_ACCEL_CMDQ = 4'h2;
+
+parameter FSAB_DID_DMA = 4'h4;
+parameter FSAB_SUBDID_DMA = 4'h0;
+
+parameter FSAB_DID_SACE = 4'h5;
+parameter FSAB_SUBDID_SACE = 4'h0;
 
 parameter FSAB_ADDR_HI = 30;
 parameter FSAB_ADDR_LO = 3;
@@ -30,3 +41,6 @@ parameter FSAB_LEN_MAX = 8;
 
 parameter FSAB_INITIAL_CREDITS = 4;
 parameter FSAB_CREDITS_HI = 2;
+
+/* Between the arbiter and the memory controller. */
+parameter FSAB_MEM_CREDITS = 8;
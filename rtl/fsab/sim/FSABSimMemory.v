@@ -18,21 +18,27 @@ module FSABSimMemory(
 	output wire [FSAB_DATA_HI:0] fsabi_data
 	);
 
-	parameter SIMMEM_SIZE = 8 * 1024 * 1024;
+	/* Must be a power of two. */
+	parameter SIMMEM_SIZE = 128 * 1024 * 1024;
 
 `include "fsab_defines.vh"
+`include "memory_defines.vh"
+
+	/* The arbiter's MEM_CREDITS must match this. */
+	parameter CREDITS = FSAB_MEM_CREDITS;
+	parameter CREDITS_HI = $clog2(CREDITS);
 
 	/*** Inbound request FIFO (RFIF) ***/
 `define SIMMEM_RFIF_HI (FSAB_REQ_HI+1 + FSAB_DID_HI+1 + FSAB_DID_HI+1 + FSAB_ADDR_HI+1 + FSAB_LEN_HI)
-	reg [FSAB_CREDITS_HI:0] rfif_wpos_0a = 'h0;
-	reg [FSAB_CREDITS_HI:0] rfif_rpos_0a = 'h0;
-	reg [`SIMMEM_RFIF_HI:0] rfif_fifo [(FSAB_INITIAL_CREDITS-1):0];
+	reg [CREDITS_HI:0] rfif_wpos_0a = 'h0;
+	reg [CREDITS_HI:0] rfif_rpos_0a = 'h0;
+	reg [`SIMMEM_RFIF_HI:0] rfif_fifo [(CREDITS-1):0];
 	wire rfif_wr_0a;
 	wire rfif_rd_0a;
 	wire [`SIMMEM_RFIF_HI:0] rfif_wdat_0a;
 	reg [`SIMMEM_RFIF_HI:0] rfif_rdat_1a;
 	wire rfif_empty_0a = (rfif_rpos_0a == rfif_wpos_0a);
-	wire rfif_full_0a = (rfif_wpos_0a == (rfif_rpos_0a + FSAB_INITIAL_CREDITS));
+	wire rfif_full_0a = (rfif_wpos_0a == (rfif_rpos_0a + CREDITS));
 	
 	always @(posedge clk or negedge rst_b)
 		if (!rst_b) begin
@@ -42,13 +48,13 @@ module FSABSimMemory(
 			if (rfif_rd_0a) begin
 				$display("SIMMEM: %5d: reading from rfif", $time);
 				/* NOTE: this FIFO style will NOT port to Xilinx! */
-				rfif_rdat_1a <= rfif_fifo[rfif_rpos_0a[1:0]];
+				rfif_rdat_1a <= rfif_fifo[rfif_rpos_0a[CREDITS_HI-1:0]];
 				rfif_rpos_0a <= rfif_rpos_0a + 'h1;
 			end
 			
 			if (rfif_wr_0a) begin
 				$display("SIMMEM: %5d: writing to rfif (%d word %s)", $time, fsabo_len, (fsabo_mode == FSAB_WRITE) ? "write" : "read");
-				rfif_fifo[rfif_wpos_0a[1:0]] <= rfif_wdat_0a;
+				rfif_fifo[rfif_wpos_0a[CREDITS_HI-1:0]] <= rfif_wdat_0a;
 				rfif_wpos_0a <= rfif_wpos_0a + 'h1;
 			end
 		end
@@ -88,7 +94,7 @@ module FSABSimMemory(
 		end
 	
 	/*** Inbound data FIFO (DFIF) ***/
-`define SIMMEM_DFIF_MAX ((FSAB_INITIAL_CREDITS * FSAB_LEN_MAX) - 1)
+`define SIMMEM_DFIF_MAX ((CREDITS * FSAB_LEN_MAX) - 1)
 `define SIMMEM_DFIF_HI ($clog2(`SIMMEM_DFIF_MAX) - 1)
 	reg [`SIMMEM_DFIF_HI:0] dfif_wpos_0a = 'h0;
 	reg [`SIMMEM_DFIF_HI:0] dfif_rpos_0a = 'h0;
@@ -153,18 +159,132 @@ module FSABSimMemory(
 			dfif_rd_1a <= dfif_rd_0a;
 		end
 	
+	/*** DRAM timing model ***/
+	
+	/* Rather than answering everything right away, we hold each request
+	 * at the head of the RFIF for about as long as the MIG would take to
+	 * get to it.  We keep track of which row is open in each bank (the
+	 * MIG keeps them open if MULTI_BANK_EN), and charge tRP and tRCD for
+	 * a miss, and CAS latency always.  Every tREFI, all of the banks get
+	 * closed for a refresh, and nobody gets in for tRP + tRFC.
+	 *
+	 * The MIG moves APPDATA_WIDTH bits per clock, and always does a
+	 * whole burst; so a short request still holds the data bus for
+	 * BURST_LEN / 2 cycles, and a request that crosses a burst takes
+	 * two.
+	 *
+	 * The latency of the next request overlaps with the data transfer
+	 * of the current one, like it does on the real thing.  Everything
+	 * is in clk cycles, which are assumed to be CLK_PERIOD long.  Set
+	 * PERFECT to "TRUE" to go back to answering everything right away.
+	 */
+	parameter PERFECT = "FALSE";
+	parameter TRCD_CK = (TRCD + CLK_PERIOD - 1) / CLK_PERIOD;
+	parameter TRP_CK = (TRP + CLK_PERIOD - 1) / CLK_PERIOD;
+	parameter TRFC_CK = (TRFC + CLK_PERIOD - 1) / CLK_PERIOD;
+	parameter TWTR_CK = (TWTR + CLK_PERIOD - 1) / CLK_PERIOD;
+	parameter TREFI_CK = (TREFI_NS * 1000) / CLK_PERIOD;
+	parameter CL_CK = CAS_LAT + ADDITIVE_LAT;
+	parameter BURST_CK = BURST_LEN / 2;
+	
+	/* The MIG's address is {row, bank, column}, in units of DQ_WIDTH. */
+`define SIMMEM_BANK(a) a[COL_WIDTH+BANK_WIDTH+2:COL_WIDTH+3]
+`define SIMMEM_ROW(a)  a[COL_WIDTH+BANK_WIDTH+ROW_WIDTH+2:COL_WIDTH+BANK_WIDTH+3]
+
+	wire [FSAB_REQ_HI:0]  tm_mode;
+	wire [FSAB_DID_HI:0]  tm_did;
+	wire [FSAB_DID_HI:0]  tm_subdid;
+	wire [FSAB_ADDR_HI:0] tm_addr;
+	wire [FSAB_LEN_HI:0]  tm_len;
+	assign {tm_mode, tm_did, tm_subdid, tm_addr, tm_len} = rfif_fifo[rfif_rpos_0a[CREDITS_HI-1:0]];
+	
+	wire [3:0] tm_end = tm_addr[5:3] + ((tm_len == 0) ? 0 : (tm_len - 1));
+	wire [1:0] tm_bursts = tm_end[3] ? 2 : 1;
+	wire [BANK_WIDTH-1:0] tm_bank = `SIMMEM_BANK(tm_addr);
+	wire [ROW_WIDTH-1:0]  tm_row = `SIMMEM_ROW(tm_addr);
+	
+	reg [ROW_WIDTH-1:0]         tm_bank_row [(1 << BANK_WIDTH)-1:0];
+	reg [(1 << BANK_WIDTH)-1:0] tm_bank_open = 0;
+	reg                         tm_last_write = 0;
+	reg [15:0]                  tm_refi = 0;
+	reg                         tm_ref_pending = 0;
+	reg [7:0]                   tm_ref_wait = 0;
+	reg                         tm_charged = 0;	/* the head of the RFIF has been charged for */
+	reg [7:0]                   tm_wait = 0;	/* ... and this is how long it has left */
+	reg [7:0]                   tm_bus = 0;	/* how long the data bus is busy */
+	
+	integer tm_i;
+	initial
+		for (tm_i = 0; tm_i < (1 << BANK_WIDTH); tm_i = tm_i + 1)
+			tm_bank_row[tm_i] = 0;
+	
+	wire tm_row_hit = tm_bank_open[tm_bank] && (tm_bank_row[tm_bank] == tm_row);
+	wire tm_row_conflict = tm_bank_open[tm_bank] && (tm_bank_row[tm_bank] != tm_row);
+	/* verilator lint_off WIDTH */
+	wire [7:0] tm_latency = (tm_row_hit ? 0 : (tm_row_conflict ? TRP_CK + TRCD_CK : TRCD_CK)) +
+	                        ((tm_mode == FSAB_WRITE) ? CL_CK - 1 : CL_CK) +
+	                        ((tm_last_write && (tm_mode == FSAB_READ)) ? TWTR_CK : 0);
+	/* verilator lint_on WIDTH */
+	
+	wire tm_charge = !rfif_empty_0a && !tm_charged && (tm_ref_wait == 0) && !tm_ref_pending;
+	wire tm_go = (PERFECT == "TRUE") || (tm_charged && (tm_wait == 0) && (tm_bus == 0));
+	
+	always @(posedge clk or negedge rst_b)
+		if (!rst_b) begin
+			tm_bank_open <= 0;
+			tm_last_write <= 0;
+			tm_refi <= 0;
+			tm_ref_pending <= 0;
+			tm_ref_wait <= 0;
+			tm_charged <= 0;
+			tm_wait <= 0;
+			tm_bus <= 0;
+		end else if (PERFECT != "TRUE") begin
+			if (tm_refi == TREFI_CK - 1) begin
+				tm_refi <= 0;
+				tm_ref_pending <= 1;
+			end else
+				tm_refi <= tm_refi + 1;
+			
+			/* Refreshes go in between requests. */
+			if (tm_ref_pending && !tm_charged && (tm_ref_wait == 0)) begin
+				$display("SIMMEM: %5d: refresh", $time);
+				tm_ref_pending <= 0;
+				tm_ref_wait <= TRP_CK + TRFC_CK;
+				tm_bank_open <= 0;
+			end else if (tm_ref_wait != 0)
+				tm_ref_wait <= tm_ref_wait - 1;
+			
+			if (tm_charge) begin
+				$display("SIMMEM: %5d: %s at %08x: bank %d row %x, %s, %d cycles", $time, (tm_mode == FSAB_WRITE) ? "WRITE" : "READ", tm_addr, tm_bank, tm_row, tm_row_hit ? "hit" : tm_row_conflict ? "conflict" : "miss", tm_latency);
+				tm_charged <= 1;
+				tm_wait <= tm_latency;
+				tm_bank_open[tm_bank] <= 1;
+				tm_bank_row[tm_bank] <= tm_row;
+				tm_last_write <= (tm_mode == FSAB_WRITE);
+			end else if (tm_wait != 0)
+				tm_wait <= tm_wait - 1;
+			
+			if (rfif_rd_0a) begin
+				tm_charged <= 0;
+				/* verilator lint_off WIDTH */
+				tm_bus <= tm_bursts * BURST_CK;
+				/* verilator lint_on WIDTH */
+			end else if (tm_bus != 0)
+				tm_bus <= tm_bus - 1;
+		end
+	
 	/*** Memory control logic ***/
-	reg [63:0] simmem [(SIMMEM_SIZE / 8):0];
-	reg [31:0] simmem32 [(SIMMEM_SIZE / 4):0];
-	integer f;
+	
+	/* The memory itself lives in the testbench (simmem.cpp), which only
+	 * allocates the pages that actually get touched.
+	 */
 	initial
 	begin
 		assert(FSAB_DATA_HI == 63) else $error("FSAB_DATA_HI unsupported");
-		for (f = 0; f < SIMMEM_SIZE / 8; f++)
-			simmem[f] = 64'h0000000000000000;
+		$c("{extern void simmem_init(unsigned int size); simmem_init(", SIMMEM_SIZE, ");}");
 	end
 	
-	
 	/* Active determines whether we have a request waiting (i.e., we did
 	 * an RFIF read).  It is high as long as we are serving it (which
 	 * might be more than the number of cycles in 'len', since we might
@@ -175,6 +295,8 @@ module FSABSimMemory(
 	reg                   mem_cur_req_active_1a = 0;
 	wire [FSAB_ADDR_HI:0] mem_cur_req_addr_1a;
 	reg  [FSAB_ADDR_HI:0] mem_cur_req_addr_1a_r = 0;
+	wire [FSAB_ADDR_HI:0] mem_next_addr_1a;
+	reg  [FSAB_DATA_HI:0] mem_rd_data_1a = 0;
 	
 	/* If we just finished reading from the dfif for the last time
 	 * (i.e., we just went inactive), then we can release a credit. 
@@ -188,7 +310,7 @@ module FSABSimMemory(
 	 * then continues doing the read until we run out of data.  Can the
 	 * one-cycle pause be removed easily?
 	 */
-	assign rfif_rd_0a = !rfif_empty_0a && !mem_cur_req_active_0a && !rfif_rd_1a;
+	assign rfif_rd_0a = !rfif_empty_0a && !mem_cur_req_active_0a && !rfif_rd_1a && tm_go;
 	assign dfif_rd_0a = rfif_rd_0a || /* We must always do a read from dfif on rfif. */
 	                    (mem_cur_req_active_0a &&
 	                     (rfif_mode_1a == FSAB_WRITE) &&
@@ -205,15 +327,14 @@ module FSABSimMemory(
 	                     (mem_cur_req_len_rem_0a != 'h0);
 	assign fsabi_did = rfif_did_1a;
 	assign fsabi_subdid = rfif_subdid_1a;
-	/* verilator lint_off WIDTH */
-	assign fsabi_data = simmem[mem_cur_req_addr_1a[FSAB_ADDR_HI:3]];
-	/* verilator lint_on WIDTH */
+	/* We only ever send read data from mem_cur_req_addr_1a_r, so we go
+	 * fetch it as that gets updated.
+	 */
+	assign fsabi_data = mem_rd_data_1a;
 	
-	/* This reg is not actually a flop; it is storage for behavioral
-	 * data masking.  */
-	integer i;
-	integer j;
-	reg [FSAB_DATA_HI:0] masked_data;
+	assign mem_next_addr_1a = rfif_rd_1a ? rfif_addr_1a :
+	                          (dfif_rd_0a || fsabi_valid) ? (mem_cur_req_addr_1a + (FSAB_DATA_HI + 1) / 8) :
+	                          mem_cur_req_addr_1a_r;
 	
 	always @(posedge clk or negedge rst_b)
 		if (!rst_b) begin
@@ -235,23 +356,16 @@ module FSABSimMemory(
 			end
 			
 			if (dfif_rd_1a && (rfif_mode_1a == FSAB_WRITE)) begin
-				/* verilator lint_off WIDTH */ /* for memory neq FSAB_ADDR size */
-				/* This is the wonderful thing about being a behavioral simulation. */
-				for (i = 0; i <= FSAB_MASK_HI; i = i + 1)
-					for (j = 0; j < 8; j = j + 1)
-						masked_data[i*8 + j] =
-							dfif_mask_1a[i] ?
-								dfif_data_1a[i*8 + j] :
-								simmem[mem_cur_req_addr_1a[FSAB_ADDR_HI:FSAB_ADDR_LO]][i*8 + j];
-				$display("SIMMEM: %5d: writing %016x data (%08b mask) to %08x address (old value %016x)", $time, dfif_data_1a, dfif_mask_1a, {mem_cur_req_addr_1a[FSAB_ADDR_HI:FSAB_ADDR_LO], 3'b0}, simmem[mem_cur_req_addr_1a[FSAB_ADDR_HI:FSAB_ADDR_LO]]);
-				simmem[mem_cur_req_addr_1a[FSAB_ADDR_HI:FSAB_ADDR_LO]] <= masked_data;
-				/* verilator lint_on WIDTH */ /* for memory neq FSAB_ADDR size */
+				$display("SIMMEM: %5d: writing %016x data (%08b mask) to %08x address", $time, dfif_data_1a, dfif_mask_1a, {mem_cur_req_addr_1a[FSAB_ADDR_HI:FSAB_ADDR_LO], 3'b0});
+				$c("{extern void simmem_write(unsigned int, unsigned long long, unsigned int); simmem_write(", mem_cur_req_addr_1a, ",", dfif_data_1a, ",", dfif_mask_1a, ");}");
 			end
 			
-			if (rfif_rd_1a)
-				mem_cur_req_addr_1a_r <= rfif_addr_1a;
-			else if (dfif_rd_0a || fsabi_valid)
-				mem_cur_req_addr_1a_r <= mem_cur_req_addr_1a + (FSAB_DATA_HI + 1) / 8;
+			mem_cur_req_addr_1a_r <= mem_next_addr_1a;
+			
+			$c("{extern void simmem_tick(int, int); simmem_tick(", fsabi_valid, ",", dfif_rd_1a && (rfif_mode_1a == FSAB_WRITE), ");}");
+			
+			/* This has to come after the write, so that we see it. */
+			mem_rd_data_1a <= $c("({extern unsigned long long simmem_read(unsigned int); simmem_read(", mem_next_addr_1a, ");})");
 		end
 	
 endmodule
@@ -56,6 +56,7 @@ module SimpleDMAReadControllerTester(/*AUTOARG*/
 	                           .core_clk(clk),
 	                           .frame_clk(clk),
 	                           .frame_rst_b(rst_b),
+	                           .fifo_level(),
 	                           );
 	*/
 	SimpleDMAReadController dmacontroller(/*AUTOINST*/
@@ -71,6 +72,7 @@ module SimpleDMAReadControllerTester(/*AUTOARG*/
 					      .data		(data[63:0]),
 					      .data_ready	(data_ready),
 					      .fifo_empty	(fifo_empty),
+					      .fifo_level	(),		 // Templated
 					      .dmac__spami_busy_b(dmac__spami_busy_b),
 					      .dmac__spami_data	(dmac__spami_data[SPAM_DATA_HI:0]),
 					      // Inputs
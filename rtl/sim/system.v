@@ -26,13 +26,43 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] accel_blit__fsabo_mode;// From accelblit of AccelBlit.v
 	wire [FSAB_DID_HI:0] accel_blit__fsabo_subdid;// From accelblit of AccelBlit.v
 	wire		accel_blit__fsabo_valid;// From accelblit of AccelBlit.v
+	wire		accel_blit__idle;// From accelblit of AccelBlit.v
 	wire		accel_blit__spami_busy_b;// From accelblit of AccelBlit.v
 	wire [SPAM_DATA_HI:0] accel_blit__spami_data;// From accelblit of AccelBlit.v
+	wire [FSAB_ADDR_HI:0] accel_clear__fsabo_addr;// From accelclear of AccelClear.v
+	wire		accel_clear__fsabo_credit;// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] accel_clear__fsabo_data;// From accelclear of AccelClear.v
+	wire [FSAB_DID_HI:0] accel_clear__fsabo_did;// From accelclear of AccelClear.v
+	wire [FSAB_LEN_HI:0] accel_clear__fsabo_len;// From accelclear of AccelClear.v
+	wire [FSAB_MASK_HI:0] accel_clear__fsabo_mask;// From accelclear of AccelClear.v
+	wire [FSAB_REQ_HI:0] accel_clear__fsabo_mode;// From accelclear of AccelClear.v
+	wire [FSAB_DID_HI:0] accel_clear__fsabo_subdid;// From accelclear of AccelClear.v
+	wire		accel_clear__fsabo_valid;// From accelclear of AccelClear.v
+	wire		accel_clear__idle;// From accelclear of AccelClear.v
+	wire		accel_clear__spami_busy_b;// From accelclear of AccelClear.v
+	wire [SPAM_DATA_HI:0] accel_clear__spami_data;// From accelclear of AccelClear.v
+	wire		accel_cmdq__blit_wr;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__clear_wr;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_ADDR_HI:0] accel_cmdq__fsabo_addr;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__fsabo_credit;// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] accel_cmdq__fsabo_data;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_DID_HI:0] accel_cmdq__fsabo_did;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_LEN_HI:0] accel_cmdq__fsabo_len;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_MASK_HI:0] accel_cmdq__fsabo_mask;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_REQ_HI:0] accel_cmdq__fsabo_mode;// From accelcmdq of AccelCmdQ.v
+	wire [FSAB_DID_HI:0] accel_cmdq__fsabo_subdid;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__fsabo_valid;// From accelcmdq of AccelCmdQ.v
+	wire		accel_cmdq__spami_busy_b;// From accelcmdq of AccelCmdQ.v
+	wire [SPAM_DATA_HI:0] accel_cmdq__spami_data;// From accelcmdq of AccelCmdQ.v
+	wire [7:0] accel_cmdq__wr_addr;	// From accelcmdq of AccelCmdQ.v
+	wire [31:0] accel_cmdq__wr_data;// From accelcmdq of AccelCmdQ.v
+	wire		arb__spami_busy_b;	// From fsabarbiter of FSABArbiter.v
+	wire [SPAM_DATA_HI:0] arb__spami_data;	// From fsabarbiter of FSABArbiter.v
 	wire		cio__spami_busy_b;	// From conio of SPAM_ConsoleIO.v
 	wire [SPAM_DATA_HI:0] cio__spami_data;	// From conio of SPAM_ConsoleIO.v
 	wire [35:0]	control_vio;		// To/From core of Core.v, ...
 	wire [FSAB_ADDR_HI:0] dc__fsabo_addr;	// From core of Core.v
-	wire		dc__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire		dc__fsabo_credit;	// From l2 of FSABL2.v
 	wire [FSAB_DATA_HI:0] dc__fsabo_data;	// From core of Core.v
 	wire [FSAB_DID_HI:0] dc__fsabo_did;	// From core of Core.v
 	wire [FSAB_LEN_HI:0] dc__fsabo_len;	// From core of Core.v
@@ -40,6 +70,17 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] dc__fsabo_mode;	// From core of Core.v
 	wire [FSAB_DID_HI:0] dc__fsabo_subdid;	// From core of Core.v
 	wire		dc__fsabo_valid;	// From core of Core.v
+	wire [FSAB_ADDR_HI:0] dma__fsabo_addr;	// From dma of FSABDMA.v
+	wire		dma__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] dma__fsabo_data;	// From dma of FSABDMA.v
+	wire [FSAB_DID_HI:0] dma__fsabo_did;	// From dma of FSABDMA.v
+	wire [FSAB_LEN_HI:0] dma__fsabo_len;	// From dma of FSABDMA.v
+	wire [FSAB_MASK_HI:0] dma__fsabo_mask;	// From dma of FSABDMA.v
+	wire [FSAB_REQ_HI:0] dma__fsabo_mode;	// From dma of FSABDMA.v
+	wire [FSAB_DID_HI:0] dma__fsabo_subdid;	// From dma of FSABDMA.v
+	wire		dma__fsabo_valid;	// From dma of FSABDMA.v
+	wire		dma__spami_busy_b;	// From dma of FSABDMA.v
+	wire [SPAM_DATA_HI:0] dma__spami_data;	// From dma of FSABDMA.v
 	wire [11:0]	dvi_d;			// From frame of Framebuffer.v
 	wire		dvi_de;			// From frame of Framebuffer.v
 	wire		dvi_hs;			// From frame of Framebuffer.v
@@ -60,6 +101,16 @@ module System(/*AUTOARG*/
 	wire		fb__fsabo_valid;	// From frame of Framebuffer.v
 	wire		fb__spami_busy_b;	// From frame of Framebuffer.v
 	wire [SPAM_DATA_HI:0] fb__spami_data;	// From frame of Framebuffer.v
+	wire		fb__vblank;	// From frame of Framebuffer.v
+	wire [FSAB_ADDR_HI:0] fbspr__fsabo_addr;	// From frame of Framebuffer.v
+	wire		fbspr__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] fbspr__fsabo_data;	// From frame of Framebuffer.v
+	wire [FSAB_DID_HI:0] fbspr__fsabo_did;	// From frame of Framebuffer.v
+	wire [FSAB_LEN_HI:0] fbspr__fsabo_len;	// From frame of Framebuffer.v
+	wire [FSAB_MASK_HI:0] fbspr__fsabo_mask;	// From frame of Framebuffer.v
+	wire [FSAB_REQ_HI:0] fbspr__fsabo_mode;	// From frame of Framebuffer.v
+	wire [FSAB_DID_HI:0] fbspr__fsabo_subdid;	// From frame of Framebuffer.v
+	wire		fbspr__fsabo_valid;	// From frame of Framebuffer.v
 	wire [FSAB_DATA_HI:0] fsabi_data;	// From simmem of FSABSimMemory.v
 	wire [FSAB_DID_HI:0] fsabi_did;		// From simmem of FSABSimMemory.v
 	wire [FSAB_DID_HI:0] fsabi_subdid;	// From simmem of FSABSimMemory.v
@@ -74,7 +125,7 @@ module System(/*AUTOARG*/
 	wire [FSAB_DID_HI:0] fsabo_subdid;	// From fsabarbiter of FSABArbiter.v
 	wire		fsabo_valid;		// From fsabarbiter of FSABArbiter.v
 	wire [FSAB_ADDR_HI:0] ic__fsabo_addr;	// From core of Core.v
-	wire		ic__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire		ic__fsabo_credit;	// From l2 of FSABL2.v
 	wire [FSAB_DATA_HI:0] ic__fsabo_data;	// From core of Core.v
 	wire [FSAB_DID_HI:0] ic__fsabo_did;	// From core of Core.v
 	wire [FSAB_LEN_HI:0] ic__fsabo_len;	// From core of Core.v
@@ -82,6 +133,28 @@ module System(/*AUTOARG*/
 	wire [FSAB_REQ_HI:0] ic__fsabo_mode;	// From core of Core.v
 	wire [FSAB_DID_HI:0] ic__fsabo_subdid;	// From core of Core.v
 	wire		ic__fsabo_valid;	// From core of Core.v
+	wire [FSAB_ADDR_HI:0] l2dc__fsabo_addr;	// From l2 of FSABL2.v
+	wire		l2dc__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] l2dc__fsabo_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2dc__fsabo_did;	// From l2 of FSABL2.v
+	wire [FSAB_LEN_HI:0] l2dc__fsabo_len;	// From l2 of FSABL2.v
+	wire [FSAB_MASK_HI:0] l2dc__fsabo_mask;	// From l2 of FSABL2.v
+	wire [FSAB_REQ_HI:0] l2dc__fsabo_mode;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2dc__fsabo_subdid;	// From l2 of FSABL2.v
+	wire		l2dc__fsabo_valid;	// From l2 of FSABL2.v
+	wire [FSAB_ADDR_HI:0] l2ic__fsabo_addr;	// From l2 of FSABL2.v
+	wire		l2ic__fsabo_credit;	// From fsabarbiter of FSABArbiter.v
+	wire [FSAB_DATA_HI:0] l2ic__fsabo_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2ic__fsabo_did;	// From l2 of FSABL2.v
+	wire [FSAB_LEN_HI:0] l2ic__fsabo_len;	// From l2 of FSABL2.v
+	wire [FSAB_MASK_HI:0] l2ic__fsabo_mask;	// From l2 of FSABL2.v
+	wire [FSAB_REQ_HI:0] l2ic__fsabo_mode;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2ic__fsabo_subdid;	// From l2 of FSABL2.v
+	wire		l2ic__fsabo_valid;	// From l2 of FSABL2.v
+	wire [FSAB_DATA_HI:0] l2__fsabi_data;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2__fsabi_did;	// From l2 of FSABL2.v
+	wire [FSAB_DID_HI:0] l2__fsabi_subdid;	// From l2 of FSABL2.v
+	wire		l2__fsabi_valid;	// From l2 of FSABL2.v
 	wire		lcd__spami_busy_b;	// From lcd of SPAM_LCD.v
 	wire [SPAM_DATA_HI:0] lcd__spami_data;	// From lcd of SPAM_LCD.v
 	wire [FSAB_ADDR_HI:0] pre__fsabo_addr;	// From preload of FSABPreload.v
@@ -104,6 +177,12 @@ module System(/*AUTOARG*/
 	wire rst_b = ~rst;
 	wire fsabi_rst_b = ~rst; /* XXX? */
 
+	/* Set SYNC_CLOCKS to "TRUE" only if clk and fsabi_clk are driven by
+	 * the very same clock; that drops the clock crossing synchronizers
+	 * out of the cache miss paths and the arbiter.
+	 */
+	parameter SYNC_CLOCKS = "FALSE";
+
 `ifdef DUMMY
 	stfu_verilog_mode and_i_mean_it(
 					// Inputs
@@ -111,11 +190,12 @@ module System(/*AUTOARG*/
 					.cio__spami_data(cio__spami_data[SPAM_DATA_HI:0]));
 `endif
 	
-	wire spami_busy_b = cio__spami_busy_b | lcd__spami_busy_b | fb__spami_busy_b | accel_blit__spami_busy_b;
-	wire [SPAM_DATA_HI:0] spami_data = cio__spami_data[SPAM_DATA_HI:0] | lcd__spami_data[SPAM_DATA_HI:0] | fb__spami_data[SPAM_DATA_HI:0] | accel_blit__spami_data[SPAM_DATA_HI:0];
+	wire spami_busy_b = cio__spami_busy_b | arb__spami_busy_b | lcd__spami_busy_b | fb__spami_busy_b | accel_clear__spami_busy_b | accel_blit__spami_busy_b | dma__spami_busy_b | accel_cmdq__spami_busy_b;
+	wire [SPAM_DATA_HI:0] spami_data = cio__spami_data[SPAM_DATA_HI:0] | arb__spami_data[SPAM_DATA_HI:0] | lcd__spami_data[SPAM_DATA_HI:0] | fb__spami_data[SPAM_DATA_HI:0] | accel_clear__spami_data[SPAM_DATA_HI:0] | accel_blit__spami_data[SPAM_DATA_HI:0] | dma__spami_data[SPAM_DATA_HI:0] | accel_cmdq__spami_data[SPAM_DATA_HI:0];
 
 	/* Core AUTO_TEMPLATE (
 		.rst_b(rst_core_b & rst_b),
+		.fsabi_\(valid\|did\|subdid\|data\)(l2__fsabi_\1[]),
 		);
 	*/
 	Core core(/*AUTOINST*/
@@ -148,14 +228,15 @@ module System(/*AUTOARG*/
 		  .rst_b		(rst_core_b & rst_b),	 // Templated
 		  .ic__fsabo_credit	(ic__fsabo_credit),
 		  .dc__fsabo_credit	(dc__fsabo_credit),
-		  .fsabi_valid		(fsabi_valid),
-		  .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
-		  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
-		  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		  .fsabi_valid		(l2__fsabi_valid),	 // Templated
+		  .fsabi_did		(l2__fsabi_did[FSAB_DID_HI:0]), // Templated
+		  .fsabi_subdid		(l2__fsabi_subdid[FSAB_DID_HI:0]), // Templated
+		  .fsabi_data		(l2__fsabi_data[FSAB_DATA_HI:0]), // Templated
 		  .fsabi_clk		(fsabi_clk),
 		  .fsabi_rst_b		(fsabi_rst_b),
 		  .spami_busy_b		(spami_busy_b),
 		  .spami_data		(spami_data[SPAM_DATA_HI:0]));
+	defparam core.SYNC_CLOCKS = SYNC_CLOCKS;
 	
 	wire [8:0] sys_odata;
 	wire sys_tookdata;
@@ -221,8 +302,17 @@ module System(/*AUTOARG*/
 			  .fb__fsabo_len	(fb__fsabo_len[FSAB_LEN_HI:0]),
 			  .fb__fsabo_data	(fb__fsabo_data[FSAB_DATA_HI:0]),
 			  .fb__fsabo_mask	(fb__fsabo_mask[FSAB_MASK_HI:0]),
+			  .fbspr__fsabo_valid(fbspr__fsabo_valid),
+			  .fbspr__fsabo_mode(fbspr__fsabo_mode[FSAB_REQ_HI:0]),
+			  .fbspr__fsabo_did(fbspr__fsabo_did[FSAB_DID_HI:0]),
+			  .fbspr__fsabo_subdid(fbspr__fsabo_subdid[FSAB_DID_HI:0]),
+			  .fbspr__fsabo_addr(fbspr__fsabo_addr[FSAB_ADDR_HI:0]),
+			  .fbspr__fsabo_len(fbspr__fsabo_len[FSAB_LEN_HI:0]),
+			  .fbspr__fsabo_data(fbspr__fsabo_data[FSAB_DATA_HI:0]),
+			  .fbspr__fsabo_mask(fbspr__fsabo_mask[FSAB_MASK_HI:0]),
 			  .fb__spami_busy_b	(fb__spami_busy_b),
 			  .fb__spami_data	(fb__spami_data[SPAM_DATA_HI:0]),
+			  .fb__vblank		(fb__vblank),
 			  // Inouts
 			  .dvi_sda		(dvi_sda),
 			  .dvi_scl		(dvi_scl),
@@ -239,16 +329,92 @@ module System(/*AUTOARG*/
 			  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
 			  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
 			  .fb__fsabo_credit	(fb__fsabo_credit),
+			  .fbspr__fsabo_credit(fbspr__fsabo_credit),
 			  .spamo_valid		(spamo_valid),
 			  .spamo_r_nw		(spamo_r_nw),
 			  .spamo_did		(spamo_did[SPAM_DID_HI:0]),
 			  .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
 			  .spamo_data		(spamo_data[SPAM_DATA_HI:0]));
 
-	/*AUTO_LISP(setq list-of-prefixes '("pre" "fb" "ic" "dc" "accel_blit" ))*/
-	parameter FSAB_DEVICES = 5;
-	wire [FSAB_DEVICES-1:0] fsabo_clks = {clk, clk, clk, clk, fsabi_clk};
-	wire [FSAB_DEVICES-1:0] fsabo_rst_bs = {rst_b, rst_b, rst_b, rst_b, fsabi_rst_b};
+	/* Set L2 to "TRUE" to put a unified L2 between the core and the
+	 * arbiter.  The L2 runs on fsabi_clk, and all of its traffic comes
+	 * out of the l2dc port.
+	 */
+	parameter L2 = "FALSE";
+
+	/* FSABL2 AUTO_TEMPLATE (
+		.cclk(clk),
+		.cclk_rst_b(rst_b),
+		); */
+	FSABL2 l2(/*AUTOINST*/
+		  // Outputs
+		  .ic__fsabo_credit	(ic__fsabo_credit),
+		  .dc__fsabo_credit	(dc__fsabo_credit),
+		  .l2__fsabi_valid	(l2__fsabi_valid),
+		  .l2__fsabi_did	(l2__fsabi_did[FSAB_DID_HI:0]),
+		  .l2__fsabi_subdid	(l2__fsabi_subdid[FSAB_DID_HI:0]),
+		  .l2__fsabi_data	(l2__fsabi_data[FSAB_DATA_HI:0]),
+		  .l2ic__fsabo_valid	(l2ic__fsabo_valid),
+		  .l2ic__fsabo_mode	(l2ic__fsabo_mode[FSAB_REQ_HI:0]),
+		  .l2ic__fsabo_did	(l2ic__fsabo_did[FSAB_DID_HI:0]),
+		  .l2ic__fsabo_subdid	(l2ic__fsabo_subdid[FSAB_DID_HI:0]),
+		  .l2ic__fsabo_addr	(l2ic__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .l2ic__fsabo_len	(l2ic__fsabo_len[FSAB_LEN_HI:0]),
+		  .l2ic__fsabo_data	(l2ic__fsabo_data[FSAB_DATA_HI:0]),
+		  .l2ic__fsabo_mask	(l2ic__fsabo_mask[FSAB_MASK_HI:0]),
+		  .l2dc__fsabo_valid	(l2dc__fsabo_valid),
+		  .l2dc__fsabo_mode	(l2dc__fsabo_mode[FSAB_REQ_HI:0]),
+		  .l2dc__fsabo_did	(l2dc__fsabo_did[FSAB_DID_HI:0]),
+		  .l2dc__fsabo_subdid	(l2dc__fsabo_subdid[FSAB_DID_HI:0]),
+		  .l2dc__fsabo_addr	(l2dc__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .l2dc__fsabo_len	(l2dc__fsabo_len[FSAB_LEN_HI:0]),
+		  .l2dc__fsabo_data	(l2dc__fsabo_data[FSAB_DATA_HI:0]),
+		  .l2dc__fsabo_mask	(l2dc__fsabo_mask[FSAB_MASK_HI:0]),
+		  // Inputs
+		  .cclk			(clk),			 // Templated
+		  .cclk_rst_b		(rst_b),		 // Templated
+		  .fsabi_clk		(fsabi_clk),
+		  .fsabi_rst_b		(fsabi_rst_b),
+		  .ic__fsabo_valid	(ic__fsabo_valid),
+		  .ic__fsabo_mode	(ic__fsabo_mode[FSAB_REQ_HI:0]),
+		  .ic__fsabo_did	(ic__fsabo_did[FSAB_DID_HI:0]),
+		  .ic__fsabo_subdid	(ic__fsabo_subdid[FSAB_DID_HI:0]),
+		  .ic__fsabo_addr	(ic__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .ic__fsabo_len	(ic__fsabo_len[FSAB_LEN_HI:0]),
+		  .ic__fsabo_data	(ic__fsabo_data[FSAB_DATA_HI:0]),
+		  .ic__fsabo_mask	(ic__fsabo_mask[FSAB_MASK_HI:0]),
+		  .dc__fsabo_valid	(dc__fsabo_valid),
+		  .dc__fsabo_mode	(dc__fsabo_mode[FSAB_REQ_HI:0]),
+		  .dc__fsabo_did	(dc__fsabo_did[FSAB_DID_HI:0]),
+		  .dc__fsabo_subdid	(dc__fsabo_subdid[FSAB_DID_HI:0]),
+		  .dc__fsabo_addr	(dc__fsabo_addr[FSAB_ADDR_HI:0]),
+		  .dc__fsabo_len	(dc__fsabo_len[FSAB_LEN_HI:0]),
+		  .dc__fsabo_data	(dc__fsabo_data[FSAB_DATA_HI:0]),
+		  .dc__fsabo_mask	(dc__fsabo_mask[FSAB_MASK_HI:0]),
+		  .l2ic__fsabo_credit	(l2ic__fsabo_credit),
+		  .l2dc__fsabo_credit	(l2dc__fsabo_credit),
+		  .fsabi_valid		(fsabi_valid),
+		  .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+		  .fsabi_subdid		(fsabi_subdid[FSAB_DID_HI:0]),
+		  .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		  .fsabo_valid		(fsabo_valid),
+		  .fsabo_mode		(fsabo_mode[FSAB_REQ_HI:0]),
+		  .fsabo_did		(fsabo_did[FSAB_DID_HI:0]),
+		  .fsabo_addr		(fsabo_addr[FSAB_ADDR_HI:0]),
+		  .fsabo_len		(fsabo_len[FSAB_LEN_HI:0]));
+	defparam l2.ENABLE = L2;
+	defparam l2.SYNC_CLOCKS = SYNC_CLOCKS;
+
+	/*AUTO_LISP(setq list-of-prefixes '("fbspr" "accel_clear" "accel_cmdq" "dma" "pre" "fb" "l2ic" "l2dc" "accel_blit" ))*/
+	parameter FSAB_DEVICES = 9;
+	/* Scanout and the blitter stream big linear reads, so they get more
+	 * credits (and deeper arbiter FIFOs) to keep enough reads in flight to
+	 * cover the memory latency.  Everybody else makes do with the default.
+	 */
+	parameter STREAM_CREDITS = 8;
+	parameter MEM_CREDITS = FSAB_MEM_CREDITS;
+	wire [FSAB_DEVICES-1:0] fsabo_clks = {fsabi_clk, fsabi_clk, fsabi_clk, fsabi_clk, clk, clk, clk, (L2 == "TRUE") ? fsabi_clk : clk, fsabi_clk};
+	wire [FSAB_DEVICES-1:0] fsabo_rst_bs = {fsabi_rst_b, fsabi_rst_b, fsabi_rst_b, fsabi_rst_b, rst_b, rst_b, rst_b, (L2 == "TRUE") ? fsabi_rst_b : rst_b, fsabi_rst_b};
 
 	/* FSABArbiter AUTO_TEMPLATE (
 		.fsabo_valids(@"(template \"__fsabo_valid\")"),
@@ -262,11 +428,13 @@ module System(/*AUTOARG*/
 		.fsabo_credits(@"(template \"__fsabo_credit\")"),
 		.clk(fsabi_clk),
 		.rst_b(fsabi_rst_b),
+		.cclk(clk),
+		.cclk_rst_b(rst_b),
 		); */
 	FSABArbiter fsabarbiter(
 		/*AUTOINST*/
 				// Outputs
-				.fsabo_credits	({pre__fsabo_credit,fb__fsabo_credit,ic__fsabo_credit,dc__fsabo_credit,accel_blit__fsabo_credit}), // Templated
+				.fsabo_credits	({fbspr__fsabo_credit,accel_clear__fsabo_credit,accel_cmdq__fsabo_credit,dma__fsabo_credit,pre__fsabo_credit,fb__fsabo_credit,l2ic__fsabo_credit,l2dc__fsabo_credit,accel_blit__fsabo_credit}), // Templated
 				.fsabo_valid	(fsabo_valid),
 				.fsabo_mode	(fsabo_mode[FSAB_REQ_HI:0]),
 				.fsabo_did	(fsabo_did[FSAB_DID_HI:0]),
@@ -275,22 +443,45 @@ module System(/*AUTOARG*/
 				.fsabo_len	(fsabo_len[FSAB_LEN_HI:0]),
 				.fsabo_data	(fsabo_data[FSAB_DATA_HI:0]),
 				.fsabo_mask	(fsabo_mask[FSAB_MASK_HI:0]),
+				.arb__spami_busy_b(arb__spami_busy_b),
+				.arb__spami_data(arb__spami_data[SPAM_DATA_HI:0]),
 				// Inputs
 				.clk		(fsabi_clk),	 // Templated
 				.rst_b		(fsabi_rst_b),	 // Templated
-				.fsabo_valids	({pre__fsabo_valid,fb__fsabo_valid,ic__fsabo_valid,dc__fsabo_valid,accel_blit__fsabo_valid}), // Templated
-				.fsabo_modes	({pre__fsabo_mode[FSAB_REQ_HI:0],fb__fsabo_mode[FSAB_REQ_HI:0],ic__fsabo_mode[FSAB_REQ_HI:0],dc__fsabo_mode[FSAB_REQ_HI:0],accel_blit__fsabo_mode[FSAB_REQ_HI:0]}), // Templated
-				.fsabo_dids	({pre__fsabo_did[FSAB_DID_HI:0],fb__fsabo_did[FSAB_DID_HI:0],ic__fsabo_did[FSAB_DID_HI:0],dc__fsabo_did[FSAB_DID_HI:0],accel_blit__fsabo_did[FSAB_DID_HI:0]}), // Templated
-				.fsabo_subdids	({pre__fsabo_subdid[FSAB_DID_HI:0],fb__fsabo_subdid[FSAB_DID_HI:0],ic__fsabo_subdid[FSAB_DID_HI:0],dc__fsabo_subdid[FSAB_DID_HI:0],accel_blit__fsabo_subdid[FSAB_DID_HI:0]}), // Templated
-				.fsabo_addrs	({pre__fsabo_addr[FSAB_ADDR_HI:0],fb__fsabo_addr[FSAB_ADDR_HI:0],ic__fsabo_addr[FSAB_ADDR_HI:0],dc__fsabo_addr[FSAB_ADDR_HI:0],accel_blit__fsabo_addr[FSAB_ADDR_HI:0]}), // Templated
-				.fsabo_lens	({pre__fsabo_len[FSAB_LEN_HI:0],fb__fsabo_len[FSAB_LEN_HI:0],ic__fsabo_len[FSAB_LEN_HI:0],dc__fsabo_len[FSAB_LEN_HI:0],accel_blit__fsabo_len[FSAB_LEN_HI:0]}), // Templated
-				.fsabo_datas	({pre__fsabo_data[FSAB_DATA_HI:0],fb__fsabo_data[FSAB_DATA_HI:0],ic__fsabo_data[FSAB_DATA_HI:0],dc__fsabo_data[FSAB_DATA_HI:0],accel_blit__fsabo_data[FSAB_DATA_HI:0]}), // Templated
-				.fsabo_masks	({pre__fsabo_mask[FSAB_MASK_HI:0],fb__fsabo_mask[FSAB_MASK_HI:0],ic__fsabo_mask[FSAB_MASK_HI:0],dc__fsabo_mask[FSAB_MASK_HI:0],accel_blit__fsabo_mask[FSAB_MASK_HI:0]}), // Templated
+				.fsabo_valids	({fbspr__fsabo_valid,accel_clear__fsabo_valid,accel_cmdq__fsabo_valid,dma__fsabo_valid,pre__fsabo_valid,fb__fsabo_valid,l2ic__fsabo_valid,l2dc__fsabo_valid,accel_blit__fsabo_valid}), // Templated
+				.fsabo_modes	({fbspr__fsabo_mode[FSAB_REQ_HI:0],accel_clear__fsabo_mode[FSAB_REQ_HI:0],accel_cmdq__fsabo_mode[FSAB_REQ_HI:0],dma__fsabo_mode[FSAB_REQ_HI:0],pre__fsabo_mode[FSAB_REQ_HI:0],fb__fsabo_mode[FSAB_REQ_HI:0],l2ic__fsabo_mode[FSAB_REQ_HI:0],l2dc__fsabo_mode[FSAB_REQ_HI:0],accel_blit__fsabo_mode[FSAB_REQ_HI:0]}), // Templated
+				.fsabo_dids	({fbspr__fsabo_did[FSAB_DID_HI:0],accel_clear__fsabo_did[FSAB_DID_HI:0],accel_cmdq__fsabo_did[FSAB_DID_HI:0],dma__fsabo_did[FSAB_DID_HI:0],pre__fsabo_did[FSAB_DID_HI:0],fb__fsabo_did[FSAB_DID_HI:0],l2ic__fsabo_did[FSAB_DID_HI:0],l2dc__fsabo_did[FSAB_DID_HI:0],accel_blit__fsabo_did[FSAB_DID_HI:0]}), // Templated
+				.fsabo_subdids	({fbspr__fsabo_subdid[FSAB_DID_HI:0],accel_clear__fsabo_subdid[FSAB_DID_HI:0],accel_cmdq__fsabo_subdid[FSAB_DID_HI:0],dma__fsabo_subdid[FSAB_DID_HI:0],pre__fsabo_subdid[FSAB_DID_HI:0],fb__fsabo_subdid[FSAB_DID_HI:0],l2ic__fsabo_subdid[FSAB_DID_HI:0],l2dc__fsabo_subdid[FSAB_DID_HI:0],accel_blit__fsabo_subdid[FSAB_DID_HI:0]}), // Templated
+				.fsabo_addrs	({fbspr__fsabo_addr[FSAB_ADDR_HI:0],accel_clear__fsabo_addr[FSAB_ADDR_HI:0],accel_cmdq__fsabo_addr[FSAB_ADDR_HI:0],dma__fsabo_addr[FSAB_ADDR_HI:0],pre__fsabo_addr[FSAB_ADDR_HI:0],fb__fsabo_addr[FSAB_ADDR_HI:0],l2ic__fsabo_addr[FSAB_ADDR_HI:0],l2dc__fsabo_addr[FSAB_ADDR_HI:0],accel_blit__fsabo_addr[FSAB_ADDR_HI:0]}), // Templated
+				.fsabo_lens	({fbspr__fsabo_len[FSAB_LEN_HI:0],accel_clear__fsabo_len[FSAB_LEN_HI:0],accel_cmdq__fsabo_len[FSAB_LEN_HI:0],dma__fsabo_len[FSAB_LEN_HI:0],pre__fsabo_len[FSAB_LEN_HI:0],fb__fsabo_len[FSAB_LEN_HI:0],l2ic__fsabo_len[FSAB_LEN_HI:0],l2dc__fsabo_len[FSAB_LEN_HI:0],accel_blit__fsabo_len[FSAB_LEN_HI:0]}), // Templated
+				.fsabo_datas	({fbspr__fsabo_data[FSAB_DATA_HI:0],accel_clear__fsabo_data[FSAB_DATA_HI:0],accel_cmdq__fsabo_data[FSAB_DATA_HI:0],dma__fsabo_data[FSAB_DATA_HI:0],pre__fsabo_data[FSAB_DATA_HI:0],fb__fsabo_data[FSAB_DATA_HI:0],l2ic__fsabo_data[FSAB_DATA_HI:0],l2dc__fsabo_data[FSAB_DATA_HI:0],accel_blit__fsabo_data[FSAB_DATA_HI:0]}), // Templated
+				.fsabo_masks	({fbspr__fsabo_mask[FSAB_MASK_HI:0],accel_clear__fsabo_mask[FSAB_MASK_HI:0],accel_cmdq__fsabo_mask[FSAB_MASK_HI:0],dma__fsabo_mask[FSAB_MASK_HI:0],pre__fsabo_mask[FSAB_MASK_HI:0],fb__fsabo_mask[FSAB_MASK_HI:0],l2ic__fsabo_mask[FSAB_MASK_HI:0],l2dc__fsabo_mask[FSAB_MASK_HI:0],accel_blit__fsabo_mask[FSAB_MASK_HI:0]}), // Templated
 				.fsabo_clks	(fsabo_clks[FSAB_DEVICES-1:0]),
 				.fsabo_rst_bs	(fsabo_rst_bs[FSAB_DEVICES-1:0]),
-				.fsabo_credit	(fsabo_credit));
-	defparam fsabarbiter.FSAB_DEVICES = 5;
-	defparam fsabarbiter.FSAB_DEVICES_HI = 2;
+				.fsabo_credit	(fsabo_credit),
+				.cclk		(clk),		 // Templated
+				.cclk_rst_b	(rst_b),	 // Templated
+				.spamo_valid	(spamo_valid),
+				.spamo_r_nw	(spamo_r_nw),
+				.spamo_did	(spamo_did[SPAM_DID_HI:0]),
+				.spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
+				.spamo_data	(spamo_data[SPAM_DATA_HI:0]));
+	defparam fsabarbiter.FSAB_DEVICES = FSAB_DEVICES;
+	/* Scanout (and its sprites) is real-time, and the CPU stalls on its
+	 * misses; everything else can wait.  Software can change these later.
+	 */
+	defparam fsabarbiter.DEFAULT_PRIOS = {2'd3, 2'd0, 2'd0, 2'd0, 2'd0, 2'd3, 2'd2, 2'd2, 2'd0};
+	defparam fsabarbiter.SYNC_DEVICES = {1'b1, 1'b1, 1'b1, 1'b1, (SYNC_CLOCKS == "TRUE"), (SYNC_CLOCKS == "TRUE"), (SYNC_CLOCKS == "TRUE"),
+	                                     (SYNC_CLOCKS == "TRUE") || (L2 == "TRUE"), 1'b1};
+	defparam fsabarbiter.FSAB_DEVICES_HI = 3;
+	defparam fsabarbiter.DEVICE_CREDITS = {8'd0, 8'd0, 8'd0, 8'd0, 8'd0, STREAM_CREDITS[7:0], 8'd0, 8'd0, STREAM_CREDITS[7:0]};
+	defparam fsabarbiter.MEM_CREDITS = MEM_CREDITS;
+	defparam frame.DMA_CREDITS = STREAM_CREDITS;	/* up above, before STREAM_CREDITS exists */
+
+	/* Set PERFECT_MEMORY to "TRUE" to have simmem answer everything right
+	 * away, instead of modelling the DDR2's timing.
+	 */
+	parameter PERFECT_MEMORY = "FALSE";
 
 	/* FSABSimMemory AUTO_TEMPLATE (
 		.clk(fsabi_clk),
@@ -315,6 +506,8 @@ module System(/*AUTOARG*/
 			     .fsabo_len		(fsabo_len[FSAB_LEN_HI:0]),
 			     .fsabo_data	(fsabo_data[FSAB_DATA_HI:0]),
 			     .fsabo_mask	(fsabo_mask[FSAB_MASK_HI:0]));
+	defparam simmem.CREDITS = MEM_CREDITS;
+	defparam simmem.PERFECT = PERFECT_MEMORY;
 
 	FSABPreload preload(/*AUTOINST*/
 			    // Outputs
@@ -336,6 +529,42 @@ module System(/*AUTOARG*/
 			    .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
 			    .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]));
 
+	/* AccelClear AUTO_TEMPLATE (
+		.cclk(clk),
+		.cclk_rst_b(rst_b),
+		); */
+	AccelClear accelclear(/*AUTOINST*/
+			      // Outputs
+			      .accel_clear__fsabo_valid(accel_clear__fsabo_valid),
+			      .accel_clear__fsabo_mode(accel_clear__fsabo_mode[FSAB_REQ_HI:0]),
+			      .accel_clear__fsabo_did(accel_clear__fsabo_did[FSAB_DID_HI:0]),
+			      .accel_clear__fsabo_subdid(accel_clear__fsabo_subdid[FSAB_DID_HI:0]),
+			      .accel_clear__fsabo_addr(accel_clear__fsabo_addr[FSAB_ADDR_HI:0]),
+			      .accel_clear__fsabo_len(accel_clear__fsabo_len[FSAB_LEN_HI:0]),
+			      .accel_clear__fsabo_data(accel_clear__fsabo_data[FSAB_DATA_HI:0]),
+			      .accel_clear__fsabo_mask(accel_clear__fsabo_mask[FSAB_MASK_HI:0]),
+			      .accel_clear__spami_busy_b(accel_clear__spami_busy_b),
+			      .accel_clear__spami_data(accel_clear__spami_data[SPAM_DATA_HI:0]),
+			      .accel_clear__idle(accel_clear__idle),
+			      // Inputs
+			      .accel_clear__fsabo_credit(accel_clear__fsabo_credit),
+			      .fsabi_clk	(fsabi_clk),
+			      .fsabi_rst_b	(fsabi_rst_b),
+			      .fsabi_valid	(fsabi_valid),
+			      .fsabi_did	(fsabi_did[FSAB_DID_HI:0]),
+			      .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+			      .fsabi_data	(fsabi_data[FSAB_DATA_HI:0]),
+			      .cclk		(clk),		 // Templated
+			      .cclk_rst_b	(rst_b),	 // Templated
+			      .spamo_valid	(spamo_valid),
+			      .spamo_r_nw	(spamo_r_nw),
+			      .spamo_did	(spamo_did[SPAM_DID_HI:0]),
+			      .spamo_addr	(spamo_addr[SPAM_ADDR_HI:0]),
+			      .spamo_data	(spamo_data[SPAM_DATA_HI:0]),
+			      .accel_cmdq__clear_wr(accel_cmdq__clear_wr),
+			      .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			      .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]));
+
 	/* AccelBlit AUTO_TEMPLATE (
 		.cclk(clk),
 		.cclk_rst_b(rst_b),
@@ -352,6 +581,7 @@ module System(/*AUTOARG*/
 			    .accel_blit__fsabo_mask(accel_blit__fsabo_mask[FSAB_MASK_HI:0]),
 			    .accel_blit__spami_busy_b(accel_blit__spami_busy_b),
 			    .accel_blit__spami_data(accel_blit__spami_data[SPAM_DATA_HI:0]),
+			    .accel_blit__idle	(accel_blit__idle),
 			    // Inputs
 			    .accel_blit__fsabo_credit(accel_blit__fsabo_credit),
 			    .fsabi_clk		(fsabi_clk),
@@ -366,8 +596,83 @@ module System(/*AUTOARG*/
 			    .spamo_r_nw		(spamo_r_nw),
 			    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
 			    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+			    .spamo_data		(spamo_data[SPAM_DATA_HI:0]),
+			    .accel_cmdq__blit_wr(accel_cmdq__blit_wr),
+			    .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			    .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]));
+	defparam accelblit.CREDITS = STREAM_CREDITS;
+
+	/* AccelCmdQ AUTO_TEMPLATE (
+		.cclk(clk),
+		.cclk_rst_b(rst_b),
+		); */
+	AccelCmdQ accelcmdq(/*AUTOINST*/
+			    // Outputs
+			    .accel_cmdq__fsabo_valid(accel_cmdq__fsabo_valid),
+			    .accel_cmdq__fsabo_mode(accel_cmdq__fsabo_mode[FSAB_REQ_HI:0]),
+			    .accel_cmdq__fsabo_did(accel_cmdq__fsabo_did[FSAB_DID_HI:0]),
+			    .accel_cmdq__fsabo_subdid(accel_cmdq__fsabo_subdid[FSAB_DID_HI:0]),
+			    .accel_cmdq__fsabo_addr(accel_cmdq__fsabo_addr[FSAB_ADDR_HI:0]),
+			    .accel_cmdq__fsabo_len(accel_cmdq__fsabo_len[FSAB_LEN_HI:0]),
+			    .accel_cmdq__fsabo_data(accel_cmdq__fsabo_data[FSAB_DATA_HI:0]),
+			    .accel_cmdq__fsabo_mask(accel_cmdq__fsabo_mask[FSAB_MASK_HI:0]),
+			    .accel_cmdq__clear_wr(accel_cmdq__clear_wr),
+			    .accel_cmdq__blit_wr(accel_cmdq__blit_wr),
+			    .accel_cmdq__wr_addr(accel_cmdq__wr_addr[7:0]),
+			    .accel_cmdq__wr_data(accel_cmdq__wr_data[31:0]),
+			    .accel_cmdq__spami_busy_b(accel_cmdq__spami_busy_b),
+			    .accel_cmdq__spami_data(accel_cmdq__spami_data[SPAM_DATA_HI:0]),
+			    // Inputs
+			    .accel_cmdq__fsabo_credit(accel_cmdq__fsabo_credit),
+			    .fsabi_clk		(fsabi_clk),
+			    .fsabi_rst_b	(fsabi_rst_b),
+			    .fsabi_valid	(fsabi_valid),
+			    .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+			    .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+			    .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+			    .accel_clear__idle	(accel_clear__idle),
+			    .accel_blit__idle	(accel_blit__idle),
+			    .fb__vblank		(fb__vblank),
+			    .cclk		(clk),		 // Templated
+			    .cclk_rst_b		(rst_b),	 // Templated
+			    .spamo_valid	(spamo_valid),
+			    .spamo_r_nw		(spamo_r_nw),
+			    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+			    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
 			    .spamo_data		(spamo_data[SPAM_DATA_HI:0]));
 
+	/* FSABDMA AUTO_TEMPLATE (
+		.cclk(clk),
+		.cclk_rst_b(rst_b),
+		); */
+	FSABDMA dma(/*AUTOINST*/
+		    // Outputs
+		    .dma__fsabo_valid	(dma__fsabo_valid),
+		    .dma__fsabo_mode	(dma__fsabo_mode[FSAB_REQ_HI:0]),
+		    .dma__fsabo_did	(dma__fsabo_did[FSAB_DID_HI:0]),
+		    .dma__fsabo_subdid	(dma__fsabo_subdid[FSAB_DID_HI:0]),
+		    .dma__fsabo_addr	(dma__fsabo_addr[FSAB_ADDR_HI:0]),
+		    .dma__fsabo_len	(dma__fsabo_len[FSAB_LEN_HI:0]),
+		    .dma__fsabo_data	(dma__fsabo_data[FSAB_DATA_HI:0]),
+		    .dma__fsabo_mask	(dma__fsabo_mask[FSAB_MASK_HI:0]),
+		    .dma__spami_busy_b	(dma__spami_busy_b),
+		    .dma__spami_data	(dma__spami_data[SPAM_DATA_HI:0]),
+		    // Inputs
+		    .dma__fsabo_credit	(dma__fsabo_credit),
+		    .fsabi_clk		(fsabi_clk),
+		    .fsabi_rst_b	(fsabi_rst_b),
+		    .fsabi_valid	(fsabi_valid),
+		    .fsabi_did		(fsabi_did[FSAB_DID_HI:0]),
+		    .fsabi_subdid	(fsabi_subdid[FSAB_DID_HI:0]),
+		    .fsabi_data		(fsabi_data[FSAB_DATA_HI:0]),
+		    .cclk		(clk),		 // Templated
+		    .cclk_rst_b		(rst_b),	 // Templated
+		    .spamo_valid	(spamo_valid),
+		    .spamo_r_nw		(spamo_r_nw),
+		    .spamo_did		(spamo_did[SPAM_DID_HI:0]),
+		    .spamo_addr		(spamo_addr[SPAM_ADDR_HI:0]),
+		    .spamo_data		(spamo_data[SPAM_DATA_HI:0]));
+
 endmodule
 
 /*
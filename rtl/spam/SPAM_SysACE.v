@@ -1,15 +1,32 @@
+/* SystemACE MPU interface.
+ *
+ * 000-1FC: the SystemACE's own registers, one 16-bit register per word.
+ * 200-20C: the sector DMA, which pulls sectors out of the data buffer and
+ *          writes them to memory over FSAB, once a read command has been
+ *          started the usual way (lock, LBA, SECCNTCMD):
+ *   200 = destination (64-byte aligned)
+ *   204 = number of sectors (0 means 256, just like SECCNTCMD)
+ *   208 = control: writing bit 0 starts the copy
+ *   20C = status (read only; so is any other read in here): bit 0 busy,
+ *         bit 1 done, bit 2 gave up waiting for the data buffer
+ */
+
 module SPAM_SysACE(/*AUTOARG*/
    // Outputs
    sace__spami_busy_b, sace__spami_data, sace_mpa, sace_mpce_n,
-   sace_mpwe_n, sace_mpoe_n,
+   sace_mpwe_n, sace_mpoe_n, sace__fsabo_valid, sace__fsabo_mode,
+   sace__fsabo_did, sace__fsabo_subdid, sace__fsabo_addr,
+   sace__fsabo_len, sace__fsabo_data, sace__fsabo_mask,
    // Inouts
    sace_mpd, control_vio,
    // Inputs
    clk, rst_b, spamo_valid, spamo_r_nw, spamo_did, spamo_addr,
-   spamo_data, sace_clk
+   spamo_data, sace_clk, sace__fsabo_credit
    );
 
 	`include "spam_defines.vh"
+	`include "fsab_defines.vh"
+	`include "clog2.vh"
 
 	input clk, rst_b;
 	
@@ -19,8 +36,8 @@ module SPAM_SysACE(/*AUTOARG*/
 	input      [SPAM_ADDR_HI:0] spamo_addr;
 	input      [SPAM_DATA_HI:0] spamo_data;
 	
-	output reg                  sace__spami_busy_b = 0;
-	output reg [SPAM_DATA_HI:0] sace__spami_data = 'h0;
+	output wire                 sace__spami_busy_b;
+	output wire [SPAM_DATA_HI:0] sace__spami_data;
 	
 	input                       sace_clk;
 	output wire [6:0]           sace_mpa;
@@ -29,12 +46,36 @@ module SPAM_SysACE(/*AUTOARG*/
 	output reg                  sace_mpwe_n = 1;
 	output reg                  sace_mpoe_n = 1;
 	
+	/* FSAB, for the sector DMA; runs on sace_clk */
+	output reg                  sace__fsabo_valid = 0;
+	output reg [FSAB_REQ_HI:0]  sace__fsabo_mode = 0;
+	output reg [FSAB_DID_HI:0]  sace__fsabo_did = 0;
+	output reg [FSAB_DID_HI:0]  sace__fsabo_subdid = 0;
+	output reg [FSAB_ADDR_HI:0] sace__fsabo_addr = 0;
+	output reg [FSAB_LEN_HI:0]  sace__fsabo_len = 0;
+	output reg [FSAB_DATA_HI:0] sace__fsabo_data = 0;
+	output reg [FSAB_MASK_HI:0] sace__fsabo_mask = 0;
+	input                       sace__fsabo_credit;
+	
 	reg sace_dowrite_n = 1;
 	
 	inout [35:0] control_vio;
 	
 	parameter DEBUG = "FALSE";
 	
+	parameter FSAB_DID = FSAB_DID_SACE;
+	parameter FSAB_SUBDID = FSAB_SUBDID_SACE;
+	
+	parameter CREDITS = FSAB_INITIAL_CREDITS;
+	parameter CREDITS_HI = clog2(CREDITS) - 1;
+	
+	/* Where the sector DMA looks on the MPU bus: status register 0 (low
+	 * half), and the data buffer.
+	 */
+	parameter MPA_STATUS = 7'h04;
+	parameter MPA_DATABUF = 7'h40;
+	parameter STATUS_DATABUFRDY = 5;
+	
 	wire [15:0] sace_mpd_rd;
 	wire [15:0] sace_mpd_wr;
 	
@@ -62,6 +103,16 @@ module SPAM_SysACE(/*AUTOARG*/
 	reg [15:0]           sace_mpd_rd_l_sclk_s = 0;
 	reg [15:0]           sace_mpd_rd_l_sclk_cclk = 0;
 	
+	reg                  mpu__spami_busy_b = 0;
+	reg [SPAM_DATA_HI:0] mpu__spami_data = 'h0;
+	
+	wire                 dma_wr_busy_b;
+	wire                 dma_rd_busy_b;
+	wire [2:0]           dma_status_cclk;
+	
+	assign sace__spami_busy_b = mpu__spami_busy_b | dma_wr_busy_b | dma_rd_busy_b;
+	assign sace__spami_data = mpu__spami_data | (dma_rd_busy_b ? {29'h0, dma_status_cclk} : 32'h0);
+	
 	always @(posedge clk or negedge rst_b) begin
 		if (!rst_b) begin
 			cur_request_cclk <= 0;
@@ -78,10 +129,10 @@ module SPAM_SysACE(/*AUTOARG*/
 			sace_mpd_rd_l_sclk_s <= 0;
 			sace_mpd_rd_l_sclk_cclk <= 0;
 			
-			sace__spami_data <= 32'h0;
-			sace__spami_busy_b <= 0;
+			mpu__spami_data <= 32'h0;
+			mpu__spami_busy_b <= 0;
 		end else begin
-			if (spamo_valid && (spamo_did == SPAM_DID_SACE)) begin
+			if (spamo_valid && (spamo_did == SPAM_DID_SACE) && !spamo_addr[9]) begin
 				cur_request_cclk <= ~cur_request_cclk;
 				cur_r_nw_cclk <= spamo_r_nw;
 				cur_did_cclk <= spamo_did;
@@ -98,11 +149,11 @@ module SPAM_SysACE(/*AUTOARG*/
 			sace_mpd_rd_l_sclk_cclk <= sace_mpd_rd_l_sclk_s;
 			
 			if (completed_request_sclk_1a_cclk ^ completed_request_sclk_2a_cclk) begin
-				sace__spami_data <= {16'h0000, sace_mpd_rd_l_sclk_cclk};
-				sace__spami_busy_b <= 1;
+				mpu__spami_data <= {16'h0000, sace_mpd_rd_l_sclk_cclk};
+				mpu__spami_busy_b <= 1;
 			end else begin
-				sace__spami_data <= 32'h0;
-				sace__spami_busy_b <= 0;
+				mpu__spami_data <= 32'h0;
+				mpu__spami_busy_b <= 0;
 			end
 		end
 	end
@@ -163,11 +214,72 @@ module SPAM_SysACE(/*AUTOARG*/
 	end
 	
 
+	/*** Sector DMA registers ***/
+	
+	wire dma_wr_decode = spamo_valid && !spamo_r_nw && (spamo_did == SPAM_DID_SACE) && spamo_addr[9];
+	wire dma_rd_decode = spamo_valid && spamo_r_nw && (spamo_did == SPAM_DID_SACE) && spamo_addr[9];
+	
+	wire dma_csr_strobe;
+	wire [7:0] dma_csr_addr;
+	wire [31:0] dma_csr_data;
+	
+	CSRAsyncWrite #(.WIDTH       (40),
+	                .RESET_VALUE (40'h0))
+		CSR_DMA(/* NOT AUTOINST */
+		        // Outputs
+		        .wr_wait_cclk       (),
+		        .wr_done_strobe_cclk(dma_wr_busy_b),
+		        .wr_strobe_tclk     (dma_csr_strobe),
+		        .wr_data_tclk       ({dma_csr_addr, dma_csr_data}),
+		        // Inputs
+		        .cclk               (clk),
+		        .tclk               (sace_clk),
+		        .rst_b_cclk         (rst_b),
+		        .rst_b_tclk         (sace_rst_b),
+		        .wr_strobe_cclk     (dma_wr_decode),
+		        .wr_data_cclk       ({spamo_addr[7:0], spamo_data}));
+	
+	reg dma_busy = 0;
+	reg dma_done = 0;
+	reg dma_err = 0;
+	
+	CSRAsyncRead #(.WIDTH        (3))
+		CSR_DMA_STATUS(/* NOT AUTOINST */
+		               // Outputs
+		               .rd_data_cclk       (dma_status_cclk),
+		               .rd_wait_cclk       (),
+		               .rd_done_strobe_cclk(dma_rd_busy_b),
+		               .rd_strobe_tclk     (),
+		               // Inputs
+		               .cclk               (clk),
+		               .tclk               (sace_clk),
+		               .rst_b_cclk         (rst_b),
+		               .rst_b_tclk         (sace_rst_b),
+		               .rd_strobe_cclk     (dma_rd_decode),
+		               .rd_data_tclk       ({dma_err, dma_done, dma_busy}));
+	
 	/*** SystemACE I/O control ***/
 	
-	assign sace_mpa = cur_addr_cclk_sclk[8:2];
-	assign sace_mpd_wr = cur_wrdata_cclk_sclk[15:0];
-	assign sace_mpce_n = ~(completed_request_sclk != cur_request_cclk_2a_sclk);
+	/* Each bus cycle is either on behalf of a SPAM request, or of the
+	 * sector DMA.  SPAM requests go first, so that software can still
+	 * get at the SystemACE while a copy is going on.
+	 */
+	reg        cyc = 0;
+	reg        cyc_dma = 0;
+	reg        cyc_r_nw = 0;
+	reg [6:0]  cyc_mpa = 0;
+	reg [15:0] cyc_wrdata = 0;
+	
+	wire       spam_pend = (completed_request_sclk != cur_request_cclk_2a_sclk);
+	wire       dma_want;
+	wire [6:0] dma_mpa;
+	wire       dma_take = !cyc && !spam_pend && dma_want;
+	reg        dma_rd_strobe = 0;
+	reg [15:0] dma_rd_data = 0;
+	
+	assign sace_mpa = cyc_mpa;
+	assign sace_mpd_wr = cyc_wrdata;
+	assign sace_mpce_n = ~cyc;
 	
 	reg [1:0] state = 2'b00;
 	
@@ -178,9 +290,26 @@ module SPAM_SysACE(/*AUTOARG*/
 			sace_mpoe_n <= 1;
 			sace_mpoe_n <= 1;
 			state <= 2'b00;
+			cyc <= 0;
+			cyc_dma <= 0;
+			dma_rd_strobe <= 0;
 		end else begin
-			if (completed_request_sclk != cur_request_cclk_2a_sclk) begin
-				case ({cur_r_nw_cclk_sclk, state})
+			dma_rd_strobe <= 0;
+			if (!cyc) begin
+				if (spam_pend) begin
+					cyc <= 1;
+					cyc_dma <= 0;
+					cyc_r_nw <= cur_r_nw_cclk_sclk;
+					cyc_mpa <= cur_addr_cclk_sclk[8:2];
+					cyc_wrdata <= cur_wrdata_cclk_sclk[15:0];
+				end else if (dma_take) begin
+					cyc <= 1;
+					cyc_dma <= 1;
+					cyc_r_nw <= 1;
+					cyc_mpa <= dma_mpa;
+				end
+			end else begin
+				case ({cyc_r_nw, state})
 				3'b000: begin
 					sace_dowrite_n <= 0;
 					state <= 2'b01;
@@ -196,6 +325,7 @@ module SPAM_SysACE(/*AUTOARG*/
 					sace_mpwe_n <= 1;
 					sace_dowrite_n <= 1;
 					state <= 2'b00;
+					cyc <= 0;
 					completed_request_sclk <= cur_request_cclk_1a_sclk;
 				end
 				3'b100: begin
@@ -206,15 +336,175 @@ module SPAM_SysACE(/*AUTOARG*/
 					state <= 2'b10;
 				end
 				3'b110: begin
-					sace_mpd_rd_l_sclk <= sace_mpd_rd;
+					/* The DMA's reads get their own latch, so
+					 * that they can't trample a SPAM read that
+					 * is still on its way over to clk.
+					 */
+					if (cyc_dma) begin
+						dma_rd_data <= sace_mpd_rd;
+						dma_rd_strobe <= 1;
+					end else begin
+						sace_mpd_rd_l_sclk <= sace_mpd_rd;
+						completed_request_sclk <= cur_request_cclk_1a_sclk;
+					end
 					sace_mpoe_n <= 1;
 					state <= 2'b00;
-					completed_request_sclk <= cur_request_cclk_1a_sclk;
+					cyc <= 0;
 				end
 				endcase
 			end
 		end
-
+	
+	/*** Sector DMA ***/
+	
+	/* The data buffer holds 32 bytes at a time; once DATABUFRDY comes up,
+	 * it can be read out 16 bits at a time.  Two of those make a 64-byte
+	 * block, which goes out as one 8-beat write before the next block gets
+	 * started.
+	 */
+	parameter DS_POLL = 2'b00;
+	parameter DS_READ = 2'b01;
+	parameter DS_SEND = 2'b10;
+	
+	reg [1:0]   dstate = DS_POLL;
+	reg         dma_wait = 0;	/* bus cycle on its way */
+	reg [30:0]  dma_base = 0;
+	reg [7:0]   dma_sectors = 0;
+	reg [30:0]  dma_addr = 0;
+	reg [11:0]  blocks_left = 0;
+	reg [4:0]   rd_n = 0;
+	reg [511:0] blk = 0;
+	reg [23:0]  timeout = 0;	/* bit 23 comes up after a quarter second, or so */
+	
+	assign dma_want = dma_busy && !dma_wait && ((dstate == DS_POLL) || (dstate == DS_READ));
+	assign dma_mpa = (dstate == DS_POLL) ? MPA_STATUS : MPA_DATABUF;
+	
+	/* FSAB credit availability logic */
+	wire trans_start;
+	
+	reg [CREDITS_HI:0] fsab_credits = CREDITS;
+	wire fsab_credit_avail = (fsab_credits != 0);
+	always @(posedge sace_clk or negedge sace_rst_b)
+		if (!sace_rst_b)
+			fsab_credits <= CREDITS;
+		else
+			fsab_credits <= fsab_credits + (sace__fsabo_credit ? 1 : 0) - (trans_start ? 1 : 0);
+	
+	reg        sending = 0;
+	reg [2:0]  beat = 0;
+	
+	assign trans_start = dma_busy && (dstate == DS_SEND) && !sending && fsab_credit_avail;
+	wire       trans_beat = trans_start || sending;
+	wire [2:0] cur_beat = trans_start ? 3'd0 : beat;
+	
+	always @(posedge sace_clk or negedge sace_rst_b)
+		if (!sace_rst_b) begin
+			dstate <= DS_POLL;
+			dma_busy <= 0;
+			dma_done <= 0;
+			dma_err <= 0;
+			dma_wait <= 0;
+			dma_base <= 0;
+			dma_sectors <= 0;
+			sending <= 0;
+			beat <= 0;
+	
+			sace__fsabo_valid <= 0;
+			sace__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+			sace__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+			sace__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+			sace__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+			sace__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+			sace__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+			sace__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+		end else begin
+			if (dma_take)
+				dma_wait <= 1;
+	
+			if (dma_csr_strobe)
+				case (dma_csr_addr)
+				8'h00: dma_base <= {dma_csr_data[30:6], 6'b000000};
+				8'h04: dma_sectors <= dma_csr_data[7:0];
+				8'h08: if (dma_csr_data[0] && !dma_busy) begin
+					dma_busy <= 1;
+					dma_done <= 0;
+					dma_err <= 0;
+					dma_addr <= dma_base;
+					blocks_left <= {(dma_sectors == 0), dma_sectors, 3'b000};
+					rd_n <= 0;
+					timeout <= 0;
+					dstate <= DS_POLL;
+				end
+				default: begin end
+				endcase
+	
+			if (dma_busy)
+				case (dstate)
+				DS_POLL: begin
+					timeout <= timeout + 1;
+					if (dma_rd_strobe) begin
+						dma_wait <= 0;
+						if (dma_rd_data[STATUS_DATABUFRDY]) begin
+							timeout <= 0;
+							dstate <= DS_READ;
+						end else if (timeout[23]) begin
+`ifdef verilator
+							$display("SACE: timed out waiting for the data buffer at %08x", dma_addr);
+`endif
+							dma_busy <= 0;
+							dma_err <= 1;
+						end
+					end
+				end
+				DS_READ: if (dma_rd_strobe) begin
+					dma_wait <= 0;
+					blk[{rd_n, 4'b0000} +: 16] <= dma_rd_data;
+					rd_n <= rd_n + 1;
+					if (rd_n == 5'd31)
+						dstate <= DS_SEND;
+					else if (rd_n[3:0] == 4'hF)
+						dstate <= DS_POLL;
+				end
+				DS_SEND: if (trans_start) begin
+					sending <= 1;
+					beat <= 1;
+				end else if (sending) begin
+					beat <= beat + 1;
+					if (beat == 7) begin
+						sending <= 0;
+						dma_addr <= dma_addr + 64;
+						blocks_left <= blocks_left - 1;
+						dstate <= DS_POLL;
+						if (blocks_left == 1) begin
+							dma_busy <= 0;
+							dma_done <= 1;
+						end
+					end
+				end
+				default: begin end
+				endcase
+	
+			if (trans_beat) begin
+				sace__fsabo_valid <= 1;
+				sace__fsabo_mode <= FSAB_WRITE;
+				sace__fsabo_did <= FSAB_DID;
+				sace__fsabo_subdid <= FSAB_SUBDID;
+				sace__fsabo_addr <= dma_addr;
+				sace__fsabo_len <= 'h8;
+				sace__fsabo_data <= blk[{cur_beat, 6'b000000} +: 64];
+				sace__fsabo_mask <= 8'hFF;
+			end else begin
+				sace__fsabo_valid <= 0;
+				sace__fsabo_mode <= {(FSAB_REQ_HI+1){1'bx}};
+				sace__fsabo_did <= {(FSAB_DID_HI+1){1'bx}};
+				sace__fsabo_subdid <= {(FSAB_DID_HI+1){1'bx}};
+				sace__fsabo_addr <= {(FSAB_ADDR_HI+1){1'bx}};
+				sace__fsabo_len <= {{FSAB_LEN_HI+1}{1'bx}};
+				sace__fsabo_data <= {{FSAB_DATA_HI+1}{1'bx}};
+				sace__fsabo_mask <= {{FSAB_MASK_HI+1}{1'bx}};
+			end
+		end
+	
 	generate
 	if (DEBUG == "TRUE") begin: debug
 		wire [35:0] control0, control1, control2;
@@ -231,6 +521,7 @@ module SPAM_SysACE(/*AUTOARG*/
 			.CLK(sace_clk), // IN
 			.TRIG0({state[1:0], sace_mpce_n, sace_mpoe_n, sace_mpwe_n, sace_mpd_wr[15:0],
 			        sace_mpa[6:0], sace_mpd_rd[15:0], completed_request_sclk, cur_request_cclk_1a_sclk,
+			        cyc, cyc_dma, dma_busy, dstate[1:0], rd_n[4:0], sending,
 			        cur_r_nw_cclk_sclk, sace_mpd_rd_l_sclk[15:0], cur_addr_cclk_sclk[9:0], cur_request_cclk_sclk,
 			        sace_clk_rst_b_sync})
 		);
@@ -258,3 +549,7 @@ module SPAM_SysACE(/*AUTOARG*/
 	endgenerate
 
 endmodule
+
+// Local Variables:
+// verilog-library-directories:("." "../fsab" "../util")
+// End:
@@ -12,3 +12,6 @@ parameter SPAM_DID_AUDIO = 4;
 parameter SPAM_DID_KEYBOARD = 5;
 parameter SPAM_DID_TIMER = 6;
 parameter SPAM_DID_ACCEL = 7;
+parameter SPAM_DID_CORE = 8;
+parameter SPAM_DID_FSAB = 9;
+parameter SPAM_DID_DMA = 10;
@@ -0,0 +1,132 @@
+/* Scanout sink for the Framebuffer.
+ *
+ * The Framebuffer hands us every visible pixel as it goes out, and tells
+ * us when a frame is done and when its DMA FIFO runs dry.  We keep the
+ * frame that's being scanned out, write every Nth one out as a PPM, and
+ * print how long each one took (in both simulated time and wall-clock
+ * time) and how many times it underflowed.
+ *
+ * Environment variables:
+ *   FBSINK_PREFIX=path  write frames to path00000.ppm, path00001.ppm, ...
+ *                       (numbered by frame); without it, nothing gets
+ *                       written, but the stats still get printed
+ *   FBSINK_EVERY=n      only write every nth frame (default 30)
+ *   FBSINK_QUIET=1      only print frames that underflowed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define FBSINK_WIDTH 640
+#define FBSINK_HEIGHT 480
+
+extern double sc_time_stamp();
+
+static unsigned char frame[FBSINK_HEIGHT][FBSINK_WIDTH][3];
+
+static int initted = 0;
+static const char *prefix = NULL;
+static unsigned int every = 30;
+static int quiet = 0;
+
+static unsigned int frames = 0;
+static unsigned int underflows = 0;
+static unsigned int total_underflows = 0;
+static double last_stamp = 0;
+static double first_wall = 0, last_wall = 0;
+
+static double fbsink_wall()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void fbsink_summary()
+{
+	double wall = last_wall - first_wall;
+
+	printf("FBSINK: %u frames, %u underflows", frames, total_underflows);
+	if (frames > 1 && wall > 0)
+		printf(", %.3f frames/s wall-clock", (frames - 1) / wall);
+	printf("\n");
+}
+
+static void fbsink_init()
+{
+	const char *s;
+
+	initted = 1;
+	prefix = getenv("FBSINK_PREFIX");
+	if ((s = getenv("FBSINK_EVERY")) && atoi(s) > 0)
+		every = atoi(s);
+	quiet = getenv("FBSINK_QUIET") != NULL;
+
+	atexit(fbsink_summary);
+}
+
+static void fbsink_write(unsigned int n)
+{
+	char fn[1024];
+	FILE *fp;
+
+	snprintf(fn, sizeof(fn), "%s%05u.ppm", prefix, n);
+	fp = fopen(fn, "wb");
+	if (!fp) {
+		perror("FBSINK: open frame");
+		return;
+	}
+	fprintf(fp, "P6\n%d %d\n255\n", FBSINK_WIDTH, FBSINK_HEIGHT);
+	fwrite(frame, sizeof(frame), 1, fp);
+	fclose(fp);
+}
+
+/* rgb is 0x00RRGGBB. */
+void fbsink_pixel(unsigned int x, unsigned int y, unsigned int rgb)
+{
+	if (x >= FBSINK_WIDTH || y >= FBSINK_HEIGHT)
+		return;
+
+	frame[y][x][0] = (rgb >> 16) & 0xFF;
+	frame[y][x][1] = (rgb >> 8) & 0xFF;
+	frame[y][x][2] = rgb & 0xFF;
+}
+
+void fbsink_underflow(unsigned int x, unsigned int y)
+{
+	if (!initted)
+		fbsink_init();
+
+	if (underflows == 0)
+		printf("FBSINK: frame %u: underflow at x %u, y %u\n", frames, x, y);
+	underflows++;
+	total_underflows++;
+}
+
+/* Called as the last visible line finishes. */
+void fbsink_frame()
+{
+	double stamp = sc_time_stamp();
+	double wall;
+
+	if (!initted)
+		fbsink_init();
+
+	wall = fbsink_wall();
+	if (frames == 0)
+		first_wall = last_wall = wall;
+	if (!quiet || underflows)
+		printf("FBSINK: frame %u done at %.0f (+%.0f; %.3fs wall-clock), %u underflows\n",
+		       frames, stamp, stamp - last_stamp, wall - last_wall, underflows);
+
+	if (prefix && (frames % every) == 0)
+		fbsink_write(frames);
+
+	last_stamp = stamp;
+	last_wall = wall;
+	underflows = 0;
+	frames++;
+}
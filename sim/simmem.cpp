@@ -0,0 +1,164 @@
+/* Backing store for FSABSimMemory.
+ *
+ * Memory is kept in pages that get allocated the first time that they're
+ * touched, so the whole address space can be as big as we like without
+ * costing anything until the program actually uses it.
+ *
+ * Environment variables:
+ *   SIMMEM_INIT=file   map file in as the initial contents of memory,
+ *                      starting at address 0 (copy-on-write; the file is
+ *                      never modified)
+ *   SIMMEM_DUMP=file   on exit, write out every page that was touched, at
+ *                      its offset in file; untouched pages become holes
+ *
+ * On exit, we also print how many beats went each way, out of how many
+ * memory clocks, which is what utils/credit_sweep.sh looks at.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SIMMEM_PAGE_BITS 12
+#define SIMMEM_PAGE_SIZE (1 << SIMMEM_PAGE_BITS)
+
+static unsigned char **pages = NULL;
+static unsigned int npages = 0;
+static unsigned int memmask = 0;
+
+static unsigned char *initmap = NULL;
+static size_t initsize = 0;
+
+static unsigned long long ticks = 0;
+static unsigned long long rd_beats = 0;
+static unsigned long long wr_beats = 0;
+
+static void simmem_stats()
+{
+	if (!ticks)
+		return;
+	printf("SIMMEM: %llu read beats, %llu write beats in %llu cycles (%.1f%% busy, %.3f bytes/cycle)\n",
+	       rd_beats, wr_beats, ticks,
+	       100.0 * (rd_beats + wr_beats) / ticks, 8.0 * (rd_beats + wr_beats) / ticks);
+}
+
+static void simmem_dump()
+{
+	const char *fn = getenv("SIMMEM_DUMP");
+	unsigned int i;
+	int fd;
+
+	if (!fn)
+		return;
+
+	fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror("SIMMEM: open dump file");
+		return;
+	}
+
+	for (i = 0; i < npages; i++)
+		if (pages[i] && pwrite(fd, pages[i], SIMMEM_PAGE_SIZE, (off_t)i * SIMMEM_PAGE_SIZE) != SIMMEM_PAGE_SIZE) {
+			perror("SIMMEM: write dump file");
+			close(fd);
+			return;
+		}
+	if (ftruncate(fd, (off_t)npages * SIMMEM_PAGE_SIZE) < 0) {
+		perror("SIMMEM: truncate dump file");
+		close(fd);
+		return;
+	}
+	close(fd);
+	printf("SIMMEM: dumped memory to %s\n", fn);
+}
+
+/* size must be a power of two. */
+void simmem_init(unsigned int size)
+{
+	const char *fn = getenv("SIMMEM_INIT");
+
+	npages = size >> SIMMEM_PAGE_BITS;
+	memmask = size - 1;
+	pages = (unsigned char **)calloc(npages, sizeof(*pages));
+
+	if (fn) {
+		struct stat st;
+		int fd = open(fn, O_RDONLY);
+
+		if (fd < 0 || fstat(fd, &st) < 0) {
+			perror("SIMMEM: open init file");
+			exit(1);
+		}
+		initsize = st.st_size;
+		if (initsize > size)
+			initsize = size;
+		initmap = (unsigned char *)mmap(NULL, initsize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (initmap == MAP_FAILED) {
+			perror("SIMMEM: mmap init file");
+			exit(1);
+		}
+		close(fd);
+		printf("SIMMEM: %s mapped at 0x00000000 (%zu bytes)\n", fn, initsize);
+	}
+
+	atexit(simmem_dump);
+	atexit(simmem_stats);
+}
+
+static unsigned char *simmem_page(unsigned int addr)
+{
+	unsigned int pg = (addr & memmask) >> SIMMEM_PAGE_BITS;
+	size_t ofs = (size_t)pg * SIMMEM_PAGE_SIZE;
+
+	if (pages[pg])
+		return pages[pg];
+
+	/* Pages that are entirely inside the init file just point into the
+	 * (private) mapping; the kernel copies them when we write to them.
+	 */
+	if (ofs + SIMMEM_PAGE_SIZE <= initsize) {
+		pages[pg] = initmap + ofs;
+		return pages[pg];
+	}
+
+	pages[pg] = (unsigned char *)calloc(1, SIMMEM_PAGE_SIZE);
+	if (ofs < initsize)
+		memcpy(pages[pg], initmap + ofs, initsize - ofs);
+	return pages[pg];
+}
+
+/* addr is a byte address, and is rounded down to a 64-bit word. */
+unsigned long long simmem_read(unsigned int addr)
+{
+	unsigned long long d;
+
+	memcpy(&d, simmem_page(addr) + (addr & (SIMMEM_PAGE_SIZE - 8)), 8);
+	return d;
+}
+
+/* Called once per memory clock, with whether a read beat went back out,
+ * and whether a write beat got written.
+ */
+void simmem_tick(int rd, int wr)
+{
+	ticks++;
+	if (rd)
+		rd_beats++;
+	if (wr)
+		wr_beats++;
+}
+
+/* Bit n of mask enables byte n of data. */
+void simmem_write(unsigned int addr, unsigned long long data, unsigned int mask)
+{
+	unsigned char *p = simmem_page(addr) + (addr & (SIMMEM_PAGE_SIZE - 8));
+	int i;
+
+	for (i = 0; i < 8; i++)
+		if (mask & (1 << i))
+			p[i] = (data >> (i * 8)) & 0xFF;
+}
@@ -58,13 +58,19 @@ double sc_time_stamp ()
 	return main_time / 4.0f;
 }
 
+/* SIM_CYCLES=n stops the simulation after n core clocks, so that runs
+ * can be compared against each other (see utils/credit_sweep.sh).
+ */
 int main()
 {
+	const char *s = getenv("SIM_CYCLES");
+	double limit = s ? atof(s) : 0;
+
 	top = new Vsystem;
 	
 	top->clk = 0;
 	top->fsabi_clk = 0;
-	while (!Verilated::gotFinish())
+	while (!Verilated::gotFinish() && (limit == 0 || sc_time_stamp() < limit))
 	{
 		if (main_time % 2)
 			top->clk = !top->clk;
@@ -1,4 +1,5 @@
 #include "minilib.h"
+#include "sysace.h"
 
 #define FB_START 0x800000
 
@@ -182,7 +183,7 @@ void systemace_boot()
 		return;
 	}
 	
-	if (sysace_readsec(0, (unsigned char *)ptab) < 0)
+	if (sysace_readsec(0, (unsigned int *)ptab) < 0)
 	{
 		puts("  partition table read failed; aborting boot");
 		return;
@@ -231,14 +232,16 @@ void systemace_boot()
 	if (lbasize > 1024)	/* 512kbyte max */
 		lbasize = 1024;
 	
-	for (i = 0; i < lbasize; i++)
+	for (i = 0; i < lbasize; i += SYSACE_MAX_SECTORS)
 	{
-		if (sysace_readsec(lbastart + i, dest) < 0)
+		int n = (lbasize - i > SYSACE_MAX_SECTORS) ? SYSACE_MAX_SECTORS : (lbasize - i);
+		
+		if (sysace_readsecs(lbastart + i, dest, n) < 0)
 		{
 			puts("  sector read failed; aborting boot");
 			return;
 		}
-		dest += 512;
+		dest += n * 512;
 	}
 	
 	puts("Starting boot1.");
@@ -137,7 +137,7 @@ void main()
 		if ((i % 64) == 0)
 			printf("iters: %d, i %% 100 = %d, clock cycles: %d\r\n", i, ((unsigned int)i) % 100U, *num_clock_cycles);
 		for (y = 0; y < 448; y += 64)
-			accel_blit(start + y * 640 + x, r->pixels, r->w, r->h);
+			accel_blit(start + y * 640 + x, 640, r->pixels, r->w, r->w, r->h, BLIT_MODE_ALPHA(1));
 		x += 16;
 		if (x == 512)
 			x = 0;	
@@ -6,11 +6,18 @@
 #include "malloc.h"
 #include "multibuf.h"
 #include "imgres.h"
+#include "tcm.h"
 
 #define MAX_QBEATS 50000
 #define SCREEN_WIDTH 640
 #define SCREEN_HEIGHT 480
 
+/* Everything that the game draws while a song is playing lands in here, so
+ * nothing else needs clearing from one frame to the next.
+ */
+#define PLAYFIELD_X 16
+#define PLAYFIELD_W 320
+
 /* SCORES (higher number = worse result)*/
 #define MARVELOUS 1
 #define PERFECT 2
@@ -52,7 +59,8 @@ int misses;
 
 #define MAX(x,y) ((x) > (y)) ? (x) : (y)
 
-static unsigned char chars[] = {
+/* Glyphs get hit once per pixel when drawing text, so keep them close. */
+static unsigned char chars[] __tcm = {
 #include "chars.inc"
 };
 
@@ -109,17 +117,8 @@ int load_steps(struct fat16_handle * h, struct stepfile * song, char * filename)
 
 void cons_drawchar_with_scale_3(unsigned int *buf, int c, int x, int y, int fg, int bg)
 {
-	int xx, yy;
-	int i, j;
-	buf = buf + (y*SCREEN_WIDTH+x);
-	
-	for (yy = 0; yy < 8; yy++) 
-		for (xx = 0; xx < 8; xx++) 
-			for (i = 0; i < 3; i++) {
-				for (j = 0; j < 3; j++)
-					buf[(yy*3+j) * SCREEN_WIDTH + (7 - (xx*3+i))] = ((chars[c*8 + yy] >> xx) & 1) ? fg : bg;
-				audio_samples_played();
-			}
+	/* The glyph's right-hand column lands at x+7, as it always has. */
+	accel_glyph(buf + y*SCREEN_WIDTH + x - 16, SCREEN_WIDTH, &chars[(c & 0xFF) * 8], fg, bg, 3);
 }
 
 multibuf_t *bufs;
@@ -133,6 +132,11 @@ void splat_text(unsigned int *buf, char* string, int x, int y, int fg, int bg)
 	}
 }
 
+/* Number of buffers that still have something other than the loading
+ * screen in them; set this before the first splat_loading().
+ */
+static int splat_loading_dirty = 3;
+
 void splat_loading()
 {
 	int i;
@@ -143,10 +147,22 @@ void splat_loading()
 	{
 		buf = multibuf_flip(bufs);
 	}
-	
+
 	printf(".");
+
+	/* Nobody would see another frame yet, and flipping would just wait
+	 * for the last one; get back to loading instead.
+	 */
+	if (multibuf_flip_pending(bufs) && !splat_loading_dirty)
+		return;
 	
-	accel_fill(buf, 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+	/* After a full clear, only the text changes. */
+	if (splat_loading_dirty)
+	{
+		accel_fill(buf, 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+		splat_loading_dirty--;
+	} else
+		accel_fill_rect(buf + 300*SCREEN_WIDTH + 200-16, 0x00000000, 24*10, 24, SCREEN_WIDTH);
 
 	cons_drawchar_with_scale_3(buf, (int)'L', 200+24*0, 300, gencol(c+10), 0x000000);
 	cons_drawchar_with_scale_3(buf, (int)'o', 200+24*1, 300, gencol(c+20), 0x000000);
@@ -164,52 +180,90 @@ void splat_loading()
 
 }
 
-unsigned int *load_audio(struct fat16_handle *h, int *length, char *filename, void **buf)
+/* The song streams in from the card through a ring while it plays, so we
+ * only have to wait for the first little bit of it before starting.
+ */
+#define STREAM_RING_LEN (128*1024)
+#define STREAM_PREFILL (16*1024)
+#define STREAM_CHUNK 8192
+#define STREAM_WATERMARK (32*1024)
+
+static struct fat16_file audio_fd;
+
+/* Songs can come packed, to save on card space and reads; the first of
+ * these that's there gets played.
+ */
+static const struct {
+	char ext[4];
+	int fmt;
+} audio_exts[] = {
+	{ "IMA", AUDIO_FMT_IMA_ADPCM },
+	{ "RAW", AUDIO_FMT_S16_STEREO },
+};
+
+/* filename is 8.3, without the dot; the extension gets filled in. */
+void *open_audio(struct fat16_handle *h, char *filename)
 {
-	int rv;
-	int len, tlen;
-	struct fat16_file fd;
-	unsigned int *p;
+	void *p;
+	int i;
 	
-	printf("Opening %s... ", filename);
-	if (fat16_open_by_name(h, &fd, filename) == -1)
+	for (i = 0; i < sizeof(audio_exts) / sizeof(audio_exts[0]); i++)
 	{
+		memcpy(filename+8, audio_exts[i].ext, 4);
+		printf("Opening %s... ", filename);
+		if (fat16_open_by_name(h, &audio_fd, filename) != -1)
+			break;
 		printf("not found?\r\n");
+	}
+	if (i == sizeof(audio_exts) / sizeof(audio_exts[0]))
 		return NULL;
-	} 
 	
-	p = malloc(fd.len + 64);
+	p = malloc(STREAM_RING_LEN + 64);
 	if (!p)
 	{
-		printf("malloc(%d) failed!\n", fd.len + 64);
+		printf("malloc(%d) failed!\n", STREAM_RING_LEN + 64);
 		return NULL;
 	}
-	if (buf)
-		*buf = p;
+	printf("streaming %d bytes\r\n", audio_fd.len);
 	
-	p = (unsigned int *)(((unsigned int)p + 64) & ~63);
+	audio_format_set(audio_exts[i].fmt);
+	audio_stream_start((void *)(((unsigned int)p + 64) & ~63), STREAM_RING_LEN, STREAM_WATERMARK);
 	
-	len = fd.len;
-	tlen = 0;
-	while (len)
-	{
-		int thislen = (len > 16384) ? 16384 : len;
-		rv = fat16_read(&fd, ((void*)p) + tlen, thislen);
-		if (rv != thislen)
+	return p;
+}
+
+/* Reads a chunk into the ring (or more than one, if it's getting low).
+ * Returns 1 once the whole song has gone in.
+ */
+int stream_audio()
+{
+	int want, room, rv;
+	void *p;
+	
+	do {
+		/* The DMA only deals in whole 64-byte blocks. */
+		want = (audio_fd.len - audio_fd.pos) & ~63;
+		if (!want)
+			return 1;
+		
+		p = audio_stream_space(&room);
+		if (want > room)
+			want = room;
+		if (want > STREAM_CHUNK)
+			want = STREAM_CHUNK;
+		if (!want)
+			return 0;
+		
+		rv = fat16_read(&audio_fd, p, want);
+		if (rv != want)
 		{
 			printf("short read?\r\n");
-			return NULL;
+			return 1;
 		}
-		splat_loading();
-		tlen += rv;
-		len -= rv;
-	}
-	printf("loaded! (%d bytes)\r\n", tlen);
-	
-	if (length)
-		*length = tlen;
+		audio_stream_commit(rv);
+	} while (audio_stream_low());
 	
-	return p;
+	return 0;
 }
 
 
@@ -402,6 +456,37 @@ struct img_resource *down_spot[2];
 
 struct img_resource *fantastic, *perfect, *great, *good, *boo, *miss;
 
+/* Sound effects get mixed in on top of the song by the hardware. */
+#define VOICE_HIT 0
+
+struct sound {
+	void *samples;	/* 64-byte aligned */
+	int len;
+};
+
+struct sound hit_sound;
+
+void sound_load(struct fat16_handle *h, struct sound *snd, char *filename)
+{
+	struct fat16_file fd;
+	void *p;
+	
+	snd->samples = NULL;
+	snd->len = 0;
+	if (fat16_open_by_name(h, &fd, filename) == -1)
+		return;
+	
+	p = malloc(fd.len + 64);
+	if (!p)
+		return;
+	p = (void *)(((unsigned int)p + 64) & ~63);
+	if (fat16_read(&fd, p, fd.len) != fd.len)
+		return;
+	
+	snd->samples = p;
+	snd->len = fd.len;
+}
+
 void res_load(struct fat16_handle *h)
 {
 	int i, j;
@@ -462,6 +547,9 @@ void res_load(struct fat16_handle *h)
 	good =      img_load(h, "GRGOOD  RES");
 	boo =       img_load(h, "GRBOO   RES");
 	miss =      img_load(h, "GRMISS  RES");
+	
+	/* Optional; the game's just quieter without it. */
+	sound_load(h, &hit_sound, "HIT     RAW");
 }
 
 void game(struct fat16_handle * h, char * prefix)
@@ -473,19 +561,18 @@ void game(struct fat16_handle * h, char * prefix)
 	boos = 0;
 	misses = 0;
 	int i, j;
-	int length;
 	int rv;
+	int streamed;
 	volatile int* cycles = 0x86000000;
 	char fname[12];
 	void *orig;
 
-	unsigned int *audio_mem_base;
-	
 	/* Set up graphics. */
 	unsigned int *buf;
 	
 	/* Load music. */
 	
+	splat_loading_dirty = 3;
 	splat_loading();
 
 	memcpy(fname, prefix, 8);
@@ -498,18 +585,22 @@ void game(struct fat16_handle * h, char * prefix)
 		return;
 	}
 
-	memcpy(fname+8, "RAW", 4);
-
-	audio_mem_base = load_audio(h, &length, fname, &orig);
-	if (!audio_mem_base) {
+	orig = open_audio(h, fname);
+	if (!orig) {
 		printf("Failure loading audio! (%d)\r\n", rv);
 		return;
 	}
+	
+	streamed = 0;
+	for (i = 0; (i < STREAM_PREFILL / STREAM_CHUNK) && !streamed; i++) {
+		streamed = stream_audio();
+		splat_loading();
+	}
 
 
 	printf("qbeats: %d; samps_per_qbeat: %d; playing...\r\n", song.len_qbeats, song.samps_per_qbeat);
 
-	audio_play(audio_mem_base, length, AUDIO_MODE_ONCE);
+	audio_stream_go();
 
 	volatile unsigned int * scancodeaddr = 0x85000000;
 	unsigned int scancode;
@@ -526,10 +617,20 @@ void game(struct fat16_handle * h, char * prefix)
 	int last_hit = NONE;
 	int prev_cycle = *cycleaddr;
 	int curr_cycle = *cycleaddr;
+	struct img_resource *judgement = NULL, *judgement_shown = NULL;
+	int judgement_sprites = 0;
 	buf = multibuf_flip(bufs);
+	multibuf_clear_stats();
 	offset = SAMPLE_TO_VIDEO_OFFSET;
-
-	while (!is_audio_done(length)) {
+	
+	/* Only the playfield gets cleared from here on in, so get rid of the
+	 * loading screen everywhere first.
+	 */
+	accel_fill(bufs->bufs[0], 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+	accel_fill(bufs->bufs[1], 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+	accel_fill(bufs->bufs[2], 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+
+	while (!streamed || !audio_stream_drained()) {
 		signed int qbeat, rem, qbeat_round;
 		char datum;
 		int i;
@@ -540,6 +641,9 @@ void game(struct fat16_handle * h, char * prefix)
 		int samples_played;
 		int s;
 		
+		if (!streamed)
+			streamed = stream_audio();
+		
 		curr_cycle = *cycleaddr;
 		/*printf("Cycles: %d\r\n", curr_cycle-prev_cycle);*/
 		prev_cycle = curr_cycle;
@@ -550,7 +654,7 @@ void game(struct fat16_handle * h, char * prefix)
 		if (hit == NONE)	
 			hit = check_hit(qbeat_round, rem);
 
-		accel_fill(buf, 0x00000000, SCREEN_WIDTH*SCREEN_HEIGHT);
+		accel_queue_fill_rect(buf + PLAYFIELD_X, 0x00000000, PLAYFIELD_W, SCREEN_HEIGHT, SCREEN_WIDTH);
 		
 		samples_played = audio_samples_played()+offset;
 		qbeat = (samples_played-song.delay_samps-1600)/song.samps_per_qbeat;
@@ -589,39 +693,58 @@ void game(struct fat16_handle * h, char * prefix)
 		}
 		if (hit == NONE)
 			hit = last_hit;
-		else
+		else {
 			last_hit = hit;
+			if ((hit != MISS) && hit_sound.samples)
+				audio_voice_play(VOICE_HIT, hit_sound.samples, hit_sound.len, AUDIO_VOL_UNITY, 0);
+		}
 
+		/* The judgement goes up on the hardware sprites, so it only
+		 * needs touching when it changes -- unless it doesn't fit on
+		 * them, in which case it gets blitted every frame like before.
+		 */
 		switch (hit) {
 			case MARVELOUS:
-				bitblt(buf, 32, 200, fantastic);
+				judgement = fantastic;
 				break;
 			case PERFECT:	
-				bitblt(buf, 32, 200, perfect);
+				judgement = perfect;
 				break;
 			case GREAT:
-				bitblt(buf, 32, 200, great);
+				judgement = great;
 				break;
 			case GOOD:
-				bitblt(buf, 32, 200, good);
+				judgement = good;
 				break;
 			case BOO:
-				bitblt(buf, 32, 200, boo);
+				judgement = boo;
 				break;
 			case MISS: 
-				bitblt(buf, 32, 200, miss);
+				judgement = miss;
 				break;
 			default:
+				judgement = NULL;
 				break;
 		}
+		if (judgement != judgement_shown) {
+			sprite_hide(0, MULTIBUF_SPRITES);
+			judgement_sprites = judgement ? sprite_show(0, 32, 200, judgement) : 0;
+			judgement_shown = judgement;
+		}
+		if (judgement && !judgement_sprites)
+			bitblt(buf, 32, 200, judgement);
 		hit = check_hit();
 		
 		buf = multibuf_flip(bufs);
 	}
 
+	sprite_hide(0, MULTIBUF_SPRITES);
+	audio_stop();
+
 	/* show score */
 	
 	printf("MARVELOUSES: %d, PERFECTS: %d, GREATS: %d, GOODS: %d, BOOS: %d, MISSES: %d\r\n", marvelouses, perfects, greats, goods, boos, misses);
+	printf("Scanout: %d underflows, FIFO low-water mark %d words\r\n", multibuf_underflows(), multibuf_fifo_min());
 
 	char str_buf[40];
 	int score_x = 175;
@@ -1,6 +1,8 @@
 #include "fat16.h"
 #include "imgres.h"
 #include "minilib.h"
+#include "accel.h"
+#include "multibuf.h"
 
 #define SCREEN_WIDTH 640
 
@@ -48,58 +50,46 @@ struct img_resource *img_load(struct fat16_handle *h, char *name)
 }
 
 void bitblt(unsigned int *fb, unsigned int x0, unsigned int y0, struct img_resource *r) {
-	int x, y;
-	unsigned int *buf;
-	
 	if (((x0 + r->w) > 640) || ((y0 + r->h) > 480))
 	{
 		/*printf("BOUNDS CHECK!\r\n");*/
 		return;
 	}
 	
-	if (((r->w & 63) == 0) && ((x0 & 15) == 0))
-	{
-		/* we can take the fast path! */
-		accel_blit(fb + y0 * 640 + x0, r->pixels, r->w, r->h);
-		return;
-	}
+	/* Anything with any alpha at all gets drawn. */
+	accel_queue_blit(fb + y0 * SCREEN_WIDTH + x0, SCREEN_WIDTH, r->pixels, r->w, r->w, r->h, BLIT_MODE_ALPHA(1));
+}
+
+/* Puts an image up on the hardware sprites, starting with sprite first;
+ * anything wider than a sprite gets split across as many as it takes.
+ * Returns the number of sprites used, or 0 if the image can't go on the
+ * sprites at all: the pitch has to be a multiple of 8 bytes (so, an even
+ * number of pixels), and there have to be enough sprites left to cover
+ * the whole width.  In that case, the caller has to blit it instead.
+ */
+int sprite_show(unsigned int first, int x0, int y0, struct img_resource *r)
+{
+	unsigned int n = first;
+	unsigned int x, w;
 	
-	printf("*** had to take the slow path (%d, %d)\r\n", r->w & 63, x0 & 15);
+	if ((r->w & 1) || (first >= MULTIBUF_SPRITES) ||
+	    (r->w > (MULTIBUF_SPRITES - first) * MULTIBUF_SPRITE_W_MAX))
+		return 0;
 	
-	buf = r->pixels;
-	for (y = 0; y < r->h; y++) {
-		for (x = 0; x < r->w; x+=8) {
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+0)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+1)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+2)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+3)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+4)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+5)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+6)] = *buf;
-			buf++;
-			
-			if (*buf & 0x000000FF)
-				fb[SCREEN_WIDTH*(y0+y)+(x0+x+7)] = *buf;
-			buf++;
-		}
+	for (x = 0; x < r->w; x += w, n++)
+	{
+		w = r->w - x;
+		if (w > MULTIBUF_SPRITE_W_MAX)
+			w = MULTIBUF_SPRITE_W_MAX;
+		multibuf_sprite_move(n, x0 + x, y0);
+		multibuf_sprite_set(n, r->pixels + x, r->w, w, r->h, BLIT_MODE_ALPHA(1));
 	}
+	
+	return n - first;
+}
+
+void sprite_hide(unsigned int first, unsigned int count)
+{
+	while (count--)
+		multibuf_sprite_hide(first++);
 }
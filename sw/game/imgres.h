@@ -11,5 +11,7 @@ struct img_resource
 
 extern struct img_resource *img_load(struct fat16_handle *h, char *name);
 extern void bitblt(unsigned int *fb, unsigned int x0, unsigned int y0, struct img_resource *r);
+extern int sprite_show(unsigned int first, int x0, int y0, struct img_resource *r);
+extern void sprite_hide(unsigned int first, unsigned int count);
 
 #endif
@@ -1,4 +1,6 @@
 #include "minilib.h"
+#include "region.h"
+#include "accel.h"
 
 /* GIMP RGBA C-Source image dump (Down Tap Note 4th 4x1.c) */
 
@@ -758,56 +760,25 @@ static const struct {
 
 void main()
 {
-	int i, j;
 	unsigned int *start_d = 0x00100000;
-	unsigned int *d;
 	unsigned int *num_clock_cycles = 0x86000000;
 	int x = 100;
 	int y = 0;
-	int index = 0;
-	int pixel_data;
-	volatile int test = 0;
+	
+	/* The framebuffer is only ever written, so stream it out. */
+	region_set(0, 0x00100000, 2*1024*1024, REGION_WC);
+	
 	while(1) {
 		for (y = 0; y < 300; y++) {
-			index = 0;
-			d = start_d + y*640+x;
-			for (i = 0; i < gimp_image.height; i++){
-				for (j = 0; j < gimp_image.width; j+=4) {
-					pixel_data = ((int*)gimp_image.pixel_data)[index];
-					if ((gimp_image.pixel_data[index*4+3]) == 0xFF)
-						*(d) = pixel_data; 
-					d++;
-					index++;
-					pixel_data = ((int*)gimp_image.pixel_data)[index];
-					if ((gimp_image.pixel_data[index*4+3]) == 0xFF)
-						*(d) = pixel_data; 
-					d++;
-					index++;
-					pixel_data = ((int*)gimp_image.pixel_data)[index];
-					if ((gimp_image.pixel_data[index*4+3]) == 0xFF)
-						*(d) = pixel_data; 
-					d++;
-					index++;
-					pixel_data = ((int*)gimp_image.pixel_data)[index];
-					if ((gimp_image.pixel_data[index*4+3]) == 0xFF)
-						*(d) = pixel_data; 
-					d++;
-					index++;
-				}
-				d += (640-gimp_image.width);
-			}
-			d = start_d + y*640+x;
-			for (i = 0; i < gimp_image.height; i++){
-				for (j = 0; j < gimp_image.width; j+=4) {
-					*(d++) = 0x00000000; 
-					*(d++) = 0x00000000; 
-					*(d++) = 0x00000000; 
-					*(d++) = 0x00000000; 
-				}
-				d += (640-gimp_image.width);
-			}
+			/* Only the opaque parts of the arrow get drawn; GIMP
+			 * puts the alpha in the last byte of each pixel.
+			 */
+			accel_blit(start_d + y*640+x, 640,
+			           (unsigned int *)gimp_image.pixel_data, gimp_image.width,
+			           gimp_image.width, gimp_image.height,
+			           BLIT_MODE_ALPHA(0xFF) | BLIT_MODE_ALPHA_HI);
+			accel_fill_rect(start_d + y*640+x, 0x00000000, gimp_image.width, gimp_image.height, 640);
 		}
 		printf("Number of clock cycles: %x\r\n", *num_clock_cycles);
 	}
 }
-
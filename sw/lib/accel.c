@@ -3,16 +3,35 @@
 
 #define P(x) (*(volatile unsigned int *)(x))
 
+/* Command ring; each command is 8 words. */
+#define ACCEL_RING_CMDS 64
+static volatile unsigned int accel_ring[ACCEL_RING_CMDS * 8] __attribute__((aligned(32)));
+static unsigned int accel_ring_head = 0;
+static int accel_ring_up = 0;
+
 void accel_fill(unsigned int *base, unsigned int value, unsigned int words)
 {
-	if (words % 8)
-		printf("ACCEL: fill word count not multiple of 2\r\n");
+	/* A one-row rectangle takes care of any odd ends. */
+	accel_fill_rect(base, value, words, 1, 0);
+}
+
+/* w and h are in pixels, and pitch is the number of pixels from the start
+ * of one row to the start of the next.
+ */
+void accel_fill_rect(unsigned int *base, unsigned int value, unsigned int w, unsigned int h, unsigned int pitch)
+{
+	accel_queue_wait();
+	
+	if ((unsigned int)base & 3)
+		printf("ACCEL: fill alignment incorrect\r\n");
 	
 	P(FILL_VALUE) = value;
 	P(FILL_ADDR) = (unsigned int)base;
-	P(FILL_LENREM) = words / 2;
+	P(FILL_WIDTH) = w;
+	P(FILL_STRIDE) = pitch * 4;
+	P(FILL_ROWS) = h;
 	
-	while (P(FILL_LENREM) != 0)
+	while (P(FILL_ROWS) != 0)
 	{
 		int i;
 		
@@ -21,29 +40,147 @@ void accel_fill(unsigned int *base, unsigned int value, unsigned int words)
 	}
 }
 
-void accel_blit(unsigned int *dest, unsigned int *src, unsigned int w, unsigned int h)
+/* Draws an 8x8 1-bpp bitmap (one byte per row, most significant bit on
+ * the left), with each bit blown up to a scale-by-scale square.
+ */
+void accel_glyph(unsigned int *dest, unsigned int pitch, const unsigned char *bits,
+                 unsigned int fg, unsigned int bg, unsigned int scale)
+{
+	unsigned int size = (scale & 0xF) * 8;
+	
+	accel_queue_wait();
+	
+	if ((unsigned int)dest & 3)
+		printf("ACCEL: glyph alignment incorrect\r\n");
+	
+	P(FILL_VALUE) = bg;
+	P(FILL_FG) = fg;
+	P(FILL_BITMAP0) = bits[0] | (bits[1] << 8) | (bits[2] << 16) | (bits[3] << 24);
+	P(FILL_BITMAP1) = bits[4] | (bits[5] << 8) | (bits[6] << 16) | (bits[7] << 24);
+	P(FILL_EXPAND) = scale;
+	P(FILL_ADDR) = (unsigned int)dest;
+	P(FILL_WIDTH) = size;
+	P(FILL_STRIDE) = pitch * 4;
+	P(FILL_ROWS) = size;
+	
+	while (P(FILL_ROWS) != 0)
+		;
+	
+	/* Leave plain fills (including queued ones) alone. */
+	P(FILL_EXPAND) = 0;
+}
+
+void accel_blit(unsigned int *dest, unsigned int dpitch, unsigned int *src, unsigned int spitch,
+                unsigned int w, unsigned int h, unsigned int mode)
 {
-	int packets = (w / 16) * h;
+	accel_queue_wait();
 	
-	if (w % 16)
-		printf("ACCEL: blit width not multiple of 16 pxls\r\n");
-	if ((unsigned int)dest & 63)
+	if ((unsigned int)dest & 3)
 		printf("ACCEL: destination alignment for blit incorrect\r\n");
-	if ((unsigned int)src & 63)
+	if ((unsigned int)src & 3)
 		printf("ACCEL: source alignment for blit incorrect\r\n");
 	
-	P(BLIT_WRADDR) = (unsigned int)dest;
-	P(BLIT_WRROWL) = w / 16;
-	P(BLIT_WRROWS) = 640 * 4;
-	P(BLIT_WRDONE) = 0;
-	
 	P(BLIT_RDADDR) = (unsigned int)src;
-	P(BLIT_RDLEN) = packets;
+	P(BLIT_WRADDR) = (unsigned int)dest;
+	P(BLIT_WIDTH) = w;
+	P(BLIT_WRSTRIDE) = dpitch * 4;
+	P(BLIT_RDSTRIDE) = spitch * 4;
+	P(BLIT_MODE) = mode;
+	P(BLIT_ROWS) = h;
 	
-	while (P(BLIT_WRDONE) != packets)
+	while (P(BLIT_ROWS) != 0)
 	{
 		int i;
 		for (i = 0; i < 10; i++)
 			P(BLIT_RDADDR);	/* times out */
 	}
 }
+
+static volatile unsigned int *accel_queue_slot()
+{
+	unsigned int next;
+	
+	if (!accel_ring_up)
+	{
+		P(CMDQ_RING) = (unsigned int)accel_ring;
+		P(CMDQ_SIZE) = ACCEL_RING_CMDS;
+		accel_ring_head = 0;
+		accel_ring_up = 1;
+	}
+	
+	/* Leave one slot empty, so that a full ring doesn't look empty. */
+	next = (accel_ring_head + 1) % ACCEL_RING_CMDS;
+	while (P(CMDQ_TAIL) == next)
+		;
+	
+	return &accel_ring[accel_ring_head * 8];
+}
+
+static void accel_queue_push()
+{
+	/* The ring is write-through cached, so the command is already in
+	 * memory by the time that the head pointer moves.
+	 */
+	accel_ring_head = (accel_ring_head + 1) % ACCEL_RING_CMDS;
+	P(CMDQ_HEAD) = accel_ring_head;
+}
+
+void accel_queue_fill(unsigned int *base, unsigned int value, unsigned int words)
+{
+	accel_queue_fill_rect(base, value, words, 1, 0);
+}
+
+void accel_queue_fill_rect(unsigned int *base, unsigned int value, unsigned int w, unsigned int h, unsigned int pitch)
+{
+	volatile unsigned int *cmd = accel_queue_slot();
+	
+	if ((unsigned int)base & 3)
+		printf("ACCEL: fill alignment incorrect\r\n");
+	
+	cmd[0] = CMDQ_OP_RECT;
+	cmd[1] = value;
+	cmd[2] = (unsigned int)base;
+	cmd[3] = 0;
+	cmd[4] = w;
+	cmd[5] = pitch * 4;
+	cmd[6] = h;
+	accel_queue_push();
+}
+
+void accel_queue_blit(unsigned int *dest, unsigned int dpitch, unsigned int *src, unsigned int spitch,
+                      unsigned int w, unsigned int h, unsigned int mode)
+{
+	volatile unsigned int *cmd = accel_queue_slot();
+	
+	if ((unsigned int)dest & 3)
+		printf("ACCEL: destination alignment for blit incorrect\r\n");
+	if ((unsigned int)src & 3)
+		printf("ACCEL: source alignment for blit incorrect\r\n");
+	
+	cmd[0] = CMDQ_OP_BLIT;
+	cmd[1] = (unsigned int)src;
+	cmd[2] = h;
+	cmd[3] = (unsigned int)dest;
+	cmd[4] = w;
+	cmd[5] = dpitch * 4;
+	cmd[6] = spitch * 4;
+	cmd[7] = mode;
+	accel_queue_push();
+}
+
+void accel_queue_vblank()
+{
+	volatile unsigned int *cmd = accel_queue_slot();
+	
+	cmd[0] = CMDQ_OP_VBLANK;
+	accel_queue_push();
+}
+
+void accel_queue_wait()
+{
+	if (!accel_ring_up)
+		return;
+	
+	while (P(CMDQ_STATUS) & CMDQ_STATUS_BUSY)
+		;
+}
@@ -7,16 +7,72 @@
 #define FILL_VALUE  (FILL_BASE + 0x0)
 #define FILL_ADDR   (FILL_BASE + 0x4)
 #define FILL_LENREM (FILL_BASE + 0x8)
+#define FILL_WIDTH  (FILL_BASE + 0xC)
+#define FILL_STRIDE (FILL_BASE + 0x10)
+#define FILL_ROWS   (FILL_BASE + 0x14)
+#define FILL_FG     (FILL_BASE + 0x18)
+#define FILL_BITMAP0 (FILL_BASE + 0x1C)
+#define FILL_BITMAP1 (FILL_BASE + 0x20)
+#define FILL_EXPAND (FILL_BASE + 0x24)
 
-#define BLIT_BASE   (ACCEL_BASE + 0x100000)
-#define BLIT_RDADDR (BLIT_BASE + 0x0)
-#define BLIT_RDLEN  (BLIT_BASE + 0x4)
-#define BLIT_WRADDR (BLIT_BASE + 0x8)
-#define BLIT_WRROWL (BLIT_BASE + 0xC)
-#define BLIT_WRROWS (BLIT_BASE + 0x10)
-#define BLIT_WRDONE (BLIT_BASE + 0x14)
+/* OR into the scale passed to accel_glyph to leave the background alone. */
+#define FILL_EXPAND_CLEAR_BG 0x10
+
+#define BLIT_BASE     (ACCEL_BASE + 0x100000)
+#define BLIT_RDADDR   (BLIT_BASE + 0x0)
+#define BLIT_ROWS     (BLIT_BASE + 0x4)
+#define BLIT_WRADDR   (BLIT_BASE + 0x8)
+#define BLIT_WIDTH    (BLIT_BASE + 0xC)
+#define BLIT_WRSTRIDE (BLIT_BASE + 0x10)
+#define BLIT_RDSTRIDE (BLIT_BASE + 0x14)
+#define BLIT_MODE     (BLIT_BASE + 0x18)
+
+/* Which source pixels a blit writes: those with alpha of at least ref, all
+ * of them, or those whose colour isn't the same as the key's (the key's
+ * alpha doesn't matter).  Alpha is normally the low byte of a pixel; OR in
+ * BLIT_MODE_ALPHA_HI for images whose alpha is in the high byte.
+ */
+#define BLIT_MODE_ALPHA(ref) (((ref) & 0xFF) << 8)
+#define BLIT_MODE_ALPHA_HI   4
+#define BLIT_MODE_COPY       1
+#define BLIT_MODE_KEY(key)   (((key) & 0xFFFFFF00) | 2)
+
+#define CMDQ_BASE   (ACCEL_BASE + 0x200000)
+#define CMDQ_RING   (CMDQ_BASE + 0x0)
+#define CMDQ_SIZE   (CMDQ_BASE + 0x4)
+#define CMDQ_HEAD   (CMDQ_BASE + 0x8)
+#define CMDQ_TAIL   (CMDQ_BASE + 0xC)
+#define CMDQ_STATUS (CMDQ_BASE + 0x10)
+
+#define CMDQ_STATUS_BUSY   0x1
+#define CMDQ_STATUS_VBLANK 0x2
+
+#define CMDQ_OP_NOP    0
+#define CMDQ_OP_FILL   1
+#define CMDQ_OP_BLIT   2
+#define CMDQ_OP_VBLANK 3
+#define CMDQ_OP_RECT   4
 
 extern void accel_fill(unsigned int *base, unsigned int value, unsigned int words);
-extern void accel_blit(unsigned int *dest, unsigned int *src, unsigned int w, unsigned int h); 
+extern void accel_fill_rect(unsigned int *base, unsigned int value, unsigned int w, unsigned int h, unsigned int pitch);
+/* Pitches are the number of pixels from the start of one row to the start
+ * of the next.
+ */
+extern void accel_glyph(unsigned int *dest, unsigned int pitch, const unsigned char *bits,
+                        unsigned int fg, unsigned int bg, unsigned int scale);
+extern void accel_blit(unsigned int *dest, unsigned int dpitch, unsigned int *src, unsigned int spitch,
+                       unsigned int w, unsigned int h, unsigned int mode);
+
+/* Queued versions of the above: these return as soon as the command is in
+ * the ring, and the accelerators get to it when they get to it.  Call
+ * accel_queue_wait before touching anything that a queued command might
+ * still be drawing into (or before flipping to it).
+ */
+extern void accel_queue_fill(unsigned int *base, unsigned int value, unsigned int words);
+extern void accel_queue_fill_rect(unsigned int *base, unsigned int value, unsigned int w, unsigned int h, unsigned int pitch);
+extern void accel_queue_blit(unsigned int *dest, unsigned int dpitch, unsigned int *src, unsigned int spitch,
+                             unsigned int w, unsigned int h, unsigned int mode);
+extern void accel_queue_vblank();
+extern void accel_queue_wait();
 
 #endif
@@ -1,10 +1,18 @@
 /* Small audio library. */
+#include "minilib.h"
 #include "audio.h"
+#include "dma.h"
 
-static volatile int *dma_start  = (int*) 0x84000000;
+static volatile int *dma_base   = (int*) 0x84000000;
 static volatile int *dma_length = (int*) 0x84000004;
 static volatile int *dma_cmd    = (int*) 0x84000008;
+static volatile int *dma_fetched = (int*) 0x8400000c;
 static volatile int *dma_nread  = (int*) 0x84000010;
+static volatile int *dma_status = (int*) 0x84000018;
+static volatile int *dma_ring_limit = (int*) 0x8400001c;
+static volatile int *dma_ring_watermark = (int*) 0x84000020;
+
+#define DMA_STATUS_RING_LOW 0x4
 
 static volatile short *master_vol = (short*) 0x84000100;
 static volatile short *mic_vol    = (short*) 0x84000104;
@@ -13,6 +21,20 @@ static volatile short *cd_vol     = (short*) 0x8400010c;
 static volatile short *pcm_vol    = (short*) 0x84000110;
 static volatile short *rec_select = (short*) 0x84000114;
 static volatile short *rec_gain   = (short*) 0x84000118;
+static volatile int *stream_vol   = (int*) 0x8400011c;
+static volatile int *stream_fmt   = (int*) 0x84000120;
+
+#define VOICE_REG(n, r) (*(volatile int*) (0x84000200 + (n)*0x10 + (r)))
+#define VOICE_ADDR    0x0
+#define VOICE_LEN     0x4
+#define VOICE_VOL     0x8
+#define VOICE_CTRL    0xc
+static volatile int *voice_status = (int*) 0x840002f0;
+
+static volatile int *capture_start = (int*) 0x84000300;
+static volatile int *capture_len   = (int*) 0x84000304;
+static volatile int *capture_ctrl  = (int*) 0x84000308;
+static volatile int *capture_count = (int*) 0x84000310;
 
 void audio_master_volume_set(char mute, char left, char right)
 {
@@ -73,11 +95,24 @@ void audio_rec_gain_set(char mute, char left, char right)
 	*rec_gain = val;
 }
 
+/* Twice the number of samples in a byte, as a shift; for turning bytes
+ * read back into samples.
+ */
+static const int fmt_shift[] = { 3, 2, 2, 1, 0 };
+static int audio_fmt = AUDIO_FMT_S16_STEREO;
+
+/* Also starts ADPCM decoding over, so call it before each new stream. */
+void audio_format_set(int fmt)
+{
+	audio_fmt = fmt;
+	*stream_fmt = fmt;
+}
+
 void audio_play(void *location, int length, int mode)
 {
 	/* must align, or else dma falls over */
 	*dma_length = length & ~0xFF;
-	*dma_start = (int) location;
+	*dma_base = (int) location;
 	*dma_cmd = mode;
 }
 
@@ -89,7 +124,7 @@ void audio_stop()
 
 int audio_samples_played()
 {
-	return *dma_nread/AUDIO_BYTES_PER_SAMP;
+	return (*dma_nread * 2) >> fmt_shift[audio_fmt];
 }
 
 int is_audio_done(int len)
@@ -97,5 +132,141 @@ int is_audio_done(int len)
 	return (*dma_nread == (len & ~0xFF));
 }
 
+/* Streaming.  The DMA reads the ring over and over, but never gets ahead
+ * of what we've told it we've written (the ring limit), and FIFO_BYTES_READ
+ * says how far it has got, so anything behind that can be refilled.  All
+ * of the counts are in bytes since the stream started, and everything has
+ * to be in multiples of 64 bytes, because that's what the DMA fetches.
+ */
+static unsigned char *stream_ring;
+static int stream_len;
+static int stream_written;
+
+void audio_stream_start(void *ring, int length, int watermark)
+{
+	stream_ring = ring;
+	stream_len = length & ~63;
+	stream_written = 0;
+
+	*dma_cmd = 0;
+	*dma_ring_limit = 0;
+	*dma_ring_watermark = watermark;
+	*dma_length = stream_len;
+	*dma_base = (int) ring;
+}
+
+void audio_stream_go()
+{
+	*dma_cmd = AUDIO_MODE_RING;
+}
+
+void *audio_stream_space(int *room)
+{
+	int off = stream_written % stream_len;
+	int free = *dma_fetched + stream_len - stream_written;
+
+	if (free > stream_len - off)
+		free = stream_len - off;
+	*room = free;
+	return stream_ring + off;
+}
+
+void audio_stream_commit(int bytes)
+{
+	stream_written += bytes & ~63;
+	*dma_ring_limit = stream_written;
+}
+
+int audio_stream_low()
+{
+	return (*dma_status & DMA_STATUS_RING_LOW) != 0;
+}
 
+int audio_stream_drained()
+{
+	return *dma_fetched == stream_written;
+}
 
+/* Mixer.  The voices get read and mixed in by the hardware, on top of the
+ * stream; a voice's buffer must be 64-byte aligned, and only whole 64-byte
+ * blocks of it get played.
+ */
+void audio_stream_volume_set(int vol)
+{
+	*stream_vol = vol;
+}
+
+void audio_voice_play(int n, void *location, int length, int vol, int loop)
+{
+	VOICE_REG(n, VOICE_CTRL) = 0;
+	VOICE_REG(n, VOICE_ADDR) = (int) location;
+	VOICE_REG(n, VOICE_LEN) = length & ~63;
+	VOICE_REG(n, VOICE_VOL) = vol;
+	VOICE_REG(n, VOICE_CTRL) = AUDIO_VOICE_PLAY | (loop ? AUDIO_VOICE_LOOP : 0);
+}
+
+void audio_voice_stop(int n)
+{
+	VOICE_REG(n, VOICE_CTRL) = 0;
+}
+
+void audio_voice_volume_set(int n, int vol)
+{
+	VOICE_REG(n, VOICE_VOL) = vol;
+}
+
+int audio_voice_playing(int n)
+{
+	return (*voice_status >> n) & 1;
+}
+
+/* Capture.  The hardware writes whole 64-byte blocks into the ring behind
+ * the cache's back, so whatever gets copied out has to be swept first.
+ * If the reader falls more than a ring behind, it skips ahead to the
+ * oldest block that's still there.
+ */
+static unsigned char *capture_ring;
+static int capture_ring_len;
+static int capture_read;
+
+void audio_capture_start(void *ring, int length)
+{
+	capture_ring = ring;
+	capture_ring_len = length & ~63;
+	capture_read = 0;
+
+	*capture_ctrl = 0;
+	*capture_start = (int) ring;
+	*capture_len = capture_ring_len;
+	*capture_ctrl = 1;
+}
+
+void audio_capture_stop()
+{
+	*capture_ctrl = 0;
+}
+
+int audio_capture_read(void *dest, int bytes)
+{
+	int count = *capture_count;
+	int off, n;
+
+	if (count - capture_read > capture_ring_len)
+		capture_read = count - capture_ring_len;
+	if (bytes > count - capture_read)
+		bytes = count - capture_read;
+
+	off = capture_read % capture_ring_len;
+	n = bytes;
+	if (n > capture_ring_len - off)
+		n = capture_ring_len - off;
+
+	dma_sweep_dcache(capture_ring + off, n);
+	memcpy(dest, capture_ring + off, n);
+	if (n < bytes) {
+		dma_sweep_dcache(capture_ring, bytes - n);
+		memcpy((unsigned char *)dest + n, capture_ring, bytes - n);
+	}
+	capture_read += bytes;
+	return bytes;
+}
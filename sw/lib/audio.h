@@ -12,8 +12,25 @@
 
 #define AUDIO_BYTES_PER_SAMP 4
 
+/* Formats that the hardware can play the stream (not the voices) from;
+ * 8-bit samples are unsigned, and ADPCM is headerless IMA, mono, low
+ * nibble first.  AUDIO_BYTES_PER_SAMP is for the first one.
+ */
+#define AUDIO_FMT_S16_STEREO 0
+#define AUDIO_FMT_S16_MONO   1
+#define AUDIO_FMT_U8_STEREO  2
+#define AUDIO_FMT_U8_MONO    3
+#define AUDIO_FMT_IMA_ADPCM  4
+
 #define AUDIO_MODE_ONCE 1
 #define AUDIO_MODE_LOOP 2
+#define AUDIO_MODE_RING 3
+
+/* Mixer: volumes go from 0 to 511, and 256 is unity. */
+#define AUDIO_VOICES 4
+#define AUDIO_VOL_UNITY 256
+#define AUDIO_VOICE_PLAY 1
+#define AUDIO_VOICE_LOOP 2
 
 /* options for record select */
 
@@ -34,8 +51,41 @@ void audio_cd_volume_set(char mute, char left, char right);
 void audio_pcm_volume_set(char mute, char left, char right);
 void audio_rec_select_set(char leftdevice, char rightdevice);
 void audio_rec_gain_set(char mute, char left, char right);
+void audio_format_set(int fmt);
 void audio_play(void *location, int length, int mode);
 void audio_stop();
 int audio_samples_played();
 
+/* Streaming: hand audio_stream_start() a 64-byte aligned ring, fill some
+ * of it (audio_stream_space(), then audio_stream_commit()), and start it
+ * with audio_stream_go().  Keep filling it as room opens up;
+ * audio_stream_low() says that there are fewer than watermark bytes left
+ * to play.  Once the last of it has been committed, wait for
+ * audio_stream_drained() and then audio_stop().
+ */
+void audio_stream_start(void *ring, int length, int watermark);
+void audio_stream_go();
+void *audio_stream_space(int *room);
+void audio_stream_commit(int bytes);
+int audio_stream_low();
+int audio_stream_drained();
+
+/* Sound effects: each voice plays a buffer (in the same format as the
+ * stream) out of memory by itself, and gets mixed in with the stream.
+ */
+void audio_stream_volume_set(int vol);
+void audio_voice_play(int n, void *location, int length, int vol, int loop);
+void audio_voice_stop(int n);
+void audio_voice_volume_set(int n, int vol);
+int audio_voice_playing(int n);
+
+/* Capture: records whatever is picked with audio_rec_select_set() into a
+ * 64-byte aligned ring (in the same format as the stream).
+ * audio_capture_read() copies out up to bytes of what has come in since
+ * the last call, and returns how much that was.
+ */
+void audio_capture_start(void *ring, int length);
+void audio_capture_stop();
+int audio_capture_read(void *dest, int bytes);
+
 #endif
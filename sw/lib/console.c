@@ -1,4 +1,6 @@
 #include "console.h"
+#include "minilib.h"
+#include "accel.h"
 
 static unsigned char chars[] = {
 #include "chars.inc"
@@ -6,14 +8,16 @@ static unsigned char chars[] = {
 
 static int _cx = 0, _cy = 0, _cfg = 0xFFFFFFFF, _cbg = 0x00000000;
 
+/* What's on the screen, so that the cursor can be drawn without reading
+ * the framebuffer back.
+ */
+static unsigned char _cchars[60][80];
+
 void cons_drawchar(int c, int x, int y, int fg, int bg)
 {
-	volatile unsigned int *fb = (volatile unsigned int *)(0x00100000 + (y * 8 * 640 + x * 8) * 4);
-	int xx, yy;
+	unsigned int *fb = (unsigned int *)(0x00100000 + (y * 8 * 640 + x * 8) * 4);
 	
-	for (yy = 0; yy < 8; yy++)
-		for (xx = 0; xx < 8; xx++)
-			fb[yy * 640 + (7 - xx)] = ((chars[c*8 + yy] >> xx) & 1) ? fg : bg;
+	accel_glyph(fb, 640, &chars[(c & 0xFF) * 8], fg, bg, 1);
 }
 
 void cons_set_position(int x, int y)
@@ -28,22 +32,19 @@ void cons_set_color(int fg, int bg)
 	_cbg = bg;
 }
 
-static void _inv_block(int x, int y)
+static void _inv_block(int x, int y, int on)
 {
-	volatile unsigned int *fb = (volatile unsigned int *)(0x00100000 + (y * 8 * 640 + x * 8) * 4);
-	int xx, yy;
+	int c = _cchars[y][x] ? _cchars[y][x] : ' ';
 	
-	for (yy = 0; yy < 8; yy++)
-		for (xx = 0; xx < 8; xx++)
-			if (fb[yy * 640 + (7 - xx)] == _cbg)
-				fb[yy * 640 + (7 - xx)] = _cfg;
-			else
-				fb[yy * 640 + (7 - xx)] = _cbg;
+	if (on)
+		cons_drawchar(c, x, y, _cbg, _cfg);
+	else
+		cons_drawchar(c, x, y, _cfg, _cbg);
 }
 
 void cons_putchar(int c)
 {
-	_inv_block(_cx, _cy);
+	_inv_block(_cx, _cy, 0);
 
 	switch (c)
 	{
@@ -65,6 +66,7 @@ void cons_putchar(int c)
 		_cx--;
 		break;
 	default:
+		_cchars[_cy][_cx] = c;
 		cons_drawchar(c, _cx, _cy, _cfg, _cbg);
 		_cx++;
 		if (_cx == 80)
@@ -81,19 +83,16 @@ void cons_putchar(int c)
 		break;
 	}
 	
-	_inv_block(_cx, _cy);
+	_inv_block(_cx, _cy, 1);
 }
 
 void cons_clear()
 {
-	volatile unsigned int *fb = (volatile unsigned int *)0x00100000;
-	int p;
-	
-	for (p = 0; p < 640*480; p++)
-		fb[p] = _cbg;
+	accel_fill((unsigned int *)0x00100000, _cbg, 640*480);
+	memset(_cchars, ' ', sizeof(_cchars));
 	
 	_cx = 0;
 	_cy = 0;
 	
-	_inv_block(_cx, _cy);
+	_inv_block(_cx, _cy, 1);
 }
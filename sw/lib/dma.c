@@ -0,0 +1,65 @@
+#include "minilib.h"
+#include "dma.h"
+
+#define P(x) (*(volatile unsigned int *)(x))
+
+/* Below this, setting up a descriptor and sweeping the cache costs more
+ * than just doing the copy.
+ */
+#define DMA_MIN_BYTES 256
+
+/* The data cache is 16 lines of 64 bytes, direct mapped.  Reading the
+ * line of this that has the same index as a line of the destination
+ * knocks the destination out of the cache if it was in there.
+ */
+#define DCACHE_LINE   64
+#define DCACHE_LINES  16
+static volatile unsigned int dma_sweep[DCACHE_LINES * DCACHE_LINE / 4] __attribute__((aligned(DCACHE_LINES * DCACHE_LINE)));
+
+void dma_start(struct dma_desc *d)
+{
+	P(DMA_DESC) = (unsigned int)d;
+}
+
+int dma_busy()
+{
+	return P(DMA_STATUS) & DMA_STATUS_BUSY;
+}
+
+void dma_wait()
+{
+	while (dma_busy())
+		;
+}
+
+void dma_sweep_dcache(void *dest, int bytes)
+{
+	unsigned int line = (unsigned int)dest / DCACHE_LINE;
+	unsigned int last = ((unsigned int)dest + bytes - 1) / DCACHE_LINE;
+	int n;
+	
+	for (n = 0; (n < DCACHE_LINES) && (line <= last); n++, line++)
+		dma_sweep[(line % DCACHE_LINES) * DCACHE_LINE / 4];
+}
+
+void *dma_memcpy(void *dest, const void *src, int bytes)
+{
+	static struct dma_desc d;
+	
+	if (bytes < DMA_MIN_BYTES || DMA_IN_TCM(dest) || DMA_IN_TCM(src) || DMA_IN_TCM(&d))
+		return memcpy(dest, src, bytes);
+	
+	dma_wait();
+	
+	d.src = (unsigned int)src;
+	d.dst = (unsigned int)dest;
+	d.len = bytes;
+	d.flags = 0;
+	d.next = 0;
+	dma_start(&d);
+	dma_wait();
+	
+	dma_sweep_dcache(dest, bytes);
+	
+	return dest;
+}
@@ -0,0 +1,55 @@
+/* dma.h
+ * Memory-to-memory DMA engine
+ *
+ * The engine walks a chain of descriptors in memory, copying each one in
+ * turn.  Addresses and lengths can be any byte at all, but the source and
+ * destination of one copy must not overlap.
+ *
+ * The engine is not coherent with the L1 caches: it reads whatever is in
+ * memory (which is fine, since the caches are write-through), but the
+ * core can keep stale copies of the destination around afterwards.  (The
+ * L2, if there is one, drops lines that any bus master writes to, so it
+ * never needs any help.)  dma_memcpy sweeps the destination out of the
+ * L1 data cache once the copy is done; anything else is up to the caller,
+ * with dma_sweep_dcache, which also works for other bus masters that
+ * write to memory.  Nothing here touches the instruction cache.
+ */
+
+#ifndef DMA_H
+#define DMA_H
+
+#define DMA_BASE         0x8A000000
+#define DMA_DESC         (DMA_BASE + 0x0)
+#define DMA_STATUS       (DMA_BASE + 0x4)
+#define DMA_COUNT        (DMA_BASE + 0x8)
+
+#define DMA_STATUS_BUSY  0x1
+#define DMA_STATUS_DONE  0x2
+
+/* Stuff in the TCM never goes out on the FSAB, so no bus master (this
+ * engine or any other) can see it.
+ */
+#define DMA_TCM_BASE  0x40000000
+#define DMA_TCM_MASK  0xFFFFC000
+#define DMA_IN_TCM(p) (((unsigned int)(p) & DMA_TCM_MASK) == DMA_TCM_BASE)
+
+/* Descriptor flags */
+#define DMA_F_STATUS     0x1		/* write flags back when done */
+#define DMA_F_DONE       0x80000000	/* ... with this set */
+
+struct dma_desc {
+	unsigned int src;
+	unsigned int dst;
+	unsigned int len;
+	volatile unsigned int flags;
+	struct dma_desc *next;
+	unsigned int pad[3];
+} __attribute__((aligned(32)));
+
+extern void dma_start(struct dma_desc *d);
+extern int dma_busy();
+extern void dma_wait();
+extern void dma_sweep_dcache(void *dest, int bytes);
+extern void *dma_memcpy(void *dest, const void *src, int bytes);
+
+#endif
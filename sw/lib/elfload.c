@@ -10,9 +10,30 @@
 
 #include "elf.h"
 #include "minilib.h"
+#include "dma.h"
 
 static const unsigned char elf_ident[4] = { 0x7F, 'E', 'L', 'F' }; 
 
+/* Sections that run somewhere other than where they get loaded (.tcm,
+ * which crt0 copies down into the TCM) have a load address that only
+ * shows up in the program headers.  Find it, or fall back on the
+ * section's own address.
+ */
+static Elf32_Addr elf_load_addr (Elf32_Ehdr * elf_hdr, Elf32_Shdr * sec, char * buf) {
+	Elf32_Phdr * elf_prog_hdrs = (Elf32_Phdr *) (buf + elf_hdr->e_phoff);
+	int i;
+	
+	for (i = 0; i < elf_hdr->e_phnum; i++) {
+		if (elf_prog_hdrs[i].p_type != PT_LOAD)
+			continue;
+		if ((sec->sh_addr >= elf_prog_hdrs[i].p_vaddr) &&
+		    (sec->sh_addr < (elf_prog_hdrs[i].p_vaddr + elf_prog_hdrs[i].p_memsz)))
+			return elf_prog_hdrs[i].p_paddr + (sec->sh_addr - elf_prog_hdrs[i].p_vaddr);
+	}
+	
+	return sec->sh_addr;
+}
+
 void *elf_load (char * buf, int size) {
 
 	Elf32_Ehdr * elf_hdr = (Elf32_Ehdr *) buf;
@@ -65,11 +86,13 @@ void *elf_load (char * buf, int size) {
 			continue;
 		}
 
-		printf("ELF: loading %s at %08x\r\n", section_name, elf_sec_hdrs[i].sh_addr);
+		Elf32_Addr load_addr = elf_load_addr(elf_hdr, &elf_sec_hdrs[i], buf);
+
+		printf("ELF: loading %s at %08x\r\n", section_name, load_addr);
 
-		memcpy((void *)elf_sec_hdrs[i].sh_addr,
-		       buf + elf_sec_hdrs[i].sh_offset,
-		       elf_sec_hdrs[i].sh_size);
+		dma_memcpy((void *)load_addr,
+		           buf + elf_sec_hdrs[i].sh_offset,
+		           elf_sec_hdrs[i].sh_size);
 	}
 
 	return (void *)elf_hdr->e_entry;
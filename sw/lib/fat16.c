@@ -1,6 +1,7 @@
 #include "sysace.h"
 #include "minilib.h"
 #include "fat16.h"
+#include "dma.h"
 
 #ifdef DEBUG
 #include "console.h"
@@ -193,13 +194,32 @@ int fat16_read(struct fat16_file *fd, unsigned char *buf, int len)
 			printf("FAT16: reading from sector %d\r\n", secnum);
 #endif
 			
-			if (sysace_readsec(secnum, (unsigned int *)secbuf))
+			/* Whole sectors can go straight into buf, as many at a
+			 * time as the rest of the cluster has.
+			 */
+			if ((fd->pos % 512) == 0 && cluslen >= 512 && ((unsigned int)buf & 3) == 0)
 			{
-				puts("failed to read sector!");
-				return retlen ? retlen : -1;
+				int nsec = cluslen / 512;
+				if (nsec > SYSACE_MAX_SECTORS)
+					nsec = SYSACE_MAX_SECTORS;
+				seclen = nsec * 512;
+				
+				if (sysace_readsecs(secnum, (unsigned int *)buf, nsec))
+				{
+					puts("failed to read sectors!");
+					return retlen ? retlen : -1;
+				}
+			}
+			else
+			{
+				if (sysace_readsec(secnum, (unsigned int *)secbuf))
+				{
+					puts("failed to read sector!");
+					return retlen ? retlen : -1;
+				}
+				
+				dma_memcpy(buf, secbuf + fd->pos % 512, seclen);
 			}
-			
-			memcpy(buf, secbuf + fd->pos % 512, seclen);
 			
 			retlen += seclen;
 			buf += seclen;
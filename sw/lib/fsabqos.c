@@ -0,0 +1,34 @@
+#include "fsabqos.h"
+
+#define P(x) (*(volatile unsigned int *)(x))
+
+#define FSABQOS_PRIO(n)    (FSABQOS_BASE + (n) * 0x20 + 0x00)
+#define FSABQOS_PERIOD(n)  (FSABQOS_BASE + (n) * 0x20 + 0x04)
+#define FSABQOS_DEPTH(n)   (FSABQOS_BASE + (n) * 0x20 + 0x08)
+#define FSABQOS_LATCAP(n)  (FSABQOS_BASE + (n) * 0x20 + 0x0C)
+#define FSABQOS_STARVE(n)  (FSABQOS_BASE + (n) * 0x20 + 0x10)
+#define FSABQOS_MAXWAIT(n) (FSABQOS_BASE + (n) * 0x20 + 0x14)
+
+void fsab_qos_set(int dev, int prio, unsigned int period, int depth, unsigned int latcap)
+{
+	P(FSABQOS_PRIO(dev)) = prio;
+	P(FSABQOS_PERIOD(dev)) = period;
+	P(FSABQOS_DEPTH(dev)) = depth;
+	P(FSABQOS_LATCAP(dev)) = latcap;
+}
+
+unsigned int fsab_qos_starvation(int dev)
+{
+	return P(FSABQOS_STARVE(dev));
+}
+
+unsigned int fsab_qos_max_wait(int dev)
+{
+	return P(FSABQOS_MAXWAIT(dev));
+}
+
+void fsab_qos_clear_stats(int dev)
+{
+	P(FSABQOS_STARVE(dev)) = 0;
+	P(FSABQOS_MAXWAIT(dev)) = 0;
+}
@@ -0,0 +1,37 @@
+/* fsabqos.h
+ * FSAB arbiter quality-of-service controls
+ *
+ * Each device on the arbiter has a priority class, a token bucket that
+ * reserves it a share of the bus, and a latency cap past which it jumps
+ * the queue.  The arbiter also counts how long each device has spent
+ * waiting, so that starvation can be spotted from software.
+ *
+ * Device numbers are arbiter slots, and are the FPGA system's; the
+ * simulation system has fewer devices.
+ */
+
+#ifndef FSABQOS_H
+#define FSABQOS_H
+
+#define FSABQOS_BASE        0x89000000
+
+#define FSABQOS_DEV_BLIT    0
+#define FSABQOS_DEV_CLEAR   1
+#define FSABQOS_DEV_DCACHE  2
+#define FSABQOS_DEV_ICACHE  3
+#define FSABQOS_DEV_AUDIO   4
+#define FSABQOS_DEV_FB      5
+#define FSABQOS_DEV_PRE     6
+#define FSABQOS_DEV_DMA     7
+#define FSABQOS_DEV_CMDQ    8
+#define FSABQOS_DEV_FBSPR   9
+#define FSABQOS_DEV_AMIX    10
+#define FSABQOS_DEV_ACAP    11
+#define FSABQOS_DEV_SACE    12
+
+extern void fsab_qos_set(int dev, int prio, unsigned int period, int depth, unsigned int latcap);
+extern unsigned int fsab_qos_starvation(int dev);
+extern unsigned int fsab_qos_max_wait(int dev);
+extern void fsab_qos_clear_stats(int dev);
+
+#endif
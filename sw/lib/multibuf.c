@@ -4,6 +4,34 @@
 
 #include "malloc.h"
 #include "multibuf.h"
+#include "accel.h"
+
+static volatile unsigned int *frame_start = (unsigned int *)0x82000000;
+static volatile unsigned int *frame_len = (unsigned int *)0x82000004;
+static volatile unsigned int *frame_command = (unsigned int *)0x82000008;
+static volatile unsigned int *frame_currread = (unsigned int *)0x82000014;
+static volatile unsigned int *frame_dmastatus = (unsigned int *)0x82000018;
+static volatile unsigned int *frame_status = (unsigned int *)0x82000020;
+static volatile unsigned int *frame_count = (unsigned int *)0x82000024;
+static volatile unsigned int *frame_mode = (unsigned int *)0x82000028;
+static volatile unsigned int *frame_underflows = (unsigned int *)0x8200002C;
+static volatile unsigned int *frame_fifo_min = (unsigned int *)0x82000030;
+static volatile unsigned int *frame_palette = (unsigned int *)0x82000400;
+static volatile unsigned int *frame_sprites = (unsigned int *)0x82000100;
+
+#define FRAME_DMASTATUS_START_PENDING 0x1
+#define FRAME_DMASTATUS_BUSY 0x2
+#define FRAME_STATUS_VBLANK 0x1
+
+#define SPRITE_ADDR   0
+#define SPRITE_POS    1
+#define SPRITE_SIZE   2
+#define SPRITE_STRIDE 3
+#define SPRITE_MODE   4
+#define SPRITE_REG(n, r) frame_sprites[(n) * 8 + (r)]
+
+#define FRAME_COMMAND_STOP 0
+#define FRAME_COMMAND_AUTOTRIGGER 2
 
 /* Utility function because we don't trust % on this system */
 static unsigned int getnext_mod3(unsigned int x){
@@ -32,21 +60,134 @@ unsigned int *multibuf_init(multibuf_t *tbuf, unsigned int width, unsigned int h
 	return multibuf_flip(tbuf);
 }
 
-unsigned int *multibuf_flip(multibuf_t *tbuf)
+/* Nonzero if the last buffer that we flipped to isn't on the screen yet. */
+int multibuf_flip_pending(multibuf_t *tbuf)
+{
+	return *frame_dmastatus & FRAME_DMASTATUS_START_PENDING;
+}
+
+/* Number of frames that have been scanned out; handy for pacing. */
+unsigned int multibuf_frames()
+{
+	return *frame_count;
+}
+
+int multibuf_in_vblank()
 {
-	volatile unsigned int *frame_start = 0x82000000;
-	volatile unsigned int *frame_nread = 0x8200000c;
-	volatile unsigned int *frame_currread = 0x82000014;
+	return *frame_status & FRAME_STATUS_VBLANK;
+}
 
-	int* buffer_curr_reading = (int*)(*frame_currread);
-	*frame_start = tbuf->bufs[tbuf->which];
+/* Scanout health: how many times the scanout has run dry, and how close
+ * it has come to doing so (in 64-bit words left in its FIFO), since the
+ * last multibuf_clear_stats.
+ */
+unsigned int multibuf_underflows()
+{
+	return *frame_underflows;
+}
 
-	unsigned int next_which = getnext_mod3(tbuf->which);
+unsigned int multibuf_fifo_min()
+{
+	return *frame_fifo_min;
+}
 
-	if (tbuf->bufs[next_which] != buffer_curr_reading)
-		tbuf->which = next_which;
-	else
-		tbuf->which = getnext_mod3(next_which);
+void multibuf_clear_stats()
+{
+	*frame_underflows = 0;
+}
+
+unsigned int *multibuf_flip(multibuf_t *tbuf)
+{
+	unsigned int *showing;
+	unsigned int next_which;
+	
+	/* Anything still in the accelerator queue is drawing into this buffer. */
+	accel_queue_wait();
+	
+	/* The scanout only picks up a new buffer at the start of a frame.
+	 * Wait for the last flip to get picked up, so that the buffer that
+	 * was on the screen before it is free; this also keeps us from
+	 * drawing frames faster than they can be shown.
+	 */
+	while (multibuf_flip_pending(tbuf))
+		;
+	
+	showing = (unsigned int *)(*frame_currread);
+	*frame_start = (unsigned int)tbuf->bufs[tbuf->which];
+
+	/* Draw next into whichever buffer is neither on the screen nor
+	 * about to be.
+	 */
+	next_which = getnext_mod3(tbuf->which);
+	if (tbuf->bufs[next_which] == showing)
+		next_which = getnext_mod3(next_which);
+	tbuf->which = next_which;
 
 	return tbuf->bufs[tbuf->which];
 }
+
+/* Bytes of memory that one frame takes up in a given mode. */
+unsigned int multibuf_frame_bytes(unsigned int mode)
+{
+	unsigned int bytes = 640*480*4;
+	
+	if ((mode & 3) == MULTIBUF_MODE_16BPP)
+		bytes /= 2;
+	else if ((mode & 3) == MULTIBUF_MODE_8BPP)
+		bytes /= 4;
+	if (mode & MULTIBUF_MODE_DOUBLE)
+		bytes /= 4;
+	return bytes;
+}
+
+/* The scanout can only change modes while it's stopped, so stop it, let
+ * it drain, and start it up again on the buffer that was showing.  The
+ * buffers themselves are big enough for any mode.
+ */
+void multibuf_set_mode(multibuf_t *tbuf, unsigned int mode)
+{
+	unsigned int showing;
+	
+	while (multibuf_flip_pending(tbuf))
+		;
+	showing = *frame_currread;
+	
+	*frame_command = FRAME_COMMAND_STOP;
+	while (*frame_dmastatus & FRAME_DMASTATUS_BUSY)
+		;
+	
+	*frame_mode = mode;
+	*frame_len = multibuf_frame_bytes(mode);
+	*frame_start = showing;
+	*frame_command = FRAME_COMMAND_AUTOTRIGGER;
+}
+
+/* rgb is laid out like a 32-bpp pixel. */
+void multibuf_set_palette(unsigned int index, unsigned int rgb)
+{
+	frame_palette[index & 0xFF] = rgb;
+}
+
+/* Points sprite n at an image; pitch is in pixels, like a blit's.  The
+ * sprite shows up wherever it was last moved to.
+ */
+void multibuf_sprite_set(unsigned int n, unsigned int *pixels, unsigned int pitch,
+                         unsigned int w, unsigned int h, unsigned int mode)
+{
+	SPRITE_REG(n, SPRITE_SIZE) = 0;
+	SPRITE_REG(n, SPRITE_ADDR) = (unsigned int)pixels;
+	SPRITE_REG(n, SPRITE_STRIDE) = pitch * 4;
+	SPRITE_REG(n, SPRITE_MODE) = mode;
+	SPRITE_REG(n, SPRITE_SIZE) = ((h & 0xFFF) << 16) | (w & 0xFFF);
+}
+
+/* Positions can be negative, to hang a sprite off the top or the left. */
+void multibuf_sprite_move(unsigned int n, int x, int y)
+{
+	SPRITE_REG(n, SPRITE_POS) = ((y & 0xFFF) << 16) | (x & 0xFFF);
+}
+
+void multibuf_sprite_hide(unsigned int n)
+{
+	SPRITE_REG(n, SPRITE_SIZE) = 0;
+}
@@ -5,6 +5,22 @@
 #ifndef MULTIBUF_H
 #define MULTIBUF_H
 
+/* Scanout modes; 8-bpp pixels index a palette, and MULTIBUF_MODE_DOUBLE
+ * shows a 320x240 image at 640x480.
+ */
+#define MULTIBUF_MODE_32BPP  0
+#define MULTIBUF_MODE_16BPP  1
+#define MULTIBUF_MODE_8BPP   2
+#define MULTIBUF_MODE_DOUBLE 4
+
+/* Hardware sprites go on top of whatever's in the frame, with the
+ * lowest-numbered one on top.  They can be at most MULTIBUF_SPRITE_W_MAX
+ * pixels wide, and their pixels (and pitch) have to be 8-byte aligned;
+ * mode works just like a blit's mode (see accel.h).
+ */
+#define MULTIBUF_SPRITES 4
+#define MULTIBUF_SPRITE_W_MAX 64
+
 typedef struct {
 	unsigned int *bufs[3];
 	unsigned int *bufs_orig[3];
@@ -13,5 +29,18 @@ typedef struct {
 
 unsigned int *multibuf_init(multibuf_t *bufs, unsigned int width, unsigned int height);
 unsigned int *multibuf_flip(multibuf_t *bufs);
+int multibuf_flip_pending(multibuf_t *bufs);
+unsigned int multibuf_frames();
+int multibuf_in_vblank();
+unsigned int multibuf_underflows();
+unsigned int multibuf_fifo_min();
+void multibuf_clear_stats();
+unsigned int multibuf_frame_bytes(unsigned int mode);
+void multibuf_set_mode(multibuf_t *bufs, unsigned int mode);
+void multibuf_set_palette(unsigned int index, unsigned int rgb);
+void multibuf_sprite_set(unsigned int n, unsigned int *pixels, unsigned int pitch,
+                         unsigned int w, unsigned int h, unsigned int mode);
+void multibuf_sprite_move(unsigned int n, int x, int y);
+void multibuf_sprite_hide(unsigned int n);
 
 #endif
@@ -0,0 +1,23 @@
+#include "region.h"
+
+#define P(x) (*(volatile unsigned int *)(x))
+
+#define REGION_ENT_BASE(n) (REGION_BASE + (n) * 0x10 + 0x0)
+#define REGION_ENT_MASK(n) (REGION_BASE + (n) * 0x10 + 0x4)
+#define REGION_ENT_ATTR(n) (REGION_BASE + (n) * 0x10 + 0x8)
+
+void region_set(int n, unsigned int base, unsigned int size, int attr)
+{
+	/* Disable the entry while it's being changed, so that it never
+	 * matches with half-written state.
+	 */
+	P(REGION_ENT_MASK(n)) = 0;
+	P(REGION_ENT_BASE(n)) = base;
+	P(REGION_ENT_ATTR(n)) = attr;
+	P(REGION_ENT_MASK(n)) = ~(size - 1);
+}
+
+void region_clear(int n)
+{
+	P(REGION_ENT_MASK(n)) = 0;
+}
@@ -0,0 +1,27 @@
+/* region.h
+ * Memory region attributes
+ *
+ * The core has a small table of address ranges that tell the data cache
+ * how to treat accesses.  Anything not covered by an entry is cacheable.
+ * Regions must be a power of two in size, and aligned to their size.
+ *
+ * Write-combining regions gather stores into 64-byte bursts; the buffer
+ * gets pushed out when it fills, or before any other bus access or any
+ * MMIO access, so kicking off a flip or an accelerator op after drawing
+ * is always safe.
+ */
+
+#ifndef REGION_H
+#define REGION_H
+
+#define REGION_BASE      0x88000000
+#define REGION_ENTRIES   4
+
+#define REGION_CACHEABLE 0
+#define REGION_UNCACHED  1
+#define REGION_WC        2
+
+extern void region_set(int n, unsigned int base, unsigned int size, int attr);
+extern void region_clear(int n);
+
+#endif
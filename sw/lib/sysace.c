@@ -1,5 +1,6 @@
 #include "sysace.h"
 #include "serial.h"
+#include "dma.h"
 
 int sysace_init()
 {
@@ -58,26 +59,17 @@ int sysace_waitbufready()
 }
 
 
-int sysace_readsec(unsigned int lbasect, unsigned int *dest)
+/* Copies the sectors out of the data buffer by hand, 32 bytes at a time. */
+static int sysace_readbuf(unsigned int *dest, int count)
 {
 	volatile unsigned int *sace = SYSACE_BASE;
 	
 	int i;
 	
-	if (sysace_getcflock() < 0)
-		return -1;
-	if (sysace_waitready() < 0)
-		return -1;
-	
-	sace[SYSACE_MPULBA_0] = lbasect & 0xFFFF;
-	sace[SYSACE_MPULBA_1] = lbasect >> 16;
-	
-	sace[SYSACE_SECCNTCMDREG] = SYSACE_SECCNTCMDREG_READ | SYSACE_SECCNTCMDREG_SECTORS(1);
-		
 	/* XXX they say I must hold the config controller in reset, but
 	 * their source indicates that "This breaks mvl, beware!". ???
 	 */
-	for(i = 0; i < 512; i += 32)
+	for(i = 0; i < count * 512; i += 32)
 	{
 		int j;
 		
@@ -95,7 +87,71 @@ int sysace_readsec(unsigned int lbasect, unsigned int *dest)
 		}
 	}
 	
-	sace[SYSACE_CONTROLREG_0] = 0;
+	return 0;
+}
+
+/* Lets the sector DMA copy the data buffer into memory, and waits for it
+ * to finish.  The DMA goes around the cache, so anything of dest that was
+ * in there gets swept out afterwards.
+ */
+static int sysace_dmabuf(unsigned int *dest, int count)
+{
+	volatile unsigned int *sace = SYSACE_BASE;
+	int timeout = 250000 * 16;
+	unsigned int status;
+	
+	sace[SYSACE_DMA_ADDR] = (unsigned int)dest;
+	sace[SYSACE_DMA_COUNT] = SYSACE_SECCNTCMDREG_SECTORS(count);
+	sace[SYSACE_DMA_CTRL] = SYSACE_DMA_CTRL_GO;
+	
+	while ((status = sace[SYSACE_DMA_STATUS]) & SYSACE_DMA_STATUS_BUSY)
+		if ((timeout--) == 0)
+		{
+			puts("CF DMA timed out!");
+			return -1;
+		}
+	
+	if (status & SYSACE_DMA_STATUS_ERROR)
+	{
+		puts("CF DMA buffer ready wait timed out!");
+		return -1;
+	}
+	
+	dma_sweep_dcache(dest, count * 512);
 	
 	return 0;
 }
+
+/* Reads count (1 to SYSACE_MAX_SECTORS) sectors with one command.  If
+ * dest is 64-byte aligned, and out where the bus can see it, the sector
+ * DMA does the copying; otherwise, it gets done by hand.
+ */
+int sysace_readsecs(unsigned int lbasect, unsigned int *dest, int count)
+{
+	volatile unsigned int *sace = SYSACE_BASE;
+	int rv;
+	
+	if (sysace_getcflock() < 0)
+		return -1;
+	if (sysace_waitready() < 0)
+		return -1;
+	
+	sace[SYSACE_MPULBA_0] = lbasect & 0xFFFF;
+	sace[SYSACE_MPULBA_1] = lbasect >> 16;
+	
+	sace[SYSACE_SECCNTCMDREG] = SYSACE_SECCNTCMDREG_READ | SYSACE_SECCNTCMDREG_SECTORS(count);
+	
+	if (((unsigned int)dest & 63) == 0 && !DMA_IN_TCM(dest))
+		rv = sysace_dmabuf(dest, count);
+	else
+		rv = sysace_readbuf(dest, count);
+	
+	sace[SYSACE_CONTROLREG_0] = 0;
+	
+	return rv;
+}
+
+int sysace_readsec(unsigned int lbasect, unsigned int *dest)
+{
+	return sysace_readsecs(lbasect, dest, 1);
+}
@@ -24,9 +24,25 @@
 
 #define SYSACE_DATABUFREG (0x20 << 1)
 
+/* Sector DMA, in the FPGA rather than the SystemACE; these are plain word
+ * offsets.
+ */
+#define SYSACE_DMA_ADDR (0x200 >> 2)
+#define SYSACE_DMA_COUNT (0x204 >> 2)
+#define SYSACE_DMA_CTRL (0x208 >> 2)
+#define SYSACE_DMA_CTRL_GO 0x1
+#define SYSACE_DMA_STATUS (0x20C >> 2)
+#define SYSACE_DMA_STATUS_BUSY 0x1
+#define SYSACE_DMA_STATUS_DONE 0x2
+#define SYSACE_DMA_STATUS_ERROR 0x4
+
+/* Most sectors that one command can read. */
+#define SYSACE_MAX_SECTORS 256
+
 extern int sysace_init();
 extern int sysace_getcflock();
 extern int sysace_waitready();
 extern int sysace_readsec(unsigned int lbasect, unsigned int *dest);
+extern int sysace_readsecs(unsigned int lbasect, unsigned int *dest, int count);
 
 #endif
@@ -0,0 +1,18 @@
+/* tcm.h
+ * Placement macros for the tightly coupled memory
+ *
+ * TCM accesses never miss and never touch the FSAB, so it's the place
+ * for small, hot things: lookup tables, per-frame state, the stack.  The
+ * TCM is only 16KB, so don't get carried away.
+ */
+
+#ifndef TCM_H
+#define TCM_H
+
+/* Initialized data; copied into the TCM by crt0. */
+#define __tcm __attribute__((section(".tcm")))
+
+/* Zero-initialized data; zeroed by crt0, takes no space in the image. */
+#define __tcm_bss __attribute__((section(".tcm.bss")))
+
+#endif
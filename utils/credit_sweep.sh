@@ -0,0 +1,39 @@
+#!/bin/sh
+# Builds a simulator for each FSAB credit setting, runs the same memory
+# image on each one for the same number of core clocks, and prints what
+# simmem and fbsink had to say about it.
+#
+# usage: utils/credit_sweep.sh image [cycles]
+#
+#   image    memory image to start from (passed on as SIMMEM_INIT)
+#   cycles   core clocks to run for (default 2000000)
+#
+# SWEEP can be set to a list of STREAM_CREDITS:MEM_CREDITS pairs; the
+# default covers the old setting (everything at 4) and the new one.
+# Run from the top of the tree.
+
+if [ -z "$1" ]; then
+	echo "usage: $0 image [cycles]" >&2
+	exit 1
+fi
+
+IMAGE=`readlink -f "$1"`
+CYCLES=${2:-2000000}
+SWEEP=${SWEEP:-"4:4 4:8 8:4 8:8"}
+SWEEPRUN=sweep-`date +%Y%m%d-%H%M%S`
+mkdir -p runs
+
+for cfg in $SWEEP; do
+	stream=${cfg%:*}
+	mem=${cfg#*:}
+	run=$SWEEPRUN-s$stream-m$mem
+
+	make sim RUN=$run SIM_VFLAGS="-GSTREAM_CREDITS=$stream -GMEM_CREDITS=$mem" > runs/$run.build.log 2>&1 || {
+		echo "STREAM_CREDITS=$stream MEM_CREDITS=$mem: build failed, see runs/$run.build.log" >&2
+		exit 1
+	}
+
+	echo "STREAM_CREDITS=$stream MEM_CREDITS=$mem:"
+	(cd runs/$run/sim && SIMMEM_INIT="$IMAGE" SIM_CYCLES=$CYCLES FBSINK_QUIET=1 ./Vsystem) |
+		grep -E '^(SIMMEM|FBSINK): [0-9]+ '
+done